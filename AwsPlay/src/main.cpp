@@ -7,14 +7,13 @@
  * © 2018 by Richard Walters
  */
 
-#include "TimeKeeper.hpp"
-
 #include <Aws/Config.hpp>
 #include <Aws/SignApi.hpp>
 #include <chrono>
 #include <Http/Client.hpp>
 #include <Http/Request.hpp>
 #include <HttpNetworkTransport/HttpClientNetworkTransport.hpp>
+#include <MonotonicClock/TimeKeeper.hpp>
 #include <stdlib.h>
 #include <stdio.h>
 #include <StringExtensions/StringExtensions.hpp>
@@ -184,7 +183,9 @@ namespace {
             }
         );
         deps.transport = transport;
-        deps.timeKeeper = std::make_shared< TimeKeeper >();
+        deps.timeKeeper = std::make_shared< MonotonicClock::TimeKeeper >(
+            std::make_shared< MonotonicClock::Clock >()
+        );
         client.Mobilize(deps);
         return true;
     }
@@ -0,0 +1,97 @@
+#pragma once
+
+/**
+ * @file Clock.hpp
+ *
+ * This module declares the MonotonicClock::Clock class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <chrono>
+#include <memory>
+
+namespace MonotonicClock {
+
+    /**
+     * This tells the time as seconds since the UNIX epoch, the way the
+     * wall clock does, but by reading a monotonic clock, so that the
+     * time never jumps when the wall clock is set.  The monotonic clock
+     * is anchored to the wall clock once, when the clock is constructed.
+     *
+     * On Linux, the monotonic clock is read through the vDSO, without a
+     * system call, but it still takes a few tens of nanoseconds.  For hot
+     * paths which don't need to tell the time more precisely than to the
+     * nearest millisecond or so, the clock also has a coarse time, which
+     * is a copy of the time kept up to date by a ticker thread.
+     */
+    class Clock {
+        // Lifecycle management
+    public:
+        ~Clock() noexcept;
+        Clock(const Clock&) = delete;
+        Clock(Clock&&) noexcept;
+        Clock& operator=(const Clock&) = delete;
+        Clock& operator=(Clock&&) noexcept;
+
+        // Public Methods
+    public:
+        /**
+         * This is the default constructor.  It anchors the monotonic
+         * clock to the wall clock.
+         */
+        Clock();
+
+        /**
+         * This method returns the current time.
+         *
+         * @return
+         *     The current time, in seconds since the UNIX epoch,
+         *     is returned.
+         */
+        double GetTime() const;
+
+        /**
+         * This method starts the ticker thread which keeps the coarse
+         * time up to date, if it isn't already running.
+         *
+         * @param[in] interval
+         *     This is how often the ticker thread updates the coarse time.
+         */
+        void StartTicker(
+            std::chrono::microseconds interval = std::chrono::milliseconds(1)
+        );
+
+        /**
+         * This method stops the ticker thread, if it's running.
+         * After this, the coarse time is the same as the current time.
+         */
+        void StopTicker();
+
+        /**
+         * This method returns the coarse time, which is the current time
+         * as of the last tick of the ticker thread.  If the ticker thread
+         * isn't running, the current time is returned instead.
+         *
+         * @return
+         *     The coarse time, in seconds since the UNIX epoch,
+         *     is returned.
+         */
+        double GetCoarseTime() const;
+
+        // Private Properties
+    private:
+        /**
+         * This is the type of structure that contains the private
+         * properties of the instance.  It is defined in the implementation
+         * and declared here to ensure that it is scoped inside the class.
+         */
+        struct Impl;
+
+        /**
+         * This contains the private properties of the instance.
+         */
+        std::unique_ptr< Impl > impl_;
+    };
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+/**
+ * @file TimeKeeper.hpp
+ *
+ * This module declares the MonotonicClock::TimeKeeper class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Clock.hpp"
+
+#include <Http/TimeKeeper.hpp>
+#include <memory>
+
+namespace MonotonicClock {
+
+    /**
+     * This is the implementation of Http::TimeKeeper used by the
+     * applications, which tells the time using a shared Clock.
+     */
+    class TimeKeeper
+        : public Http::TimeKeeper
+    {
+        // Lifecycle Methods
+    public:
+        ~TimeKeeper() noexcept;
+        TimeKeeper(const TimeKeeper&) = delete;
+        TimeKeeper(TimeKeeper&&) noexcept = delete;
+        TimeKeeper& operator=(const TimeKeeper&) = delete;
+        TimeKeeper& operator=(TimeKeeper&&) noexcept = delete;
+
+        // Public Methods
+    public:
+        /**
+         * This is the constructor of the class.
+         *
+         * @param[in] clock
+         *     This is the clock to use to tell the time.
+         *
+         * @param[in] coarse
+         *     This indicates whether or not to tell the clock's coarse
+         *     time, rather than its current time.
+         */
+        explicit TimeKeeper(
+            std::shared_ptr< const Clock > clock,
+            bool coarse = false
+        );
+
+        // Http::TimeKeeper
+    public:
+        virtual double GetCurrentTime() override;
+
+        // Private properties
+    private:
+        /**
+         * This is the type of structure that contains the private
+         * properties of the instance.  It is defined in the implementation
+         * and declared here to ensure that it is scoped inside the class.
+         */
+        struct Impl;
+
+        /**
+         * This contains the private properties of the instance.
+         */
+        std::unique_ptr< Impl > impl_;
+    };
+
+}
@@ -0,0 +1,176 @@
+/**
+ * @file Clock.cpp
+ *
+ * This module contains the implementation of the
+ * MonotonicClock::Clock class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <MonotonicClock/Clock.hpp>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+
+namespace {
+
+    /**
+     * This is the monotonic clock anchored to the wall clock.
+     * On Linux, this is CLOCK_MONOTONIC, which is read through the vDSO.
+     */
+    typedef std::chrono::steady_clock Monotonic;
+
+    /**
+     * This is the number of nanoseconds in one second.
+     */
+    constexpr double NANOSECONDS_PER_SECOND = 1e9;
+
+}
+
+namespace MonotonicClock {
+
+    /**
+     * This contains the private properties of a Clock class instance.
+     */
+    struct Clock::Impl {
+        // Properties
+
+        /**
+         * This is the time, according to the monotonic clock, at which
+         * the clock was anchored to the wall clock.
+         */
+        Monotonic::time_point anchor;
+
+        /**
+         * This is the time, in nanoseconds since the UNIX epoch, at which
+         * the clock was anchored to the wall clock.
+         */
+        int64_t anchorTime = 0;
+
+        /**
+         * This is the coarse time, in nanoseconds since the UNIX epoch,
+         * or zero if the ticker thread isn't running.
+         */
+        std::atomic< int64_t > coarseTime{0};
+
+        /**
+         * This is used to synchronize access to the ticker thread's
+         * stop flag.
+         */
+        std::mutex mutex;
+
+        /**
+         * This is used to wake the ticker thread when it should stop.
+         */
+        std::condition_variable wakeCondition;
+
+        /**
+         * This flag indicates whether or not the ticker thread should stop.
+         */
+        bool stopTicker = false;
+
+        /**
+         * This is the thread which keeps the coarse time up to date.
+         */
+        std::thread ticker;
+
+        // Methods
+
+        /**
+         * This is the destructor of the structure.  It stops the ticker
+         * thread, if it's running.
+         */
+        ~Impl() noexcept {
+            StopTicker();
+        }
+
+        /**
+         * This method returns the current time.
+         *
+         * @return
+         *     The current time, in nanoseconds since the UNIX epoch,
+         *     is returned.
+         */
+        int64_t GetTime() const {
+            return (
+                anchorTime
+                + std::chrono::duration_cast< std::chrono::nanoseconds >(
+                    Monotonic::now() - anchor
+                ).count()
+            );
+        }
+
+        /**
+         * This method stops the ticker thread, if it's running.
+         */
+        void StopTicker() {
+            if (!ticker.joinable()) {
+                return;
+            }
+            {
+                std::lock_guard< std::mutex > lock(mutex);
+                stopTicker = true;
+                wakeCondition.notify_one();
+            }
+            ticker.join();
+            stopTicker = false;
+            coarseTime.store(0, std::memory_order_relaxed);
+        }
+
+        /**
+         * This is the body of the ticker thread, which updates the
+         * coarse time once every given interval.
+         *
+         * @param[in] interval
+         *     This is how often to update the coarse time.
+         */
+        void Tick(std::chrono::microseconds interval) {
+            std::unique_lock< std::mutex > lock(mutex);
+            while (!stopTicker) {
+                coarseTime.store(GetTime(), std::memory_order_relaxed);
+                wakeCondition.wait_for(lock, interval);
+            }
+        }
+    };
+
+    Clock::~Clock() noexcept = default;
+    Clock::Clock(Clock&&) noexcept = default;
+    Clock& Clock::operator=(Clock&&) noexcept = default;
+
+    Clock::Clock()
+        : impl_(new Impl())
+    {
+        impl_->anchor = Monotonic::now();
+        impl_->anchorTime = std::chrono::duration_cast< std::chrono::nanoseconds >(
+            std::chrono::system_clock::now().time_since_epoch()
+        ).count();
+    }
+
+    double Clock::GetTime() const {
+        return (double)impl_->GetTime() / NANOSECONDS_PER_SECOND;
+    }
+
+    void Clock::StartTicker(std::chrono::microseconds interval) {
+        if (impl_->ticker.joinable()) {
+            return;
+        }
+        impl_->coarseTime.store(impl_->GetTime(), std::memory_order_relaxed);
+        impl_->ticker = std::thread(&Impl::Tick, impl_.get(), interval);
+    }
+
+    void Clock::StopTicker() {
+        impl_->StopTicker();
+    }
+
+    double Clock::GetCoarseTime() const {
+        const auto coarseTime = impl_->coarseTime.load(std::memory_order_relaxed);
+        if (coarseTime == 0) {
+            return GetTime();
+        }
+        return (double)coarseTime / NANOSECONDS_PER_SECOND;
+    }
+
+}
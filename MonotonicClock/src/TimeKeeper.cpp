@@ -0,0 +1,50 @@
+/**
+ * @file TimeKeeper.cpp
+ *
+ * This module contains the implementation of the
+ * MonotonicClock::TimeKeeper class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <memory>
+#include <MonotonicClock/TimeKeeper.hpp>
+
+namespace MonotonicClock {
+
+    /**
+     * This contains the private properties of a TimeKeeper class instance.
+     */
+    struct TimeKeeper::Impl {
+        /**
+         * This is the clock used to tell the time.
+         */
+        std::shared_ptr< const Clock > clock;
+
+        /**
+         * This indicates whether or not to tell the clock's coarse time,
+         * rather than its current time.
+         */
+        bool coarse = false;
+    };
+
+    TimeKeeper::~TimeKeeper() noexcept = default;
+
+    TimeKeeper::TimeKeeper(
+        std::shared_ptr< const Clock > clock,
+        bool coarse
+    )
+        : impl_(new Impl())
+    {
+        impl_->clock = clock;
+        impl_->coarse = coarse;
+    }
+
+    double TimeKeeper::GetCurrentTime() {
+        if (impl_->coarse) {
+            return impl_->clock->GetCoarseTime();
+        }
+        return impl_->clock->GetTime();
+    }
+
+}
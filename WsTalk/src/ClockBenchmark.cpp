@@ -0,0 +1,206 @@
+/**
+ * @file ClockBenchmark.cpp
+ *
+ * This module contains the implementation of the function used to measure
+ * how long it takes to tell the time with MonotonicClock::Clock.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "ClockBenchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <MonotonicClock/Clock.hpp>
+#include <MonotonicClock/TimeKeeper.hpp>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <SystemAbstractions/Time.hpp>
+#include <time.h>
+
+namespace {
+
+    /**
+     * This is the type of clock used to time everything.
+     */
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * This is the least amount of time, in seconds, to spend telling
+     * the time each way.
+     */
+    constexpr double MIN_MEASUREMENT_TIME = 0.5;
+
+    /**
+     * This is the number of times to tell the time between each look
+     * at how much time has passed while measuring.
+     */
+    constexpr size_t CALLS_PER_BATCH = 1000;
+
+    /**
+     * This is how often the ticker thread updates the coarse time.
+     */
+    constexpr auto TICK_INTERVAL = std::chrono::milliseconds(1);
+
+    /**
+     * This tells the time the way the time keeper given to the web client
+     * used to, so that the two can be compared.
+     */
+    struct PreviousTimeKeeper {
+        /**
+         * This is used to interface with the operating system's
+         * notion of time.
+         */
+        SystemAbstractions::Time time;
+
+        /**
+         * This method returns the current time.
+         *
+         * @return
+         *     The current time, in seconds since the UNIX epoch,
+         *     is returned.
+         */
+        double GetCurrentTime() {
+            static const auto startTimeHighRes = time.GetTime();
+            static const auto startTimeReal = (double)::time(NULL);
+            return startTimeReal + (time.GetTime() - startTimeHighRes);
+        }
+    };
+
+    /**
+     * This function repeatedly calls the given function to tell the time
+     * until at least the minimum measurement time has passed, and returns
+     * the nanoseconds taken by each call.
+     *
+     * @param[in] tellTime
+     *     This is the function to call to tell the time.
+     *
+     * @param[in,out] monotonic
+     *     This is cleared if the time told ever goes backwards.
+     *
+     * @return
+     *     The number of nanoseconds taken by each call is returned.
+     */
+    template< typename TellTime > double MeasureNanosecondsPerCall(
+        TellTime tellTime,
+        bool& monotonic
+    ) {
+        const auto start = Clock::now();
+        size_t calls = 0;
+        double elapsed = 0.0;
+        auto lastTime = tellTime();
+        do {
+            for (size_t i = 0; i < CALLS_PER_BATCH; ++i) {
+                const auto time = tellTime();
+                if (time < lastTime) {
+                    monotonic = false;
+                }
+                lastTime = time;
+            }
+            calls += CALLS_PER_BATCH;
+            elapsed = std::chrono::duration< double >(Clock::now() - start).count();
+        } while (elapsed < MIN_MEASUREMENT_TIME);
+        return elapsed * 1e9 / (double)calls;
+    }
+
+    /**
+     * This function returns the current wall clock time.
+     *
+     * @return
+     *     The current wall clock time, in seconds since the UNIX epoch,
+     *     is returned.
+     */
+    double GetWallClockTime() {
+        return std::chrono::duration< double >(
+            std::chrono::system_clock::now().time_since_epoch()
+        ).count();
+    }
+
+}
+
+bool RunClockBenchmark(
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+) {
+    const auto clock = std::make_shared< MonotonicClock::Clock >();
+    const auto wallClockStart = GetWallClockTime();
+    const auto clockStart = clock->GetTime();
+    PreviousTimeKeeper previousTimeKeeper;
+    MonotonicClock::TimeKeeper timeKeeper(clock);
+    bool previousMonotonic = true;
+    bool monotonic = true;
+    printf("mode                     ns/call\n");
+    printf(
+        "previous time keeper %11.1f\n",
+        MeasureNanosecondsPerCall(
+            [&previousTimeKeeper]{ return previousTimeKeeper.GetCurrentTime(); },
+            previousMonotonic
+        )
+    );
+    printf(
+        "precise              %11.1f\n",
+        MeasureNanosecondsPerCall(
+            [&clock]{ return clock->GetTime(); },
+            monotonic
+        )
+    );
+    printf(
+        "precise time keeper  %11.1f\n",
+        MeasureNanosecondsPerCall(
+            [&timeKeeper]{ return timeKeeper.GetCurrentTime(); },
+            monotonic
+        )
+    );
+    clock->StartTicker(TICK_INTERVAL);
+    printf(
+        "coarse               %11.1f\n",
+        MeasureNanosecondsPerCall(
+            [&clock]{ return clock->GetCoarseTime(); },
+            monotonic
+        )
+    );
+
+    // Find out how far behind the current time the coarse time falls.
+    double maxStaleness = 0.0;
+    const auto stalenessStart = Clock::now();
+    while (
+        std::chrono::duration< double >(Clock::now() - stalenessStart).count()
+        < MIN_MEASUREMENT_TIME
+    ) {
+        const auto coarseTime = clock->GetCoarseTime();
+        maxStaleness = std::max(maxStaleness, clock->GetTime() - coarseTime);
+    }
+    clock->StopTicker();
+    printf(
+        "\nCoarse time was at most %.3f ms behind (ticking every %.3f ms).\n",
+        maxStaleness * 1e3,
+        std::chrono::duration< double, std::milli >(TICK_INTERVAL).count()
+    );
+
+    // Compare how far the clock and the wall clock have each moved
+    // since the start, to show whether or not the clock drifts.
+    const auto wallClockElapsed = GetWallClockTime() - wallClockStart;
+    const auto clockElapsed = clock->GetTime() - clockStart;
+    printf(
+        "Clock moved %.1f us %s than the wall clock over %.3f s.\n",
+        fabs(clockElapsed - wallClockElapsed) * 1e6,
+        ((clockElapsed < wallClockElapsed) ? "less" : "more"),
+        wallClockElapsed
+    );
+    if (!previousMonotonic) {
+        diagnosticMessageDelegate(
+            "WsTalk",
+            SystemAbstractions::DiagnosticsSender::Levels::WARNING,
+            "the previous time keeper went backwards"
+        );
+    }
+    if (!monotonic) {
+        diagnosticMessageDelegate(
+            "WsTalk",
+            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+            "the clock went backwards"
+        );
+    }
+    return monotonic;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+/**
+ * @file ClockBenchmark.hpp
+ *
+ * This module declares the function used to measure how long it takes
+ * to tell the time with MonotonicClock::Clock.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <SystemAbstractions/DiagnosticsSender.hpp>
+
+/**
+ * This function measures how long it takes to tell the time each way
+ * MonotonicClock::Clock offers, compared with the way the time keeper
+ * given to the web client used to, and prints a line for each giving
+ * the nanoseconds per call.  It also prints how far the clock has
+ * strayed from the wall clock by the end, and how stale the coarse
+ * time got.
+ *
+ * @param[in] diagnosticMessageDelegate
+ *     This is the function to call to publish any diagnostic messages.
+ *
+ * @return
+ *     An indication of whether or not the time told by the clock
+ *     never went backwards is returned.
+ */
+bool RunClockBenchmark(
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+);
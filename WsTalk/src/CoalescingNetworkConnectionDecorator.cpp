@@ -0,0 +1,249 @@
+/**
+ * @file CoalescingNetworkConnectionDecorator.cpp
+ *
+ * This module contains the implementation of the
+ * CoalescingNetworkConnectionDecorator class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "CoalescingNetworkConnectionDecorator.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+/**
+ * This contains the private properties of a
+ * CoalescingNetworkConnectionDecorator class instance.
+ */
+struct CoalescingNetworkConnectionDecorator::Impl {
+    // Properties
+
+    /**
+     * This is the interface to the network connection being decorated.
+     */
+    std::shared_ptr< SystemAbstractions::INetworkConnection > lowerLayer;
+
+    /**
+     * This is the longest to hold data sent through the connection
+     * before sending it to the lower layer.
+     */
+    std::chrono::microseconds window{0};
+
+    /**
+     * This is the number of bytes which, once gathered, are sent to
+     * the lower layer at once.
+     */
+    size_t byteThreshold = 0;
+
+    /**
+     * This is used to synchronize access to the data gathered,
+     * the deadline, and the worker thread's stop flag.
+     */
+    std::mutex mutex;
+
+    /**
+     * This is used to wake the worker thread when data is first gathered,
+     * or when it should stop.
+     */
+    std::condition_variable wakeCondition;
+
+    /**
+     * This holds the data gathered so far, waiting to be sent.
+     */
+    std::vector< uint8_t > pending;
+
+    /**
+     * This is the time by which the data gathered so far must be sent.
+     */
+    std::chrono::steady_clock::time_point deadline;
+
+    /**
+     * This flag indicates whether or not the worker thread should stop.
+     */
+    bool stopWorker = false;
+
+    /**
+     * This is used to keep batches of data in order, by letting only one
+     * of them be sent to the lower layer at a time.
+     */
+    std::mutex flushMutex;
+
+    /**
+     * This holds the batch of data being sent to the lower layer.
+     * It's swapped with the data gathered, so that neither buffer needs
+     * to be allocated again once it's grown.
+     */
+    std::vector< uint8_t > sending;
+
+    /**
+     * This is the thread which sends the data gathered when its
+     * deadline passes.
+     */
+    std::thread worker;
+
+    // Methods
+
+    /**
+     * This is the destructor of the structure.  It stops the worker
+     * thread, if one was started, and sends what's left of the data
+     * gathered.
+     */
+    ~Impl() noexcept {
+        if (!worker.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard< std::mutex > lock(mutex);
+            stopWorker = true;
+            wakeCondition.notify_one();
+        }
+        worker.join();
+        Flush();
+    }
+
+    /**
+     * This method sends all the data gathered so far to the lower layer.
+     */
+    void Flush() {
+        std::lock_guard< std::mutex > flushLock(flushMutex);
+        {
+            std::lock_guard< std::mutex > lock(mutex);
+            if (pending.empty()) {
+                return;
+            }
+            pending.swap(sending);
+        }
+        lowerLayer->SendMessage(sending);
+        sending.clear();
+    }
+
+    /**
+     * This method gathers the given data to send, sending it and
+     * everything gathered before it to the lower layer if enough has
+     * been gathered.
+     *
+     * @param[in] message
+     *     This is the data to send.
+     */
+    void Gather(const std::vector< uint8_t >& message) {
+        bool flushNow = false;
+        {
+            std::lock_guard< std::mutex > lock(mutex);
+            const auto wasEmpty = pending.empty();
+            pending.insert(pending.end(), message.begin(), message.end());
+            if (pending.size() >= byteThreshold) {
+                flushNow = true;
+            } else if (wasEmpty) {
+                deadline = std::chrono::steady_clock::now() + window;
+                wakeCondition.notify_one();
+            }
+        }
+        if (flushNow) {
+            Flush();
+        }
+    }
+
+    /**
+     * This is the body of the worker thread, which sends the data
+     * gathered whenever its deadline passes.
+     */
+    void Work() {
+        std::unique_lock< std::mutex > lock(mutex);
+        while (!stopWorker) {
+            if (pending.empty()) {
+                wakeCondition.wait(lock);
+            } else if (std::chrono::steady_clock::now() < deadline) {
+                wakeCondition.wait_until(lock, deadline);
+            } else {
+                lock.unlock();
+                Flush();
+                lock.lock();
+            }
+        }
+    }
+};
+
+CoalescingNetworkConnectionDecorator::~CoalescingNetworkConnectionDecorator() noexcept = default;
+CoalescingNetworkConnectionDecorator::CoalescingNetworkConnectionDecorator(CoalescingNetworkConnectionDecorator&&) noexcept = default;
+CoalescingNetworkConnectionDecorator& CoalescingNetworkConnectionDecorator::operator=(CoalescingNetworkConnectionDecorator&&) noexcept = default;
+
+CoalescingNetworkConnectionDecorator::CoalescingNetworkConnectionDecorator()
+    : impl_(new Impl())
+{
+}
+
+void CoalescingNetworkConnectionDecorator::Decorate(
+    std::shared_ptr< SystemAbstractions::INetworkConnection > lowerLayer,
+    std::chrono::microseconds window,
+    size_t byteThreshold
+) {
+    if (impl_->worker.joinable()) {
+        return;
+    }
+    impl_->lowerLayer = lowerLayer;
+    impl_->window = window;
+    impl_->byteThreshold = byteThreshold;
+    impl_->pending.reserve(byteThreshold);
+    impl_->sending.reserve(byteThreshold);
+    impl_->worker = std::thread(&Impl::Work, impl_.get());
+}
+
+void CoalescingNetworkConnectionDecorator::Flush() {
+    impl_->Flush();
+}
+
+SystemAbstractions::DiagnosticsSender::UnsubscribeDelegate CoalescingNetworkConnectionDecorator::SubscribeToDiagnostics(
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate delegate,
+    size_t minLevel
+) {
+    return impl_->lowerLayer->SubscribeToDiagnostics(delegate, minLevel);
+}
+
+bool CoalescingNetworkConnectionDecorator::Connect(uint32_t peerAddress, uint16_t peerPort) {
+    return impl_->lowerLayer->Connect(peerAddress, peerPort);
+}
+
+bool CoalescingNetworkConnectionDecorator::Process(
+    MessageReceivedDelegate messageReceivedDelegate,
+    BrokenDelegate brokenDelegate
+) {
+    return impl_->lowerLayer->Process(messageReceivedDelegate, brokenDelegate);
+}
+
+uint32_t CoalescingNetworkConnectionDecorator::GetPeerAddress() const {
+    return impl_->lowerLayer->GetPeerAddress();
+}
+
+uint16_t CoalescingNetworkConnectionDecorator::GetPeerPort() const {
+    return impl_->lowerLayer->GetPeerPort();
+}
+
+bool CoalescingNetworkConnectionDecorator::IsConnected() const {
+    return impl_->lowerLayer->IsConnected();
+}
+
+uint32_t CoalescingNetworkConnectionDecorator::GetBoundAddress() const {
+    return impl_->lowerLayer->GetBoundAddress();
+}
+
+uint16_t CoalescingNetworkConnectionDecorator::GetBoundPort() const {
+    return impl_->lowerLayer->GetBoundPort();
+}
+
+void CoalescingNetworkConnectionDecorator::SendMessage(const std::vector< uint8_t >& message) {
+    impl_->Gather(message);
+}
+
+void CoalescingNetworkConnectionDecorator::Close(bool clean) {
+    if (clean) {
+        impl_->Flush();
+    }
+    impl_->lowerLayer->Close(clean);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+/**
+ * @file CoalescingNetworkConnectionDecorator.hpp
+ *
+ * This module declares the CoalescingNetworkConnectionDecorator class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <chrono>
+#include <memory>
+#include <stddef.h>
+#include <SystemAbstractions/INetworkConnection.hpp>
+
+/**
+ * This is a decorator for SystemAbstractions::INetworkConnection which
+ * gathers data sent through the connection in short succession and
+ * sends it to the lower layer all at once, so that many small sends
+ * cost the lower layer (and the layers below it) only one.  Data is held
+ * until a fixed time has passed since the first of it was sent, or until
+ * enough of it has gathered, whichever comes first, or until the
+ * decorator is explicitly flushed.
+ */
+class CoalescingNetworkConnectionDecorator
+    : public SystemAbstractions::INetworkConnection
+{
+    // Lifecycle management
+public:
+    ~CoalescingNetworkConnectionDecorator() noexcept;
+    CoalescingNetworkConnectionDecorator(const CoalescingNetworkConnectionDecorator&) = delete;
+    CoalescingNetworkConnectionDecorator(CoalescingNetworkConnectionDecorator&&) noexcept;
+    CoalescingNetworkConnectionDecorator& operator=(const CoalescingNetworkConnectionDecorator&) = delete;
+    CoalescingNetworkConnectionDecorator& operator=(CoalescingNetworkConnectionDecorator&&) noexcept;
+
+    // Public Methods
+public:
+    /**
+     * This is the default constructor.
+     */
+    CoalescingNetworkConnectionDecorator();
+
+    /**
+     * This method sets up the decorator with the network connection to
+     * decorate and when to send the data gathered.
+     *
+     * @param[in] lowerLayer
+     *     This is the lower-level connection to decorate.
+     *
+     * @param[in] window
+     *     This is the longest to hold data sent through the connection
+     *     before sending it to the lower layer.
+     *
+     * @param[in] byteThreshold
+     *     This is the number of bytes which, once gathered, are sent to
+     *     the lower layer at once, without waiting for the window to end.
+     */
+    void Decorate(
+        std::shared_ptr< SystemAbstractions::INetworkConnection > lowerLayer,
+        std::chrono::microseconds window,
+        size_t byteThreshold
+    );
+
+    /**
+     * This method sends any data gathered to the lower layer right away.
+     * Callers which can't wait for the window to end should call this
+     * after sending whatever needs to go out right away.
+     */
+    void Flush();
+
+    // SystemAbstractions::INetworkConnection
+public:
+    virtual SystemAbstractions::DiagnosticsSender::UnsubscribeDelegate SubscribeToDiagnostics(
+        SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate delegate,
+        size_t minLevel = 0
+    ) override;
+    virtual bool Connect(uint32_t peerAddress, uint16_t peerPort) override;
+    virtual bool Process(
+        MessageReceivedDelegate messageReceivedDelegate,
+        BrokenDelegate brokenDelegate
+    ) override;
+    virtual uint32_t GetPeerAddress() const override;
+    virtual uint16_t GetPeerPort() const override;
+    virtual bool IsConnected() const override;
+    virtual uint32_t GetBoundAddress() const override;
+    virtual uint16_t GetBoundPort() const override;
+    virtual void SendMessage(const std::vector< uint8_t >& message) override;
+    virtual void Close(bool clean = false) override;
+
+    // Private Properties
+private:
+    /**
+     * This is the type of structure that contains the private
+     * properties of the instance.  It is defined in the implementation
+     * and declared here to ensure that it is scoped inside the class.
+     */
+    struct Impl;
+
+    /**
+     * This contains the private properties of the instance.
+     */
+    std::shared_ptr< Impl > impl_;
+};
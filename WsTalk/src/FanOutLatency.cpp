@@ -0,0 +1,809 @@
+/**
+ * @file FanOutLatency.cpp
+ *
+ * This module contains the implementation of the function used to measure
+ * how long it takes a tell in a chat room to reach every other member of
+ * the room, for rooms of different sizes.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "FanOutLatency.hpp"
+#include "Statistics.hpp"
+#include "WebSocketOpener.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <inttypes.h>
+#include <Json/Value.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <StringExtensions/StringExtensions.hpp>
+#include <thread>
+
+namespace {
+
+    /**
+     * This is the type of clock used to time everything.  The same clock
+     * stamps tells when they're sent and when they're received, which is
+     * possible because senders and listeners share this process.
+     */
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * This is how long to sleep between passes over the WebSockets.
+     */
+    constexpr std::chrono::milliseconds TICK(5);
+
+    /**
+     * This is the longest to wait for the chat room to reply to
+     * a request made while setting up a sender.
+     */
+    constexpr std::chrono::milliseconds REPLY_TIMEOUT(5000);
+
+    /**
+     * This is the longest to wait for the server to close its ends of
+     * the WebSockets, once they have all been closed on this end.
+     */
+    constexpr std::chrono::milliseconds CLOSE_TIMEOUT(5000);
+
+    /**
+     * This is the format of the text of every tell sent to measure
+     * latency.  It holds the number of the room size being measured,
+     * the index of the sender, the sequence number of the tell, and
+     * the time the tell was sent, in nanoseconds.
+     */
+    constexpr const char* TELL_FORMAT = "fanout %zu %zu %" PRIu64 " %" PRIu64;
+
+    /**
+     * This is the format used to scan the text of tells received,
+     * matching the format used to send them.
+     */
+    constexpr const char* TELL_SCAN_FORMAT = "fanout %zu %zu %" SCNu64 " %" SCNu64;
+
+    /**
+     * This holds what the listeners have measured, along with what each
+     * listener needs to detect tells received out of order.  It's shared
+     * by the WebSocket delegates, which are called from the WebSockets'
+     * own threads.
+     */
+    struct Measurements {
+        /**
+         * This is used to synchronize access to the measurements.
+         */
+        std::mutex mutex;
+
+        /**
+         * This is the number of the room size being measured, counting
+         * from one.  It's zero between measurements.
+         */
+        size_t phase = 0;
+
+        /**
+         * These are the latencies, in milliseconds, of the tells received
+         * while measuring the current room size.
+         */
+        std::vector< double > latencies;
+
+        /**
+         * This is the number of tells received while measuring
+         * the current room size.
+         */
+        uint64_t delivered = 0;
+
+        /**
+         * This is the number of tells received, while measuring the current
+         * room size, with a sequence number no greater than one already
+         * received by the same listener from the same sender.
+         */
+        uint64_t reordered = 0;
+
+        /**
+         * This is the number of tells received after the measurement
+         * of the room size for which they were sent was over.
+         */
+        uint64_t late = 0;
+
+        /**
+         * This is the number of listener WebSockets closed by the server
+         * before this end closed them.
+         */
+        size_t dropped = 0;
+
+        /**
+         * This is the number of WebSockets closed for any reason.
+         */
+        size_t closed = 0;
+    };
+
+    /**
+     * This holds the parts of a listener shared with the delegates
+     * of its WebSocket.  It's guarded by the measurements mutex.
+     */
+    struct ListenerState {
+        /**
+         * This is the highest sequence number received from each sender.
+         */
+        std::vector< uint64_t > lastSequences;
+
+        /**
+         * This indicates whether or not this end has started
+         * closing the WebSocket.
+         */
+        bool closing = false;
+    };
+
+    /**
+     * This holds everything about one listener in the chat room.
+     */
+    struct Listener {
+        /**
+         * This is used to open the WebSocket.
+         */
+        WebSocketOpener opener;
+
+        /**
+         * This is the WebSocket, once it's open.
+         */
+        std::shared_ptr< WebSockets::WebSocket > ws;
+
+        /**
+         * This is shared with the delegates of the WebSocket.
+         */
+        std::shared_ptr< ListenerState > state = std::make_shared< ListenerState >();
+
+        /**
+         * This indicates whether or not the WebSocket is still opening.
+         */
+        bool opening = true;
+    };
+
+    /**
+     * This holds the parts of a sender shared with the delegates
+     * of its WebSocket.
+     */
+    struct SenderState {
+        /**
+         * This is used to synchronize access to the state.
+         */
+        std::mutex mutex;
+
+        /**
+         * This is used to wait for replies from the chat room.
+         */
+        std::condition_variable condition;
+
+        /**
+         * These are the messages received from the chat room,
+         * other than tells, not yet handled.
+         */
+        std::deque< Json::Value > replies;
+
+        /**
+         * This indicates whether or not the WebSocket was closed.
+         */
+        bool closed = false;
+    };
+
+    /**
+     * This holds everything about one sender in the chat room.
+     */
+    struct Sender {
+        /**
+         * This is the WebSocket of the sender.
+         */
+        std::shared_ptr< WebSockets::WebSocket > ws;
+
+        /**
+         * This is shared with the delegates of the WebSocket.
+         */
+        std::shared_ptr< SenderState > state = std::make_shared< SenderState >();
+
+        /**
+         * This is the nickname the sender took in the chat room.
+         */
+        std::string nickname;
+
+        /**
+         * This is the sequence number of the next tell to send.
+         */
+        uint64_t nextSequence = 1;
+
+        /**
+         * This is when the next tell is due to be sent.
+         */
+        Clock::time_point nextSend;
+    };
+
+    /**
+     * This function returns the number of nanoseconds since the epoch
+     * of the clock used to time everything.
+     *
+     * @param[in] time
+     *     This is the time to convert.
+     *
+     * @return
+     *     The number of nanoseconds since the epoch of the clock
+     *     is returned.
+     */
+    uint64_t Nanoseconds(Clock::time_point time) {
+        return (uint64_t)std::chrono::duration_cast< std::chrono::nanoseconds >(
+            time.time_since_epoch()
+        ).count();
+    }
+
+    /**
+     * This function waits for the given WebSocket to open, or fail.
+     *
+     * @param[in,out] opener
+     *     This is used to open the WebSocket.
+     *
+     * @param[in] shutDown
+     *     This is a flag which is set when the wait should be canceled.
+     *
+     * @return
+     *     The state of the opening of the WebSocket is returned.
+     */
+    WebSocketOpener::State AwaitOpen(
+        WebSocketOpener& opener,
+        const bool& shutDown
+    ) {
+        auto state = WebSocketOpener::State::Opening;
+        while (
+            !shutDown
+            && (state == WebSocketOpener::State::Opening)
+        ) {
+            state = opener.Await(std::chrono::milliseconds(100));
+        }
+        return state;
+    }
+
+    /**
+     * This function waits for the chat room to send the given sender
+     * a message of the given type.  Messages of other types received
+     * in the meantime are discarded.
+     *
+     * @param[in,out] sender
+     *     This is the sender expecting the message.
+     *
+     * @param[in] type
+     *     This is the type of message to wait for.
+     *
+     * @param[out] reply
+     *     This is where to store the message received.
+     *
+     * @return
+     *     An indication of whether or not the message was received
+     *     in time is returned.
+     */
+    bool AwaitReply(
+        Sender& sender,
+        const std::string& type,
+        Json::Value& reply
+    ) {
+        const auto deadline = Clock::now() + REPLY_TIMEOUT;
+        std::unique_lock< std::mutex > lock(sender.state->mutex);
+        for (;;) {
+            while (!sender.state->replies.empty()) {
+                const auto message = std::move(sender.state->replies.front());
+                sender.state->replies.pop_front();
+                if ((std::string)message["Type"] == type) {
+                    reply = message;
+                    return true;
+                }
+            }
+            if (
+                sender.state->closed
+                || (
+                    sender.state->condition.wait_until(lock, deadline)
+                    == std::cv_status::timeout
+                )
+            ) {
+                return false;
+            }
+        }
+    }
+
+    /**
+     * This function opens a WebSocket for a sender and has it take one
+     * of the nicknames the chat room has available, since only members
+     * with nicknames may send tells.
+     *
+     * @param[in,out] client
+     *     This is the client to use to connect to the server.
+     *
+     * @param[in] url
+     *     This is the URL of the chat room to which to connect.
+     *
+     * @param[in,out] sender
+     *     This is the sender to set up.
+     *
+     * @param[in] measurements
+     *     This is counted in when the WebSocket is closed.
+     *
+     * @param[in] shutDown
+     *     This is a flag which is set when setting up should be canceled.
+     *
+     * @param[in] diagnosticMessageDelegate
+     *     This is the function to call to publish any diagnostic messages.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool SetUpSender(
+        Http::Client& client,
+        const Uri::Uri& url,
+        Sender& sender,
+        std::shared_ptr< Measurements > measurements,
+        const bool& shutDown,
+        SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+    ) {
+        const auto state = sender.state;
+        WebSockets::WebSocket::Delegates wsDelegates;
+        wsDelegates.text = [state](const std::string& data){
+            auto message = Json::Value::FromEncoding(data);
+            if (
+                !message.Has("Type")
+                || ((std::string)message["Type"] == "Tell")
+            ) {
+                return;
+            }
+            std::lock_guard< std::mutex > lock(state->mutex);
+            state->replies.push_back(std::move(message));
+            state->condition.notify_all();
+        };
+        wsDelegates.close = [state, measurements](
+            unsigned int code,
+            const std::string& reason
+        ){
+            {
+                std::lock_guard< std::mutex > lock(state->mutex);
+                state->closed = true;
+                state->condition.notify_all();
+            }
+            std::lock_guard< std::mutex > lock(measurements->mutex);
+            ++measurements->closed;
+        };
+        WebSocketOpener opener;
+        opener.Start(client, url, std::move(wsDelegates), nullptr);
+        if (AwaitOpen(opener, shutDown) != WebSocketOpener::State::Open) {
+            if (!shutDown) {
+                diagnosticMessageDelegate(
+                    "WsTalk",
+                    SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                    "unable to open sender WebSocket: " + opener.GetError()
+                );
+            }
+            return false;
+        }
+        sender.ws = opener.GetWebSocket();
+        Json::Value request(Json::Value::Type::Object);
+        request.Set("Type", "GetAvailableNickNames");
+        sender.ws->SendText(request.ToEncoding());
+        Json::Value reply;
+        if (!AwaitReply(sender, "AvailableNickNames", reply)) {
+            diagnosticMessageDelegate(
+                "WsTalk",
+                SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                "no list of available nicknames received from chat room"
+            );
+            return false;
+        }
+        const auto nicknames = reply["AvailableNickNames"];
+        for (size_t i = 0; i < nicknames.GetSize(); ++i) {
+            const std::string nickname = nicknames[i];
+            if (nickname.empty()) {
+                continue;
+            }
+            Json::Value setNickname(Json::Value::Type::Object);
+            setNickname.Set("Type", "SetNickName");
+            setNickname.Set("NickName", nickname);
+            sender.ws->SendText(setNickname.ToEncoding());
+            if (!AwaitReply(sender, "SetNickNameResult", reply)) {
+                diagnosticMessageDelegate(
+                    "WsTalk",
+                    SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                    "no reply received from chat room to setting nickname"
+                );
+                return false;
+            }
+            if ((bool)reply["Success"]) {
+                sender.nickname = nickname;
+                return true;
+            }
+        }
+        diagnosticMessageDelegate(
+            "WsTalk",
+            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+            "chat room has no nickname available for another sender"
+        );
+        return false;
+    }
+
+    /**
+     * This function starts opening a WebSocket for a listener.  Every tell
+     * sent for the measurement received by the listener is recorded.
+     *
+     * @param[in,out] client
+     *     This is the client to use to connect to the server.
+     *
+     * @param[in] url
+     *     This is the URL of the chat room to which to connect.
+     *
+     * @param[in] numSenders
+     *     This is the number of senders.
+     *
+     * @param[in,out] listener
+     *     This is the listener to start.
+     *
+     * @param[in] measurements
+     *     This is where to record what the listener receives.
+     */
+    void StartListener(
+        Http::Client& client,
+        const Uri::Uri& url,
+        size_t numSenders,
+        Listener& listener,
+        std::shared_ptr< Measurements > measurements
+    ) {
+        const auto state = listener.state;
+        state->lastSequences.assign(numSenders, 0);
+        WebSockets::WebSocket::Delegates wsDelegates;
+        wsDelegates.text = [state, measurements](const std::string& data){
+            const auto received = Nanoseconds(Clock::now());
+            const auto message = Json::Value::FromEncoding(data);
+            if (
+                !message.Has("Type")
+                || !message.Has("Tell")
+                || ((std::string)message["Type"] != "Tell")
+            ) {
+                return;
+            }
+            const std::string tell = message["Tell"];
+            size_t phase, sender;
+            uint64_t sequence, sent;
+            if (
+                (sscanf(tell.c_str(), TELL_SCAN_FORMAT, &phase, &sender, &sequence, &sent) != 4)
+                || (sender >= state->lastSequences.size())
+            ) {
+                return;
+            }
+            std::lock_guard< std::mutex > lock(measurements->mutex);
+            if (phase != measurements->phase) {
+                ++measurements->late;
+                return;
+            }
+            auto& lastSequence = state->lastSequences[sender];
+            if (sequence <= lastSequence) {
+                ++measurements->reordered;
+            } else {
+                lastSequence = sequence;
+            }
+            ++measurements->delivered;
+            measurements->latencies.push_back(
+                (received > sent)
+                ? (double)(received - sent) / 1e6
+                : 0.0
+            );
+        };
+        wsDelegates.close = [state, measurements](
+            unsigned int code,
+            const std::string& reason
+        ){
+            std::lock_guard< std::mutex > lock(measurements->mutex);
+            if (!state->closing) {
+                ++measurements->dropped;
+            }
+            ++measurements->closed;
+        };
+        listener.opener.Start(client, url, std::move(wsDelegates), nullptr);
+    }
+
+    /**
+     * This function waits the given number of seconds, or until
+     * the given flag is set.
+     *
+     * @param[in] seconds
+     *     This is the number of seconds to wait.
+     *
+     * @param[in] shutDown
+     *     This is a flag which is set when the wait should be canceled.
+     */
+    void Wait(
+        double seconds,
+        const bool& shutDown
+    ) {
+        const auto deadline = Clock::now() + std::chrono::duration_cast< Clock::duration >(
+            std::chrono::duration< double >(seconds)
+        );
+        while (
+            !shutDown
+            && (Clock::now() < deadline)
+        ) {
+            std::this_thread::sleep_for(TICK);
+        }
+    }
+
+}
+
+bool RunFanOut(
+    Http::Client& client,
+    const Uri::Uri& url,
+    const FanOutConfiguration& configuration,
+    const bool& shutDown,
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+) {
+    if (configuration.rate <= 0.0) {
+        diagnosticMessageDelegate(
+            "WsTalk",
+            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+            "tell rate must be greater than zero"
+        );
+        return false;
+    }
+    const auto measurements = std::make_shared< Measurements >();
+    std::vector< Sender > senders(configuration.senders);
+    std::vector< Listener > listeners;
+    listeners.reserve(configuration.listeners.empty() ? 0 : configuration.listeners.back());
+    const auto sendInterval = std::max(
+        Clock::duration(1),
+        std::chrono::duration_cast< Clock::duration >(
+            std::chrono::duration< double >(1.0 / configuration.rate)
+        )
+    );
+    std::map< std::string, size_t > errors;
+    size_t opening = 0;
+    size_t failed = 0;
+    bool succeeded = true;
+
+    // Open the senders one at a time, since each one needs to take
+    // a nickname not taken by the others.
+    diagnosticMessageDelegate(
+        "WsTalk",
+        3,
+        StringExtensions::sprintf(
+            "Setting up %zu senders in '%s'...",
+            configuration.senders,
+            url.GenerateString().c_str()
+        )
+    );
+    for (auto& sender: senders) {
+        if (
+            !SetUpSender(
+                client,
+                url,
+                sender,
+                measurements,
+                shutDown,
+                diagnosticMessageDelegate
+            )
+        ) {
+            succeeded = false;
+            break;
+        }
+    }
+
+    // Measure each room size in turn.
+    if (succeeded) {
+        printf("listeners  room     tells   received      lost reordered       p50       p90       p99       max (ms)\n");
+    }
+    for (size_t phase = 1; succeeded && (phase <= configuration.listeners.size()); ++phase) {
+        const auto numListeners = configuration.listeners[phase - 1];
+
+        // Add listeners to the room, ramping up gradually.
+        const auto rampStart = Clock::now();
+        const auto rampFirst = listeners.size();
+        while (
+            !shutDown
+            && (
+                (listeners.size() < numListeners)
+                || (opening > 0)
+            )
+        ) {
+            size_t due = numListeners;
+            if (configuration.rampRate > 0.0) {
+                due = std::min(
+                    due,
+                    rampFirst + (size_t)(
+                        std::chrono::duration< double >(Clock::now() - rampStart).count()
+                        * configuration.rampRate
+                    ) + 1
+                );
+            }
+            while (listeners.size() < due) {
+                listeners.emplace_back();
+                StartListener(
+                    client,
+                    url,
+                    configuration.senders,
+                    listeners.back(),
+                    measurements
+                );
+                ++opening;
+            }
+            for (auto& listener: listeners) {
+                if (!listener.opening) {
+                    continue;
+                }
+                switch (listener.opener.Await(std::chrono::milliseconds(0))) {
+                    case WebSocketOpener::State::Open: {
+                        listener.opening = false;
+                        listener.ws = listener.opener.GetWebSocket();
+                        --opening;
+                    } break;
+
+                    case WebSocketOpener::State::Failed: {
+                        listener.opening = false;
+                        ++errors[listener.opener.GetError()];
+                        --opening;
+                        ++failed;
+                    } break;
+
+                    default: break;
+                }
+            }
+            std::this_thread::sleep_for(TICK);
+        }
+        if (shutDown) {
+            break;
+        }
+
+        // Start the measurement for this room size.
+        size_t listening;
+        {
+            std::lock_guard< std::mutex > lock(measurements->mutex);
+            listening = listeners.size() - failed - measurements->dropped;
+            measurements->phase = phase;
+            measurements->latencies.clear();
+            measurements->delivered = 0;
+            measurements->reordered = 0;
+        }
+
+        // Have the senders send tells, spread evenly over each interval.
+        uint64_t sent = 0;
+        const auto sendStart = Clock::now();
+        const auto sendEnd = sendStart + std::chrono::duration_cast< Clock::duration >(
+            std::chrono::duration< double >(configuration.duration)
+        );
+        for (size_t i = 0; i < senders.size(); ++i) {
+            senders[i].nextSend = sendStart + sendInterval * i / senders.size();
+        }
+        while (
+            !shutDown
+            && (Clock::now() < sendEnd)
+        ) {
+            const auto now = Clock::now();
+            for (size_t i = 0; i < senders.size(); ++i) {
+                auto& sender = senders[i];
+                if (now < sender.nextSend) {
+                    continue;
+                }
+
+                // Send every tell which has come due since the last pass,
+                // so that rates faster than one tell per tick aren't
+                // quietly capped at one per tick.
+                do {
+                    Json::Value tell(Json::Value::Type::Object);
+                    tell.Set("Type", "Tell");
+                    tell.Set(
+                        "Tell",
+                        StringExtensions::sprintf(
+                            TELL_FORMAT,
+                            phase,
+                            i,
+                            sender.nextSequence++,
+                            Nanoseconds(Clock::now())
+                        )
+                    );
+                    sender.ws->SendText(tell.ToEncoding());
+                    ++sent;
+                    sender.nextSend += sendInterval;
+                } while (sender.nextSend <= now);
+            }
+            std::this_thread::sleep_for(TICK);
+        }
+
+        // Wait for tells still on their way, and then end the measurement.
+        Wait(configuration.drainTime, shutDown);
+        std::vector< double > latencies;
+        uint64_t delivered, reordered;
+        {
+            std::lock_guard< std::mutex > lock(measurements->mutex);
+            measurements->phase = 0;
+            latencies.swap(measurements->latencies);
+            delivered = measurements->delivered;
+            reordered = measurements->reordered;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        const uint64_t expected = sent * listening;
+        printf(
+            "%9zu %5zu %9" PRIu64 " %10" PRIu64 " %9" PRIu64 " %9" PRIu64 " %9.2f %9.2f %9.2f %9.2f\n",
+            listening,
+            listening + senders.size(),
+            sent,
+            delivered,
+            (expected > delivered) ? expected - delivered : 0,
+            reordered,
+            Percentile(latencies, 50.0),
+            Percentile(latencies, 90.0),
+            Percentile(latencies, 99.0),
+            (latencies.empty() ? 0.0 : latencies.back())
+        );
+    }
+    if (shutDown) {
+        diagnosticMessageDelegate(
+            "WsTalk",
+            SystemAbstractions::DiagnosticsSender::Levels::WARNING,
+            "Measurement canceled"
+        );
+    }
+
+    // Close every WebSocket still open, and wait for the server
+    // to close its ends.
+    size_t open = 0;
+    {
+        std::lock_guard< std::mutex > lock(measurements->mutex);
+        for (auto& listener: listeners) {
+            if (listener.ws != nullptr) {
+                listener.state->closing = true;
+                ++open;
+            }
+        }
+    }
+    for (auto& listener: listeners) {
+        if (listener.ws != nullptr) {
+            listener.ws->Close(1000, "Kthxbye");
+        }
+    }
+    for (auto& sender: senders) {
+        if (sender.ws != nullptr) {
+            sender.ws->Close(1000, "Kthxbye");
+            ++open;
+        }
+    }
+    const auto closeDeadline = Clock::now() + CLOSE_TIMEOUT;
+    for (;;) {
+        {
+            std::lock_guard< std::mutex > lock(measurements->mutex);
+            if (measurements->closed >= open) {
+                break;
+            }
+        }
+        if (Clock::now() >= closeDeadline) {
+            diagnosticMessageDelegate(
+                "WsTalk",
+                SystemAbstractions::DiagnosticsSender::Levels::WARNING,
+                "Timed out waiting for WebSockets to close on server end"
+            );
+            break;
+        }
+        std::this_thread::sleep_for(TICK);
+    }
+    listeners.clear();
+    senders.clear();
+
+    // Report anything which went wrong along the way.
+    std::lock_guard< std::mutex > lock(measurements->mutex);
+    if (
+        (failed > 0)
+        || (measurements->dropped > 0)
+        || (measurements->late > 0)
+    ) {
+        printf(
+            "\n%zu listeners failed to open, %zu dropped by server; %" PRIu64 " tells arrived too late to count\n",
+            failed,
+            measurements->dropped,
+            measurements->late
+        );
+        for (const auto& error: errors) {
+            printf("  %zu x %s\n", error.second, error.first.c_str());
+        }
+    }
+    return succeeded;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+/**
+ * @file FanOutLatency.hpp
+ *
+ * This module declares the function used to measure how long it takes
+ * a tell in a chat room to reach every other member of the room, for
+ * rooms of different sizes.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <Http/Client.hpp>
+#include <stddef.h>
+#include <SystemAbstractions/DiagnosticsSender.hpp>
+#include <Uri/Uri.hpp>
+#include <vector>
+
+/**
+ * This holds the settings which control the measurement of
+ * chat room fan-out latency.
+ */
+struct FanOutConfiguration {
+    /**
+     * These are the numbers of listeners for which to measure latency,
+     * in increasing order.  Listeners are added to the room between
+     * measurements, so that each measurement is of a larger room.
+     */
+    std::vector< size_t > listeners;
+
+    /**
+     * This is the number of senders.  Each sender takes one of the
+     * nicknames the chat room has available.
+     */
+    size_t senders = 1;
+
+    /**
+     * This is the number of tells each sender sends per second.
+     */
+    double rate = 0.5;
+
+    /**
+     * This is the number of listeners to start opening per second.
+     * If zero, all of them are started at once.
+     */
+    double rampRate = 50.0;
+
+    /**
+     * This is the number of seconds to send tells for each room size.
+     */
+    double duration = 10.0;
+
+    /**
+     * This is the number of seconds to wait, after the last tell sent for
+     * a room size, for the tells still on their way to arrive.
+     */
+    double drainTime = 2.0;
+};
+
+/**
+ * This function opens listener and sender WebSockets to the chat room
+ * at the given URL.  For each configured room size, listeners are added
+ * until the room has that many, and then the senders send tells, each
+ * carrying a sequence number and the time it was sent.  The latency of
+ * every tell received by every listener is recorded, along with the
+ * number of tells lost or received out of order.  A line of percentiles
+ * is printed for each room size.
+ *
+ * @param[in,out] client
+ *     This is the client to use to connect to the server.
+ *
+ * @param[in] url
+ *     This is the URL of the chat room to which to connect.
+ *
+ * @param[in] configuration
+ *     This holds the settings which control the measurement.
+ *
+ * @param[in] shutDown
+ *     This is a flag which is set when the measurement should be
+ *     stopped early.
+ *
+ * @param[in] diagnosticMessageDelegate
+ *     This is the function to call to publish any diagnostic messages.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool RunFanOut(
+    Http::Client& client,
+    const Uri::Uri& url,
+    const FanOutConfiguration& configuration,
+    const bool& shutDown,
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+);
@@ -0,0 +1,136 @@
+/**
+ * @file HandshakeBenchmark.cpp
+ *
+ * This module contains the implementation of the function used to measure
+ * how long it takes, and how much processor time, to set up each new
+ * WebSocket connection, including its TCP and TLS handshakes.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "HandshakeBenchmark.hpp"
+#include "HdrHistogram.hpp"
+#include "ProcessCpuTime.hpp"
+#include "WebSocketOpener.hpp"
+
+#include <chrono>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <StringExtensions/StringExtensions.hpp>
+
+namespace {
+
+    /**
+     * This is the type of clock used to time everything.
+     */
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * This is the highest time, in microseconds, which can be recorded
+     * for a WebSocket to open.
+     */
+    constexpr uint64_t HIGHEST_OPEN_TIME = 60 * 1000 * 1000;
+
+    /**
+     * This is the number of significant digits kept of each time
+     * recorded for a WebSocket to open.
+     */
+    constexpr int OPEN_TIME_SIGNIFICANT_DIGITS = 3;
+
+}
+
+bool RunHandshakeBenchmark(
+    Http::Client& client,
+    const Uri::Uri& url,
+    const HandshakeConfiguration& configuration,
+    const bool& shutDown,
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+) {
+    const auto scheme = url.GetScheme();
+    diagnosticMessageDelegate(
+        "WsTalk",
+        3,
+        StringExtensions::sprintf(
+            "Opening %zu WebSockets to '%s' (%s), one at a time...",
+            configuration.handshakes,
+            url.GenerateString().c_str(),
+            (
+                ((scheme == "wss") || (scheme == "https"))
+                ? "TLS"
+                : "plain TCP"
+            )
+        )
+    );
+    HdrHistogram openTimes(1, HIGHEST_OPEN_TIME, OPEN_TIME_SIGNIFICANT_DIGITS);
+    bool firstOpened = false;
+    uint64_t firstOpenTime = 0;
+    double firstCpuTime = 0.0;
+    double cpuTime = 0.0;
+    uint64_t failures = 0;
+    for (size_t i = 0; i < configuration.handshakes; ++i) {
+        if (shutDown) {
+            break;
+        }
+        const auto cpuStart = GetProcessCpuTime();
+        const auto start = Clock::now();
+        WebSocketOpener opener;
+        opener.Start(client, url, WebSockets::WebSocket::Delegates(), nullptr);
+        auto openState = WebSocketOpener::State::Opening;
+        while (
+            !shutDown
+            && (openState == WebSocketOpener::State::Opening)
+        ) {
+            openState = opener.Await(std::chrono::milliseconds(100));
+        }
+        const auto openTime = (uint64_t)std::chrono::duration_cast< std::chrono::microseconds >(
+            Clock::now() - start
+        ).count();
+        const auto openCpuTime = GetProcessCpuTime() - cpuStart;
+        if (openState != WebSocketOpener::State::Open) {
+            if (!shutDown) {
+                diagnosticMessageDelegate(
+                    "WsTalk",
+                    SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                    opener.GetError()
+                );
+                ++failures;
+            }
+            continue;
+        }
+        opener.GetWebSocket()->Close(1000, "Kthxbye");
+        if (!firstOpened) {
+            // The first WebSocket to open, not merely the first tried,
+            // is the one which pays for everything done only once.
+            firstOpened = true;
+            firstOpenTime = openTime;
+            firstCpuTime = openCpuTime;
+        } else {
+            openTimes.Record(openTime);
+            cpuTime += openCpuTime;
+        }
+    }
+    printf(
+        "\nWebSockets: %" PRIu64 " opened, %" PRIu64 " failed\n",
+        openTimes.GetCount() + (firstOpened ? 1 : 0),
+        failures
+    );
+    if (firstOpened) {
+        printf(
+            "First: %.3f ms, CPU %.3f ms\n",
+            (double)firstOpenTime / 1000.0,
+            firstCpuTime * 1000.0
+        );
+    }
+    if (openTimes.GetCount() > 0) {
+        printf(
+            "Rest:  p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms, CPU %.3f ms each\n",
+            (double)openTimes.GetValueAtPercentile(50.0) / 1000.0,
+            (double)openTimes.GetValueAtPercentile(90.0) / 1000.0,
+            (double)openTimes.GetValueAtPercentile(99.0) / 1000.0,
+            (double)openTimes.GetMax() / 1000.0,
+            cpuTime * 1000.0 / (double)openTimes.GetCount()
+        );
+    }
+    return (failures == 0);
+}
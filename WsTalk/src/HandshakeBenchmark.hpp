@@ -0,0 +1,62 @@
+#pragma once
+
+/**
+ * @file HandshakeBenchmark.hpp
+ *
+ * This module declares the function used to measure how long it takes,
+ * and how much processor time, to set up each new WebSocket connection,
+ * including its TCP and TLS handshakes.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <Http/Client.hpp>
+#include <stddef.h>
+#include <SystemAbstractions/DiagnosticsSender.hpp>
+#include <Uri/Uri.hpp>
+
+/**
+ * This holds the settings which control the handshake benchmark.
+ */
+struct HandshakeConfiguration {
+    /**
+     * This is the number of WebSockets to open, one after another.
+     */
+    size_t handshakes = 100;
+};
+
+/**
+ * This function opens WebSockets to the server at the given URL, one at a
+ * time, closing each once it's open, and measures how long each took to
+ * open, from the start of the TCP connection, through the TLS handshake,
+ * if any, to the server accepting the upgrade.  At the end, percentiles of
+ * the times taken and the processor time the client spent on each are
+ * printed, with the first WebSocket, which also pays for anything set up
+ * only once, reported on its own.
+ *
+ * @param[in,out] client
+ *     This is the client to use to connect to the server.
+ *
+ * @param[in] url
+ *     This is the URL of the server to which to connect.
+ *
+ * @param[in] configuration
+ *     These are the settings which control the benchmark.
+ *
+ * @param[in] shutDown
+ *     This is a flag which is set when the benchmark should stop early.
+ *
+ * @param[in] diagnosticMessageDelegate
+ *     This is the function to call to publish any diagnostic messages.
+ *
+ * @return
+ *     An indication of whether or not every WebSocket was opened
+ *     is returned.
+ */
+bool RunHandshakeBenchmark(
+    Http::Client& client,
+    const Uri::Uri& url,
+    const HandshakeConfiguration& configuration,
+    const bool& shutDown,
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+);
@@ -0,0 +1,267 @@
+/**
+ * @file HdrHistogram.cpp
+ *
+ * This module contains the implementation of the HdrHistogram class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "HdrHistogram.hpp"
+
+#include <algorithm>
+#include <math.h>
+#include <stddef.h>
+#include <vector>
+
+namespace {
+
+    /**
+     * This function returns the number of bits needed to hold
+     * the given value.
+     *
+     * @param[in] value
+     *     This is the value whose bits to count.
+     *
+     * @return
+     *     The number of bits needed to hold the given value is returned.
+     */
+    int BitLength(uint64_t value) {
+        int bits = 0;
+        for (int shift = 32; shift > 0; shift /= 2) {
+            if ((value >> shift) != 0) {
+                value >>= shift;
+                bits += shift;
+            }
+        }
+        return bits + (int)value;
+    }
+
+}
+
+/**
+ * This contains the private properties of a HdrHistogram class instance.
+ */
+struct HdrHistogram::Impl {
+    // Properties
+
+    /**
+     * This is the highest value which can be recorded.
+     */
+    uint64_t highest = 0;
+
+    /**
+     * This is the base-2 logarithm of the lowest value which
+     * can be told apart from zero.
+     */
+    int unitMagnitude = 0;
+
+    /**
+     * This is the base-2 logarithm of half the number of sub-buckets
+     * in each bucket.
+     */
+    int subBucketHalfCountMagnitude = 0;
+
+    /**
+     * This is half the number of sub-buckets in each bucket.  Only the
+     * upper half of the sub-buckets of every bucket but the first are
+     * kept, since the lower half overlap the bucket before.
+     */
+    uint64_t subBucketHalfCount = 0;
+
+    /**
+     * This is the mask which selects the bits of a value which
+     * select a sub-bucket within the first bucket.
+     */
+    uint64_t subBucketMask = 0;
+
+    /**
+     * These are the counts of values recorded in each sub-bucket.
+     */
+    std::vector< uint64_t > counts;
+
+    /**
+     * This is the number of values recorded.
+     */
+    uint64_t total = 0;
+
+    /**
+     * This is the lowest value recorded.
+     */
+    uint64_t min = 0;
+
+    /**
+     * This is the highest value recorded.
+     */
+    uint64_t max = 0;
+
+    /**
+     * This is the sum of all the values recorded, used to compute
+     * the mean.
+     */
+    double sum = 0.0;
+
+    // Methods
+
+    /**
+     * This method returns the index of the count for the given value.
+     *
+     * @param[in] value
+     *     This is the value whose count to find.
+     *
+     * @return
+     *     The index of the count for the given value is returned.
+     */
+    size_t GetCountIndex(uint64_t value) const {
+        const auto bucketIndex = (
+            BitLength(value | subBucketMask)
+            - (unitMagnitude + subBucketHalfCountMagnitude + 1)
+        );
+        const auto subBucketIndex = value >> (bucketIndex + unitMagnitude);
+        return (size_t)(
+            ((uint64_t)(bucketIndex + 1) << subBucketHalfCountMagnitude)
+            + (subBucketIndex - subBucketHalfCount)
+        );
+    }
+
+    /**
+     * This method returns the highest value which is counted
+     * at the given index.
+     *
+     * @param[in] index
+     *     This is the index of the count.
+     *
+     * @return
+     *     The highest value counted at the given index is returned.
+     */
+    uint64_t GetHighestValueAt(size_t index) const {
+        int bucketIndex = (int)(index >> subBucketHalfCountMagnitude) - 1;
+        uint64_t subBucketIndex = (index & (subBucketHalfCount - 1)) + subBucketHalfCount;
+        if (bucketIndex < 0) {
+            subBucketIndex -= subBucketHalfCount;
+            bucketIndex = 0;
+        }
+        const auto shift = bucketIndex + unitMagnitude;
+        return ((subBucketIndex + 1) << shift) - 1;
+    }
+};
+
+HdrHistogram::~HdrHistogram() noexcept = default;
+HdrHistogram::HdrHistogram(HdrHistogram&&) noexcept = default;
+HdrHistogram& HdrHistogram::operator=(HdrHistogram&&) noexcept = default;
+
+HdrHistogram::HdrHistogram(
+    uint64_t lowest,
+    uint64_t highest,
+    int significantDigits
+)
+    : impl_(new Impl())
+{
+    lowest = std::max(lowest, (uint64_t)1);
+    highest = std::max(highest, 2 * lowest);
+    significantDigits = std::min(std::max(significantDigits, 1), 5);
+    impl_->highest = highest;
+    impl_->unitMagnitude = BitLength(lowest) - 1;
+
+    // Each bucket needs enough sub-buckets to tell apart values which
+    // differ in their last significant digit, at the top of the bucket.
+    const auto largestValueWithSingleUnitResolution = 2 * (uint64_t)pow(10.0, significantDigits);
+    const auto subBucketCountMagnitude = BitLength(largestValueWithSingleUnitResolution - 1);
+    impl_->subBucketHalfCountMagnitude = std::max(subBucketCountMagnitude, 2) - 1;
+    impl_->subBucketHalfCount = (uint64_t)1 << impl_->subBucketHalfCountMagnitude;
+    const auto subBucketCount = impl_->subBucketHalfCount * 2;
+    impl_->subBucketMask = (subBucketCount - 1) << impl_->unitMagnitude;
+
+    // Add buckets, each covering twice the range of the one before,
+    // until the highest value is covered.
+    size_t bucketCount = 1;
+    auto smallestUntrackableValue = subBucketCount << impl_->unitMagnitude;
+    while (smallestUntrackableValue <= highest) {
+        if (smallestUntrackableValue > UINT64_MAX / 2) {
+            ++bucketCount;
+            break;
+        }
+        smallestUntrackableValue <<= 1;
+        ++bucketCount;
+    }
+    impl_->counts.resize((bucketCount + 1) * impl_->subBucketHalfCount);
+}
+
+void HdrHistogram::Record(uint64_t value) {
+    value = std::min(value, impl_->highest);
+    const auto index = std::min(impl_->GetCountIndex(value), impl_->counts.size() - 1);
+    ++impl_->counts[index];
+    if (
+        (impl_->total == 0)
+        || (value < impl_->min)
+    ) {
+        impl_->min = value;
+    }
+    impl_->max = std::max(impl_->max, value);
+    impl_->sum += (double)value;
+    ++impl_->total;
+}
+
+void HdrHistogram::Add(const HdrHistogram& other) {
+    if (other.impl_->total == 0) {
+        return;
+    }
+    const auto size = std::min(impl_->counts.size(), other.impl_->counts.size());
+    for (size_t i = 0; i < size; ++i) {
+        impl_->counts[i] += other.impl_->counts[i];
+    }
+    if (
+        (impl_->total == 0)
+        || (other.impl_->min < impl_->min)
+    ) {
+        impl_->min = other.impl_->min;
+    }
+    impl_->max = std::max(impl_->max, other.impl_->max);
+    impl_->sum += other.impl_->sum;
+    impl_->total += other.impl_->total;
+}
+
+void HdrHistogram::Reset() {
+    std::fill(impl_->counts.begin(), impl_->counts.end(), 0);
+    impl_->total = 0;
+    impl_->min = 0;
+    impl_->max = 0;
+    impl_->sum = 0.0;
+}
+
+uint64_t HdrHistogram::GetCount() const {
+    return impl_->total;
+}
+
+uint64_t HdrHistogram::GetMin() const {
+    return impl_->min;
+}
+
+uint64_t HdrHistogram::GetMax() const {
+    return impl_->max;
+}
+
+double HdrHistogram::GetMean() const {
+    if (impl_->total == 0) {
+        return 0.0;
+    }
+    return impl_->sum / (double)impl_->total;
+}
+
+uint64_t HdrHistogram::GetValueAtPercentile(double percentile) const {
+    if (impl_->total == 0) {
+        return 0;
+    }
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    const auto countAtPercentile = std::max(
+        (uint64_t)1,
+        (uint64_t)(percentile / 100.0 * (double)impl_->total + 0.5)
+    );
+    uint64_t countSoFar = 0;
+    for (size_t i = 0; i < impl_->counts.size(); ++i) {
+        countSoFar += impl_->counts[i];
+        if (countSoFar >= countAtPercentile) {
+            return std::min(impl_->GetHighestValueAt(i), impl_->max);
+        }
+    }
+    return impl_->max;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+/**
+ * @file HdrHistogram.hpp
+ *
+ * This module declares the HdrHistogram class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <memory>
+#include <stdint.h>
+
+/**
+ * This is a high dynamic range (HDR) histogram, which counts values over
+ * a wide range using a fixed amount of memory, keeping a fixed number of
+ * significant decimal digits of every value.  Values are grouped in
+ * buckets which each cover twice the range of the one before, and each
+ * bucket is divided into the same number of evenly-spaced sub-buckets.
+ * Recording a value costs a few shifts and an increment, so the histogram
+ * can be kept for as long as a program runs.
+ */
+class HdrHistogram {
+    // Lifecycle management
+public:
+    ~HdrHistogram() noexcept;
+    HdrHistogram(const HdrHistogram&) = delete;
+    HdrHistogram(HdrHistogram&&) noexcept;
+    HdrHistogram& operator=(const HdrHistogram&) = delete;
+    HdrHistogram& operator=(HdrHistogram&&) noexcept;
+
+    // Public Methods
+public:
+    /**
+     * This constructs a histogram for the given range of values.
+     *
+     * @param[in] lowest
+     *     This is the lowest value which can be told apart from zero.
+     *     It must be at least one.
+     *
+     * @param[in] highest
+     *     This is the highest value which can be recorded.  Higher values
+     *     are recorded as this value.
+     *
+     * @param[in] significantDigits
+     *     This is the number of significant decimal digits of each value
+     *     to keep, from 1 to 5.
+     */
+    HdrHistogram(
+        uint64_t lowest,
+        uint64_t highest,
+        int significantDigits
+    );
+
+    /**
+     * This method records one occurrence of the given value.
+     *
+     * @param[in] value
+     *     This is the value to record.
+     */
+    void Record(uint64_t value);
+
+    /**
+     * This method adds all the values recorded in the given histogram,
+     * which must have been constructed with the same settings,
+     * to this histogram.
+     *
+     * @param[in] other
+     *     This is the histogram whose values to add.
+     */
+    void Add(const HdrHistogram& other);
+
+    /**
+     * This method forgets every value recorded.
+     */
+    void Reset();
+
+    /**
+     * This method returns the number of values recorded.
+     *
+     * @return
+     *     The number of values recorded is returned.
+     */
+    uint64_t GetCount() const;
+
+    /**
+     * This method returns the lowest value recorded.
+     *
+     * @return
+     *     The lowest value recorded, or zero if none were,
+     *     is returned.
+     */
+    uint64_t GetMin() const;
+
+    /**
+     * This method returns the highest value recorded.
+     *
+     * @return
+     *     The highest value recorded, or zero if none were,
+     *     is returned.
+     */
+    uint64_t GetMax() const;
+
+    /**
+     * This method returns the mean of the values recorded.
+     *
+     * @return
+     *     The mean of the values recorded, or zero if none were,
+     *     is returned.
+     */
+    double GetMean() const;
+
+    /**
+     * This method returns the value at the given percentile of the
+     * values recorded, to the number of significant digits kept.
+     *
+     * @param[in] percentile
+     *     This is the percentile to return, from 0 to 100.
+     *
+     * @return
+     *     The highest value which counts as equal to the value at the
+     *     given percentile, or zero if no values were recorded,
+     *     is returned.
+     */
+    uint64_t GetValueAtPercentile(double percentile) const;
+
+    // Private Properties
+private:
+    /**
+     * This is the type of structure that contains the private
+     * properties of the instance.  It is defined in the implementation
+     * and declared here to ensure that it is scoped inside the class.
+     */
+    struct Impl;
+
+    /**
+     * This contains the private properties of the instance.
+     */
+    std::unique_ptr< Impl > impl_;
+};
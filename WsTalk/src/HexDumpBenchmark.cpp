@@ -0,0 +1,274 @@
+/**
+ * @file HexDumpBenchmark.cpp
+ *
+ * This module contains the implementation of the function used to measure
+ * how fast the HexDumpNetworkConnectionDecorator formats hex dumps.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "HexDumpBenchmark.hpp"
+#include "HexDumpNetworkConnectionDecorator.hpp"
+
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <StringExtensions/StringExtensions.hpp>
+#include <SystemAbstractions/INetworkConnection.hpp>
+#include <vector>
+
+namespace {
+
+    /**
+     * This is the type of clock used to time everything.
+     */
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * These are the sizes, in bytes, of the messages to dump.
+     */
+    constexpr size_t MESSAGE_SIZES[] = {
+        64,
+        1024,
+        64 * 1024,
+        1024 * 1024,
+    };
+
+    /**
+     * This is the least amount of time, in seconds, to spend dumping
+     * messages of each size each way.
+     */
+    constexpr double MIN_MEASUREMENT_TIME = 0.5;
+
+    /**
+     * This is the number of messages which can be waiting to be dumped
+     * when measuring asynchronous hex dump delivery.
+     */
+    constexpr size_t ASYNC_QUEUE_CAPACITY = 1024;
+
+    /**
+     * This is a network connection which goes nowhere, used as the
+     * lower layer of the decorator measured, so that only the cost
+     * of the decorator itself is measured.
+     */
+    class NullNetworkConnection
+        : public SystemAbstractions::INetworkConnection
+    {
+        // SystemAbstractions::INetworkConnection
+    public:
+        virtual SystemAbstractions::DiagnosticsSender::UnsubscribeDelegate SubscribeToDiagnostics(
+            SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate delegate,
+            size_t minLevel = 0
+        ) override {
+            return []{};
+        }
+
+        virtual bool Connect(uint32_t peerAddress, uint16_t peerPort) override {
+            return true;
+        }
+
+        virtual bool Process(
+            MessageReceivedDelegate messageReceivedDelegate,
+            BrokenDelegate brokenDelegate
+        ) override {
+            return true;
+        }
+
+        virtual uint32_t GetPeerAddress() const override {
+            return 0;
+        }
+
+        virtual uint16_t GetPeerPort() const override {
+            return 0;
+        }
+
+        virtual bool IsConnected() const override {
+            return true;
+        }
+
+        virtual uint32_t GetBoundAddress() const override {
+            return 0;
+        }
+
+        virtual uint16_t GetBoundPort() const override {
+            return 0;
+        }
+
+        virtual void SendMessage(const std::vector< uint8_t >& message) override {
+        }
+
+        virtual void Close(bool clean = false) override {
+        }
+    };
+
+    /**
+     * Publish hex dump lines to show the contents of the given vector of
+     * data, formatting them with string streams the way the decorator used
+     * to, so the two can be compared.
+     *
+     * @param[in] data
+     *     This is the data to show in the hex dump.
+     *
+     * @param[in] hexDumpDelegate
+     *     This is the function to call to publish each line of the hex dump.
+     */
+    void StreamHexDump(
+        const std::vector< uint8_t >& data,
+        HexDumpNetworkConnectionDecorator::HexDumpDelegate hexDumpDelegate
+    ) {
+        hexDumpDelegate(
+            StringExtensions::sprintf(
+                "Sending %zu bytes:",
+                data.size()
+            )
+        );
+        std::ostringstream l, r, c;
+        for (size_t i = 0; i < data.size(); ++i) {
+            if ((i % 16) == 0) {
+                l = std::ostringstream();
+                r = std::ostringstream();
+                c = std::ostringstream();
+                l << std::hex << std::setw(4) << std::setfill('0') << i;
+            }
+            if ((i % 8) == 0) {
+                l << " ";
+            }
+            l << " " << std::hex << std::setw(2) << std::setfill('0') << (int)(uint8_t)data[i];
+            if (
+                (data[i] > 32)
+                && (data[i] < 127)
+            ) {
+                r << (char)data[i];
+            } else {
+                r << '.';
+            }
+            if (
+                (((i + 1) % 16) == 0)
+                || (i + 1 == data.size())
+            ) {
+                for (size_t j = 1; ((i + j) % 16) != 0; ++j) {
+                    if (((i + j) % 8) == 0) {
+                        l << " ";
+                    }
+                    l << "   ";
+                }
+                c << l.str() << "  " << r.str();
+                hexDumpDelegate(c.str());
+            }
+        }
+    }
+
+    /**
+     * This function repeatedly calls the given function until at least
+     * the minimum measurement time has passed, and returns the number
+     * of calls made per second.
+     *
+     * @param[in] dump
+     *     This is the function to call.
+     *
+     * @return
+     *     The number of calls made per second is returned.
+     */
+    double MeasureCallsPerSecond(std::function< void() > dump) {
+        const auto start = Clock::now();
+        size_t calls = 0;
+        double elapsed = 0.0;
+        do {
+            dump();
+            ++calls;
+            elapsed = std::chrono::duration< double >(Clock::now() - start).count();
+        } while (elapsed < MIN_MEASUREMENT_TIME);
+        return (double)calls / elapsed;
+    }
+
+}
+
+bool RunHexDumpBenchmark(
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+) {
+    const auto decorator = std::make_shared< HexDumpNetworkConnectionDecorator >();
+    std::string transcript;
+    bool keepTranscript = false;
+    const auto hexDumpDelegate = [&transcript, &keepTranscript](const std::string& lines){
+        if (keepTranscript) {
+            transcript += lines;
+            transcript += '\n';
+        }
+    };
+    decorator->Decorate(std::make_shared< NullNetworkConnection >(), hexDumpDelegate);
+    const auto asyncDecorator = std::make_shared< HexDumpNetworkConnectionDecorator >();
+    asyncDecorator->Decorate(
+        std::make_shared< NullNetworkConnection >(),
+        [](const std::string& lines){}
+    );
+    asyncDecorator->DeliverAsynchronously(
+        ASYNC_QUEUE_CAPACITY,
+        HexDumpNetworkConnectionDecorator::DropPolicy::DropNewest
+    );
+    bool matched = true;
+    printf("     size  stream MB/s   table MB/s  speedup  async ns/msg  dropped\n");
+    for (const auto messageSize: MESSAGE_SIZES) {
+        std::vector< uint8_t > message(messageSize);
+        for (size_t i = 0; i < messageSize; ++i) {
+            message[i] = (uint8_t)(i * 7 + i / 256);
+        }
+
+        // Check that both ways of dumping the message give the same lines.
+        keepTranscript = true;
+        StreamHexDump(message, hexDumpDelegate);
+        const auto streamTranscript = std::move(transcript);
+        transcript.clear();
+        decorator->SendMessage(message);
+        keepTranscript = false;
+        if (transcript != streamTranscript) {
+            diagnosticMessageDelegate(
+                "WsTalk",
+                SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                StringExtensions::sprintf(
+                    "hex dumps of %zu-byte message don't match",
+                    messageSize
+                )
+            );
+            matched = false;
+        }
+        transcript.clear();
+
+        // Time each way of dumping the message.
+        const auto streamRate = MeasureCallsPerSecond(
+            [&message, &hexDumpDelegate]{
+                StreamHexDump(message, hexDumpDelegate);
+            }
+        );
+        const auto tableRate = MeasureCallsPerSecond(
+            [&message, &decorator]{
+                decorator->SendMessage(message);
+            }
+        );
+        const auto droppedBefore = asyncDecorator->GetDroppedCount();
+        size_t asyncCalls = 0;
+        const auto asyncRate = MeasureCallsPerSecond(
+            [&message, &asyncDecorator, &asyncCalls]{
+                asyncDecorator->SendMessage(message);
+                ++asyncCalls;
+            }
+        );
+        const auto dropped = asyncDecorator->GetDroppedCount() - droppedBefore;
+        const auto megabytes = (double)messageSize / (1024.0 * 1024.0);
+        printf(
+            "%9zu %12.1f %12.1f %7.1fx %13.0f %7.1f%%\n",
+            messageSize,
+            streamRate * megabytes,
+            tableRate * megabytes,
+            tableRate / streamRate,
+            1e9 / asyncRate,
+            100.0 * (double)dropped / (double)asyncCalls
+        );
+    }
+    return matched;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+/**
+ * @file HexDumpBenchmark.hpp
+ *
+ * This module declares the function used to measure how fast the
+ * HexDumpNetworkConnectionDecorator formats hex dumps.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <SystemAbstractions/DiagnosticsSender.hpp>
+
+/**
+ * This function measures how fast the HexDumpNetworkConnectionDecorator
+ * formats hex dumps of messages of several sizes, compared with formatting
+ * them with string streams, the way the decorator used to.  The hex dumps
+ * made both ways are checked to match, and a line is printed for each
+ * message size giving the megabytes per second each way and the speedup.
+ * The line also gives the time each send takes when hex dumps are
+ * delivered asynchronously instead, and the share of them dropped
+ * because the decorator's queue was full.
+ *
+ * @param[in] diagnosticMessageDelegate
+ *     This is the function to call to publish any diagnostic messages.
+ *
+ * @return
+ *     An indication of whether or not the hex dumps made both
+ *     ways matched is returned.
+ */
+bool RunHexDumpBenchmark(
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+);
@@ -9,19 +9,319 @@
 
 #include "HexDumpNetworkConnectionDecorator.hpp"
 
-#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <inttypes.h>
 #include <memory>
-#include <sstream>
+#include <mutex>
+#include <stddef.h>
+#include <stdio.h>
 #include <string>
-#include <StringExtensions/StringExtensions.hpp>
+#include <thread>
 #include <vector>
 
+namespace {
+
+    /**
+     * This is the number of bytes shown on each line of a hex dump.
+     */
+    constexpr size_t BYTES_PER_LINE = 16;
+
+    /**
+     * This is the number of bytes in each group of bytes shown on a line
+     * of a hex dump, with an extra space between groups.
+     */
+    constexpr size_t BYTES_PER_GROUP = 8;
+
+    /**
+     * This is the most lines of a hex dump to publish in one batch.
+     */
+    constexpr size_t LINES_PER_BATCH = 256;
+
+    /**
+     * This is the fewest hexadecimal digits used to show the offset
+     * at the start of each line of a hex dump.
+     */
+    constexpr size_t MIN_OFFSET_DIGITS = 4;
+
+    /**
+     * This is the most hexadecimal digits which can be needed to show
+     * the offset at the start of each line of a hex dump.
+     */
+    constexpr size_t MAX_OFFSET_DIGITS = sizeof(size_t) * 2;
+
+    /**
+     * This is the width of the part of a line of a hex dump showing
+     * the bytes in hexadecimal, including the space before each byte
+     * and each group.
+     */
+    constexpr size_t HEX_COLUMN_WIDTH = (
+        BYTES_PER_LINE * 3
+        + BYTES_PER_LINE / BYTES_PER_GROUP
+    );
+
+    /**
+     * This is the longest a line of a hex dump can be, including
+     * the line feed separating it from the line before.
+     */
+    constexpr size_t MAX_LINE_LENGTH = (
+        1
+        + MAX_OFFSET_DIGITS
+        + HEX_COLUMN_WIDTH
+        + 2
+        + BYTES_PER_LINE
+    );
+
+    /**
+     * This is the longest the line introducing a hex dump can be.
+     */
+    constexpr size_t MAX_HEADER_LENGTH = 64;
+
+    /**
+     * These are the digits used to show numbers in hexadecimal.
+     */
+    constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+    /**
+     * This holds tables used to look up how to show each possible
+     * value of a byte in a hex dump.
+     */
+    struct HexDumpTables {
+        /**
+         * These are the two hexadecimal digits for each byte value.
+         */
+        char hex[256][2];
+
+        /**
+         * This is the character shown for each byte value in the part
+         * of a line showing the bytes as ASCII.
+         */
+        char ascii[256];
+
+        /**
+         * This constructor fills in the tables.
+         */
+        HexDumpTables() {
+            for (size_t value = 0; value < 256; ++value) {
+                hex[value][0] = HEX_DIGITS[value >> 4];
+                hex[value][1] = HEX_DIGITS[value & 0xF];
+                ascii[value] = (
+                    (
+                        (value > 32)
+                        && (value < 127)
+                    )
+                    ? (char)value
+                    : '.'
+                );
+            }
+        }
+    };
+
+    /**
+     * These are the tables used to look up how to show each possible
+     * value of a byte in a hex dump.
+     */
+    const HexDumpTables TABLES;
+
+    /**
+     * This is the longest the thread delivering hex dumps asynchronously
+     * sleeps before checking for more data to dump, in case it misses
+     * being woken up.
+     */
+    constexpr std::chrono::milliseconds WORKER_POLL_INTERVAL(10);
+
+    /**
+     * This is the size of the cache line assumed when keeping
+     * properties written by different threads apart.
+     */
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    /**
+     * This holds a copy of data which passed through the connection,
+     * waiting to be dumped.
+     */
+    struct DumpRecord {
+        /**
+         * This is the position in the queue for which the record is next
+         * ready to be filled (if equal to the position) or emptied (if one
+         * more than the position).
+         */
+        std::atomic< size_t > sequence;
+
+        /**
+         * This is what was done with the data ("Sending" or "Received").
+         */
+        const char* action = nullptr;
+
+        /**
+         * This is the number of bytes which passed through the connection.
+         */
+        size_t size = 0;
+
+        /**
+         * These are the bytes to dump, which may be fewer than those
+         * which passed through the connection.  The vector's storage is
+         * kept between uses of the record, so that copying the data
+         * rarely needs memory to be allocated.
+         */
+        std::vector< uint8_t > data;
+    };
+
+    /**
+     * This is a fixed-size queue of data waiting to be dumped, which any
+     * number of threads may push onto and pop from without taking locks.
+     * Each record holds a sequence number which tells threads whether it's
+     * ready to be filled or emptied for a given position in the queue,
+     * so that threads need only agree on positions (Dmitry Vyukov's
+     * bounded queue).
+     */
+    class DumpQueue {
+        // Public Methods
+    public:
+        /**
+         * This constructor sets up the queue to hold the given number
+         * of records.
+         *
+         * @param[in] capacity
+         *     This is the number of records the queue can hold,
+         *     which must be a power of two.
+         */
+        explicit DumpQueue(size_t capacity)
+            : records_(new DumpRecord[capacity])
+            , mask_(capacity - 1)
+        {
+            for (size_t i = 0; i < capacity; ++i) {
+                records_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            pushPosition_.store(0, std::memory_order_relaxed);
+            popPosition_.store(0, std::memory_order_relaxed);
+        }
+
+        /**
+         * This method adds a record to the back of the queue, unless
+         * the queue is full.
+         *
+         * @param[in] fill
+         *     This is the function to call to fill in the record added.
+         *
+         * @return
+         *     An indication of whether or not a record was added
+         *     is returned.
+         */
+        template< typename Fill > bool TryPush(Fill fill) {
+            auto position = pushPosition_.load(std::memory_order_relaxed);
+            DumpRecord* record;
+            for (;;) {
+                record = &records_[position & mask_];
+                const auto sequence = record->sequence.load(std::memory_order_acquire);
+                const auto difference = (intptr_t)sequence - (intptr_t)position;
+                if (difference == 0) {
+                    if (
+                        pushPosition_.compare_exchange_weak(
+                            position,
+                            position + 1,
+                            std::memory_order_relaxed
+                        )
+                    ) {
+                        break;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = pushPosition_.load(std::memory_order_relaxed);
+                }
+            }
+            fill(*record);
+            record->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * This method removes the record at the front of the queue,
+         * unless the queue is empty.
+         *
+         * @param[in] drain
+         *     This is the function to call with the record removed,
+         *     before it can be reused.
+         *
+         * @return
+         *     An indication of whether or not a record was removed
+         *     is returned.
+         */
+        template< typename Drain > bool TryPop(Drain drain) {
+            auto position = popPosition_.load(std::memory_order_relaxed);
+            DumpRecord* record;
+            for (;;) {
+                record = &records_[position & mask_];
+                const auto sequence = record->sequence.load(std::memory_order_acquire);
+                const auto difference = (intptr_t)sequence - (intptr_t)(position + 1);
+                if (difference == 0) {
+                    if (
+                        popPosition_.compare_exchange_weak(
+                            position,
+                            position + 1,
+                            std::memory_order_relaxed
+                        )
+                    ) {
+                        break;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = popPosition_.load(std::memory_order_relaxed);
+                }
+            }
+            drain(*record);
+            record->sequence.store(position + mask_ + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Private Properties
+    private:
+        /**
+         * These are the records of the queue.
+         */
+        std::unique_ptr< DumpRecord[] > records_;
+
+        /**
+         * This is used to turn a position in the queue into the index
+         * of its record.
+         */
+        size_t mask_;
+
+        /**
+         * This keeps the positions apart from the other properties,
+         * and from each other, so that threads pushing and popping
+         * don't slow each other down by sharing cache lines.
+         */
+        char padding1_[CACHE_LINE_SIZE];
+
+        /**
+         * This is the position of the next record to be added.
+         */
+        std::atomic< size_t > pushPosition_;
+
+        /**
+         * This keeps the push and pop positions apart.
+         */
+        char padding2_[CACHE_LINE_SIZE];
+
+        /**
+         * This is the position of the next record to be removed.
+         */
+        std::atomic< size_t > popPosition_;
+    };
+
+}
+
 struct HexDumpNetworkConnectionDecorator::Impl {
     // Properties
 
     /**
-     * This is the function to call whenever a line of a hex dump
-     * is published by the decorator.
+     * This is the function to call whenever lines of a hex dump
+     * are published by the decorator.
      */
     HexDumpDelegate hexDumpDelegate;
 
@@ -30,51 +330,328 @@ struct HexDumpNetworkConnectionDecorator::Impl {
      */
     std::shared_ptr< SystemAbstractions::INetworkConnection > lowerLayer;
 
+    /**
+     * This is used to keep hex dumps of data sent and data received
+     * from being formatted into the buffer at the same time, and from
+     * being published interleaved with each other.
+     */
+    std::mutex mutex;
+
+    /**
+     * If hex dumps are delivered asynchronously, this holds the data
+     * waiting to be dumped.
+     */
+    std::unique_ptr< DumpQueue > queue;
+
+    /**
+     * This determines what happens when data passes through the
+     * connection while the queue is full.
+     */
+    DropPolicy dropPolicy = DropPolicy::DropNewest;
+
+    /**
+     * This is the most bytes of each send or receive to copy into
+     * the queue, or zero to copy them all.
+     */
+    size_t maxBytesPerDump = 0;
+
+    /**
+     * This is the number of hex dumps dropped because the queue was full.
+     */
+    std::atomic< uint64_t > dropped{0};
+
+    /**
+     * This is the number of dropped hex dumps already reported
+     * by the worker thread.
+     */
+    uint64_t droppedReported = 0;
+
+    /**
+     * This is the thread which formats and delivers hex dumps
+     * asynchronously.
+     */
+    std::thread worker;
+
+    /**
+     * This is used with wakeCondition to let the worker thread sleep
+     * while there's nothing to dump.
+     */
+    std::mutex wakeMutex;
+
+    /**
+     * This is used to wake up the worker thread.
+     */
+    std::condition_variable wakeCondition;
+
+    /**
+     * This indicates whether or not the worker thread may be sleeping,
+     * so that threads passing data through the connection only bother
+     * to wake it up when it is.
+     */
+    std::atomic< bool > workerSleeping{false};
+
+    /**
+     * This is set when the worker thread should dump whatever is left
+     * in the queue and stop.
+     */
+    bool stopWorker = false;
+
+    /**
+     * This is where each batch of hex dump lines is formatted before
+     * being published.  It's allocated once, big enough for the largest
+     * batch, and reused.
+     */
+    std::string buffer;
+
     // Methods
 
+    /**
+     * This is the constructor of the structure.
+     */
+    Impl() {
+        buffer.reserve(MAX_HEADER_LENGTH + LINES_PER_BATCH * MAX_LINE_LENGTH);
+    }
+
+    /**
+     * This is the destructor of the structure.  It stops the worker
+     * thread, if one was started, after it dumps what's left in the queue.
+     */
+    ~Impl() noexcept {
+        if (!worker.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard< std::mutex > lock(wakeMutex);
+            stopWorker = true;
+            wakeCondition.notify_one();
+        }
+        worker.join();
+    }
+
+    /**
+     * This method formats the line of a hex dump showing the bytes
+     * at the given offset of the given data, at the given position.
+     *
+     * @param[in] data
+     *     This is the data to show in the hex dump.
+     *
+     * @param[in] offset
+     *     This is the offset of the first byte to show on the line.
+     *
+     * @param[in] line
+     *     This is where to format the line.  There must be room for
+     *     at least MAX_LINE_LENGTH - 1 characters.
+     *
+     * @return
+     *     The position just past the end of the line formatted is returned.
+     */
+    static char* FormatLine(
+        const std::vector< uint8_t >& data,
+        size_t offset,
+        char* line
+    ) {
+        size_t offsetDigits = MIN_OFFSET_DIGITS;
+        while (
+            (offsetDigits < MAX_OFFSET_DIGITS)
+            && ((offset >> (offsetDigits * 4)) != 0)
+        ) {
+            ++offsetDigits;
+        }
+        for (size_t i = offsetDigits; i > 0; --i) {
+            *line++ = HEX_DIGITS[(offset >> ((i - 1) * 4)) & 0xF];
+        }
+        const auto bytes = data.data() + offset;
+        const auto numBytes = std::min(BYTES_PER_LINE, data.size() - offset);
+        for (size_t i = 0; i < BYTES_PER_LINE; ++i) {
+            if ((i % BYTES_PER_GROUP) == 0) {
+                *line++ = ' ';
+            }
+            *line++ = ' ';
+            if (i < numBytes) {
+                *line++ = TABLES.hex[bytes[i]][0];
+                *line++ = TABLES.hex[bytes[i]][1];
+            } else {
+                *line++ = ' ';
+                *line++ = ' ';
+            }
+        }
+        *line++ = ' ';
+        *line++ = ' ';
+        for (size_t i = 0; i < numBytes; ++i) {
+            *line++ = TABLES.ascii[bytes[i]];
+        }
+        return line;
+    }
+
     /**
      * Publish hex dump lines to show the contents of the given
      * vector of data, in the form of hexadecimal and ASCII.
      *
+     * @param[in] action
+     *     This is what's being done with the data ("Sending" or
+     *     "Received"), used to introduce the hex dump.
+     *
      * @param[in] data
      *     This is the data to show in the hex dump.
-     *     This is the number of bytes to show in the hex dump.
-     */
-    void HexDump(const std::vector< uint8_t >& data) {
-        std::ostringstream l, r, c;
-        for (size_t i = 0; i < data.size(); ++i) {
-            if ((i % 16) == 0) {
-                l = std::ostringstream();
-                r = std::ostringstream();
-                c = std::ostringstream();
-                l << std::hex << std::setw(4) << std::setfill('0') << i;
-            }
-            if ((i % 8) == 0) {
-                l << " ";
+     *
+     * @param[in] size
+     *     This is the number of bytes which passed through the connection,
+     *     which is more than the number shown if only the first part
+     *     of the data was kept to be dumped.
+     */
+    void HexDump(
+        const char* action,
+        const std::vector< uint8_t >& data,
+        size_t size
+    ) {
+        std::lock_guard< std::mutex > lock(mutex);
+        char header[MAX_HEADER_LENGTH];
+        const auto headerLength = (
+            (data.size() < size)
+            ? snprintf(
+                header,
+                sizeof(header),
+                "%s %zu bytes (first %zu shown):",
+                action,
+                size,
+                data.size()
+            )
+            : snprintf(
+                header,
+                sizeof(header),
+                "%s %zu bytes:",
+                action,
+                size
+            )
+        );
+        buffer.assign(header, (size_t)headerLength);
+        size_t linesInBatch = 0;
+        for (size_t offset = 0; offset < data.size(); offset += BYTES_PER_LINE) {
+            if (linesInBatch == LINES_PER_BATCH) {
+                hexDumpDelegate(buffer);
+                buffer.clear();
+                linesInBatch = 0;
             }
-            l << " " << std::hex << std::setw(2) << std::setfill('0') << (int)(uint8_t)data[i];
-            if (
-                (data[i] > 32)
-                && (data[i] < 127)
-            ) {
-                r << (char)data[i];
-            } else {
-                r << '.';
+            const auto start = buffer.size();
+            buffer.resize(start + MAX_LINE_LENGTH);
+            auto line = &buffer[start];
+            if (start > 0) {
+                *line++ = '\n';
             }
-            if (
-                (((i + 1) % 16) == 0)
-                || (i + 1 == data.size())
-            ) {
-                for (size_t j = 0; ((i + j) % 16) != 0; ++j) {
-                    if (((i + j) % 8) == 0) {
-                        l << " ";
+            line = FormatLine(data, offset, line);
+            buffer.resize((size_t)(line - &buffer[0]));
+            ++linesInBatch;
+        }
+        hexDumpDelegate(buffer);
+    }
+
+    /**
+     * This method dumps the given data passing through the connection,
+     * either right away, or, if hex dumps are delivered asynchronously,
+     * by copying it into the queue for the worker thread to dump.
+     *
+     * @param[in] action
+     *     This is what's being done with the data ("Sending" or
+     *     "Received"), used to introduce the hex dump.
+     *
+     * @param[in] data
+     *     This is the data to dump.
+     */
+    void Dump(
+        const char* action,
+        const std::vector< uint8_t >& data
+    ) {
+        if (queue == nullptr) {
+            HexDump(action, data, data.size());
+            return;
+        }
+        const auto bytesToCopy = (
+            (maxBytesPerDump == 0)
+            ? data.size()
+            : std::min(data.size(), maxBytesPerDump)
+        );
+        const auto fill = [action, &data, bytesToCopy](DumpRecord& record){
+            record.action = action;
+            record.size = data.size();
+            record.data.assign(data.begin(), data.begin() + bytesToCopy);
+        };
+        while (!queue->TryPush(fill)) {
+            switch (dropPolicy) {
+                case DropPolicy::DropNewest: {
+                    ++dropped;
+                    return;
+                } break;
+
+                case DropPolicy::DropOldest: {
+                    if (queue->TryPop([](DumpRecord&){})) {
+                        ++dropped;
                     }
-                    l << "   ";
-                }
-                c << l.str() << "  " << r.str();
-                hexDumpDelegate(c.str());
+                } break;
+
+                case DropPolicy::Wait:
+                default: {
+                    WakeWorker();
+                    std::this_thread::yield();
+                } break;
+            }
+        }
+        WakeWorker();
+    }
+
+    /**
+     * This method wakes up the worker thread, if it may be sleeping.
+     */
+    void WakeWorker() {
+        if (workerSleeping.load()) {
+            std::lock_guard< std::mutex > lock(wakeMutex);
+            wakeCondition.notify_one();
+        }
+    }
+
+    /**
+     * This method publishes a line saying how many more hex dumps were
+     * dropped, if any were dropped since the last time it was called.
+     */
+    void ReportDrops() {
+        const auto droppedNow = dropped.load();
+        if (droppedNow == droppedReported) {
+            return;
+        }
+        char report[MAX_HEADER_LENGTH];
+        (void)snprintf(
+            report,
+            sizeof(report),
+            "(%" PRIu64 " hex dumps dropped)",
+            droppedNow - droppedReported
+        );
+        droppedReported = droppedNow;
+        hexDumpDelegate(report);
+    }
+
+    /**
+     * This method is called in a separate thread to dump the data
+     * copied into the queue.
+     */
+    void Work() {
+        const auto deliver = [this](DumpRecord& record){
+            HexDump(record.action, record.data, record.size);
+        };
+        for (;;) {
+            if (queue->TryPop(deliver)) {
+                continue;
             }
+            ReportDrops();
+            std::unique_lock< std::mutex > lock(wakeMutex);
+            if (stopWorker) {
+                break;
+            }
+            workerSleeping.store(true);
+            (void)wakeCondition.wait_for(lock, WORKER_POLL_INTERVAL);
+            workerSleeping.store(false);
+        }
+        while (queue->TryPop(deliver)) {
         }
+        ReportDrops();
     }
 
 };
@@ -96,6 +673,28 @@ void HexDumpNetworkConnectionDecorator::Decorate(
     impl_->hexDumpDelegate = hexDumpDelegate;
 }
 
+void HexDumpNetworkConnectionDecorator::DeliverAsynchronously(
+    size_t queueCapacity,
+    DropPolicy dropPolicy,
+    size_t maxBytesPerDump
+) {
+    if (impl_->worker.joinable()) {
+        return;
+    }
+    size_t capacity = 2;
+    while (capacity < queueCapacity) {
+        capacity <<= 1;
+    }
+    impl_->queue.reset(new DumpQueue(capacity));
+    impl_->dropPolicy = dropPolicy;
+    impl_->maxBytesPerDump = maxBytesPerDump;
+    impl_->worker = std::thread(&Impl::Work, impl_.get());
+}
+
+uint64_t HexDumpNetworkConnectionDecorator::GetDroppedCount() const {
+    return impl_->dropped.load();
+}
+
 SystemAbstractions::DiagnosticsSender::UnsubscribeDelegate HexDumpNetworkConnectionDecorator::SubscribeToDiagnostics(
     SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate delegate,
     size_t minLevel
@@ -120,13 +719,7 @@ bool HexDumpNetworkConnectionDecorator::Process(
         if (impl == nullptr) {
             return;
         }
-        impl->hexDumpDelegate(
-            StringExtensions::sprintf(
-                "Received %zu bytes:",
-                message.size()
-            )
-        );
-        impl->HexDump(message);
+        impl->Dump("Received", message);
         messageReceivedDelegate(message);
     };
     return impl_->lowerLayer->Process(decoratedMessageReceivedDelegate, brokenDelegate);
@@ -153,13 +746,7 @@ uint16_t HexDumpNetworkConnectionDecorator::GetBoundPort() const {
 }
 
 void HexDumpNetworkConnectionDecorator::SendMessage(const std::vector< uint8_t >& message) {
-    impl_->hexDumpDelegate(
-        StringExtensions::sprintf(
-            "Sending %zu bytes:",
-            message.size()
-        )
-    );
-    impl_->HexDump(message);
+    impl_->Dump("Sending", message);
     impl_->lowerLayer->SendMessage(message);
 }
 
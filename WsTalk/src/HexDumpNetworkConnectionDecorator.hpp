@@ -10,6 +10,8 @@
 
 #include <functional>
 #include <memory>
+#include <stddef.h>
+#include <stdint.h>
 #include <string>
 #include <SystemAbstractions/INetworkConnection.hpp>
 
@@ -23,16 +25,41 @@ class HexDumpNetworkConnectionDecorator
 // Types
 public:
     /**
-     * This is the type of function used to publish a line of a hex dump from
-     * the decorator.
+     * This is the type of function used to publish lines of a hex dump from
+     * the decorator.  Lines are published in batches, to keep the number of
+     * calls down for large messages.
      *
-     * @param[in] line
-     *     This is the line of hex dump published by the decorator.
+     * @param[in] lines
+     *     These are the lines of hex dump published by the decorator,
+     *     separated by line feeds, without a line feed after the last one.
      */
     typedef std::function<
-        void(const std::string& line)
+        void(const std::string& lines)
     > HexDumpDelegate;
 
+    /**
+     * These are the things the decorator can do when data passes through
+     * the connection while the queue of data waiting to be dumped
+     * asynchronously is full.
+     */
+    enum class DropPolicy {
+        /**
+         * Don't dump the new data.
+         */
+        DropNewest,
+
+        /**
+         * Throw away the oldest data waiting to be dumped to make room
+         * for the new data.
+         */
+        DropOldest,
+
+        /**
+         * Hold up the connection until there's room for the new data.
+         */
+        Wait,
+    };
+
     // Lifecycle management
 public:
     ~HexDumpNetworkConnectionDecorator() noexcept;
@@ -64,6 +91,42 @@ public:
         HexDumpDelegate hexDumpDelegate
     );
 
+    /**
+     * This method switches the decorator to formatting and delivering
+     * hex dumps on a thread of its own, rather than on the thread passing
+     * the data through the connection.  Data passing through is copied into
+     * a fixed-size queue, without taking any locks, and passed on at once.
+     * It should be called before any data passes through the connection.
+     *
+     * @param[in] queueCapacity
+     *     This is the number of sends and receives which can be waiting
+     *     to be dumped at once.  It's rounded up to a power of two.
+     *
+     * @param[in] dropPolicy
+     *     This determines what happens when data passes through the
+     *     connection while the queue is full.
+     *
+     * @param[in] maxBytesPerDump
+     *     This is the most bytes of each send or receive to copy and dump.
+     *     The rest are left out of the hex dump.  If zero, all the bytes
+     *     are dumped.
+     */
+    void DeliverAsynchronously(
+        size_t queueCapacity,
+        DropPolicy dropPolicy,
+        size_t maxBytesPerDump = 65536
+    );
+
+    /**
+     * This method returns the number of sends and receives which
+     * weren't dumped, or were thrown away before being dumped,
+     * because the queue of data waiting to be dumped was full.
+     *
+     * @return
+     *     The number of hex dumps dropped is returned.
+     */
+    uint64_t GetDroppedCount() const;
+
     // SystemAbstractions::INetworkConnection
 public:
     virtual SystemAbstractions::DiagnosticsSender::UnsubscribeDelegate SubscribeToDiagnostics(
@@ -0,0 +1,455 @@
+/**
+ * @file LinkShapingNetworkConnectionDecorator.cpp
+ *
+ * This module contains the implementation of the
+ * LinkShapingNetworkConnectionDecorator class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "LinkShapingNetworkConnectionDecorator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    /**
+     * This is the type of clock used to time the release of data.
+     */
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * This function converts the given number of seconds
+     * into a clock duration.
+     *
+     * @param[in] seconds
+     *     This is the number of seconds to convert.
+     *
+     * @return
+     *     The clock duration equal to the given number of seconds
+     *     is returned.
+     */
+    Clock::duration ToDuration(double seconds) {
+        return std::chrono::duration_cast< Clock::duration >(
+            std::chrono::duration< double >(seconds)
+        );
+    }
+
+    /**
+     * These are the kinds of things which are held in a release queue.
+     */
+    enum class EventType {
+        /**
+         * Data sent or received through the connection.
+         */
+        Data,
+
+        /**
+         * The connection being broken by the peer.
+         */
+        Broken,
+
+        /**
+         * The connection being closed cleanly by the user.
+         */
+        Close,
+    };
+
+    /**
+     * This is something held in a release queue until its time comes.
+     */
+    struct Event {
+        /**
+         * This is the time at which to release the event.
+         */
+        Clock::time_point releaseTime;
+
+        /**
+         * This indicates what kind of event it is.
+         */
+        EventType type = EventType::Data;
+
+        /**
+         * This is the data sent or received, if the event is data.
+         */
+        std::vector< uint8_t > data;
+
+        /**
+         * This indicates whether or not the peer broke the connection
+         * gracefully, if the event is the connection being broken.
+         */
+        bool graceful = false;
+    };
+
+    /**
+     * This holds the state of one direction of the link being imitated.
+     */
+    struct Direction {
+        /**
+         * These are the events waiting for their time to come, in the
+         * order of their release times.
+         */
+        std::deque< Event > queue;
+
+        /**
+         * This is the time at which the link will have finished
+         * transmitting everything given to it so far, or earlier, if it's
+         * been idle since then.  It's used to limit both the bandwidth
+         * and bursts of the link.
+         */
+        Clock::time_point transmittedTime;
+
+        /**
+         * This is the release time of the last event queued.
+         */
+        Clock::time_point lastReleaseTime;
+    };
+
+}
+
+/**
+ * This contains the private properties of a
+ * LinkShapingNetworkConnectionDecorator class instance.
+ */
+struct LinkShapingNetworkConnectionDecorator::Impl {
+    // Properties
+
+    /**
+     * This is the interface to the network connection being decorated.
+     */
+    std::shared_ptr< SystemAbstractions::INetworkConnection > lowerLayer;
+
+    /**
+     * These are the properties of the network link to imitate.
+     */
+    LinkShape shape;
+
+    /**
+     * This is used to synchronize access to the release queues,
+     * the random number generator, the delegates, and the worker
+     * thread's stop flag.
+     */
+    std::mutex mutex;
+
+    /**
+     * This is used to wake the worker thread when an event is queued,
+     * or when it should stop.
+     */
+    std::condition_variable wakeCondition;
+
+    /**
+     * This generates the random numbers which make up the jitter.
+     */
+    std::mt19937 generator;
+
+    /**
+     * This holds the state of the direction of the link over which
+     * data is sent.
+     */
+    Direction sent;
+
+    /**
+     * This holds the state of the direction of the link over which
+     * data is received.
+     */
+    Direction received;
+
+    /**
+     * This is the delegate to call to deliver data received.
+     */
+    MessageReceivedDelegate messageReceivedDelegate;
+
+    /**
+     * This is the delegate to call to deliver the connection being broken.
+     */
+    BrokenDelegate brokenDelegate;
+
+    /**
+     * This flag indicates whether or not the worker thread should stop.
+     */
+    bool stopWorker = false;
+
+    /**
+     * This is the thread which releases events from the queues
+     * when their time comes.
+     */
+    std::thread worker;
+
+    // Methods
+
+    /**
+     * This is the destructor of the structure.  It stops the worker
+     * thread, if one was started, dropping anything still queued.
+     */
+    ~Impl() noexcept {
+        if (!worker.joinable()) {
+            return;
+        }
+        if (worker.get_id() == std::this_thread::get_id()) {
+            // The last reference to the decorator was dropped by a delegate
+            // called from the worker thread, which will stop on its own.
+            worker.detach();
+            return;
+        }
+        {
+            std::lock_guard< std::mutex > lock(mutex);
+            stopWorker = true;
+            wakeCondition.notify_one();
+        }
+        worker.join();
+    }
+
+    /**
+     * This method queues the given event in the given direction,
+     * to be released once the link would have delivered it.
+     *
+     * @param[in,out] direction
+     *     This is the direction in which the event is passing.
+     *
+     * @param[in] event
+     *     This is the event to queue.
+     */
+    void Enqueue(
+        Direction& direction,
+        Event&& event
+    ) {
+        std::lock_guard< std::mutex > lock(mutex);
+        const auto now = Clock::now();
+        auto releaseTime = now;
+        if (event.type == EventType::Data) {
+            if (shape.bandwidth > 0.0) {
+                const auto transmissionTime = ToDuration((double)event.data.size() / shape.bandwidth);
+                const auto burstTime = ToDuration((double)shape.burstSize / shape.bandwidth);
+                direction.transmittedTime = std::max(direction.transmittedTime, now);
+                releaseTime = std::max(
+                    now,
+                    direction.transmittedTime + transmissionTime - burstTime
+                );
+                direction.transmittedTime += transmissionTime;
+            }
+            auto latency = shape.latency;
+            if (shape.jitter > 0.0) {
+                std::uniform_real_distribution< double > jitter(-shape.jitter, shape.jitter);
+                latency = std::max(0.0, latency + jitter(generator));
+            }
+            releaseTime += ToDuration(latency);
+        }
+        event.releaseTime = std::max(releaseTime, direction.lastReleaseTime);
+        direction.lastReleaseTime = event.releaseTime;
+        direction.queue.push_back(std::move(event));
+        wakeCondition.notify_one();
+    }
+
+    /**
+     * This method carries out the given event, now that its time has come.
+     *
+     * @param[in] event
+     *     This is the event to carry out.
+     *
+     * @param[in] outbound
+     *     This indicates whether the event is passing in the
+     *     direction of data sent (true) or received (false).
+     *
+     * @param[in] messageReceivedDelegate
+     *     This is the delegate to call to deliver data received.
+     *
+     * @param[in] brokenDelegate
+     *     This is the delegate to call to deliver the connection
+     *     being broken.
+     */
+    void Release(
+        const Event& event,
+        bool outbound,
+        const MessageReceivedDelegate& messageReceivedDelegate,
+        const BrokenDelegate& brokenDelegate
+    ) {
+        switch (event.type) {
+            case EventType::Data: {
+                if (outbound) {
+                    lowerLayer->SendMessage(event.data);
+                } else if (messageReceivedDelegate != nullptr) {
+                    messageReceivedDelegate(event.data);
+                }
+            } break;
+
+            case EventType::Broken: {
+                if (brokenDelegate != nullptr) {
+                    brokenDelegate(event.graceful);
+                }
+            } break;
+
+            case EventType::Close: {
+                lowerLayer->Close(true);
+            } break;
+        }
+    }
+
+    /**
+     * This is the body of the worker thread, which releases events from
+     * the queues when their time comes.
+     *
+     * @param[in] implWeak
+     *     This is a weak reference to the structure, which is held
+     *     strongly while delegates are called, in case one of them drops
+     *     the last reference to the decorator.
+     */
+    void Work(std::weak_ptr< Impl > implWeak) {
+        std::unique_lock< std::mutex > lock(mutex);
+        while (!stopWorker) {
+            Direction* nextDirection = nullptr;
+            for (auto direction: {&sent, &received}) {
+                if (
+                    !direction->queue.empty()
+                    && (
+                        (nextDirection == nullptr)
+                        || (direction->queue.front().releaseTime < nextDirection->queue.front().releaseTime)
+                    )
+                ) {
+                    nextDirection = direction;
+                }
+            }
+            if (nextDirection == nullptr) {
+                wakeCondition.wait(lock);
+                continue;
+            }
+            const auto releaseTime = nextDirection->queue.front().releaseTime;
+            if (Clock::now() < releaseTime) {
+                wakeCondition.wait_until(lock, releaseTime);
+                continue;
+            }
+            const auto event = std::move(nextDirection->queue.front());
+            nextDirection->queue.pop_front();
+            const auto outbound = (nextDirection == &sent);
+            const auto messageReceivedDelegateCopy = messageReceivedDelegate;
+            const auto brokenDelegateCopy = brokenDelegate;
+            lock.unlock();
+            {
+                const auto impl = implWeak.lock();
+                if (impl == nullptr) {
+                    return;
+                }
+                Release(event, outbound, messageReceivedDelegateCopy, brokenDelegateCopy);
+            }
+            if (implWeak.expired()) {
+                return;
+            }
+            lock.lock();
+        }
+    }
+};
+
+LinkShapingNetworkConnectionDecorator::~LinkShapingNetworkConnectionDecorator() noexcept = default;
+LinkShapingNetworkConnectionDecorator::LinkShapingNetworkConnectionDecorator(LinkShapingNetworkConnectionDecorator&&) noexcept = default;
+LinkShapingNetworkConnectionDecorator& LinkShapingNetworkConnectionDecorator::operator=(LinkShapingNetworkConnectionDecorator&&) noexcept = default;
+
+LinkShapingNetworkConnectionDecorator::LinkShapingNetworkConnectionDecorator()
+    : impl_(new Impl())
+{
+}
+
+void LinkShapingNetworkConnectionDecorator::Decorate(
+    std::shared_ptr< SystemAbstractions::INetworkConnection > lowerLayer,
+    const LinkShape& shape
+) {
+    if (impl_->worker.joinable()) {
+        return;
+    }
+    impl_->lowerLayer = lowerLayer;
+    impl_->shape = shape;
+    impl_->generator.seed(shape.seed);
+    impl_->worker = std::thread(&Impl::Work, impl_.get(), std::weak_ptr< Impl >(impl_));
+}
+
+SystemAbstractions::DiagnosticsSender::UnsubscribeDelegate LinkShapingNetworkConnectionDecorator::SubscribeToDiagnostics(
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate delegate,
+    size_t minLevel
+) {
+    return impl_->lowerLayer->SubscribeToDiagnostics(delegate, minLevel);
+}
+
+bool LinkShapingNetworkConnectionDecorator::Connect(uint32_t peerAddress, uint16_t peerPort) {
+    return impl_->lowerLayer->Connect(peerAddress, peerPort);
+}
+
+bool LinkShapingNetworkConnectionDecorator::Process(
+    MessageReceivedDelegate messageReceivedDelegate,
+    BrokenDelegate brokenDelegate
+) {
+    {
+        std::lock_guard< std::mutex > lock(impl_->mutex);
+        impl_->messageReceivedDelegate = messageReceivedDelegate;
+        impl_->brokenDelegate = brokenDelegate;
+    }
+    const std::weak_ptr< Impl > implWeak(impl_);
+    const auto decoratedMessageReceivedDelegate = [implWeak](const std::vector< uint8_t >& message){
+        const auto impl(implWeak.lock());
+        if (impl == nullptr) {
+            return;
+        }
+        Event event;
+        event.data = message;
+        impl->Enqueue(impl->received, std::move(event));
+    };
+    const auto decoratedBrokenDelegate = [implWeak](bool graceful){
+        const auto impl(implWeak.lock());
+        if (impl == nullptr) {
+            return;
+        }
+        Event event;
+        event.type = EventType::Broken;
+        event.graceful = graceful;
+        impl->Enqueue(impl->received, std::move(event));
+    };
+    return impl_->lowerLayer->Process(decoratedMessageReceivedDelegate, decoratedBrokenDelegate);
+}
+
+uint32_t LinkShapingNetworkConnectionDecorator::GetPeerAddress() const {
+    return impl_->lowerLayer->GetPeerAddress();
+}
+
+uint16_t LinkShapingNetworkConnectionDecorator::GetPeerPort() const {
+    return impl_->lowerLayer->GetPeerPort();
+}
+
+bool LinkShapingNetworkConnectionDecorator::IsConnected() const {
+    return impl_->lowerLayer->IsConnected();
+}
+
+uint32_t LinkShapingNetworkConnectionDecorator::GetBoundAddress() const {
+    return impl_->lowerLayer->GetBoundAddress();
+}
+
+uint16_t LinkShapingNetworkConnectionDecorator::GetBoundPort() const {
+    return impl_->lowerLayer->GetBoundPort();
+}
+
+void LinkShapingNetworkConnectionDecorator::SendMessage(const std::vector< uint8_t >& message) {
+    Event event;
+    event.data = message;
+    impl_->Enqueue(impl_->sent, std::move(event));
+}
+
+void LinkShapingNetworkConnectionDecorator::Close(bool clean) {
+    if (clean) {
+        Event event;
+        event.type = EventType::Close;
+        impl_->Enqueue(impl_->sent, std::move(event));
+        return;
+    }
+    {
+        std::lock_guard< std::mutex > lock(impl_->mutex);
+        impl_->sent.queue.clear();
+        impl_->received.queue.clear();
+    }
+    impl_->lowerLayer->Close(false);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+/**
+ * @file LinkShapingNetworkConnectionDecorator.hpp
+ *
+ * This module declares the LinkShapingNetworkConnectionDecorator class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <SystemAbstractions/INetworkConnection.hpp>
+
+/**
+ * This holds the properties of a network link to imitate.
+ * Each property applies separately to each direction of traffic.
+ */
+struct LinkShape {
+    /**
+     * This is the time, in seconds, it takes data to cross the link
+     * once it's been transmitted.
+     */
+    double latency = 0.0;
+
+    /**
+     * This is the most time, in seconds, by which the latency of any
+     * data may be randomly longer or shorter.  Data is never reordered,
+     * though, so it's held back, if necessary, until data sent before
+     * it has crossed.
+     */
+    double jitter = 0.0;
+
+    /**
+     * This is the number of bytes per second the link can transmit,
+     * or zero if there is no limit.
+     */
+    double bandwidth = 0.0;
+
+    /**
+     * This is the number of bytes the link can take all at once, after
+     * being idle long enough, before it falls back to transmitting at
+     * its bandwidth.
+     */
+    size_t burstSize = 0;
+
+    /**
+     * This is used to seed the random numbers which make up the jitter,
+     * so that the same seed produces the same jitter every time.
+     */
+    uint32_t seed = 1;
+};
+
+/**
+ * This is a decorator for SystemAbstractions::INetworkConnection which
+ * imitates a slower network link than the one it's on, by holding data
+ * sent or received through the connection in a queue until the link being
+ * imitated would have delivered it.  A thread of the decorator's own
+ * releases the data from the queue when its time comes.
+ */
+class LinkShapingNetworkConnectionDecorator
+    : public SystemAbstractions::INetworkConnection
+{
+    // Lifecycle management
+public:
+    ~LinkShapingNetworkConnectionDecorator() noexcept;
+    LinkShapingNetworkConnectionDecorator(const LinkShapingNetworkConnectionDecorator&) = delete;
+    LinkShapingNetworkConnectionDecorator(LinkShapingNetworkConnectionDecorator&&) noexcept;
+    LinkShapingNetworkConnectionDecorator& operator=(const LinkShapingNetworkConnectionDecorator&) = delete;
+    LinkShapingNetworkConnectionDecorator& operator=(LinkShapingNetworkConnectionDecorator&&) noexcept;
+
+    // Public Methods
+public:
+    /**
+     * This is the default constructor.
+     */
+    LinkShapingNetworkConnectionDecorator();
+
+    /**
+     * This method sets up the decorator with the network connection to
+     * decorate and the network link to imitate.
+     *
+     * @param[in] lowerLayer
+     *     This is the lower-level connection to decorate.
+     *
+     * @param[in] shape
+     *     These are the properties of the network link to imitate.
+     */
+    void Decorate(
+        std::shared_ptr< SystemAbstractions::INetworkConnection > lowerLayer,
+        const LinkShape& shape
+    );
+
+    // SystemAbstractions::INetworkConnection
+public:
+    virtual SystemAbstractions::DiagnosticsSender::UnsubscribeDelegate SubscribeToDiagnostics(
+        SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate delegate,
+        size_t minLevel = 0
+    ) override;
+    virtual bool Connect(uint32_t peerAddress, uint16_t peerPort) override;
+    virtual bool Process(
+        MessageReceivedDelegate messageReceivedDelegate,
+        BrokenDelegate brokenDelegate
+    ) override;
+    virtual uint32_t GetPeerAddress() const override;
+    virtual uint16_t GetPeerPort() const override;
+    virtual bool IsConnected() const override;
+    virtual uint32_t GetBoundAddress() const override;
+    virtual uint16_t GetBoundPort() const override;
+    virtual void SendMessage(const std::vector< uint8_t >& message) override;
+    virtual void Close(bool clean = false) override;
+
+    // Private Properties
+private:
+    /**
+     * This is the type of structure that contains the private
+     * properties of the instance.  It is defined in the implementation
+     * and declared here to ensure that it is scoped inside the class.
+     */
+    struct Impl;
+
+    /**
+     * This contains the private properties of the instance.
+     */
+    std::shared_ptr< Impl > impl_;
+};
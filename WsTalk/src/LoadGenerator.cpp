@@ -0,0 +1,431 @@
+/**
+ * @file LoadGenerator.cpp
+ *
+ * This module contains the implementation of the function used to put a
+ * web server under load by opening many WebSockets to it and sending
+ * messages over each of them at a controlled rate.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "LoadGenerator.hpp"
+#include "Statistics.hpp"
+#include "WebSocketOpener.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <StringExtensions/StringExtensions.hpp>
+#include <thread>
+
+namespace {
+
+    /**
+     * This is the type of clock used to time everything.
+     */
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * This is how long to sleep between passes over the sessions.
+     */
+    constexpr std::chrono::milliseconds TICK(5);
+
+    /**
+     * This is how often to print progress.
+     */
+    constexpr std::chrono::seconds PROGRESS_INTERVAL(1);
+
+    /**
+     * This is the longest to wait for the server to close its ends of
+     * the WebSockets, once they have all been closed on this end.
+     */
+    constexpr std::chrono::milliseconds CLOSE_TIMEOUT(5000);
+
+    /**
+     * This holds the counts updated by the WebSocket delegates,
+     * which are called from the WebSockets' own threads.
+     */
+    struct Counters {
+        /**
+         * This is the number of messages received.
+         */
+        std::atomic< uint64_t > received{0};
+
+        /**
+         * This is the number of WebSockets closed by the server
+         * before this end closed them.
+         */
+        std::atomic< size_t > dropped{0};
+
+        /**
+         * This is the number of WebSockets closed for any reason.
+         */
+        std::atomic< size_t > closed{0};
+    };
+
+    /**
+     * This holds the parts of a session shared with the delegates
+     * of its WebSocket.
+     */
+    struct SessionState {
+        /**
+         * This indicates whether or not the WebSocket was closed.
+         */
+        std::atomic< bool > closed{false};
+
+        /**
+         * This indicates whether or not this end has started
+         * closing the WebSocket.
+         */
+        std::atomic< bool > closing{false};
+    };
+
+    /**
+     * This holds everything about one WebSocket opened to the server.
+     */
+    struct Session {
+        /**
+         * This is used to open the WebSocket.
+         */
+        WebSocketOpener opener;
+
+        /**
+         * This is the WebSocket, once it's open.
+         */
+        std::shared_ptr< WebSockets::WebSocket > ws;
+
+        /**
+         * This is shared with the delegates of the WebSocket.
+         */
+        std::shared_ptr< SessionState > state = std::make_shared< SessionState >();
+
+        /**
+         * This indicates whether or not the WebSocket is still opening.
+         */
+        bool opening = true;
+
+        /**
+         * This is when the WebSocket started opening.
+         */
+        Clock::time_point started;
+
+        /**
+         * This is when the next message is due to be sent.
+         */
+        Clock::time_point nextSend;
+
+        /**
+         * This is the index of the next line of the script to send.
+         */
+        size_t nextLine = 0;
+    };
+
+    /**
+     * This function returns the number of seconds in the given duration.
+     *
+     * @param[in] duration
+     *     This is the duration to convert.
+     *
+     * @return
+     *     The number of seconds in the given duration is returned.
+     */
+    double Seconds(Clock::duration duration) {
+        return std::chrono::duration< double >(duration).count();
+    }
+
+}
+
+bool RunLoad(
+    Http::Client& client,
+    const Uri::Uri& url,
+    const LoadConfiguration& configuration,
+    const bool& shutDown,
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+) {
+    if (
+        (configuration.rate > 0.0)
+        && configuration.script.empty()
+    ) {
+        diagnosticMessageDelegate(
+            "WsTalk",
+            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+            "no messages to send"
+        );
+        return false;
+    }
+    diagnosticMessageDelegate(
+        "WsTalk",
+        3,
+        StringExtensions::sprintf(
+            "Opening %zu WebSockets to '%s' at %g per second, each sending %g messages per second...",
+            configuration.clients,
+            url.GenerateString().c_str(),
+            configuration.rampRate,
+            configuration.rate
+        )
+    );
+    const auto counters = std::make_shared< Counters >();
+    std::vector< Session > sessions;
+    sessions.reserve(configuration.clients);
+    std::vector< double > connectTimes;
+    connectTimes.reserve(configuration.clients);
+    std::map< std::string, size_t > errors;
+    std::mt19937 generator;
+    const auto sendInterval = std::max(
+        Clock::duration(1),
+        std::chrono::duration_cast< Clock::duration >(
+            std::chrono::duration< double >(
+                (configuration.rate > 0.0)
+                ? 1.0 / configuration.rate
+                : 0.0
+            )
+        )
+    );
+    std::uniform_int_distribution< Clock::rep > sendOffset(
+        0,
+        std::max((Clock::rep)0, sendInterval.count() - 1)
+    );
+    size_t opening = 0;
+    size_t opened = 0;
+    size_t failed = 0;
+    uint64_t sent = 0;
+    const auto start = Clock::now();
+    auto nextProgress = start + PROGRESS_INTERVAL;
+    size_t lastConnectTimesReported = 0;
+    uint64_t lastSentReported = 0;
+    uint64_t lastReceivedReported = 0;
+    bool fullLoad = false;
+    auto fullLoadStart = start;
+    uint64_t fullLoadSent = 0;
+    uint64_t fullLoadReceived = 0;
+    printf("  time    open opening  failed dropped    sent/s    recv/s  connect p50/p99 (ms)\n");
+    while (!shutDown) {
+        auto now = Clock::now();
+
+        // Start opening more WebSockets, as the ramp allows.
+        size_t due = configuration.clients;
+        if (configuration.rampRate > 0.0) {
+            due = std::min(
+                due,
+                (size_t)(Seconds(now - start) * configuration.rampRate) + 1
+            );
+        }
+        while (sessions.size() < due) {
+            sessions.emplace_back();
+            auto& session = sessions.back();
+            const auto state = session.state;
+            WebSockets::WebSocket::Delegates wsDelegates;
+            wsDelegates.text = [counters](const std::string& data){
+                ++counters->received;
+            };
+            wsDelegates.binary = [counters](const std::string& data){
+                ++counters->received;
+            };
+            wsDelegates.close = [counters, state](
+                unsigned int code,
+                const std::string& reason
+            ){
+                if (!state->closing) {
+                    ++counters->dropped;
+                }
+                state->closed = true;
+                ++counters->closed;
+            };
+            session.started = Clock::now();
+            session.opener.Start(client, url, std::move(wsDelegates), nullptr);
+            ++opening;
+        }
+
+        // Check on the WebSockets still opening, and send messages
+        // over those which are open.
+        now = Clock::now();
+        for (auto& session: sessions) {
+            if (session.opening) {
+                switch (session.opener.Await(std::chrono::milliseconds(0))) {
+                    case WebSocketOpener::State::Open: {
+                        session.opening = false;
+                        session.ws = session.opener.GetWebSocket();
+                        session.nextSend = now + Clock::duration(sendOffset(generator));
+                        connectTimes.push_back(
+                            Seconds(session.opener.GetOpenTime() - session.started) * 1000.0
+                        );
+                        --opening;
+                        ++opened;
+                    } break;
+
+                    case WebSocketOpener::State::Failed: {
+                        session.opening = false;
+                        ++errors[session.opener.GetError()];
+                        --opening;
+                        ++failed;
+                    } break;
+
+                    default: break;
+                }
+            }
+            if (
+                (session.ws == nullptr)
+                || session.state->closed
+                || (configuration.rate <= 0.0)
+                || (now < session.nextSend)
+            ) {
+                continue;
+            }
+            // Send every message which has come due since the last pass,
+            // so that rates faster than one message per tick aren't
+            // quietly capped at one per tick.
+            do {
+                session.ws->SendText(configuration.script[session.nextLine]);
+                session.nextLine = (session.nextLine + 1) % configuration.script.size();
+                ++sent;
+                session.nextSend += sendInterval;
+            } while (session.nextSend <= now);
+        }
+
+        // Once every WebSocket is open (or has failed to open),
+        // hold the full load for the configured time.
+        if (
+            !fullLoad
+            && (sessions.size() == configuration.clients)
+            && (opening == 0)
+        ) {
+            fullLoad = true;
+            fullLoadStart = now;
+            fullLoadSent = sent;
+            fullLoadReceived = counters->received;
+            diagnosticMessageDelegate(
+                "WsTalk",
+                3,
+                StringExtensions::sprintf(
+                    "Ramp complete; holding full load for %g seconds.",
+                    configuration.duration
+                )
+            );
+        }
+        if (
+            fullLoad
+            && (Seconds(now - fullLoadStart) >= configuration.duration)
+        ) {
+            break;
+        }
+
+        // Print progress once per interval.
+        if (now >= nextProgress) {
+            std::vector< double > intervalConnectTimes(
+                connectTimes.begin() + lastConnectTimesReported,
+                connectTimes.end()
+            );
+            std::sort(intervalConnectTimes.begin(), intervalConnectTimes.end());
+            const uint64_t received = counters->received;
+            const auto intervalSeconds = Seconds(PROGRESS_INTERVAL);
+            printf(
+                "%6.1f %7zu %7zu %7zu %7zu %9.1f %9.1f  %9.1f %9.1f\n",
+                Seconds(now - start),
+                opened - counters->dropped,
+                opening,
+                failed,
+                (size_t)counters->dropped,
+                (double)(sent - lastSentReported) / intervalSeconds,
+                (double)(received - lastReceivedReported) / intervalSeconds,
+                Percentile(intervalConnectTimes, 50.0),
+                Percentile(intervalConnectTimes, 99.0)
+            );
+            lastConnectTimesReported = connectTimes.size();
+            lastSentReported = sent;
+            lastReceivedReported = received;
+            nextProgress += PROGRESS_INTERVAL;
+        }
+        std::this_thread::sleep_for(TICK);
+    }
+    const auto end = Clock::now();
+    const uint64_t received = counters->received;
+    if (shutDown) {
+        diagnosticMessageDelegate(
+            "WsTalk",
+            SystemAbstractions::DiagnosticsSender::Levels::WARNING,
+            "Load canceled"
+        );
+    }
+
+    // Close every WebSocket still open, and wait for the server
+    // to close its ends.
+    for (auto& session: sessions) {
+        if (session.ws != nullptr) {
+            session.state->closing = true;
+            session.ws->Close(1000, "Kthxbye");
+        }
+    }
+    const auto closeDeadline = Clock::now() + CLOSE_TIMEOUT;
+    while (
+        (counters->closed < opened)
+        && (Clock::now() < closeDeadline)
+    ) {
+        std::this_thread::sleep_for(TICK);
+    }
+    const size_t unclosed = opened - counters->closed;
+    sessions.clear();
+
+    // Report the results.
+    std::sort(connectTimes.begin(), connectTimes.end());
+    double connectTimeSum = 0.0;
+    for (const auto connectTime: connectTimes) {
+        connectTimeSum += connectTime;
+    }
+    const auto totalSeconds = Seconds(end - start);
+    const auto started = opened + failed + opening;
+    const size_t dropped = counters->dropped;
+    printf("\n");
+    printf(
+        "Sessions: %zu started, %zu opened, %zu failed, %zu dropped by server, %zu not closed in time\n",
+        started,
+        opened,
+        failed,
+        dropped,
+        unclosed
+    );
+    if (!connectTimes.empty()) {
+        printf(
+            "Connect time (ms): min %.1f, mean %.1f, p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n",
+            connectTimes.front(),
+            connectTimeSum / (double)connectTimes.size(),
+            Percentile(connectTimes, 50.0),
+            Percentile(connectTimes, 90.0),
+            Percentile(connectTimes, 99.0),
+            connectTimes.back()
+        );
+    }
+    printf(
+        "Messages: %llu sent (%.1f/s), %llu received (%.1f/s) over %.1f seconds\n",
+        (unsigned long long)sent,
+        (double)sent / totalSeconds,
+        (unsigned long long)received,
+        (double)received / totalSeconds,
+        totalSeconds
+    );
+    if (fullLoad) {
+        const auto fullLoadSeconds = Seconds(end - fullLoadStart);
+        if (fullLoadSeconds > 0.0) {
+            printf(
+                "At full load: %.1f sent/s, %.1f received/s over %.1f seconds\n",
+                (double)(sent - fullLoadSent) / fullLoadSeconds,
+                (double)(received - fullLoadReceived) / fullLoadSeconds,
+                fullLoadSeconds
+            );
+        }
+    }
+    printf(
+        "Error rate: %.2f%% of sessions failed or dropped\n",
+        (started > 0)
+        ? (double)(failed + dropped) * 100.0 / (double)started
+        : 0.0
+    );
+    for (const auto& error: errors) {
+        printf("  %zu x %s\n", error.second, error.first.c_str());
+    }
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+/**
+ * @file LoadGenerator.hpp
+ *
+ * This module declares the function used to put a web server under load
+ * by opening many WebSockets to it and sending messages over each of them
+ * at a controlled rate.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <Http/Client.hpp>
+#include <stddef.h>
+#include <string>
+#include <SystemAbstractions/DiagnosticsSender.hpp>
+#include <Uri/Uri.hpp>
+#include <vector>
+
+/**
+ * This holds the settings which control the load put on the server.
+ */
+struct LoadConfiguration {
+    /**
+     * This is the number of WebSockets to open.
+     */
+    size_t clients = 0;
+
+    /**
+     * This is the number of messages each WebSocket sends per second.
+     * If zero, the WebSockets are opened but send nothing.
+     */
+    double rate = 1.0;
+
+    /**
+     * This is the number of WebSockets to start opening per second,
+     * so that the load ramps up gradually.  If zero, all of them are
+     * started at once.
+     */
+    double rampRate = 50.0;
+
+    /**
+     * This is the number of seconds to hold the full load, once every
+     * WebSocket has been opened (or has failed to open).
+     */
+    double duration = 30.0;
+
+    /**
+     * These are the text messages each WebSocket sends, in order,
+     * starting over after the last one.
+     */
+    std::vector< std::string > script;
+};
+
+/**
+ * This function opens WebSockets to the server at the given URL, ramping
+ * up gradually, and sends messages over each of them at the configured
+ * rate.  Progress is printed once per second, followed by a report of
+ * connect times, message rates, and error rates at the end.
+ *
+ * @param[in,out] client
+ *     This is the client to use to connect to the server.
+ *
+ * @param[in] url
+ *     This is the URL of the server to which to connect.
+ *
+ * @param[in] configuration
+ *     This holds the settings which control the load.
+ *
+ * @param[in] shutDown
+ *     This is a flag which is set when the load should be stopped early.
+ *
+ * @param[in] diagnosticMessageDelegate
+ *     This is the function to call to publish any diagnostic messages.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool RunLoad(
+    Http::Client& client,
+    const Uri::Uri& url,
+    const LoadConfiguration& configuration,
+    const bool& shutDown,
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+);
@@ -0,0 +1,315 @@
+/**
+ * @file PcapngCaptureDecorator.cpp
+ *
+ * This module contains the implementation of the
+ * PcapngCaptureDecorator class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "PcapngCaptureDecorator.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace {
+
+    /**
+     * This is the size of the IPv4 header made up for each packet.
+     */
+    constexpr size_t IPV4_HEADER_SIZE = 20;
+
+    /**
+     * This is the size of the TCP header made up for each packet.
+     */
+    constexpr size_t TCP_HEADER_SIZE = 20;
+
+    /**
+     * This is the size of all the headers made up for each packet.
+     */
+    constexpr size_t HEADERS_SIZE = IPV4_HEADER_SIZE + TCP_HEADER_SIZE;
+
+    /**
+     * This is the most data which fits in one packet, limited by the
+     * 16-bit total length field of the IPv4 header.
+     */
+    constexpr size_t MAX_PACKET_PAYLOAD = 65535 - HEADERS_SIZE;
+
+    /**
+     * This is the protocol number of TCP, used in the IPv4 header.
+     */
+    constexpr uint8_t IP_PROTOCOL_TCP = 6;
+
+    /**
+     * These are the TCP flags set in every packet (PSH and ACK).
+     */
+    constexpr uint8_t TCP_FLAGS_PSH_ACK = 0x18;
+
+    /**
+     * This function stores the given 16-bit value at the given place,
+     * in network byte order.
+     *
+     * @param[in] destination
+     *     This is where to store the value.
+     *
+     * @param[in] value
+     *     This is the value to store.
+     */
+    void Store16(
+        uint8_t* destination,
+        uint16_t value
+    ) {
+        destination[0] = (uint8_t)(value >> 8);
+        destination[1] = (uint8_t)value;
+    }
+
+    /**
+     * This function stores the given 32-bit value at the given place,
+     * in network byte order.
+     *
+     * @param[in] destination
+     *     This is where to store the value.
+     *
+     * @param[in] value
+     *     This is the value to store.
+     */
+    void Store32(
+        uint8_t* destination,
+        uint32_t value
+    ) {
+        destination[0] = (uint8_t)(value >> 24);
+        destination[1] = (uint8_t)(value >> 16);
+        destination[2] = (uint8_t)(value >> 8);
+        destination[3] = (uint8_t)value;
+    }
+
+    /**
+     * This function computes the checksum of the given IPv4 header.
+     *
+     * @param[in] header
+     *     This is the header, with its checksum field set to zero.
+     *
+     * @return
+     *     The checksum of the header is returned.
+     */
+    uint16_t Ipv4HeaderChecksum(const uint8_t* header) {
+        uint32_t sum = 0;
+        for (size_t i = 0; i < IPV4_HEADER_SIZE; i += 2) {
+            sum += ((uint32_t)header[i] << 8) | header[i + 1];
+        }
+        while ((sum >> 16) != 0) {
+            sum = (sum & 0xFFFF) + (sum >> 16);
+        }
+        return (uint16_t)~sum;
+    }
+
+}
+
+/**
+ * This contains the private properties of a PcapngCaptureDecorator
+ * class instance.
+ */
+struct PcapngCaptureDecorator::Impl {
+    // Properties
+
+    /**
+     * This is the interface to the network connection being decorated.
+     */
+    std::shared_ptr< SystemAbstractions::INetworkConnection > lowerLayer;
+
+    /**
+     * This is the object used to write captured packets.
+     */
+    std::shared_ptr< PcapngWriter > writer;
+
+    /**
+     * This is the index of the writer's interface with which
+     * to tag the packets captured.
+     */
+    size_t interfaceIndex = 0;
+
+    /**
+     * If not zero, this is the port recorded for the peer in place
+     * of its real one.
+     */
+    uint16_t peerPortOverride = 0;
+
+    /**
+     * This is used to synchronize access to the sequence numbers
+     * and packet identification, and to keep packets in sequence
+     * order as they're handed to the writer.
+     */
+    std::mutex mutex;
+
+    /**
+     * This is the TCP sequence number of the next byte sent.
+     */
+    uint32_t sendSequence = 1;
+
+    /**
+     * This is the TCP sequence number of the next byte received.
+     */
+    uint32_t receiveSequence = 1;
+
+    /**
+     * This is the IPv4 identification of the next packet.
+     */
+    uint16_t nextIdentification = 1;
+
+    // Methods
+
+    /**
+     * This method captures the given data passing through the connection,
+     * as one or more TCP/IP packets.
+     *
+     * @param[in] outbound
+     *     This indicates whether the data is being sent (true)
+     *     or was received (false).
+     *
+     * @param[in] data
+     *     This is the data to capture.
+     */
+    void Capture(
+        bool outbound,
+        const std::vector< uint8_t >& data
+    ) {
+        const auto localAddress = lowerLayer->GetBoundAddress();
+        const auto localPort = lowerLayer->GetBoundPort();
+        const auto peerAddress = lowerLayer->GetPeerAddress();
+        const auto peerPort = (
+            (peerPortOverride == 0)
+            ? lowerLayer->GetPeerPort()
+            : peerPortOverride
+        );
+
+        // Hold the lock while handing packets to the writer, so that
+        // packets sent or received at the same time on different threads
+        // reach the capture file in the order of their sequence numbers.
+        std::lock_guard< std::mutex > lock(mutex);
+        for (size_t offset = 0; offset < data.size(); offset += MAX_PACKET_PAYLOAD) {
+            const auto payloadSize = std::min(MAX_PACKET_PAYLOAD, data.size() - offset);
+            uint32_t sequence, acknowledgment;
+            if (outbound) {
+                sequence = sendSequence;
+                acknowledgment = receiveSequence;
+                sendSequence += (uint32_t)payloadSize;
+            } else {
+                sequence = receiveSequence;
+                acknowledgment = sendSequence;
+                receiveSequence += (uint32_t)payloadSize;
+            }
+            const auto identification = nextIdentification++;
+            uint8_t headers[HEADERS_SIZE] = {0};
+            const auto ip = headers;
+            ip[0] = 0x45;
+            Store16(ip + 2, (uint16_t)(HEADERS_SIZE + payloadSize));
+            Store16(ip + 4, identification);
+            Store16(ip + 6, 0x4000);
+            ip[8] = 64;
+            ip[9] = IP_PROTOCOL_TCP;
+            Store32(ip + 12, outbound ? localAddress : peerAddress);
+            Store32(ip + 16, outbound ? peerAddress : localAddress);
+            Store16(ip + 10, Ipv4HeaderChecksum(ip));
+            const auto tcp = headers + IPV4_HEADER_SIZE;
+            Store16(tcp, outbound ? localPort : peerPort);
+            Store16(tcp + 2, outbound ? peerPort : localPort);
+            Store32(tcp + 4, sequence);
+            Store32(tcp + 8, acknowledgment);
+            tcp[12] = (uint8_t)((TCP_HEADER_SIZE / 4) << 4);
+            tcp[13] = TCP_FLAGS_PSH_ACK;
+            Store16(tcp + 14, 65535);
+            writer->WritePacket(
+                interfaceIndex,
+                outbound,
+                headers,
+                sizeof(headers),
+                data.data() + offset,
+                payloadSize
+            );
+        }
+    }
+};
+
+PcapngCaptureDecorator::~PcapngCaptureDecorator() noexcept = default;
+PcapngCaptureDecorator::PcapngCaptureDecorator(PcapngCaptureDecorator&&) noexcept = default;
+PcapngCaptureDecorator& PcapngCaptureDecorator::operator=(PcapngCaptureDecorator&&) noexcept = default;
+
+PcapngCaptureDecorator::PcapngCaptureDecorator()
+    : impl_(new Impl())
+{
+}
+
+void PcapngCaptureDecorator::Decorate(
+    std::shared_ptr< SystemAbstractions::INetworkConnection > lowerLayer,
+    std::shared_ptr< PcapngWriter > writer,
+    size_t interfaceIndex,
+    uint16_t peerPort
+) {
+    impl_->lowerLayer = lowerLayer;
+    impl_->writer = writer;
+    impl_->interfaceIndex = interfaceIndex;
+    impl_->peerPortOverride = peerPort;
+}
+
+SystemAbstractions::DiagnosticsSender::UnsubscribeDelegate PcapngCaptureDecorator::SubscribeToDiagnostics(
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate delegate,
+    size_t minLevel
+) {
+    return impl_->lowerLayer->SubscribeToDiagnostics(delegate, minLevel);
+}
+
+bool PcapngCaptureDecorator::Connect(uint32_t peerAddress, uint16_t peerPort) {
+    return impl_->lowerLayer->Connect(peerAddress, peerPort);
+}
+
+bool PcapngCaptureDecorator::Process(
+    MessageReceivedDelegate messageReceivedDelegate,
+    BrokenDelegate brokenDelegate
+) {
+    const std::weak_ptr< Impl > implWeak(impl_);
+    const auto decoratedMessageReceivedDelegate = [
+        implWeak,
+        messageReceivedDelegate
+    ](const std::vector< uint8_t >& message){
+        const auto impl(implWeak.lock());
+        if (impl == nullptr) {
+            return;
+        }
+        impl->Capture(false, message);
+        messageReceivedDelegate(message);
+    };
+    return impl_->lowerLayer->Process(decoratedMessageReceivedDelegate, brokenDelegate);
+}
+
+uint32_t PcapngCaptureDecorator::GetPeerAddress() const {
+    return impl_->lowerLayer->GetPeerAddress();
+}
+
+uint16_t PcapngCaptureDecorator::GetPeerPort() const {
+    return impl_->lowerLayer->GetPeerPort();
+}
+
+bool PcapngCaptureDecorator::IsConnected() const {
+    return impl_->lowerLayer->IsConnected();
+}
+
+uint32_t PcapngCaptureDecorator::GetBoundAddress() const {
+    return impl_->lowerLayer->GetBoundAddress();
+}
+
+uint16_t PcapngCaptureDecorator::GetBoundPort() const {
+    return impl_->lowerLayer->GetBoundPort();
+}
+
+void PcapngCaptureDecorator::SendMessage(const std::vector< uint8_t >& message) {
+    impl_->Capture(true, message);
+    impl_->lowerLayer->SendMessage(message);
+}
+
+void PcapngCaptureDecorator::Close(bool clean) {
+    impl_->lowerLayer->Close(clean);
+}
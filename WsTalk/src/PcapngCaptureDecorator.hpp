@@ -0,0 +1,106 @@
+#pragma once
+
+/**
+ * @file PcapngCaptureDecorator.hpp
+ *
+ * This module declares the PcapngCaptureDecorator class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "PcapngWriter.hpp"
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <SystemAbstractions/INetworkConnection.hpp>
+
+/**
+ * This is a decorator for SystemAbstractions::INetworkConnection which
+ * captures all data that passes through the connection to a file in the
+ * PCAP Next Generation (pcapng) format.  Each send or receive is recorded
+ * as one or more TCP/IP packets, with headers made up from the addresses
+ * and ports of the connection and sequence numbers counting the bytes
+ * passed in each direction, so that tools such as Wireshark can follow
+ * the stream.
+ */
+class PcapngCaptureDecorator
+    : public SystemAbstractions::INetworkConnection
+{
+    // Lifecycle management
+public:
+    ~PcapngCaptureDecorator() noexcept;
+    PcapngCaptureDecorator(const PcapngCaptureDecorator&) = delete;
+    PcapngCaptureDecorator(PcapngCaptureDecorator&&) noexcept;
+    PcapngCaptureDecorator& operator=(const PcapngCaptureDecorator&) = delete;
+    PcapngCaptureDecorator& operator=(PcapngCaptureDecorator&&) noexcept;
+
+    // Public Methods
+public:
+    /**
+     * This is the default constructor.
+     */
+    PcapngCaptureDecorator();
+
+    /**
+     * This method sets up the decorator with the network connection to
+     * decorate and where to capture the data passing through it.
+     *
+     * @param[in] lowerLayer
+     *     This is the lower-level connection to decorate.
+     *
+     * @param[in] writer
+     *     This is the object to use to write captured packets.
+     *     It may be shared by many decorators.
+     *
+     * @param[in] interfaceIndex
+     *     This is the index of the writer's interface with which
+     *     to tag the packets captured.
+     *
+     * @param[in] peerPort
+     *     If not zero, this is the port to record for the peer in place
+     *     of its real one.  Tools such as Wireshark tell TCP streams apart
+     *     only by their addresses and ports, so when more than one layer
+     *     of the same connection is captured, all but one of them need
+     *     a port of their own to keep their streams from being mixed up.
+     */
+    void Decorate(
+        std::shared_ptr< SystemAbstractions::INetworkConnection > lowerLayer,
+        std::shared_ptr< PcapngWriter > writer,
+        size_t interfaceIndex,
+        uint16_t peerPort = 0
+    );
+
+    // SystemAbstractions::INetworkConnection
+public:
+    virtual SystemAbstractions::DiagnosticsSender::UnsubscribeDelegate SubscribeToDiagnostics(
+        SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate delegate,
+        size_t minLevel = 0
+    ) override;
+    virtual bool Connect(uint32_t peerAddress, uint16_t peerPort) override;
+    virtual bool Process(
+        MessageReceivedDelegate messageReceivedDelegate,
+        BrokenDelegate brokenDelegate
+    ) override;
+    virtual uint32_t GetPeerAddress() const override;
+    virtual uint16_t GetPeerPort() const override;
+    virtual bool IsConnected() const override;
+    virtual uint32_t GetBoundAddress() const override;
+    virtual uint16_t GetBoundPort() const override;
+    virtual void SendMessage(const std::vector< uint8_t >& message) override;
+    virtual void Close(bool clean = false) override;
+
+    // Private Properties
+private:
+    /**
+     * This is the type of structure that contains the private
+     * properties of the instance.  It is defined in the implementation
+     * and declared here to ensure that it is scoped inside the class.
+     */
+    struct Impl;
+
+    /**
+     * This contains the private properties of the instance.
+     */
+    std::shared_ptr< Impl > impl_;
+};
@@ -0,0 +1,505 @@
+/**
+ * @file PcapngWriter.cpp
+ *
+ * This module contains the implementation of the PcapngWriter class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "PcapngWriter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <StringExtensions/StringExtensions.hpp>
+#include <SystemAbstractions/File.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    /**
+     * This is the type of clock used to time-stamp packets.
+     */
+    typedef std::chrono::system_clock Clock;
+
+    /**
+     * This is the block type of a section header block.
+     */
+    constexpr uint32_t SECTION_HEADER_BLOCK_TYPE = 0x0A0D0D0A;
+
+    /**
+     * This is the block type of an interface description block.
+     */
+    constexpr uint32_t INTERFACE_DESCRIPTION_BLOCK_TYPE = 0x00000001;
+
+    /**
+     * This is the block type of an enhanced packet block.
+     */
+    constexpr uint32_t ENHANCED_PACKET_BLOCK_TYPE = 0x00000006;
+
+    /**
+     * This is the value written in the section header block, from which
+     * readers tell the byte order used in the file.
+     */
+    constexpr uint32_t BYTE_ORDER_MAGIC = 0x1A2B3C4D;
+
+    /**
+     * This is the link type of packets which start with an IPv4
+     * or IPv6 header (LINKTYPE_RAW).
+     */
+    constexpr uint16_t LINKTYPE_RAW = 101;
+
+    /**
+     * This is the code of the option which ends a list of options.
+     */
+    constexpr uint16_t OPTION_END = 0;
+
+    /**
+     * This is the code of the option naming the application
+     * which wrote a section.
+     */
+    constexpr uint16_t OPTION_SHB_USERAPPL = 4;
+
+    /**
+     * This is the code of the option naming an interface.
+     */
+    constexpr uint16_t OPTION_IF_NAME = 2;
+
+    /**
+     * This is the code of the option giving the flags of a packet,
+     * including its direction.
+     */
+    constexpr uint16_t OPTION_EPB_FLAGS = 2;
+
+    /**
+     * This is the value of the packet flags option for a packet received.
+     */
+    constexpr uint32_t EPB_FLAGS_INBOUND = 1;
+
+    /**
+     * This is the value of the packet flags option for a packet sent.
+     */
+    constexpr uint32_t EPB_FLAGS_OUTBOUND = 2;
+
+    /**
+     * This is the number of bytes in an enhanced packet block besides
+     * the packet itself and its padding.
+     */
+    constexpr size_t ENHANCED_PACKET_BLOCK_OVERHEAD = 44;
+
+    /**
+     * This is the number of bytes of packets to gather in memory
+     * before writing them to the capture file.
+     */
+    constexpr size_t WRITE_BUFFER_SIZE = 1024 * 1024;
+
+    /**
+     * This is the longest packets are held in memory before being
+     * written to the capture file.
+     */
+    constexpr std::chrono::seconds MAX_WRITE_DELAY(1);
+
+    /**
+     * This is the name of the application, recorded in each capture file.
+     */
+    constexpr const char* APPLICATION_NAME = "WsTalk";
+
+    /**
+     * This function returns the given size rounded up
+     * to a multiple of four.
+     *
+     * @param[in] size
+     *     This is the size to round up.
+     *
+     * @return
+     *     The size rounded up to a multiple of four is returned.
+     */
+    size_t Padded(size_t size) {
+        return (size + 3) & ~(size_t)3;
+    }
+
+}
+
+/**
+ * This contains the private properties of a PcapngWriter class instance.
+ */
+struct PcapngWriter::Impl {
+    // Properties
+
+    /**
+     * This is used to synchronize access to the writer.
+     */
+    std::mutex mutex;
+
+    /**
+     * This is the path of the capture file being written.
+     */
+    std::string path;
+
+    /**
+     * These are the names of the interfaces on which packets are captured.
+     */
+    std::vector< std::string > interfaceNames;
+
+    /**
+     * This is the most bytes to write to each capture file.
+     */
+    uint64_t maxFileSize = 0;
+
+    /**
+     * This is the most capture files to keep.
+     */
+    size_t maxFiles = 1;
+
+    /**
+     * This is the capture file being written, if any.
+     */
+    std::unique_ptr< SystemAbstractions::File > file;
+
+    /**
+     * This is the number of bytes added to the capture file being written,
+     * including those still held in memory.
+     */
+    uint64_t fileSize = 0;
+
+    /**
+     * This is the number of bytes taken by the blocks at the start of
+     * each capture file, before any packets.
+     */
+    uint64_t headerSize = 0;
+
+    /**
+     * These are the bytes added to the capture file but not yet written.
+     */
+    SystemAbstractions::File::Buffer buffer;
+
+    /**
+     * This is the time bytes were last written to the capture file.
+     */
+    std::chrono::steady_clock::time_point lastWrite;
+
+    /**
+     * This is used to wake the worker thread when it should stop.
+     */
+    std::condition_variable wakeCondition;
+
+    /**
+     * This flag indicates whether or not the worker thread should stop.
+     */
+    bool stopWorker = false;
+
+    /**
+     * This is the thread which writes packets held in memory once they've
+     * been held long enough, even if no more packets come along.
+     */
+    std::thread worker;
+
+    // Methods
+
+    /**
+     * This is the destructor of the structure.  It stops the worker
+     * thread, if one was started.
+     */
+    ~Impl() noexcept {
+        if (!worker.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard< std::mutex > lock(mutex);
+            stopWorker = true;
+            wakeCondition.notify_one();
+        }
+        worker.join();
+    }
+
+    /**
+     * This method adds the given 16-bit value to the buffer.
+     *
+     * @param[in] value
+     *     This is the value to add.
+     */
+    void Append16(uint16_t value) {
+        const auto start = buffer.size();
+        buffer.resize(start + sizeof(value));
+        memcpy(&buffer[start], &value, sizeof(value));
+    }
+
+    /**
+     * This method adds the given 32-bit value to the buffer.
+     *
+     * @param[in] value
+     *     This is the value to add.
+     */
+    void Append32(uint32_t value) {
+        const auto start = buffer.size();
+        buffer.resize(start + sizeof(value));
+        memcpy(&buffer[start], &value, sizeof(value));
+    }
+
+    /**
+     * This method adds the given bytes to the buffer, followed by
+     * zeros to pad them to a multiple of four bytes.
+     *
+     * @param[in] data
+     *     This points to the bytes to add.
+     *
+     * @param[in] size
+     *     This is the number of bytes to add.
+     */
+    void AppendPadded(
+        const void* data,
+        size_t size
+    ) {
+        const auto start = buffer.size();
+        buffer.resize(start + Padded(size), 0);
+        if (size > 0) {
+            memcpy(&buffer[start], data, size);
+        }
+    }
+
+    /**
+     * This method adds an option holding the given string to the buffer.
+     *
+     * @param[in] code
+     *     This is the code of the option.
+     *
+     * @param[in] value
+     *     This is the value of the option.
+     */
+    void AppendStringOption(
+        uint16_t code,
+        const std::string& value
+    ) {
+        Append16(code);
+        Append16((uint16_t)value.size());
+        AppendPadded(value.data(), value.size());
+    }
+
+    /**
+     * This method sets the total length of the block which starts at the
+     * given position in the buffer and ends at the end of the buffer,
+     * and adds the copy of the length which ends every block.
+     *
+     * @param[in] blockStart
+     *     This is the position in the buffer at which the block starts.
+     */
+    void FinishBlock(size_t blockStart) {
+        const auto length = (uint32_t)(buffer.size() + sizeof(uint32_t) - blockStart);
+        memcpy(&buffer[blockStart + sizeof(uint32_t)], &length, sizeof(length));
+        Append32(length);
+        fileSize += length;
+    }
+
+    /**
+     * This method adds the blocks which start each capture file to the
+     * buffer: a section header block, followed by a description
+     * of each interface.
+     */
+    void AppendHeaderBlocks() {
+        auto blockStart = buffer.size();
+        Append32(SECTION_HEADER_BLOCK_TYPE);
+        Append32(0);
+        Append32(BYTE_ORDER_MAGIC);
+        Append16(1);
+        Append16(0);
+        Append32(0xFFFFFFFF);
+        Append32(0xFFFFFFFF);
+        AppendStringOption(OPTION_SHB_USERAPPL, APPLICATION_NAME);
+        Append32(OPTION_END);
+        FinishBlock(blockStart);
+        for (const auto& interfaceName: interfaceNames) {
+            blockStart = buffer.size();
+            Append32(INTERFACE_DESCRIPTION_BLOCK_TYPE);
+            Append32(0);
+            Append16(LINKTYPE_RAW);
+            Append16(0);
+            Append32(0);
+            AppendStringOption(OPTION_IF_NAME, interfaceName);
+            Append32(OPTION_END);
+            FinishBlock(blockStart);
+        }
+        headerSize = fileSize;
+    }
+
+    /**
+     * This method writes to the capture file any bytes held in memory.
+     * If they can't be written, capturing stops.
+     */
+    void WriteBuffer() {
+        lastWrite = std::chrono::steady_clock::now();
+        if (buffer.empty()) {
+            return;
+        }
+        if (
+            (file != nullptr)
+            && (file->Write(buffer) != buffer.size())
+        ) {
+            file.reset();
+        }
+        buffer.clear();
+    }
+
+    /**
+     * This method creates a new capture file and adds the blocks
+     * which start it.
+     *
+     * @return
+     *     An indication of whether or not the capture file
+     *     could be created is returned.
+     */
+    bool StartFile() {
+        file.reset(new SystemAbstractions::File(path));
+        if (!file->Create()) {
+            file.reset();
+            return false;
+        }
+        fileSize = 0;
+        AppendHeaderBlocks();
+        return true;
+    }
+
+    /**
+     * This method finishes the capture file being written, renames it
+     * and the older capture files kept, deleting the oldest, and starts
+     * a new capture file.
+     */
+    void Rotate() {
+        WriteBuffer();
+        file.reset();
+        const auto numberedPath = [this](size_t number){
+            return StringExtensions::sprintf("%s.%zu", path.c_str(), number);
+        };
+        if (maxFiles > 1) {
+            (void)remove(numberedPath(maxFiles - 1).c_str());
+            for (size_t number = maxFiles - 1; number > 1; --number) {
+                (void)rename(
+                    numberedPath(number - 1).c_str(),
+                    numberedPath(number).c_str()
+                );
+            }
+            (void)rename(path.c_str(), numberedPath(1).c_str());
+        }
+        (void)StartFile();
+    }
+
+    /**
+     * This is the body of the worker thread, which writes the packets
+     * held in memory whenever they've been held for the longest time
+     * allowed, so that packets captured on an idle connection aren't
+     * held until more traffic comes along.
+     */
+    void Work() {
+        std::unique_lock< std::mutex > lock(mutex);
+        while (!stopWorker) {
+            const auto deadline = lastWrite + MAX_WRITE_DELAY;
+            if (std::chrono::steady_clock::now() < deadline) {
+                wakeCondition.wait_until(lock, deadline);
+            } else {
+                WriteBuffer();
+            }
+        }
+    }
+};
+
+PcapngWriter::~PcapngWriter() noexcept {
+    if (impl_ != nullptr) {
+        std::lock_guard< std::mutex > lock(impl_->mutex);
+        impl_->WriteBuffer();
+    }
+}
+PcapngWriter::PcapngWriter(PcapngWriter&&) noexcept = default;
+PcapngWriter& PcapngWriter::operator=(PcapngWriter&&) noexcept = default;
+
+PcapngWriter::PcapngWriter()
+    : impl_(new Impl())
+{
+}
+
+bool PcapngWriter::Open(
+    const std::string& path,
+    const std::vector< std::string >& interfaceNames,
+    uint64_t maxFileSize,
+    size_t maxFiles
+) {
+    std::lock_guard< std::mutex > lock(impl_->mutex);
+    impl_->WriteBuffer();
+    impl_->path = path;
+    impl_->interfaceNames = interfaceNames;
+    impl_->maxFileSize = maxFileSize;
+    impl_->maxFiles = std::max(maxFiles, (size_t)1);
+    impl_->buffer.reserve(WRITE_BUFFER_SIZE);
+    if (!impl_->StartFile()) {
+        return false;
+    }
+    impl_->lastWrite = std::chrono::steady_clock::now();
+    if (!impl_->worker.joinable()) {
+        impl_->worker = std::thread(&Impl::Work, impl_.get());
+    }
+    return true;
+}
+
+void PcapngWriter::WritePacket(
+    size_t interfaceIndex,
+    bool outbound,
+    const uint8_t* header,
+    size_t headerSize,
+    const uint8_t* payload,
+    size_t payloadSize
+) {
+    const auto now = std::chrono::duration_cast< std::chrono::microseconds >(
+        Clock::now().time_since_epoch()
+    ).count();
+    std::lock_guard< std::mutex > lock(impl_->mutex);
+    if (impl_->file == nullptr) {
+        return;
+    }
+    const auto packetSize = headerSize + payloadSize;
+    const auto blockSize = ENHANCED_PACKET_BLOCK_OVERHEAD + Padded(packetSize);
+    if (
+        (impl_->fileSize + blockSize > impl_->maxFileSize)
+        && (impl_->fileSize > impl_->headerSize)
+    ) {
+        impl_->Rotate();
+        if (impl_->file == nullptr) {
+            return;
+        }
+    }
+    const auto blockStart = impl_->buffer.size();
+    impl_->Append32(ENHANCED_PACKET_BLOCK_TYPE);
+    impl_->Append32(0);
+    impl_->Append32((uint32_t)interfaceIndex);
+    impl_->Append32((uint32_t)((uint64_t)now >> 32));
+    impl_->Append32((uint32_t)now);
+    impl_->Append32((uint32_t)packetSize);
+    impl_->Append32((uint32_t)packetSize);
+    const auto packetStart = impl_->buffer.size();
+    impl_->buffer.resize(packetStart + Padded(packetSize), 0);
+    if (headerSize > 0) {
+        memcpy(&impl_->buffer[packetStart], header, headerSize);
+    }
+    if (payloadSize > 0) {
+        memcpy(&impl_->buffer[packetStart + headerSize], payload, payloadSize);
+    }
+    impl_->Append16(OPTION_EPB_FLAGS);
+    impl_->Append16(sizeof(uint32_t));
+    impl_->Append32(outbound ? EPB_FLAGS_OUTBOUND : EPB_FLAGS_INBOUND);
+    impl_->Append32(OPTION_END);
+    impl_->FinishBlock(blockStart);
+    if (
+        (impl_->buffer.size() >= WRITE_BUFFER_SIZE)
+        || (std::chrono::steady_clock::now() - impl_->lastWrite >= MAX_WRITE_DELAY)
+    ) {
+        impl_->WriteBuffer();
+    }
+}
+
+void PcapngWriter::Flush() {
+    std::lock_guard< std::mutex > lock(impl_->mutex);
+    impl_->WriteBuffer();
+}
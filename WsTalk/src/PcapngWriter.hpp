@@ -0,0 +1,130 @@
+#pragma once
+
+/**
+ * @file PcapngWriter.hpp
+ *
+ * This module declares the PcapngWriter class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * This is used to write captured packets to files in the PCAP Next
+ * Generation (pcapng) format, which tools such as Wireshark can open.
+ * Packets are gathered in memory and written in large pieces, or by a
+ * thread of the writer's own once they've been held for a second.  When a
+ * file reaches its size limit, it's renamed with a number added to its
+ * name, older files are renumbered, the oldest is deleted, and a new file
+ * is started, so the capture never takes more than a fixed amount of space.
+ *
+ * Packets are written as raw IP packets (link type LINKTYPE_RAW), and may
+ * be written from any number of threads at once.
+ */
+class PcapngWriter {
+    // Lifecycle management
+public:
+    ~PcapngWriter() noexcept;
+    PcapngWriter(const PcapngWriter&) = delete;
+    PcapngWriter(PcapngWriter&&) noexcept;
+    PcapngWriter& operator=(const PcapngWriter&) = delete;
+    PcapngWriter& operator=(PcapngWriter&&) noexcept;
+
+    // Public Methods
+public:
+    /**
+     * This is the default constructor.
+     */
+    PcapngWriter();
+
+    /**
+     * This method starts a new capture file at the given path,
+     * replacing any file already there.
+     *
+     * @param[in] path
+     *     This is the path of the capture file to write.
+     *
+     * @param[in] interfaceNames
+     *     These are the names of the interfaces on which packets are
+     *     captured.  Packets are tagged with the index of their interface
+     *     in this list.
+     *
+     * @param[in] maxFileSize
+     *     This is the most bytes to write to each capture file before
+     *     starting another.
+     *
+     * @param[in] maxFiles
+     *     This is the most capture files to keep, including the one
+     *     currently being written.
+     *
+     * @return
+     *     An indication of whether or not the capture file
+     *     could be created is returned.
+     */
+    bool Open(
+        const std::string& path,
+        const std::vector< std::string >& interfaceNames,
+        uint64_t maxFileSize,
+        size_t maxFiles
+    );
+
+    /**
+     * This method adds a packet to the capture, time-stamped with the
+     * current time.  The packet is given in two parts, which are
+     * written one after the other, so that headers made up for the
+     * packet needn't be copied in front of its payload.
+     *
+     * @param[in] interfaceIndex
+     *     This is the index of the interface on which the packet
+     *     was captured.
+     *
+     * @param[in] outbound
+     *     This indicates whether the packet was sent (true)
+     *     or received (false).
+     *
+     * @param[in] header
+     *     This points to the first part of the packet.
+     *
+     * @param[in] headerSize
+     *     This is the number of bytes in the first part of the packet.
+     *
+     * @param[in] payload
+     *     This points to the second part of the packet.
+     *
+     * @param[in] payloadSize
+     *     This is the number of bytes in the second part of the packet.
+     */
+    void WritePacket(
+        size_t interfaceIndex,
+        bool outbound,
+        const uint8_t* header,
+        size_t headerSize,
+        const uint8_t* payload,
+        size_t payloadSize
+    );
+
+    /**
+     * This method writes to the capture file any packets
+     * not yet written.
+     */
+    void Flush();
+
+    // Private Properties
+private:
+    /**
+     * This is the type of structure that contains the private
+     * properties of the instance.  It is defined in the implementation
+     * and declared here to ensure that it is scoped inside the class.
+     */
+    struct Impl;
+
+    /**
+     * This contains the private properties of the instance.
+     */
+    std::unique_ptr< Impl > impl_;
+};
@@ -0,0 +1,403 @@
+/**
+ * @file PingProber.cpp
+ *
+ * This module contains the implementation of the function used to measure
+ * the round-trip time of WebSocket pings to a server.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "HdrHistogram.hpp"
+#include "PingProber.hpp"
+#include "WebSocketOpener.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <inttypes.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <StringExtensions/StringExtensions.hpp>
+#include <thread>
+
+namespace {
+
+    /**
+     * This is the type of clock used to time everything.
+     */
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * This is the longest to sleep between checks for things to do.
+     */
+    constexpr std::chrono::milliseconds MAX_SLEEP(50);
+
+    /**
+     * This is the highest round-trip time, in microseconds, which can
+     * be told apart from higher ones (one hour).
+     */
+    constexpr uint64_t HIGHEST_RTT = 3600000000;
+
+    /**
+     * This is the number of significant decimal digits of round-trip
+     * times to keep.
+     */
+    constexpr int RTT_SIGNIFICANT_DIGITS = 3;
+
+    /**
+     * These are the percentiles listed in the final report.
+     */
+    constexpr double REPORT_PERCENTILES[] = {
+        50.0, 75.0, 90.0, 95.0, 99.0, 99.9, 99.99, 100.0
+    };
+
+    /**
+     * This is the format of the payload of every ping.  It holds the
+     * sequence number of the ping and the time it was sent, in nanoseconds.
+     */
+    constexpr const char* PING_FORMAT = "WsTalk %" PRIu64 " %" PRIu64;
+
+    /**
+     * This is the format used to scan the payload of pongs received,
+     * matching the format used to send pings.
+     */
+    constexpr const char* PONG_SCAN_FORMAT = "WsTalk %" SCNu64 " %" SCNu64;
+
+    /**
+     * This holds what's shared with the delegates of the WebSocket,
+     * which are called from the WebSocket's own thread.
+     */
+    struct ProbeState {
+        /**
+         * This is used to synchronize access to the state.
+         */
+        std::mutex mutex;
+
+        /**
+         * These are the times, in nanoseconds, at which pings not yet
+         * answered were sent, keyed by sequence number.
+         */
+        std::map< uint64_t, uint64_t > outstanding;
+
+        /**
+         * This is the sequence number of the next ping to send.
+         */
+        uint64_t nextSequence = 1;
+
+        /**
+         * These are the round-trip times, in microseconds, measured
+         * since the last summary.
+         */
+        HdrHistogram intervalRtts{1, HIGHEST_RTT, RTT_SIGNIFICANT_DIGITS};
+
+        /**
+         * This is the number of pongs matched to pings since
+         * the last summary.
+         */
+        uint64_t intervalReceived = 0;
+
+        /**
+         * This is the number of pings counted as lost since
+         * the last summary.
+         */
+        uint64_t intervalLost = 0;
+
+        /**
+         * This is the number of pongs received after their pings
+         * were counted as lost.
+         */
+        uint64_t late = 0;
+
+        /**
+         * This is the number of pongs received which don't answer
+         * any ping sent.
+         */
+        uint64_t unexpected = 0;
+
+        /**
+         * This indicates whether or not the WebSocket was closed.
+         */
+        bool closed = false;
+    };
+
+    /**
+     * This function returns the number of nanoseconds since the epoch
+     * of the clock used to time everything.
+     *
+     * @param[in] time
+     *     This is the time to convert.
+     *
+     * @return
+     *     The number of nanoseconds since the epoch of the clock
+     *     is returned.
+     */
+    uint64_t Nanoseconds(Clock::time_point time) {
+        return (uint64_t)std::chrono::duration_cast< std::chrono::nanoseconds >(
+            time.time_since_epoch()
+        ).count();
+    }
+
+    /**
+     * This function converts the given number of seconds into
+     * a clock duration.
+     *
+     * @param[in] seconds
+     *     This is the number of seconds to convert.
+     *
+     * @return
+     *     The clock duration is returned.
+     */
+    Clock::duration ToDuration(double seconds) {
+        return std::chrono::duration_cast< Clock::duration >(
+            std::chrono::duration< double >(seconds)
+        );
+    }
+
+}
+
+bool RunPingProber(
+    Http::Client& client,
+    const Uri::Uri& url,
+    const PingConfiguration& configuration,
+    const bool& shutDown,
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+) {
+    if (
+        (configuration.interval <= 0.0)
+        || (configuration.reportInterval <= 0.0)
+    ) {
+        diagnosticMessageDelegate(
+            "WsTalk",
+            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+            "ping and report intervals must be greater than zero"
+        );
+        return false;
+    }
+
+    // Open the WebSocket, matching pongs to pings as they arrive.
+    const auto state = std::make_shared< ProbeState >();
+    WebSockets::WebSocket::Delegates wsDelegates;
+    wsDelegates.pong = [state](const std::string& data){
+        const auto received = Nanoseconds(Clock::now());
+        uint64_t sequence, sent;
+        std::lock_guard< std::mutex > lock(state->mutex);
+        if (sscanf(data.c_str(), PONG_SCAN_FORMAT, &sequence, &sent) != 2) {
+            ++state->unexpected;
+            return;
+        }
+        const auto outstandingEntry = state->outstanding.find(sequence);
+        if (
+            (outstandingEntry == state->outstanding.end())
+            || (outstandingEntry->second != sent)
+        ) {
+            if (sequence < state->nextSequence) {
+                ++state->late;
+            } else {
+                ++state->unexpected;
+            }
+            return;
+        }
+        state->outstanding.erase(outstandingEntry);
+        state->intervalRtts.Record((received - sent) / 1000);
+        ++state->intervalReceived;
+    };
+    wsDelegates.close = [state](
+        unsigned int code,
+        const std::string& reason
+    ){
+        std::lock_guard< std::mutex > lock(state->mutex);
+        state->closed = true;
+    };
+    diagnosticMessageDelegate(
+        "WsTalk",
+        3,
+        "Connecting to '" + url.GenerateString() + "'..."
+    );
+    WebSocketOpener opener;
+    opener.Start(client, url, std::move(wsDelegates), nullptr);
+    auto openState = WebSocketOpener::State::Opening;
+    while (
+        !shutDown
+        && (openState == WebSocketOpener::State::Opening)
+    ) {
+        openState = opener.Await(std::chrono::milliseconds(100));
+    }
+    if (openState != WebSocketOpener::State::Open) {
+        if (!shutDown) {
+            diagnosticMessageDelegate(
+                "WsTalk",
+                SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                opener.GetError()
+            );
+        }
+        return false;
+    }
+    const auto ws = opener.GetWebSocket();
+    diagnosticMessageDelegate(
+        "WsTalk",
+        3,
+        StringExtensions::sprintf(
+            "Sending a ping every %g seconds; press <Ctrl>+<C> to stop.",
+            configuration.interval
+        )
+    );
+
+    // Send pings at the configured interval, counting as lost those
+    // not answered in time, and summarize each report interval.
+    const auto interval = ToDuration(configuration.interval);
+    const auto reportInterval = ToDuration(configuration.reportInterval);
+    const auto timeout = ToDuration(configuration.timeout);
+    const auto start = Clock::now();
+    const auto end = start + ToDuration(configuration.duration);
+    auto nextPing = start;
+    auto nextReport = start + reportInterval;
+    HdrHistogram totalRtts(1, HIGHEST_RTT, RTT_SIGNIFICANT_DIGITS);
+    uint64_t sent = 0;
+    uint64_t intervalSent = 0;
+    uint64_t totalReceived = 0;
+    uint64_t totalLost = 0;
+    bool closed = false;
+    printf("  time  sent  recv  lost       p50       p90       p99       max (ms)\n");
+    const auto summarize = [&](Clock::time_point now){
+        std::lock_guard< std::mutex > lock(state->mutex);
+        const auto& rtts = state->intervalRtts;
+        printf(
+            "%6.1f %5" PRIu64 " %5" PRIu64 " %5" PRIu64 " %9.3f %9.3f %9.3f %9.3f\n",
+            std::chrono::duration< double >(now - start).count(),
+            intervalSent,
+            state->intervalReceived,
+            state->intervalLost,
+            (double)rtts.GetValueAtPercentile(50.0) / 1000.0,
+            (double)rtts.GetValueAtPercentile(90.0) / 1000.0,
+            (double)rtts.GetValueAtPercentile(99.0) / 1000.0,
+            (double)rtts.GetMax() / 1000.0
+        );
+        totalRtts.Add(rtts);
+        totalReceived += state->intervalReceived;
+        totalLost += state->intervalLost;
+        state->intervalRtts.Reset();
+        state->intervalReceived = 0;
+        state->intervalLost = 0;
+        intervalSent = 0;
+    };
+    while (
+        !shutDown
+        && !closed
+        && (
+            (configuration.duration <= 0.0)
+            || (Clock::now() < end)
+        )
+    ) {
+        const auto now = Clock::now();
+        if (now >= nextPing) {
+            uint64_t sequence;
+            const auto pingTime = Nanoseconds(now);
+            {
+                std::lock_guard< std::mutex > lock(state->mutex);
+                sequence = state->nextSequence++;
+                state->outstanding[sequence] = pingTime;
+            }
+            ws->Ping(StringExtensions::sprintf(PING_FORMAT, sequence, pingTime));
+            ++sent;
+            ++intervalSent;
+            nextPing += interval;
+            if (nextPing < now) {
+                nextPing = now;
+            }
+        }
+        {
+            std::lock_guard< std::mutex > lock(state->mutex);
+            const auto nowNs = Nanoseconds(now);
+            const auto timeoutNs = (uint64_t)std::chrono::duration_cast< std::chrono::nanoseconds >(timeout).count();
+            const auto expired = (
+                (nowNs > timeoutNs)
+                ? nowNs - timeoutNs
+                : 0
+            );
+            while (
+                !state->outstanding.empty()
+                && (state->outstanding.begin()->second < expired)
+            ) {
+                state->outstanding.erase(state->outstanding.begin());
+                ++state->intervalLost;
+            }
+            closed = state->closed;
+        }
+        if (now >= nextReport) {
+            summarize(now);
+            nextReport += reportInterval;
+        }
+        std::this_thread::sleep_for(
+            std::min(
+                std::chrono::duration_cast< Clock::duration >(MAX_SLEEP),
+                std::max(
+                    Clock::duration::zero(),
+                    std::min(nextPing, nextReport) - Clock::now()
+                )
+            )
+        );
+    }
+    if (closed) {
+        diagnosticMessageDelegate(
+            "WsTalk",
+            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+            "WebSocket closed by server"
+        );
+    }
+
+    // Give the last pings time to be answered, and then count
+    // those still unanswered as lost.
+    const auto drainDeadline = Clock::now() + timeout;
+    while (
+        !closed
+        && (Clock::now() < drainDeadline)
+    ) {
+        {
+            std::lock_guard< std::mutex > lock(state->mutex);
+            if (state->outstanding.empty()) {
+                break;
+            }
+            closed = state->closed;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    {
+        std::lock_guard< std::mutex > lock(state->mutex);
+        state->intervalLost += state->outstanding.size();
+        state->outstanding.clear();
+    }
+    summarize(Clock::now());
+    if (!closed) {
+        ws->Close(1000, "Kthxbye");
+    }
+
+    // Report the distribution of all round-trip times measured.
+    std::lock_guard< std::mutex > lock(state->mutex);
+    printf(
+        "\nPings: %" PRIu64 " sent, %" PRIu64 " answered, %" PRIu64 " lost, %" PRIu64 " answered late, %" PRIu64 " unexpected pongs\n",
+        sent,
+        totalReceived,
+        totalLost,
+        state->late,
+        state->unexpected
+    );
+    if (totalRtts.GetCount() > 0) {
+        printf(
+            "Round-trip time (ms): min %.3f, mean %.3f, max %.3f\n",
+            (double)totalRtts.GetMin() / 1000.0,
+            totalRtts.GetMean() / 1000.0,
+            (double)totalRtts.GetMax() / 1000.0
+        );
+        for (const auto percentile: REPORT_PERCENTILES) {
+            printf(
+                "  %7.3f%%  %10.3f ms\n",
+                percentile,
+                (double)totalRtts.GetValueAtPercentile(percentile) / 1000.0
+            );
+        }
+    }
+    return !closed;
+}
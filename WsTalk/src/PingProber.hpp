@@ -0,0 +1,78 @@
+#pragma once
+
+/**
+ * @file PingProber.hpp
+ *
+ * This module declares the function used to measure the round-trip time
+ * of WebSocket pings to a server.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <Http/Client.hpp>
+#include <SystemAbstractions/DiagnosticsSender.hpp>
+#include <Uri/Uri.hpp>
+
+/**
+ * This holds the settings which control the probing of a server
+ * with WebSocket pings.
+ */
+struct PingConfiguration {
+    /**
+     * This is the number of seconds between pings.
+     */
+    double interval = 1.0;
+
+    /**
+     * This is the number of seconds to keep probing.  If zero,
+     * probing continues until the program is interrupted.
+     */
+    double duration = 0.0;
+
+    /**
+     * This is the number of seconds between summaries of the
+     * round-trip times measured.
+     */
+    double reportInterval = 10.0;
+
+    /**
+     * This is the number of seconds to wait for the pong answering
+     * a ping before counting the ping as lost.
+     */
+    double timeout = 5.0;
+};
+
+/**
+ * This function opens a WebSocket to the server at the given URL and sends
+ * pings over it at a fixed interval, each carrying a sequence number and the
+ * time it was sent, matching each pong received to its ping to measure the
+ * round-trip time.  Round-trip times are recorded in high dynamic range
+ * histograms.  A summary of the round-trip times measured since the last
+ * summary is printed at a fixed interval, followed by a report of the
+ * distribution of all of them at the end.
+ *
+ * @param[in,out] client
+ *     This is the client to use to connect to the server.
+ *
+ * @param[in] url
+ *     This is the URL of the server to which to connect.
+ *
+ * @param[in] configuration
+ *     This holds the settings which control the probing.
+ *
+ * @param[in] shutDown
+ *     This is a flag which is set when probing should stop.
+ *
+ * @param[in] diagnosticMessageDelegate
+ *     This is the function to call to publish any diagnostic messages.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool RunPingProber(
+    Http::Client& client,
+    const Uri::Uri& url,
+    const PingConfiguration& configuration,
+    const bool& shutDown,
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+);
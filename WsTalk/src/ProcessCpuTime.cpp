@@ -0,0 +1,42 @@
+/**
+ * @file ProcessCpuTime.cpp
+ *
+ * This module contains the implementation of the function used to find
+ * out how much processor time the program has spent.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "ProcessCpuTime.hpp"
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else /* POSIX */
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif /* _WIN32 or POSIX */
+
+double GetProcessCpuTime() {
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0.0;
+    }
+    const auto toSeconds = [](const FILETIME& time){
+        return (double)(((uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime) / 1e7;
+    };
+    return toSeconds(kernelTime) + toSeconds(userTime);
+#else /* POSIX */
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+    return (
+        (double)usage.ru_utime.tv_sec + (double)usage.ru_utime.tv_usec / 1e6
+        + (double)usage.ru_stime.tv_sec + (double)usage.ru_stime.tv_usec / 1e6
+    );
+#endif /* _WIN32 or POSIX */
+}
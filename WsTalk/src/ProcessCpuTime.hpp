@@ -0,0 +1,20 @@
+#pragma once
+
+/**
+ * @file ProcessCpuTime.hpp
+ *
+ * This module declares the function used to find out how much processor
+ * time the program has spent.
+ *
+ * © 2019 by Richard Walters
+ */
+
+/**
+ * This function returns the processor time, in seconds, the program
+ * has spent so far, in both user and kernel mode, on all threads.
+ *
+ * @return
+ *     The processor time, in seconds, spent by the program
+ *     is returned.
+ */
+double GetProcessCpuTime();
@@ -0,0 +1,197 @@
+/**
+ * @file RequestBenchmark.cpp
+ *
+ * This module contains the implementation of the function used to measure
+ * how fast plain HTTP requests can be made to a server, with and without
+ * keeping connections open to be reused.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "HdrHistogram.hpp"
+#include "RequestBenchmark.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <inttypes.h>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <StringExtensions/StringExtensions.hpp>
+
+namespace {
+
+    /**
+     * This is the type of clock used to time everything.
+     */
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * This is the highest time, in microseconds, which can be recorded
+     * for a request to be answered.
+     */
+    constexpr uint64_t HIGHEST_REQUEST_TIME = 60 * 1000 * 1000;
+
+    /**
+     * This is the number of significant digits kept of each time
+     * recorded for a request to be answered.
+     */
+    constexpr int REQUEST_TIME_SIGNIFICANT_DIGITS = 3;
+
+    /**
+     * This holds a request made but not yet answered.
+     */
+    struct InFlightRequest {
+        /**
+         * This is the time the request was made.
+         */
+        Clock::time_point start;
+
+        /**
+         * This is the time, as a count of clock ticks, at which the request
+         * was completed, or zero if it hasn't been yet.  It's set by the
+         * transaction's completion delegate, so that a request answered
+         * while an earlier one is still awaited isn't charged for the wait.
+         */
+        std::shared_ptr< std::atomic< Clock::rep > > end;
+
+        /**
+         * This is used to wait for the request to be answered.
+         */
+        std::shared_ptr< Http::Client::Transaction > transaction;
+    };
+
+    /**
+     * This function returns a description of the given transaction
+     * state, for use in diagnostic messages.
+     *
+     * @param[in] state
+     *     This is the transaction state to describe.
+     *
+     * @return
+     *     A description of the given transaction state is returned.
+     */
+    const char* DescribeFailure(Http::Client::Transaction::State state) {
+        switch (state) {
+            case Http::Client::Transaction::State::UnableToConnect: return "unable to connect";
+            case Http::Client::Transaction::State::Broken: return "connection broken by server";
+            case Http::Client::Transaction::State::Timeout: return "timeout waiting for response";
+            default: return "request failed";
+        }
+    }
+
+}
+
+bool RunRequestBenchmark(
+    Http::Client& client,
+    const Uri::Uri& url,
+    const RequestConfiguration& configuration,
+    std::shared_ptr< const TrafficMetrics > connectionMetrics,
+    const bool& shutDown,
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+) {
+    diagnosticMessageDelegate(
+        "WsTalk",
+        3,
+        StringExtensions::sprintf(
+            "Making %zu requests to '%s' at each depth, closing and then keeping connections...",
+            configuration.requests,
+            url.GenerateString().c_str()
+        )
+    );
+    Http::Request request;
+    request.method = "GET";
+    request.target = url;
+    request.headers.SetHeader("Host", url.GetHost());
+    bool succeeded = true;
+    printf("connections  depth  requests  failures     req/s    p50 ms    p99 ms    max ms  new conns  reused\n");
+    for (int persistConnection = 0; persistConnection < 2; ++persistConnection) {
+        for (const auto depth: configuration.depths) {
+            if (shutDown) {
+                break;
+            }
+            HdrHistogram requestTimes(1, HIGHEST_REQUEST_TIME, REQUEST_TIME_SIGNIFICANT_DIGITS);
+            uint64_t failures = 0;
+            std::deque< InFlightRequest > inFlight;
+            const auto awaitOldest = [&]{
+                const auto& oldest = inFlight.front();
+                while (
+                    !shutDown
+                    && !oldest.transaction->AwaitCompletion(std::chrono::milliseconds(100))
+                ) {
+                }
+                if (!shutDown) {
+                    if (oldest.transaction->state == Http::Client::Transaction::State::Completed) {
+                        const auto endTicks = oldest.end->load();
+                        const auto end = (
+                            (endTicks == 0)
+                            ? Clock::now()
+                            : Clock::time_point(Clock::duration(endTicks))
+                        );
+                        requestTimes.Record(
+                            (uint64_t)std::chrono::duration_cast< std::chrono::microseconds >(
+                                end - oldest.start
+                            ).count()
+                        );
+                    } else {
+                        if (failures == 0) {
+                            diagnosticMessageDelegate(
+                                "WsTalk",
+                                SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                                DescribeFailure(oldest.transaction->state)
+                            );
+                        }
+                        ++failures;
+                    }
+                }
+                inFlight.pop_front();
+            };
+            const auto connectionsBefore = connectionMetrics->GetSnapshot().connections;
+            const auto start = Clock::now();
+            for (size_t i = 0; i < configuration.requests; ++i) {
+                if (shutDown) {
+                    break;
+                }
+                if (inFlight.size() >= depth) {
+                    awaitOldest();
+                }
+                InFlightRequest inFlightRequest;
+                inFlightRequest.start = Clock::now();
+                inFlightRequest.end = std::make_shared< std::atomic< Clock::rep > >(0);
+                inFlightRequest.transaction = client.Request(request, (persistConnection != 0));
+                const auto end = inFlightRequest.end;
+                inFlightRequest.transaction->SetCompletionDelegate(
+                    [end]{
+                        end->store(Clock::now().time_since_epoch().count());
+                    }
+                );
+                inFlight.push_back(std::move(inFlightRequest));
+            }
+            while (!inFlight.empty()) {
+                awaitOldest();
+            }
+            const auto seconds = std::chrono::duration< double >(Clock::now() - start).count();
+            const auto answered = requestTimes.GetCount();
+            const auto newConnections = connectionMetrics->GetSnapshot().connections - connectionsBefore;
+            printf(
+                "%11s %6zu %9" PRIu64 " %9" PRIu64 " %9.1f %9.3f %9.3f %9.3f %10" PRIu64 " %7" PRIu64 "\n",
+                (persistConnection ? "kept" : "closed"),
+                depth,
+                answered + failures,
+                failures,
+                (seconds > 0.0) ? (double)answered / seconds : 0.0,
+                (double)requestTimes.GetValueAtPercentile(50.0) / 1000.0,
+                (double)requestTimes.GetValueAtPercentile(99.0) / 1000.0,
+                (double)requestTimes.GetMax() / 1000.0,
+                newConnections,
+                answered + failures - std::min(answered + failures, newConnections)
+            );
+            if (failures > 0) {
+                succeeded = false;
+            }
+        }
+    }
+    return succeeded;
+}
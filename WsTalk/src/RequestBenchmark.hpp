@@ -0,0 +1,78 @@
+#pragma once
+
+/**
+ * @file RequestBenchmark.hpp
+ *
+ * This module declares the function used to measure how fast plain HTTP
+ * requests can be made to a server, with and without keeping connections
+ * open to be reused.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "TrafficMetrics.hpp"
+
+#include <Http/Client.hpp>
+#include <memory>
+#include <stddef.h>
+#include <SystemAbstractions/DiagnosticsSender.hpp>
+#include <Uri/Uri.hpp>
+#include <vector>
+
+/**
+ * This holds the settings which control the request benchmark.
+ */
+struct RequestConfiguration {
+    /**
+     * This is the number of requests to make in each run.
+     */
+    size_t requests = 100;
+
+    /**
+     * These are the numbers of requests to have in flight at once,
+     * in a run for each.
+     */
+    std::vector< size_t > depths = {1};
+};
+
+/**
+ * This function makes GET requests to the given URL, keeping up to a given
+ * number in flight at once, and waiting for their responses in the order
+ * the requests were made, for each configured number, twice over: first
+ * asking for each connection to be closed after its response, and then
+ * asking for connections to be kept open, so that the client can reuse
+ * them.  A line is printed for each run giving the requests made per
+ * second, percentiles of the time each took, and the number of new
+ * connections made, counted at the given layer, along with the number of
+ * requests which reused a connection instead.
+ *
+ * @param[in,out] client
+ *     This is the client to use to make the requests.
+ *
+ * @param[in] url
+ *     This is the URL to request.
+ *
+ * @param[in] configuration
+ *     These are the settings which control the benchmark.
+ *
+ * @param[in] connectionMetrics
+ *     This is where the client's connections are counted.
+ *
+ * @param[in] shutDown
+ *     This is a flag which is set when the benchmark should stop early.
+ *
+ * @param[in] diagnosticMessageDelegate
+ *     This is the function to call to publish any diagnostic messages.
+ *
+ * @return
+ *     An indication of whether or not every request was answered
+ *     is returned.
+ */
+bool RunRequestBenchmark(
+    Http::Client& client,
+    const Uri::Uri& url,
+    const RequestConfiguration& configuration,
+    std::shared_ptr< const TrafficMetrics > connectionMetrics,
+    const bool& shutDown,
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+);
@@ -0,0 +1,24 @@
+/**
+ * @file Statistics.cpp
+ *
+ * This module contains the implementation of functions used to
+ * summarize measurements.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Statistics.hpp"
+
+#include <algorithm>
+#include <stddef.h>
+
+double Percentile(
+    const std::vector< double >& sorted,
+    double percentile
+) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const auto rank = (size_t)(percentile / 100.0 * (double)(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * @file Statistics.hpp
+ *
+ * This module declares functions used to summarize measurements.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <vector>
+
+/**
+ * This function returns the given percentile of the given samples.
+ *
+ * @param[in] sorted
+ *     These are the samples, in increasing order.
+ *
+ * @param[in] percentile
+ *     This is the percentile to return, from 0 to 100.
+ *
+ * @return
+ *     The given percentile of the samples is returned,
+ *     or zero if there are no samples.
+ */
+double Percentile(
+    const std::vector< double >& sorted,
+    double percentile
+);
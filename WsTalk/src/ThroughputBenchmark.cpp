@@ -0,0 +1,421 @@
+/**
+ * @file ThroughputBenchmark.cpp
+ *
+ * This module contains the implementation of the function used to measure
+ * how fast binary WebSocket messages of different sizes can be sent to an
+ * echo endpoint and received back.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "ProcessCpuTime.hpp"
+#include "ThroughputBenchmark.hpp"
+#include "WebSocketOpener.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <inttypes.h>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <StringExtensions/StringExtensions.hpp>
+
+namespace {
+
+    /**
+     * This is the type of clock used to time everything.
+     */
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * This is the most messages to have sent but not yet received back.
+     */
+    constexpr size_t MAX_IN_FLIGHT_MESSAGES = 64;
+
+    /**
+     * This is the most bytes of messages to have sent but not yet
+     * received back, unless a single message is larger.
+     */
+    constexpr size_t MAX_IN_FLIGHT_BYTES = 4 * 1024 * 1024;
+
+    /**
+     * This is the fewest messages of each size to send, however
+     * long they take.
+     */
+    constexpr uint64_t MIN_MESSAGES = 4;
+
+    /**
+     * This is the longest to wait for the last messages sent
+     * to be received back.
+     */
+    constexpr std::chrono::seconds ECHO_TIMEOUT(30);
+
+    /**
+     * This is the number of bytes at the start of each message which
+     * hold its sequence number, so that echoes can be checked.
+     */
+    constexpr size_t STAMP_SIZE = 8;
+
+    /**
+     * This holds what's shared with the delegates of the WebSocket,
+     * which are called from the WebSocket's own thread.
+     */
+    struct EchoState {
+        /**
+         * This is used to synchronize access to the state.
+         */
+        std::mutex mutex;
+
+        /**
+         * This is used to wait for messages to be received back.
+         */
+        std::condition_variable condition;
+
+        /**
+         * This is the size of the messages being sent.
+         */
+        size_t messageSize = 0;
+
+        /**
+         * This is the number of messages received back.
+         */
+        uint64_t received = 0;
+
+        /**
+         * This is the number of messages received back which weren't
+         * the size sent, or didn't have the sequence number expected.
+         */
+        uint64_t mismatched = 0;
+
+        /**
+         * This indicates whether or not the WebSocket was closed.
+         */
+        bool closed = false;
+    };
+
+    /**
+     * This function stores the given sequence number at the start of the
+     * given message, or as much of it as fits.
+     *
+     * @param[in,out] message
+     *     This is the message in which to store the sequence number.
+     *
+     * @param[in] sequence
+     *     This is the sequence number to store.
+     */
+    void Stamp(
+        std::string& message,
+        uint64_t sequence
+    ) {
+        const auto stampSize = std::min(STAMP_SIZE, message.size());
+        for (size_t i = 0; i < stampSize; ++i) {
+            message[i] = (char)(uint8_t)(sequence >> (i * 8));
+        }
+    }
+
+    /**
+     * This function checks that the given message starts with the
+     * given sequence number, or as much of it as fits.
+     *
+     * @param[in] message
+     *     This is the message to check.
+     *
+     * @param[in] sequence
+     *     This is the sequence number expected.
+     *
+     * @return
+     *     An indication of whether or not the message starts with
+     *     the given sequence number is returned.
+     */
+    bool CheckStamp(
+        const std::string& message,
+        uint64_t sequence
+    ) {
+        const auto stampSize = std::min(STAMP_SIZE, message.size());
+        for (size_t i = 0; i < stampSize; ++i) {
+            if (message[i] != (char)(uint8_t)(sequence >> (i * 8))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * This function opens a WebSocket to the echo endpoint, counting
+     * the messages received back in the given state.
+     *
+     * @param[in,out] client
+     *     This is the client to use to connect to the server.
+     *
+     * @param[in] url
+     *     This is the URL of the echo endpoint to which to connect.
+     *
+     * @param[in] state
+     *     This is where to count the messages received back.
+     *
+     * @param[in] shutDown
+     *     This is a flag which is set when opening should be canceled.
+     *
+     * @param[in] diagnosticMessageDelegate
+     *     This is the function to call to publish any diagnostic messages.
+     *
+     * @return
+     *     The WebSocket is returned.
+     *
+     * @retval nullptr
+     *     This is returned if the WebSocket could not be opened.
+     */
+    std::shared_ptr< WebSockets::WebSocket > OpenEcho(
+        Http::Client& client,
+        const Uri::Uri& url,
+        std::shared_ptr< EchoState > state,
+        const bool& shutDown,
+        SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+    ) {
+        WebSockets::WebSocket::Delegates wsDelegates;
+        wsDelegates.binary = [state](const std::string& data){
+            std::lock_guard< std::mutex > lock(state->mutex);
+            if (
+                (data.size() != state->messageSize)
+                || !CheckStamp(data, state->received)
+            ) {
+                ++state->mismatched;
+            }
+            ++state->received;
+            state->condition.notify_all();
+        };
+        wsDelegates.text = [state](const std::string& data){
+            std::lock_guard< std::mutex > lock(state->mutex);
+            ++state->mismatched;
+            ++state->received;
+            state->condition.notify_all();
+        };
+        wsDelegates.close = [state](
+            unsigned int code,
+            const std::string& reason
+        ){
+            std::lock_guard< std::mutex > lock(state->mutex);
+            state->closed = true;
+            state->condition.notify_all();
+        };
+        WebSocketOpener opener;
+        opener.Start(client, url, std::move(wsDelegates), nullptr);
+        auto openState = WebSocketOpener::State::Opening;
+        while (
+            !shutDown
+            && (openState == WebSocketOpener::State::Opening)
+        ) {
+            openState = opener.Await(std::chrono::milliseconds(100));
+        }
+        if (openState != WebSocketOpener::State::Open) {
+            if (!shutDown) {
+                diagnosticMessageDelegate(
+                    "WsTalk",
+                    SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                    opener.GetError()
+                );
+            }
+            return nullptr;
+        }
+        return opener.GetWebSocket();
+    }
+
+}
+
+bool RunThroughputBenchmark(
+    Http::Client& client,
+    const Uri::Uri& url,
+    const ThroughputConfiguration& configuration,
+    const bool& shutDown,
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+) {
+    const auto scheme = url.GetScheme();
+    diagnosticMessageDelegate(
+        "WsTalk",
+        3,
+        StringExtensions::sprintf(
+            "Measuring throughput to '%s' (%s)...",
+            url.GenerateString().c_str(),
+            (
+                ((scheme == "wss") || (scheme == "https"))
+                ? "TLS"
+                : "plain TCP"
+            )
+        )
+    );
+    auto state = std::make_shared< EchoState >();
+    std::shared_ptr< WebSockets::WebSocket > ws;
+    bool succeeded = true;
+    const auto duration = std::chrono::duration_cast< Clock::duration >(
+        std::chrono::duration< double >(configuration.duration)
+    );
+    printf("     size  fragment      msgs    msgs/s      MB/s  CPU ms/MB CPU us/msg  errors\n");
+    for (const auto messageSize: configuration.messageSizes) {
+        for (int fragmented = 0; fragmented < 2; ++fragmented) {
+            if (shutDown) {
+                break;
+            }
+            size_t fragmentSize = messageSize;
+            if (fragmented) {
+                if (
+                    (configuration.fragmentSize == 0)
+                    || (configuration.fragmentSize >= messageSize)
+                ) {
+                    continue;
+                }
+                fragmentSize = configuration.fragmentSize;
+            }
+
+            // Open the WebSocket, or open it again if the server
+            // closed it during the last run.
+            if (ws == nullptr) {
+                state = std::make_shared< EchoState >();
+                ws = OpenEcho(client, url, state, shutDown, diagnosticMessageDelegate);
+                if (ws == nullptr) {
+                    succeeded = false;
+                    break;
+                }
+            }
+            {
+                std::lock_guard< std::mutex > lock(state->mutex);
+                state->messageSize = messageSize;
+                state->received = 0;
+                state->mismatched = 0;
+            }
+
+            // Send messages for the configured time, waiting for some
+            // to be received back whenever too many are in flight.
+            std::string message(messageSize, 'X');
+            const auto maxInFlight = std::max(
+                (size_t)1,
+                std::min(MAX_IN_FLIGHT_MESSAGES, MAX_IN_FLIGHT_BYTES / messageSize)
+            );
+            uint64_t sent = 0;
+            bool closed = false;
+            const auto cpuStart = GetProcessCpuTime();
+            const auto start = Clock::now();
+            const auto end = start + duration;
+            while (
+                !shutDown
+                && !closed
+                && (
+                    (Clock::now() < end)
+                    || (sent < MIN_MESSAGES)
+                )
+            ) {
+                {
+                    std::unique_lock< std::mutex > lock(state->mutex);
+                    (void)state->condition.wait_for(
+                        lock,
+                        std::chrono::milliseconds(100),
+                        [state, sent, maxInFlight]{
+                            return (
+                                state->closed
+                                || (sent - state->received < maxInFlight)
+                            );
+                        }
+                    );
+                    closed = state->closed;
+                    if (sent - state->received >= maxInFlight) {
+                        continue;
+                    }
+                }
+                Stamp(message, sent);
+                if (fragmentSize < messageSize) {
+                    for (size_t offset = 0; offset < messageSize; offset += fragmentSize) {
+                        const auto last = (offset + fragmentSize >= messageSize);
+                        ws->SendBinary(message.substr(offset, fragmentSize), last);
+                    }
+                } else {
+                    ws->SendBinary(message);
+                }
+                ++sent;
+            }
+
+            // Wait for the last messages to be received back.
+            uint64_t received, mismatched;
+            {
+                std::unique_lock< std::mutex > lock(state->mutex);
+                (void)state->condition.wait_for(
+                    lock,
+                    ECHO_TIMEOUT,
+                    [state, sent]{
+                        return (
+                            state->closed
+                            || (state->received >= sent)
+                        );
+                    }
+                );
+                closed = state->closed;
+                received = state->received;
+                mismatched = state->mismatched;
+            }
+            const auto seconds = std::chrono::duration< double >(Clock::now() - start).count();
+            const auto cpuSeconds = GetProcessCpuTime() - cpuStart;
+            const auto megabytes = (double)received * (double)messageSize / 1e6;
+            const auto lost = sent - std::min(sent, received);
+            printf(
+                "%9zu %9s %9" PRIu64 " %9.1f %9.2f %10.3f %10.2f %7" PRIu64 "\n",
+                messageSize,
+                (
+                    (fragmentSize < messageSize)
+                    ? std::to_string(fragmentSize).c_str()
+                    : "-"
+                ),
+                received,
+                (double)received / seconds,
+                megabytes / seconds,
+                (
+                    (megabytes > 0.0)
+                    ? cpuSeconds * 1000.0 / megabytes
+                    : 0.0
+                ),
+                (
+                    (received > 0)
+                    ? cpuSeconds * 1e6 / (double)received
+                    : 0.0
+                ),
+                mismatched + lost
+            );
+            if (closed) {
+                diagnosticMessageDelegate(
+                    "WsTalk",
+                    SystemAbstractions::DiagnosticsSender::Levels::WARNING,
+                    StringExtensions::sprintf(
+                        "WebSocket closed by server while sending %zu-byte messages",
+                        messageSize
+                    )
+                );
+                ws = nullptr;
+            } else if (lost > 0) {
+                diagnosticMessageDelegate(
+                    "WsTalk",
+                    SystemAbstractions::DiagnosticsSender::Levels::WARNING,
+                    StringExtensions::sprintf(
+                        "%" PRIu64 " messages not received back in time; reconnecting",
+                        lost
+                    )
+                );
+                ws->Close(1000, "Kthxbye");
+                ws = nullptr;
+            }
+        }
+        if (!succeeded) {
+            break;
+        }
+    }
+    if (shutDown) {
+        diagnosticMessageDelegate(
+            "WsTalk",
+            SystemAbstractions::DiagnosticsSender::Levels::WARNING,
+            "Benchmark canceled"
+        );
+    }
+    if (ws != nullptr) {
+        ws->Close(1000, "Kthxbye");
+    }
+    return succeeded;
+}
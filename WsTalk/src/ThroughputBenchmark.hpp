@@ -0,0 +1,83 @@
+#pragma once
+
+/**
+ * @file ThroughputBenchmark.hpp
+ *
+ * This module declares the function used to measure how fast binary
+ * WebSocket messages of different sizes can be sent to an echo endpoint
+ * and received back.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <Http/Client.hpp>
+#include <stddef.h>
+#include <SystemAbstractions/DiagnosticsSender.hpp>
+#include <Uri/Uri.hpp>
+#include <vector>
+
+/**
+ * This holds the settings which control the throughput benchmark.
+ */
+struct ThroughputConfiguration {
+    /**
+     * These are the sizes, in bytes, of the messages to send.
+     */
+    std::vector< size_t > messageSizes = {
+        16,
+        256,
+        4 * 1024,
+        64 * 1024,
+        1024 * 1024,
+        16 * 1024 * 1024,
+    };
+
+    /**
+     * This is the size, in bytes, of the frames into which to fragment
+     * messages larger than it, in a second run of each message size.
+     * If zero, messages are only sent unfragmented.
+     */
+    size_t fragmentSize = 4096;
+
+    /**
+     * This is the number of seconds to send messages of each size.
+     */
+    double duration = 3.0;
+};
+
+/**
+ * This function opens a WebSocket to the echo endpoint at the given URL and,
+ * for each configured message size, sends binary messages of that size for
+ * the configured time, keeping a few in flight, while counting the messages
+ * echoed back.  Each size is run once with every message sent as a single
+ * frame, and again with messages fragmented, if they're larger than the
+ * fragment size.  A line is printed for each run giving the messages per
+ * second, megabytes per second, and processor time the client spent per
+ * megabyte and per message.
+ *
+ * @param[in,out] client
+ *     This is the client to use to connect to the server.
+ *
+ * @param[in] url
+ *     This is the URL of the echo endpoint to which to connect.
+ *
+ * @param[in] configuration
+ *     This holds the settings which control the benchmark.
+ *
+ * @param[in] shutDown
+ *     This is a flag which is set when the benchmark should be
+ *     stopped early.
+ *
+ * @param[in] diagnosticMessageDelegate
+ *     This is the function to call to publish any diagnostic messages.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool RunThroughputBenchmark(
+    Http::Client& client,
+    const Uri::Uri& url,
+    const ThroughputConfiguration& configuration,
+    const bool& shutDown,
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+);
@@ -0,0 +1,219 @@
+/**
+ * @file TrafficMetrics.cpp
+ *
+ * This module contains the implementation of the TrafficMetrics class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "TrafficMetrics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace {
+
+    /**
+     * This is the number of buckets in each histogram.  Bucket zero counts
+     * zeros, and each bucket after that counts values which need one more
+     * bit to hold than those of the bucket before.  Values too high for
+     * the last bucket are counted in it.
+     */
+    constexpr size_t NUM_BUCKETS = 41;
+
+    /**
+     * This function returns the index of the histogram bucket
+     * which counts the given value.
+     *
+     * @param[in] value
+     *     This is the value to count.
+     *
+     * @return
+     *     The index of the histogram bucket which counts the given
+     *     value is returned.
+     */
+    size_t GetBucket(uint64_t value) {
+        size_t bits = 0;
+        for (size_t shift = 32; shift > 0; shift /= 2) {
+            if ((value >> shift) != 0) {
+                value >>= shift;
+                bits += shift;
+            }
+        }
+        return std::min(bits + (size_t)value, NUM_BUCKETS - 1);
+    }
+
+    /**
+     * This holds the counters for one direction of traffic.
+     */
+    struct DirectionCounters {
+        /**
+         * This is the number of messages passed.
+         */
+        std::atomic< uint64_t > messages{0};
+
+        /**
+         * This is the number of bytes passed.
+         */
+        std::atomic< uint64_t > bytes{0};
+
+        /**
+         * These are the counts of messages whose sizes fell
+         * in each histogram bucket.
+         */
+        std::atomic< uint64_t > sizes[NUM_BUCKETS];
+
+        /**
+         * These are the counts of times between messages which fell
+         * in each histogram bucket.
+         */
+        std::atomic< uint64_t > interArrivalTimes[NUM_BUCKETS];
+
+        /**
+         * This is the constructor of the structure.
+         */
+        DirectionCounters() {
+            for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+                sizes[i].store(0, std::memory_order_relaxed);
+                interArrivalTimes[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * This method copies the counters into the given snapshot.
+         *
+         * @param[out] snapshot
+         *     This is where to copy the counters.
+         */
+        void Copy(TrafficMetrics::DirectionSnapshot& snapshot) const {
+            snapshot.messages = messages.load(std::memory_order_relaxed);
+            snapshot.bytes = bytes.load(std::memory_order_relaxed);
+            snapshot.sizes.resize(NUM_BUCKETS);
+            snapshot.interArrivalTimes.resize(NUM_BUCKETS);
+            for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+                snapshot.sizes[i] = sizes[i].load(std::memory_order_relaxed);
+                snapshot.interArrivalTimes[i] = interArrivalTimes[i].load(std::memory_order_relaxed);
+            }
+        }
+    };
+
+}
+
+/**
+ * This contains the private properties of a TrafficMetrics class instance.
+ */
+struct TrafficMetrics::Impl {
+    // Properties
+
+    /**
+     * This is the number of connections made.
+     */
+    std::atomic< uint64_t > connections{0};
+
+    /**
+     * These are the counters for traffic sent.
+     */
+    DirectionCounters sent;
+
+    /**
+     * These are the counters for traffic received.
+     */
+    DirectionCounters received;
+
+    // Methods
+
+    /**
+     * This method returns the counters for the given direction of traffic.
+     *
+     * @param[in] direction
+     *     This is the direction of traffic whose counters to return.
+     *
+     * @return
+     *     The counters for the given direction of traffic are returned.
+     */
+    DirectionCounters& GetCounters(Direction direction) {
+        return (
+            (direction == Direction::Sent)
+            ? sent
+            : received
+        );
+    }
+};
+
+TrafficMetrics::~TrafficMetrics() noexcept = default;
+TrafficMetrics::TrafficMetrics(TrafficMetrics&&) noexcept = default;
+TrafficMetrics& TrafficMetrics::operator=(TrafficMetrics&&) noexcept = default;
+
+TrafficMetrics::TrafficMetrics()
+    : impl_(new Impl())
+{
+}
+
+void TrafficMetrics::RecordConnection() {
+    impl_->connections.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TrafficMetrics::RecordMessage(
+    Direction direction,
+    size_t size
+) {
+    auto& counters = impl_->GetCounters(direction);
+    counters.messages.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+    counters.sizes[GetBucket(size)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void TrafficMetrics::RecordInterArrivalTime(
+    Direction direction,
+    uint64_t microseconds
+) {
+    auto& counters = impl_->GetCounters(direction);
+    counters.interArrivalTimes[GetBucket(microseconds)].fetch_add(1, std::memory_order_relaxed);
+}
+
+auto TrafficMetrics::GetSnapshot() const -> Snapshot {
+    Snapshot snapshot;
+    snapshot.connections = impl_->connections.load(std::memory_order_relaxed);
+    impl_->sent.Copy(snapshot.sent);
+    impl_->received.Copy(snapshot.received);
+    return snapshot;
+}
+
+uint64_t TrafficMetrics::GetBucketHighestValue(size_t bucket) {
+    if (bucket == 0) {
+        return 0;
+    }
+    if (bucket >= NUM_BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+    return ((uint64_t)1 << bucket) - 1;
+}
+
+uint64_t TrafficMetrics::GetValueAtPercentile(
+    const std::vector< uint64_t >& histogram,
+    double percentile
+) {
+    uint64_t total = 0;
+    for (const auto count: histogram) {
+        total += count;
+    }
+    if (total == 0) {
+        return 0;
+    }
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    const auto countAtPercentile = std::max(
+        (uint64_t)1,
+        (uint64_t)(percentile / 100.0 * (double)total + 0.5)
+    );
+    uint64_t countSoFar = 0;
+    for (size_t i = 0; i < histogram.size(); ++i) {
+        countSoFar += histogram[i];
+        if (countSoFar >= countAtPercentile) {
+            return GetBucketHighestValue(i);
+        }
+    }
+    return GetBucketHighestValue(histogram.size() - 1);
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+/**
+ * @file TrafficMetrics.hpp
+ *
+ * This module declares the TrafficMetrics class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * This collects metrics about the traffic passing through one layer of
+ * network connections: the number of connections made, the number of
+ * messages and bytes in each direction, and histograms of message sizes
+ * and of the times between messages.
+ * Histograms count values in buckets which each cover twice the range of
+ * the one before.  Everything is counted with atomic operations, so
+ * metrics may be recorded from any number of threads, and read at any
+ * time, without taking locks.
+ */
+class TrafficMetrics {
+    // Types
+public:
+    /**
+     * These are the directions in which traffic passes.
+     */
+    enum class Direction {
+        /**
+         * The traffic is being sent.
+         */
+        Sent,
+
+        /**
+         * The traffic was received.
+         */
+        Received,
+    };
+
+    /**
+     * This holds the metrics collected for one direction of traffic.
+     */
+    struct DirectionSnapshot {
+        /**
+         * This is the number of messages passed.
+         */
+        uint64_t messages = 0;
+
+        /**
+         * This is the number of bytes passed.
+         */
+        uint64_t bytes = 0;
+
+        /**
+         * These are the counts of messages whose sizes, in bytes,
+         * fell in each histogram bucket.
+         */
+        std::vector< uint64_t > sizes;
+
+        /**
+         * These are the counts of times between messages passed on the
+         * same connection, in microseconds, which fell in each
+         * histogram bucket.
+         */
+        std::vector< uint64_t > interArrivalTimes;
+    };
+
+    /**
+     * This holds the metrics collected at one moment.
+     */
+    struct Snapshot {
+        /**
+         * This is the number of connections made.
+         */
+        uint64_t connections = 0;
+
+        /**
+         * These are the metrics of traffic sent.
+         */
+        DirectionSnapshot sent;
+
+        /**
+         * These are the metrics of traffic received.
+         */
+        DirectionSnapshot received;
+    };
+
+    // Lifecycle management
+public:
+    ~TrafficMetrics() noexcept;
+    TrafficMetrics(const TrafficMetrics&) = delete;
+    TrafficMetrics(TrafficMetrics&&) noexcept;
+    TrafficMetrics& operator=(const TrafficMetrics&) = delete;
+    TrafficMetrics& operator=(TrafficMetrics&&) noexcept;
+
+    // Public Methods
+public:
+    /**
+     * This is the default constructor.
+     */
+    TrafficMetrics();
+
+    /**
+     * This method counts a connection being made.
+     */
+    void RecordConnection();
+
+    /**
+     * This method counts a message passing in the given direction.
+     *
+     * @param[in] direction
+     *     This is the direction in which the message passed.
+     *
+     * @param[in] size
+     *     This is the size of the message, in bytes.
+     */
+    void RecordMessage(
+        Direction direction,
+        size_t size
+    );
+
+    /**
+     * This method counts the time between two messages passing in the
+     * given direction on the same connection.
+     *
+     * @param[in] direction
+     *     This is the direction in which the messages passed.
+     *
+     * @param[in] microseconds
+     *     This is the time between the messages, in microseconds.
+     */
+    void RecordInterArrivalTime(
+        Direction direction,
+        uint64_t microseconds
+    );
+
+    /**
+     * This method returns a copy of the metrics collected so far.
+     *
+     * @return
+     *     A copy of the metrics collected so far is returned.
+     */
+    Snapshot GetSnapshot() const;
+
+    /**
+     * This function returns the highest value which is counted in
+     * the given histogram bucket.
+     *
+     * @param[in] bucket
+     *     This is the index of the histogram bucket.
+     *
+     * @return
+     *     The highest value counted in the given bucket is returned.
+     */
+    static uint64_t GetBucketHighestValue(size_t bucket);
+
+    /**
+     * This function returns the highest value of the histogram bucket in
+     * which the given percentile of the values counted in the given
+     * histogram fell.
+     *
+     * @param[in] histogram
+     *     These are the counts of values in each histogram bucket.
+     *
+     * @param[in] percentile
+     *     This is the percentile of values to find, from 0 to 100.
+     *
+     * @return
+     *     The highest value of the bucket holding the given percentile
+     *     of values is returned, or zero if no values were counted.
+     */
+    static uint64_t GetValueAtPercentile(
+        const std::vector< uint64_t >& histogram,
+        double percentile
+    );
+
+    // Private Properties
+private:
+    /**
+     * This is the type of structure that contains the private
+     * properties of the instance.  It is defined in the implementation
+     * and declared here to ensure that it is scoped inside the class.
+     */
+    struct Impl;
+
+    /**
+     * This contains the private properties of the instance.
+     */
+    std::unique_ptr< Impl > impl_;
+};
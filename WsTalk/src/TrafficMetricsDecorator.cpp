@@ -0,0 +1,169 @@
+/**
+ * @file TrafficMetricsDecorator.cpp
+ *
+ * This module contains the implementation of the
+ * TrafficMetricsDecorator class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "TrafficMetricsDecorator.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace {
+
+    /**
+     * This is the type of clock used to time the traffic.
+     */
+    typedef std::chrono::steady_clock Clock;
+
+}
+
+/**
+ * This contains the private properties of a TrafficMetricsDecorator
+ * class instance.
+ */
+struct TrafficMetricsDecorator::Impl {
+    // Properties
+
+    /**
+     * This is the interface to the network connection being decorated.
+     */
+    std::shared_ptr< SystemAbstractions::INetworkConnection > lowerLayer;
+
+    /**
+     * This is where to count the traffic passing through the connection.
+     */
+    std::shared_ptr< TrafficMetrics > metrics;
+
+    /**
+     * This is the time, in microseconds since the clock's epoch, at which
+     * the last message was sent, or zero if none has been sent yet.
+     */
+    std::atomic< uint64_t > lastSent{0};
+
+    /**
+     * This is the time, in microseconds since the clock's epoch, at which
+     * the last message was received, or zero if none has been
+     * received yet.
+     */
+    std::atomic< uint64_t > lastReceived{0};
+
+    // Methods
+
+    /**
+     * This method counts a message passing through the connection in
+     * the given direction, along with the time since the last one.
+     *
+     * @param[in] direction
+     *     This is the direction in which the message passed.
+     *
+     * @param[in] size
+     *     This is the size of the message, in bytes.
+     */
+    void Count(
+        TrafficMetrics::Direction direction,
+        size_t size
+    ) {
+        // One is added to the time so that zero can mean "no message yet".
+        const auto now = (uint64_t)std::chrono::duration_cast< std::chrono::microseconds >(
+            Clock::now().time_since_epoch()
+        ).count() + 1;
+        auto& last = (
+            (direction == TrafficMetrics::Direction::Sent)
+            ? lastSent
+            : lastReceived
+        );
+        const auto previous = last.exchange(now, std::memory_order_relaxed);
+        metrics->RecordMessage(direction, size);
+        if (
+            (previous != 0)
+            && (now >= previous)
+        ) {
+            metrics->RecordInterArrivalTime(direction, now - previous);
+        }
+    }
+};
+
+TrafficMetricsDecorator::~TrafficMetricsDecorator() noexcept = default;
+TrafficMetricsDecorator::TrafficMetricsDecorator(TrafficMetricsDecorator&&) noexcept = default;
+TrafficMetricsDecorator& TrafficMetricsDecorator::operator=(TrafficMetricsDecorator&&) noexcept = default;
+
+TrafficMetricsDecorator::TrafficMetricsDecorator()
+    : impl_(new Impl())
+{
+}
+
+void TrafficMetricsDecorator::Decorate(
+    std::shared_ptr< SystemAbstractions::INetworkConnection > lowerLayer,
+    std::shared_ptr< TrafficMetrics > metrics
+) {
+    impl_->lowerLayer = lowerLayer;
+    impl_->metrics = metrics;
+    metrics->RecordConnection();
+}
+
+SystemAbstractions::DiagnosticsSender::UnsubscribeDelegate TrafficMetricsDecorator::SubscribeToDiagnostics(
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate delegate,
+    size_t minLevel
+) {
+    return impl_->lowerLayer->SubscribeToDiagnostics(delegate, minLevel);
+}
+
+bool TrafficMetricsDecorator::Connect(uint32_t peerAddress, uint16_t peerPort) {
+    return impl_->lowerLayer->Connect(peerAddress, peerPort);
+}
+
+bool TrafficMetricsDecorator::Process(
+    MessageReceivedDelegate messageReceivedDelegate,
+    BrokenDelegate brokenDelegate
+) {
+    const std::weak_ptr< Impl > implWeak(impl_);
+    const auto decoratedMessageReceivedDelegate = [
+        implWeak,
+        messageReceivedDelegate
+    ](const std::vector< uint8_t >& message){
+        const auto impl(implWeak.lock());
+        if (impl == nullptr) {
+            return;
+        }
+        impl->Count(TrafficMetrics::Direction::Received, message.size());
+        messageReceivedDelegate(message);
+    };
+    return impl_->lowerLayer->Process(decoratedMessageReceivedDelegate, brokenDelegate);
+}
+
+uint32_t TrafficMetricsDecorator::GetPeerAddress() const {
+    return impl_->lowerLayer->GetPeerAddress();
+}
+
+uint16_t TrafficMetricsDecorator::GetPeerPort() const {
+    return impl_->lowerLayer->GetPeerPort();
+}
+
+bool TrafficMetricsDecorator::IsConnected() const {
+    return impl_->lowerLayer->IsConnected();
+}
+
+uint32_t TrafficMetricsDecorator::GetBoundAddress() const {
+    return impl_->lowerLayer->GetBoundAddress();
+}
+
+uint16_t TrafficMetricsDecorator::GetBoundPort() const {
+    return impl_->lowerLayer->GetBoundPort();
+}
+
+void TrafficMetricsDecorator::SendMessage(const std::vector< uint8_t >& message) {
+    impl_->Count(TrafficMetrics::Direction::Sent, message.size());
+    impl_->lowerLayer->SendMessage(message);
+}
+
+void TrafficMetricsDecorator::Close(bool clean) {
+    impl_->lowerLayer->Close(clean);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+/**
+ * @file TrafficMetricsDecorator.hpp
+ *
+ * This module declares the TrafficMetricsDecorator class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "TrafficMetrics.hpp"
+
+#include <memory>
+#include <SystemAbstractions/INetworkConnection.hpp>
+
+/**
+ * This is a decorator for SystemAbstractions::INetworkConnection which
+ * counts the messages and bytes that pass through the connection in each
+ * direction, along with their sizes and the times between them.
+ */
+class TrafficMetricsDecorator
+    : public SystemAbstractions::INetworkConnection
+{
+    // Lifecycle management
+public:
+    ~TrafficMetricsDecorator() noexcept;
+    TrafficMetricsDecorator(const TrafficMetricsDecorator&) = delete;
+    TrafficMetricsDecorator(TrafficMetricsDecorator&&) noexcept;
+    TrafficMetricsDecorator& operator=(const TrafficMetricsDecorator&) = delete;
+    TrafficMetricsDecorator& operator=(TrafficMetricsDecorator&&) noexcept;
+
+    // Public Methods
+public:
+    /**
+     * This is the default constructor.
+     */
+    TrafficMetricsDecorator();
+
+    /**
+     * This method sets up the decorator with the network connection to
+     * decorate and where to count the traffic passing through it.
+     *
+     * @param[in] lowerLayer
+     *     This is the lower-level connection to decorate.
+     *
+     * @param[in] metrics
+     *     This is where to count the connection and the traffic passing
+     *     through it.  It may be shared by many decorators.
+     */
+    void Decorate(
+        std::shared_ptr< SystemAbstractions::INetworkConnection > lowerLayer,
+        std::shared_ptr< TrafficMetrics > metrics
+    );
+
+    // SystemAbstractions::INetworkConnection
+public:
+    virtual SystemAbstractions::DiagnosticsSender::UnsubscribeDelegate SubscribeToDiagnostics(
+        SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate delegate,
+        size_t minLevel = 0
+    ) override;
+    virtual bool Connect(uint32_t peerAddress, uint16_t peerPort) override;
+    virtual bool Process(
+        MessageReceivedDelegate messageReceivedDelegate,
+        BrokenDelegate brokenDelegate
+    ) override;
+    virtual uint32_t GetPeerAddress() const override;
+    virtual uint16_t GetPeerPort() const override;
+    virtual bool IsConnected() const override;
+    virtual uint32_t GetBoundAddress() const override;
+    virtual uint16_t GetBoundPort() const override;
+    virtual void SendMessage(const std::vector< uint8_t >& message) override;
+    virtual void Close(bool clean = false) override;
+
+    // Private Properties
+private:
+    /**
+     * This is the type of structure that contains the private
+     * properties of the instance.  It is defined in the implementation
+     * and declared here to ensure that it is scoped inside the class.
+     */
+    struct Impl;
+
+    /**
+     * This contains the private properties of the instance.
+     */
+    std::shared_ptr< Impl > impl_;
+};
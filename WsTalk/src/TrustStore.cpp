@@ -0,0 +1,107 @@
+/**
+ * @file TrustStore.cpp
+ *
+ * This module contains the implementation of the TrustStore class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "TrustStore.hpp"
+
+#include <set>
+#include <stddef.h>
+#include <string>
+
+namespace {
+
+    /**
+     * This is the line which starts each certificate in a PEM bundle.
+     */
+    const std::string BEGIN_CERTIFICATE = "-----BEGIN CERTIFICATE-----";
+
+    /**
+     * This is the line which ends each certificate in a PEM bundle.
+     */
+    const std::string END_CERTIFICATE = "-----END CERTIFICATE-----";
+
+}
+
+/**
+ * This contains the private properties of a TrustStore class instance.
+ */
+struct TrustStore::Impl {
+    /**
+     * These are the certificates in the trust store, each in PEM form,
+     * with the whitespace within them removed, used to skip certificates
+     * already added.
+     */
+    std::set< std::string > certificates;
+
+    /**
+     * This is the PEM bundle holding all the certificates
+     * in the trust store.
+     */
+    std::string bundle;
+};
+
+TrustStore::~TrustStore() noexcept = default;
+TrustStore::TrustStore(TrustStore&&) noexcept = default;
+TrustStore& TrustStore::operator=(TrustStore&&) noexcept = default;
+
+TrustStore::TrustStore()
+    : impl_(new Impl())
+{
+}
+
+size_t TrustStore::AddCertificates(const std::string& pem) {
+    size_t added = 0;
+    size_t offset = 0;
+    for (;;) {
+        const auto begin = pem.find(BEGIN_CERTIFICATE, offset);
+        if (begin == std::string::npos) {
+            break;
+        }
+        const auto bodyBegin = begin + BEGIN_CERTIFICATE.length();
+        const auto end = pem.find(END_CERTIFICATE, bodyBegin);
+        if (end == std::string::npos) {
+            break;
+        }
+        offset = end + END_CERTIFICATE.length();
+        std::string body;
+        for (size_t i = bodyBegin; i < end; ++i) {
+            const auto c = pem[i];
+            if (
+                (c != ' ')
+                && (c != '\t')
+                && (c != '\r')
+                && (c != '\n')
+            ) {
+                body += c;
+            }
+        }
+        if (
+            body.empty()
+            || !impl_->certificates.insert(body).second
+        ) {
+            continue;
+        }
+        impl_->bundle += BEGIN_CERTIFICATE;
+        impl_->bundle += '\n';
+        for (size_t i = 0; i < body.length(); i += 64) {
+            impl_->bundle += body.substr(i, 64);
+            impl_->bundle += '\n';
+        }
+        impl_->bundle += END_CERTIFICATE;
+        impl_->bundle += '\n';
+        ++added;
+    }
+    return added;
+}
+
+size_t TrustStore::GetCertificateCount() const {
+    return impl_->certificates.size();
+}
+
+const std::string& TrustStore::GetBundle() const {
+    return impl_->bundle;
+}
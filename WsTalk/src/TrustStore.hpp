@@ -0,0 +1,84 @@
+#pragma once
+
+/**
+ * @file TrustStore.hpp
+ *
+ * This module declares the TrustStore class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <memory>
+#include <stddef.h>
+#include <string>
+
+/**
+ * This holds the certificates of the certificate authorities (CAs) the
+ * client trusts to verify servers' certificates, gathered from PEM bundles
+ * once at startup.  Only the certificates themselves are kept, each just
+ * once, with any other text in the bundles, such as comments naming each
+ * certificate, left out, so that the bundle handed to the TLS layer for
+ * each connection is no bigger than it needs to be.  Once built, a trust
+ * store isn't changed, so one may be shared by every connection, on any
+ * thread, without copying it.
+ */
+class TrustStore {
+    // Lifecycle management
+public:
+    ~TrustStore() noexcept;
+    TrustStore(const TrustStore&) = delete;
+    TrustStore(TrustStore&&) noexcept;
+    TrustStore& operator=(const TrustStore&) = delete;
+    TrustStore& operator=(TrustStore&&) noexcept;
+
+    // Public Methods
+public:
+    /**
+     * This is the default constructor.
+     */
+    TrustStore();
+
+    /**
+     * This method adds the certificates found in the given PEM bundle
+     * to the trust store, skipping any it already has.
+     *
+     * @param[in] pem
+     *     This is the PEM bundle from which to add certificates.
+     *
+     * @return
+     *     The number of certificates added is returned.
+     */
+    size_t AddCertificates(const std::string& pem);
+
+    /**
+     * This method returns the number of certificates in the trust store.
+     *
+     * @return
+     *     The number of certificates in the trust store is returned.
+     */
+    size_t GetCertificateCount() const;
+
+    /**
+     * This method returns the certificates in the trust store,
+     * as a PEM bundle.
+     *
+     * @return
+     *     The certificates in the trust store are returned
+     *     as a PEM bundle.
+     */
+    const std::string& GetBundle() const;
+
+    // Private Properties
+private:
+    /**
+     * This is the type of structure that contains the private
+     * properties of the instance.  It is defined in the implementation
+     * and declared here to ensure that it is scoped inside the class.
+     */
+    struct Impl;
+
+    /**
+     * This contains the private properties of the instance.
+     */
+    std::unique_ptr< Impl > impl_;
+};
@@ -0,0 +1,166 @@
+/**
+ * @file WebSocketOpener.cpp
+ *
+ * This module contains the implementation of the WebSocketOpener class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "WebSocketOpener.hpp"
+
+#include <Http/Request.hpp>
+#include <StringExtensions/StringExtensions.hpp>
+
+/**
+ * This contains the private properties of a WebSocketOpener class instance.
+ */
+struct WebSocketOpener::Impl {
+    /**
+     * This is the WebSocket being opened.
+     */
+    std::shared_ptr< WebSockets::WebSocket > ws;
+
+    /**
+     * This is the transaction used to request the upgrade to a WebSocket.
+     */
+    std::shared_ptr< Http::Client::Transaction > transaction;
+
+    /**
+     * This indicates whether or not the WebSocket engaged the
+     * upgraded connection.  It's shared with the upgrade delegate,
+     * which may outlive the opener.
+     */
+    std::shared_ptr< bool > wsEngaged = std::make_shared< bool >(false);
+
+    /**
+     * This is the time at which the WebSocket engaged the upgraded
+     * connection.  It's shared with the upgrade delegate, like the
+     * flag indicating whether or not the WebSocket did so.
+     */
+    std::shared_ptr< std::chrono::steady_clock::time_point > openTime = (
+        std::make_shared< std::chrono::steady_clock::time_point >()
+    );
+
+    /**
+     * This is the state of the opening of the WebSocket.
+     */
+    State state = State::Failed;
+
+    /**
+     * This describes why the WebSocket could not be opened.
+     */
+    std::string error = "not started";
+};
+
+WebSocketOpener::~WebSocketOpener() noexcept = default;
+WebSocketOpener::WebSocketOpener(WebSocketOpener&&) noexcept = default;
+WebSocketOpener& WebSocketOpener::operator=(WebSocketOpener&&) noexcept = default;
+
+WebSocketOpener::WebSocketOpener()
+    : impl_(new Impl())
+{
+}
+
+void WebSocketOpener::Start(
+    Http::Client& client,
+    const Uri::Uri& url,
+    WebSockets::WebSocket::Delegates delegates,
+    SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+) {
+    Http::Request request;
+    request.method = "GET";
+    request.target = url;
+    const auto ws = std::make_shared< WebSockets::WebSocket >();
+    if (diagnosticMessageDelegate != nullptr) {
+        ws->SubscribeToDiagnostics(diagnosticMessageDelegate);
+    }
+    ws->StartOpenAsClient(request);
+    ws->SetDelegates(std::move(delegates));
+    const auto wsEngaged = impl_->wsEngaged;
+    const auto openTime = impl_->openTime;
+    impl_->ws = ws;
+    impl_->state = State::Opening;
+    impl_->error.clear();
+    impl_->transaction = client.Request(
+        request,
+        false,
+        [
+            ws,
+            wsEngaged,
+            openTime
+        ](
+            const Http::Response& response,
+            std::shared_ptr< Http::Connection > connection,
+            const std::string& trailer
+        ){
+            if (ws->FinishOpenAsClient(connection, response)) {
+                *openTime = std::chrono::steady_clock::now();
+                *wsEngaged = true;
+            }
+        }
+    );
+}
+
+WebSocketOpener::State WebSocketOpener::Await(std::chrono::milliseconds timeout) {
+    if (impl_->state != State::Opening) {
+        return impl_->state;
+    }
+    if (!impl_->transaction->AwaitCompletion(timeout)) {
+        return State::Opening;
+    }
+    impl_->state = State::Failed;
+    switch (impl_->transaction->state) {
+        case Http::Client::Transaction::State::Completed: {
+            if (*impl_->wsEngaged) {
+                impl_->state = State::Open;
+            } else if (impl_->transaction->response.statusCode == 101) {
+                impl_->error = "Connection upgraded, but failed to engage WebSocket";
+            } else {
+                impl_->error = StringExtensions::sprintf(
+                    "Got back response: %u %s",
+                    impl_->transaction->response.statusCode,
+                    impl_->transaction->response.reasonPhrase.c_str()
+                );
+            }
+        } break;
+
+        case Http::Client::Transaction::State::UnableToConnect: {
+            impl_->error = "unable to connect";
+        } break;
+
+        case Http::Client::Transaction::State::Broken: {
+            impl_->error = "connection broken by server";
+        } break;
+
+        case Http::Client::Transaction::State::Timeout: {
+            impl_->error = "timeout waiting for response";
+        } break;
+
+        default: {
+            impl_->error = "request ended unexpectedly";
+        } break;
+    }
+    impl_->transaction = nullptr;
+    if (impl_->state == State::Failed) {
+        impl_->ws = nullptr;
+    }
+    return impl_->state;
+}
+
+std::shared_ptr< WebSockets::WebSocket > WebSocketOpener::GetWebSocket() const {
+    if (impl_->state == State::Open) {
+        return impl_->ws;
+    }
+    return nullptr;
+}
+
+std::chrono::steady_clock::time_point WebSocketOpener::GetOpenTime() const {
+    if (impl_->state == State::Open) {
+        return *impl_->openTime;
+    }
+    return std::chrono::steady_clock::time_point();
+}
+
+std::string WebSocketOpener::GetError() const {
+    return impl_->error;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+/**
+ * @file WebSocketOpener.hpp
+ *
+ * This module declares the WebSocketOpener class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <chrono>
+#include <Http/Client.hpp>
+#include <memory>
+#include <string>
+#include <SystemAbstractions/DiagnosticsSender.hpp>
+#include <Uri/Uri.hpp>
+#include <WebSockets/WebSocket.hpp>
+
+/**
+ * This is used to connect to a web server and request an upgrade of the
+ * connection to a WebSocket, without waiting for the upgrade to finish.
+ * This allows many WebSockets to be opened at the same time.
+ */
+class WebSocketOpener {
+    // Types
+public:
+    /**
+     * These are the states the opening of a WebSocket can be in.
+     */
+    enum class State {
+        /**
+         * The server hasn't yet responded to the upgrade request.
+         */
+        Opening,
+
+        /**
+         * The connection was upgraded and the WebSocket is open.
+         */
+        Open,
+
+        /**
+         * The WebSocket could not be opened.
+         */
+        Failed,
+    };
+
+    // Lifecycle management
+public:
+    ~WebSocketOpener() noexcept;
+    WebSocketOpener(const WebSocketOpener&) = delete;
+    WebSocketOpener(WebSocketOpener&&) noexcept;
+    WebSocketOpener& operator=(const WebSocketOpener&) = delete;
+    WebSocketOpener& operator=(WebSocketOpener&&) noexcept;
+
+    // Public Methods
+public:
+    /**
+     * This is the default constructor.
+     */
+    WebSocketOpener();
+
+    /**
+     * This method uses the given web client to connect to the web server at
+     * the given URL and request an upgrade to the WebSocket protocol.
+     * It returns without waiting for the server to respond.
+     *
+     * @param[in,out] client
+     *     This is the client to use to connect to the server.
+     *
+     * @param[in] url
+     *     This is the URL of the server to which to connect.
+     *
+     * @param[in] delegates
+     *     These are the functions the WebSocket should call when it
+     *     receives messages or is closed.
+     *
+     * @param[in] diagnosticMessageDelegate
+     *     This is the function to call to publish any diagnostic messages.
+     *     If null, diagnostic messages from the WebSocket are not published.
+     */
+    void Start(
+        Http::Client& client,
+        const Uri::Uri& url,
+        WebSockets::WebSocket::Delegates delegates,
+        SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+    );
+
+    /**
+     * This method waits up to the given amount of time for the server
+     * to respond to the upgrade request.
+     *
+     * @param[in] timeout
+     *     This is the most time to wait.  Use zero to check
+     *     without waiting.
+     *
+     * @return
+     *     The state of the opening of the WebSocket is returned.
+     */
+    State Await(std::chrono::milliseconds timeout);
+
+    /**
+     * This method returns the WebSocket, once it's open.
+     *
+     * @return
+     *     The WebSocket is returned.
+     *
+     * @retval nullptr
+     *     This is returned if the WebSocket isn't open.
+     */
+    std::shared_ptr< WebSockets::WebSocket > GetWebSocket() const;
+
+    /**
+     * This method returns the time at which the WebSocket opened, which is
+     * when the server's response upgrading the connection was handled,
+     * rather than when Await noticed.
+     *
+     * @return
+     *     The time at which the WebSocket opened is returned, or
+     *     a default-constructed time point if the WebSocket isn't open.
+     */
+    std::chrono::steady_clock::time_point GetOpenTime() const;
+
+    /**
+     * This method returns a description of why the WebSocket
+     * could not be opened.
+     *
+     * @return
+     *     A description of why the WebSocket could not be opened
+     *     is returned.
+     */
+    std::string GetError() const;
+
+    // Private Properties
+private:
+    /**
+     * This is the type of structure that contains the private
+     * properties of the instance.  It is defined in the implementation
+     * and declared here to ensure that it is scoped inside the class.
+     */
+    struct Impl;
+
+    /**
+     * This contains the private properties of the instance.
+     */
+    std::unique_ptr< Impl > impl_;
+};
@@ -7,14 +7,32 @@
  * © 2018 by Richard Walters
  */
 
+#include "ClockBenchmark.hpp"
+#include "CoalescingNetworkConnectionDecorator.hpp"
+#include "FanOutLatency.hpp"
+#include "HandshakeBenchmark.hpp"
+#include "HexDumpBenchmark.hpp"
 #include "HexDumpNetworkConnectionDecorator.hpp"
-#include "TimeKeeper.hpp"
+#include "LinkShapingNetworkConnectionDecorator.hpp"
+#include "LoadGenerator.hpp"
+#include "PcapngCaptureDecorator.hpp"
+#include "PcapngWriter.hpp"
+#include "PingProber.hpp"
+#include "RequestBenchmark.hpp"
+#include "ThroughputBenchmark.hpp"
+#include "TrafficMetrics.hpp"
+#include "TrafficMetricsDecorator.hpp"
+#include "TrustStore.hpp"
+#include "WebSocketOpener.hpp"
 
+#include <atomic>
 #include <condition_variable>
 #include <Http/Client.hpp>
-#include <Http/Request.hpp>
 #include <HttpNetworkTransport/HttpClientNetworkTransport.hpp>
+#include <inttypes.h>
 #include <iostream>
+#include <MonotonicClock/TimeKeeper.hpp>
+#include <math.h>
 #include <memory>
 #include <mutex>
 #include <signal.h>
@@ -38,6 +56,36 @@ namespace {
      */
     constexpr uint16_t DEFAULT_HTTPS_PORT = 443;
 
+    /**
+     * This is the default port for HTTP over plain TCP.
+     */
+    constexpr uint16_t DEFAULT_HTTP_PORT = 80;
+
+    /**
+     * This is the number of sends and receives which can be waiting to be
+     * hex dumped for each layer of a connection, before more are dropped.
+     */
+    constexpr size_t HEX_DUMP_QUEUE_CAPACITY = 1024;
+
+    /**
+     * This is the index of the capture interface for data passing
+     * through connections on the wire.
+     */
+    constexpr size_t WIRE_CAPTURE_INTERFACE = 0;
+
+    /**
+     * This is the index of the capture interface for data passing
+     * through connections inside TLS.
+     */
+    constexpr size_t TLS_CAPTURE_INTERFACE = 1;
+
+    /**
+     * This is the port recorded for the server in packets captured inside
+     * TLS, so that they form a stream apart from the encrypted packets of
+     * the same connection, and Wireshark decodes them as HTTP.
+     */
+    constexpr uint16_t TLS_CAPTURE_PEER_PORT = 80;
+
     /**
      * This function prints to the standard error stream information
      * about how to use this program.
@@ -46,14 +94,141 @@ namespace {
         fprintf(
             stderr,
             (
-                "Usage: WsTalk <URL>\n"
+                "Usage: WsTalk [--cert FILE] [--capture FILE [--capture-size BYTES]\n"
+                "              [--capture-files N]] [--metrics]\n"
+                "              [--coalesce US [--coalesce-bytes BYTES]]\n"
+                "              [--latency MS] [--jitter MS] [--bandwidth BYTES\n"
+                "              [--burst BYTES]] [--seed N]\n"
+                "              [--clients N [--rate R] [--ramp R] [--duration S]\n"
+                "              [--script FILE]]\n"
+                "              [--fanout LIST [--senders M] [--rate R] [--ramp R]\n"
+                "              [--duration S] [--drain S]]\n"
+                "              [--ping S [--duration S] [--report S] [--timeout S]]\n"
+                "              [--throughput [--sizes LIST] [--fragment BYTES]\n"
+                "              [--duration S]] [--handshakes N] <URL>\n"
+                "       WsTalk [--cert FILE] ... --requests N [--depth LIST] <HTTP URL>\n"
+                "       WsTalk --hexdump-benchmark\n"
+                "       WsTalk --clock-benchmark\n"
+                "\n"
+                "Connect to the server at URL (wss: for TLS, or ws: for plain TCP) with a\n"
+                "request to upgrade the connection to a WebSocket.  If the connection is\n"
+                "successfully upgraded, begin an interactive mode where incoming messages\n"
+                "are displayed and what the user types becomes content to send in a message.\n"
                 "\n"
-                "Connect to the server at URL (use wss: scheme please!) with a request to\n"
-                "upgrade the connection to a WebSocket.  If the connection is successfully\n"
-                "upgraded, begin an interactive mode where incoming messages are displayed\n"
-                "and what the user types becomes content to send in a message.\n"
+                "With --clients, put the server under load instead: open N WebSockets,\n"
+                "ramping up gradually, each sending messages taken in turn from a script,\n"
+                "and report connect times, message rates, and error rates.\n"
                 "\n"
-                "  URL     URL of the server to which to connect\n"
+                "With --fanout, measure instead how long tells take to reach every member\n"
+                "of a chat room: M senders send tells which listeners time on arrival, for\n"
+                "each number of listeners in LIST, and report latency percentiles along\n"
+                "with lost and reordered tells for each room size.\n"
+                "\n"
+                "With --ping, send a WebSocket ping every S seconds instead, and measure\n"
+                "the round-trip time of each one, printing percentiles periodically and a\n"
+                "report of their distribution at the end.\n"
+                "\n"
+                "With --throughput, send binary messages of each size in LIST to an echo\n"
+                "endpoint instead, both whole and split into fragments, and report the\n"
+                "messages and megabytes per second echoed back along with the processor\n"
+                "time spent per megabyte and per message.\n"
+                "\n"
+                "With --handshakes, open N WebSockets instead, one at a time, and report\n"
+                "how long each took to open, including the TCP and TLS handshakes, along\n"
+                "with the processor time spent on each.\n"
+                "\n"
+                "With --requests, make N plain HTTP GET requests to an http: or https: URL\n"
+                "instead, with each number in LIST of them in flight at once, first closing\n"
+                "each connection after its response and then keeping connections open to be\n"
+                "reused, and report the requests per second, request times, and how many\n"
+                "connections were made and reused.\n"
+                "\n"
+                "With --hexdump-benchmark, connect to nothing, and instead measure how fast\n"
+                "the hex dumps shown in interactive mode are formatted, compared with the\n"
+                "string stream formatting used before.  With --clock-benchmark, likewise\n"
+                "connect to nothing, and instead measure how long it takes to tell the time,\n"
+                "both precisely and from the coarse time kept by a ticker thread.\n"
+                "\n"
+                "With --capture, also record all data passing through connections, both on\n"
+                "the wire and inside TLS, to FILE in pcapng format for Wireshark, as\n"
+                "TCP/IP packets made up to carry it.\n"
+                "\n"
+                "With --metrics, also count the messages and bytes passing through\n"
+                "connections, on the wire and inside TLS, and report them at the end,\n"
+                "along with percentiles of their sizes and the times between them.\n"
+                "\n"
+                "With --coalesce, also gather data sent through connections for up to US\n"
+                "microseconds, or until BYTES have gathered, and send it all at once, so\n"
+                "that many small messages cost one TLS record and one write to the socket.\n"
+                "\n"
+                "With --latency, --jitter, or --bandwidth, also make connections imitate a\n"
+                "slower network link, such as a mobile one, by holding data sent and\n"
+                "received until the link would have delivered it.\n"
+                "\n"
+                "  URL             URL of the server to which to connect\n"
+                "  --cert FILE     extra certificate to accept (may be repeated)\n"
+                "  --capture FILE  file to which to capture traffic in pcapng format\n"
+                "  --capture-size BYTES\n"
+                "                  most bytes to write to each capture file before\n"
+                "                  starting another, with an optional K or M suffix\n"
+                "                  (default: 64M)\n"
+                "  --capture-files N\n"
+                "                  most capture files to keep; older ones are named\n"
+                "                  FILE.1, FILE.2, and so on (default: 4)\n"
+                "  --metrics       report traffic metrics for each connection layer\n"
+                "  --coalesce US   microseconds to gather data sent before sending it\n"
+                "  --coalesce-bytes BYTES\n"
+                "                  bytes to gather before sending them without waiting\n"
+                "                  longer, with an optional K or M suffix (default: 16K)\n"
+                "  --latency MS    milliseconds each way for data to cross the imitated\n"
+                "                  link\n"
+                "  --jitter MS     most milliseconds by which latency randomly varies\n"
+                "  --bandwidth BYTES\n"
+                "                  bytes per second each way the imitated link carries,\n"
+                "                  with an optional K or M suffix\n"
+                "  --burst BYTES   bytes the imitated link takes at once after being idle\n"
+                "                  (default: 0)\n"
+                "  --seed N        seed for the jitter, which is the same every run with\n"
+                "                  the same seed (default: 1)\n"
+                "  --clients N     number of WebSockets to open in load mode\n"
+                "  --rate R        messages per second each WebSocket sends (default: 1\n"
+                "                  in load mode, 0.5 in fan-out mode)\n"
+                "  --ramp R        WebSockets to start opening per second (default: 50;\n"
+                "                  0 opens them all at once)\n"
+                "  --duration S    seconds to hold the full load once ramped up, to send\n"
+                "                  tells for each room size, to send pings, or to send\n"
+                "                  messages of each size (default: 30 in load mode, 10\n"
+                "                  in fan-out mode, 0 in ping mode, meaning until\n"
+                "                  interrupted, 3 in throughput mode)\n"
+                "  --script FILE   messages to send, one per line (default: requests\n"
+                "                  for the chat room's users and available nicknames)\n"
+                "  --fanout LIST   increasing numbers of listeners in fan-out mode\n"
+                "  --senders M     number of senders in fan-out mode (default: 1)\n"
+                "  --drain S       seconds to wait for tells still on their way after\n"
+                "                  sending stops for each room size (default: 2)\n"
+                "  --ping S        seconds between pings in ping mode\n"
+                "  --report S      seconds between summaries in ping mode (default: 10)\n"
+                "  --timeout S     seconds to wait for each pong before counting its ping\n"
+                "                  as lost (default: 5)\n"
+                "  --throughput    measure binary message throughput to an echo endpoint\n"
+                "  --handshakes N  number of WebSockets to open one at a time in handshake\n"
+                "                  mode\n"
+                "  --requests N    number of HTTP requests to make in each run of request\n"
+                "                  mode\n"
+                "  --depth LIST    numbers of requests to have in flight at once in request\n"
+                "                  mode (default: 1)\n"
+                "  --hexdump-benchmark\n"
+                "                  measure hex dump formatting speed (no URL is used)\n"
+                "  --clock-benchmark\n"
+                "                  measure how long it takes to tell the time (no URL is\n"
+                "                  used)\n"
+                "  --sizes LIST    message sizes in throughput mode, in bytes, with an\n"
+                "                  optional K or M suffix (default: 16,256,4K,64K,1M,16M)\n"
+                "  --fragment BYTES\n"
+                "                  fragment size in throughput mode, with an optional K\n"
+                "                  or M suffix (default: 4K; 0 sends no fragments)\n"
+                "\n"
+                "LIST is a comma-separated list of values.\n"
             )
         );
     }
@@ -63,11 +238,71 @@ namespace {
      */
     bool shutDown = false;
 
+    /**
+     * These are the things the program can be asked to do.
+     */
+    enum class Mode {
+        /**
+         * Talk to the server interactively.
+         */
+        Interactive,
+
+        /**
+         * Put the server under load.
+         */
+        Load,
+
+        /**
+         * Measure chat room fan-out latency.
+         */
+        FanOut,
+
+        /**
+         * Measure the round-trip time of WebSocket pings.
+         */
+        Ping,
+
+        /**
+         * Measure the throughput of binary messages sent to
+         * an echo endpoint.
+         */
+        Throughput,
+
+        /**
+         * Measure how long it takes to set up each new WebSocket
+         * connection.
+         */
+        Handshake,
+
+        /**
+         * Measure how fast plain HTTP requests are made, with and
+         * without reusing connections.
+         */
+        Requests,
+
+        /**
+         * Measure how fast hex dumps are formatted, without connecting
+         * to anything.
+         */
+        HexDumpBenchmark,
+
+        /**
+         * Measure how long it takes to tell the time, without connecting
+         * to anything.
+         */
+        ClockBenchmark,
+    };
+
     /**
      * This contains variables set through the operating system environment
      * or the command-line arguments.
      */
     struct Environment {
+        /**
+         * This is what the program was asked to do.
+         */
+        Mode mode = Mode::Interactive;
+
         /**
          * This is the URL of the server to which to connect.
          */
@@ -77,110 +312,987 @@ namespace {
          * This holds extra SSL certificates the client should accept.
          */
         std::string extraCerts;
+
+        /**
+         * This indicates whether or not to publish hex dumps of all
+         * traffic passing through the client's connections.
+         */
+        bool hexDump = true;
+
+        /**
+         * This is the lowest level of diagnostic messages to publish
+         * from the client and its transport.
+         */
+        size_t minDiagnosticsLevel = 0;
+
+        /**
+         * If not empty, this is the path of the file to which to capture
+         * all traffic passing through the client's connections.
+         */
+        std::string captureFile;
+
+        /**
+         * This is the most bytes to write to each capture file.
+         */
+        size_t captureFileSize = 64 * 1024 * 1024;
+
+        /**
+         * This is the most capture files to keep.
+         */
+        size_t captureFiles = 4;
+
+        /**
+         * This indicates whether or not to collect and report metrics
+         * about the traffic passing through the client's connections.
+         */
+        bool metrics = false;
+
+        /**
+         * If not zero, this is the longest, in microseconds, to hold data
+         * sent through the client's connections, gathering it with any
+         * more sent in the meantime, before sending it all at once.
+         */
+        size_t coalesceWindow = 0;
+
+        /**
+         * This is the number of bytes which, once gathered, are sent at
+         * once, without waiting any longer.  The default is the most
+         * data a TLS record can hold.
+         */
+        size_t coalesceBytes = 16 * 1024;
+
+        /**
+         * These are the properties of a slower network link for the
+         * client's connections to imitate.  If none of latency, jitter,
+         * or bandwidth is set, connections aren't slowed down.
+         */
+        LinkShape linkShape;
+
+        /**
+         * This holds the settings which control the load put on the
+         * server, if the program was asked to do that.
+         */
+        LoadConfiguration load;
+
+        /**
+         * This holds the settings which control the measurement of chat
+         * room fan-out latency, if the program was asked to do that.
+         */
+        FanOutConfiguration fanOut;
+
+        /**
+         * This holds the settings which control the probing of the server
+         * with WebSocket pings, if the program was asked to do that.
+         */
+        PingConfiguration ping;
+
+        /**
+         * This holds the settings which control the throughput benchmark,
+         * if the program was asked to run it.
+         */
+        ThroughputConfiguration throughput;
+
+        /**
+         * This holds the settings which control the handshake benchmark,
+         * if the program was asked to run it.
+         */
+        HandshakeConfiguration handshake;
+
+        /**
+         * This holds the settings which control the request benchmark,
+         * if the program was asked to run it.
+         */
+        RequestConfiguration requests;
+    };
+
+    /**
+     * This holds the metrics collected about the traffic passing through
+     * the client's connections, if the program was asked to collect them.
+     */
+    struct ConnectionMetrics {
+        /**
+         * These are the metrics of traffic on the wire.
+         */
+        std::shared_ptr< TrafficMetrics > wire;
+
+        /**
+         * These are the metrics of traffic inside TLS.
+         */
+        std::shared_ptr< TrafficMetrics > tls;
     };
 
-    /**
-     * This function is set up to be called when the SIGINT signal is
-     * received by the program.  It just sets the "shutDown" flag
-     * and relies on the program to be polling the flag to detect
-     * when it's been set.
-     *
-     * @param[in] sig
-     *     This is the signal for which this function was called.
-     */
-    void InterruptHandler(int) {
-        shutDown = true;
-    }
+    /**
+     * This function is set up to be called when the SIGINT signal is
+     * received by the program.  It just sets the "shutDown" flag
+     * and relies on the program to be polling the flag to detect
+     * when it's been set.
+     *
+     * @param[in] sig
+     *     This is the signal for which this function was called.
+     */
+    void InterruptHandler(int) {
+        shutDown = true;
+    }
+
+    /**
+     * This function parses the given command-line argument as a number
+     * which must not be negative.
+     *
+     * @param[in] arg
+     *     This is the command-line argument to parse.
+     *
+     * @param[out] number
+     *     This is where to store the number parsed.
+     *
+     * @return
+     *     An indication of whether or not the argument is a finite
+     *     number which isn't negative is returned.
+     */
+    bool ParseNumber(
+        const std::string& arg,
+        double& number
+    ) {
+        if (arg.empty()) {
+            return false;
+        }
+        char* end = nullptr;
+        number = strtod(arg.c_str(), &end);
+        return (
+            (*end == '\0')
+            && isfinite(number)
+            && (number >= 0.0)
+        );
+    }
+
+    /**
+     * This function checks whether or not the given number, which must
+     * not be negative, is a whole number small enough to be stored
+     * as a size_t.
+     *
+     * @param[in] number
+     *     This is the number to check.
+     *
+     * @return
+     *     An indication of whether or not the number is a whole number
+     *     small enough to be stored as a size_t is returned.
+     */
+    bool IsWholeSize(double number) {
+        // SIZE_MAX rounds up when converted to double, so anything
+        // not strictly below it might not fit.
+        return (
+            (number < (double)SIZE_MAX)
+            && (number == floor(number))
+        );
+    }
+
+    /**
+     * This function parses the given command-line argument as a
+     * whole number greater than zero.
+     *
+     * @param[in] arg
+     *     This is the command-line argument to parse.
+     *
+     * @param[out] count
+     *     This is where to store the number parsed.
+     *
+     * @return
+     *     An indication of whether or not the argument is a whole number
+     *     greater than zero is returned.
+     */
+    bool ParseCount(
+        const std::string& arg,
+        size_t& count
+    ) {
+        double number;
+        if (
+            !ParseNumber(arg, number)
+            || (number < 1.0)
+            || !IsWholeSize(number)
+        ) {
+            return false;
+        }
+        count = (size_t)number;
+        return true;
+    }
+
+    /**
+     * This function parses the given command-line argument as a size
+     * in bytes, which may have a suffix of "K" or "M" for kibibytes
+     * or mebibytes.
+     *
+     * @param[in] arg
+     *     This is the command-line argument to parse.
+     *
+     * @param[out] size
+     *     This is where to store the size parsed, in bytes.
+     *
+     * @return
+     *     An indication of whether or not the argument is a size
+     *     is returned.
+     */
+    bool ParseSize(
+        std::string arg,
+        size_t& size
+    ) {
+        size_t multiplier = 1;
+        if (!arg.empty()) {
+            switch (arg.back()) {
+                case 'K': case 'k': multiplier = 1024; break;
+                case 'M': case 'm': multiplier = 1024 * 1024; break;
+                default: break;
+            }
+            if (multiplier > 1) {
+                arg.pop_back();
+            }
+        }
+        double number;
+        if (
+            !ParseNumber(arg, number)
+            || !IsWholeSize(number)
+            || ((size_t)number > SIZE_MAX / multiplier)
+        ) {
+            return false;
+        }
+        size = (size_t)number * multiplier;
+        return true;
+    }
+
+    /**
+     * This function reads the script of messages to send when putting
+     * the server under load, one message per line, from the given file.
+     * Empty lines are skipped.
+     *
+     * @param[in] path
+     *     This is the path of the file containing the script.
+     *
+     * @param[out] script
+     *     This is where to store the messages of the script.
+     *
+     * @param[in] diagnosticMessageDelegate
+     *     This is the function to call to publish any diagnostic messages.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool ReadScript(
+        const std::string& path,
+        std::vector< std::string >& script,
+        SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+    ) {
+        SystemAbstractions::File scriptFile(path);
+        if (!scriptFile.OpenReadOnly()) {
+            diagnosticMessageDelegate(
+                "WsTalk",
+                SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                StringExtensions::sprintf(
+                    "unable to open script file '%s'",
+                    scriptFile.GetPath().c_str()
+                )
+            );
+            return false;
+        }
+        std::vector< uint8_t > scriptBuffer(scriptFile.GetSize());
+        if (scriptFile.Read(scriptBuffer) != scriptBuffer.size()) {
+            diagnosticMessageDelegate(
+                "WsTalk",
+                SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                StringExtensions::sprintf(
+                    "unable to read script file '%s'",
+                    scriptFile.GetPath().c_str()
+                )
+            );
+            return false;
+        }
+        script.clear();
+        std::string line;
+        for (const auto c: scriptBuffer) {
+            if (c == '\n') {
+                if (!line.empty()) {
+                    script.push_back(line);
+                }
+                line.clear();
+            } else if (c != '\r') {
+                line.push_back((char)c);
+            }
+        }
+        if (!line.empty()) {
+            script.push_back(line);
+        }
+        if (script.empty()) {
+            diagnosticMessageDelegate(
+                "WsTalk",
+                SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                StringExtensions::sprintf(
+                    "no messages in script file '%s'",
+                    scriptFile.GetPath().c_str()
+                )
+            );
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * This function sets what the program was asked to do, unless it was
+     * already asked to do something else.
+     *
+     * @param[in,out] environment
+     *     This is the environment to update.
+     *
+     * @param[in] mode
+     *     This is what the program was asked to do.
+     *
+     * @param[in] diagnosticMessageDelegate
+     *     This is the function to call to publish any diagnostic messages.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool SetMode(
+        Environment& environment,
+        Mode mode,
+        SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+    ) {
+        if (
+            (environment.mode != Mode::Interactive)
+            && (environment.mode != mode)
+        ) {
+            diagnosticMessageDelegate(
+                "WsTalk",
+                SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                "only one of --clients, --fanout, --ping, --throughput, --handshakes, --requests, --hexdump-benchmark, and --clock-benchmark may be used"
+            );
+            return false;
+        }
+        environment.mode = mode;
+        return true;
+    }
+
+    /**
+     * This function updates the program environment to incorporate
+     * any applicable command-line arguments.
+     *
+     * @param[in] argc
+     *     This is the number of command-line arguments given to the program.
+     *
+     * @param[in] argv
+     *     This is the array of command-line arguments given to the program.
+     *
+     * @param[in,out] environment
+     *     This is the environment to update.
+     *
+     * @param[in] diagnosticMessageDelegate
+     *     This is the function to call to publish any diagnostic messages.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool ProcessCommandLineArguments(
+        int argc,
+        char* argv[],
+        Environment& environment,
+        SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+    ) {
+        std::string urlString;
+        double rate = -1.0;
+        double rampRate = -1.0;
+        double duration = -1.0;
+        size_t state = 0;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg(argv[i]);
+            switch (state) {
+                case 0: { // next argument
+                    if (arg == "--cert") {
+                        state = 1;
+                    } else if (arg == "--clients") {
+                        state = 2;
+                    } else if (arg == "--rate") {
+                        state = 3;
+                    } else if (arg == "--ramp") {
+                        state = 4;
+                    } else if (arg == "--duration") {
+                        state = 5;
+                    } else if (arg == "--script") {
+                        state = 6;
+                    } else if (arg == "--fanout") {
+                        state = 7;
+                    } else if (arg == "--senders") {
+                        state = 8;
+                    } else if (arg == "--drain") {
+                        state = 9;
+                    } else if (arg == "--ping") {
+                        state = 10;
+                    } else if (arg == "--report") {
+                        state = 11;
+                    } else if (arg == "--timeout") {
+                        state = 12;
+                    } else if (arg == "--throughput") {
+                        if (!SetMode(environment, Mode::Throughput, diagnosticMessageDelegate)) {
+                            return false;
+                        }
+                    } else if (arg == "--hexdump-benchmark") {
+                        if (!SetMode(environment, Mode::HexDumpBenchmark, diagnosticMessageDelegate)) {
+                            return false;
+                        }
+                    } else if (arg == "--clock-benchmark") {
+                        if (!SetMode(environment, Mode::ClockBenchmark, diagnosticMessageDelegate)) {
+                            return false;
+                        }
+                    } else if (arg == "--sizes") {
+                        environment.throughput.messageSizes.clear();
+                        state = 13;
+                    } else if (arg == "--fragment") {
+                        state = 14;
+                    } else if (arg == "--metrics") {
+                        environment.metrics = true;
+                    } else if (arg == "--capture") {
+                        state = 15;
+                    } else if (arg == "--capture-size") {
+                        state = 16;
+                    } else if (arg == "--capture-files") {
+                        state = 17;
+                    } else if (arg == "--coalesce") {
+                        state = 18;
+                    } else if (arg == "--coalesce-bytes") {
+                        state = 19;
+                    } else if (arg == "--latency") {
+                        state = 20;
+                    } else if (arg == "--jitter") {
+                        state = 21;
+                    } else if (arg == "--bandwidth") {
+                        state = 22;
+                    } else if (arg == "--burst") {
+                        state = 23;
+                    } else if (arg == "--seed") {
+                        state = 24;
+                    } else if (arg == "--handshakes") {
+                        state = 25;
+                    } else if (arg == "--requests") {
+                        state = 26;
+                    } else if (arg == "--depth") {
+                        environment.requests.depths.clear();
+                        state = 27;
+                    } else {
+                        if (!urlString.empty()) {
+                            diagnosticMessageDelegate(
+                                "WsTalk",
+                                SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                                "multiple URLs given"
+                            );
+                            return false;
+                        }
+                        urlString = arg;
+                        state = 0;
+                    }
+                } break;
+
+                case 1: { // certificate to accept
+                    SystemAbstractions::File certFile(arg);
+                    if (!certFile.OpenReadOnly()) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            StringExtensions::sprintf(
+                                "unable to open certificate file '%s'",
+                                certFile.GetPath().c_str()
+                            )
+                        );
+                        return false;
+                    }
+                    std::vector< uint8_t > certBuffer(certFile.GetSize());
+                    if (certFile.Read(certBuffer) != certBuffer.size()) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            StringExtensions::sprintf(
+                                "unable to read certificate file '%s'",
+                                certFile.GetPath().c_str()
+                            )
+                        );
+                        return false;
+                    }
+                    const std::string cert(
+                        (const char*)certBuffer.data(),
+                        certBuffer.size()
+                    );
+                    environment.extraCerts += cert;
+                    state = 0;
+                } break;
+
+                case 2: { // number of WebSockets to open in load mode
+                    if (!SetMode(environment, Mode::Load, diagnosticMessageDelegate)) {
+                        return false;
+                    }
+                    if (!ParseCount(arg, environment.load.clients)) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "positive whole number expected for --clients"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 3: { // messages per second per WebSocket
+                    if (!ParseNumber(arg, rate)) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "number expected for --rate"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 4: { // WebSockets to start opening per second
+                    if (!ParseNumber(arg, rampRate)) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "number expected for --ramp"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 5: { // seconds to hold load or measure
+                    if (!ParseNumber(arg, duration)) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "number expected for --duration"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 6: { // script of messages to send in load mode
+                    if (!ReadScript(arg, environment.load.script, diagnosticMessageDelegate)) {
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 7: { // numbers of listeners in fan-out mode
+                    if (!SetMode(environment, Mode::FanOut, diagnosticMessageDelegate)) {
+                        return false;
+                    }
+                    for (const auto& listenersString: StringExtensions::Split(arg, ',')) {
+                        size_t listeners;
+                        if (
+                            !ParseCount(listenersString, listeners)
+                            || (
+                                !environment.fanOut.listeners.empty()
+                                && (listeners <= environment.fanOut.listeners.back())
+                            )
+                        ) {
+                            diagnosticMessageDelegate(
+                                "WsTalk",
+                                SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                                "increasing list of positive whole numbers expected for --fanout"
+                            );
+                            return false;
+                        }
+                        environment.fanOut.listeners.push_back(listeners);
+                    }
+                    state = 0;
+                } break;
+
+                case 8: { // number of senders in fan-out mode
+                    if (!ParseCount(arg, environment.fanOut.senders)) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "positive whole number expected for --senders"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 9: { // seconds to wait for tells in fan-out mode
+                    if (!ParseNumber(arg, environment.fanOut.drainTime)) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "number expected for --drain"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 10: { // seconds between pings in ping mode
+                    if (!SetMode(environment, Mode::Ping, diagnosticMessageDelegate)) {
+                        return false;
+                    }
+                    if (
+                        !ParseNumber(arg, environment.ping.interval)
+                        || (environment.ping.interval <= 0.0)
+                    ) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "positive number expected for --ping"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 11: { // seconds between summaries in ping mode
+                    if (
+                        !ParseNumber(arg, environment.ping.reportInterval)
+                        || (environment.ping.reportInterval <= 0.0)
+                    ) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "positive number expected for --report"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 12: { // seconds to wait for each pong in ping mode
+                    if (!ParseNumber(arg, environment.ping.timeout)) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "number expected for --timeout"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 13: { // message sizes in throughput mode
+                    for (const auto& sizeString: StringExtensions::Split(arg, ',')) {
+                        size_t size;
+                        if (
+                            !ParseSize(sizeString, size)
+                            || (size == 0)
+                        ) {
+                            diagnosticMessageDelegate(
+                                "WsTalk",
+                                SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                                "list of positive sizes expected for --sizes"
+                            );
+                            return false;
+                        }
+                        environment.throughput.messageSizes.push_back(size);
+                    }
+                    state = 0;
+                } break;
+
+                case 14: { // fragment size in throughput mode
+                    if (!ParseSize(arg, environment.throughput.fragmentSize)) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "size expected for --fragment"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 15: { // capture file path
+                    environment.captureFile = arg;
+                    state = 0;
+                } break;
+
+                case 16: { // most bytes to write to each capture file
+                    if (
+                        !ParseSize(arg, environment.captureFileSize)
+                        || (environment.captureFileSize == 0)
+                    ) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "positive size expected for --capture-size"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 17: { // most capture files to keep
+                    if (!ParseCount(arg, environment.captureFiles)) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "positive number expected for --capture-files"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 18: { // microseconds to gather data sent before sending it
+                    if (!ParseCount(arg, environment.coalesceWindow)) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "positive number expected for --coalesce"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 19: { // bytes to gather before sending them at once
+                    if (
+                        !ParseSize(arg, environment.coalesceBytes)
+                        || (environment.coalesceBytes == 0)
+                    ) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "positive size expected for --coalesce-bytes"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
+
+                case 20: { // milliseconds of latency to add to connections
+                    double latency;
+                    if (!ParseNumber(arg, latency)) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "number expected for --latency"
+                        );
+                        return false;
+                    }
+                    environment.linkShape.latency = latency / 1000.0;
+                    state = 0;
+                } break;
+
+                case 21: { // milliseconds of jitter to add to connections
+                    double jitter;
+                    if (!ParseNumber(arg, jitter)) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "number expected for --jitter"
+                        );
+                        return false;
+                    }
+                    environment.linkShape.jitter = jitter / 1000.0;
+                    state = 0;
+                } break;
+
+                case 22: { // bytes per second to which to limit connections
+                    size_t bandwidth;
+                    if (
+                        !ParseSize(arg, bandwidth)
+                        || (bandwidth == 0)
+                    ) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "positive size expected for --bandwidth"
+                        );
+                        return false;
+                    }
+                    environment.linkShape.bandwidth = (double)bandwidth;
+                    state = 0;
+                } break;
+
+                case 23: { // bytes connections may take at once
+                    if (!ParseSize(arg, environment.linkShape.burstSize)) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "size expected for --burst"
+                        );
+                        return false;
+                    }
+                    state = 0;
+                } break;
 
-    /**
-     * This function updates the program environment to incorporate
-     * any applicable command-line arguments.
-     *
-     * @param[in] argc
-     *     This is the number of command-line arguments given to the program.
-     *
-     * @param[in] argv
-     *     This is the array of command-line arguments given to the program.
-     *
-     * @param[in,out] environment
-     *     This is the environment to update.
-     *
-     * @param[in] diagnosticMessageDelegate
-     *     This is the function to call to publish any diagnostic messages.
-     *
-     * @return
-     *     An indication of whether or not the function succeeded is returned.
-     */
-    bool ProcessCommandLineArguments(
-        int argc,
-        char* argv[],
-        Environment& environment,
-        SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
-    ) {
-        std::string urlString;
-        size_t state = 0;
-        for (int i = 1; i < argc; ++i) {
-            const std::string arg(argv[i]);
-            switch (state) {
-                case 0: { // next argument
-                    if (arg == "--cert") {
-                        state = 1;
-                    } else {
-                        if (!urlString.empty()) {
-                            diagnosticMessageDelegate(
-                                "WsTalk",
-                                SystemAbstractions::DiagnosticsSender::Levels::ERROR,
-                                "multiple URLs given"
-                            );
-                            return false;
-                        }
-                        urlString = arg;
-                        state = 0;
+                case 24: { // seed for the jitter added to connections
+                    size_t seed;
+                    if (!ParseCount(arg, seed)) {
+                        diagnosticMessageDelegate(
+                            "WsTalk",
+                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                            "positive number expected for --seed"
+                        );
+                        return false;
                     }
+                    environment.linkShape.seed = (uint32_t)seed;
+                    state = 0;
                 } break;
 
-                case 1: { // certificate to accept
-                    SystemAbstractions::File certFile(arg);
-                    if (!certFile.OpenReadOnly()) {
+                case 25: { // number of WebSockets to open in handshake mode
+                    if (!SetMode(environment, Mode::Handshake, diagnosticMessageDelegate)) {
+                        return false;
+                    }
+                    if (!ParseCount(arg, environment.handshake.handshakes)) {
                         diagnosticMessageDelegate(
                             "WsTalk",
                             SystemAbstractions::DiagnosticsSender::Levels::ERROR,
-                            StringExtensions::sprintf(
-                                "unable to open certificate file '%s'",
-                                certFile.GetPath().c_str()
-                            )
+                            "positive whole number expected for --handshakes"
                         );
                         return false;
                     }
-                    std::vector< uint8_t > certBuffer(certFile.GetSize());
-                    if (certFile.Read(certBuffer) != certBuffer.size()) {
+                    state = 0;
+                } break;
+
+                case 26: { // number of requests to make in request mode
+                    if (!SetMode(environment, Mode::Requests, diagnosticMessageDelegate)) {
+                        return false;
+                    }
+                    if (!ParseCount(arg, environment.requests.requests)) {
                         diagnosticMessageDelegate(
                             "WsTalk",
                             SystemAbstractions::DiagnosticsSender::Levels::ERROR,
-                            StringExtensions::sprintf(
-                                "unable to read certificate file '%s'",
-                                certFile.GetPath().c_str()
-                            )
+                            "positive whole number expected for --requests"
                         );
                         return false;
                     }
-                    const std::string cert(
-                        (const char*)certBuffer.data(),
-                        certBuffer.size()
-                    );
-                    environment.extraCerts += cert;
+                    state = 0;
+                } break;
+
+                case 27: { // numbers of requests in flight in request mode
+                    for (const auto& depthString: StringExtensions::Split(arg, ',')) {
+                        size_t depth;
+                        if (!ParseCount(depthString, depth)) {
+                            diagnosticMessageDelegate(
+                                "WsTalk",
+                                SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                                "list of positive whole numbers expected for --depth"
+                            );
+                            return false;
+                        }
+                        environment.requests.depths.push_back(depth);
+                    }
                     state = 0;
                 } break;
             }
         }
-        if (state == 1) {
+        if (state != 0) {
+            static const char* const missingValueMessages[] = {
+                "",
+                "certificate file path expected for --cert",
+                "number expected for --clients",
+                "number expected for --rate",
+                "number expected for --ramp",
+                "number expected for --duration",
+                "script file path expected for --script",
+                "list of numbers expected for --fanout",
+                "number expected for --senders",
+                "number expected for --drain",
+                "number expected for --ping",
+                "number expected for --report",
+                "number expected for --timeout",
+                "list of sizes expected for --sizes",
+                "size expected for --fragment",
+                "capture file path expected for --capture",
+                "size expected for --capture-size",
+                "number expected for --capture-files",
+                "number expected for --coalesce",
+                "size expected for --coalesce-bytes",
+                "number expected for --latency",
+                "number expected for --jitter",
+                "size expected for --bandwidth",
+                "size expected for --burst",
+                "number expected for --seed",
+                "number expected for --handshakes",
+                "number expected for --requests",
+                "list of numbers expected for --depth",
+            };
             diagnosticMessageDelegate(
                 "WsTalk",
                 SystemAbstractions::DiagnosticsSender::Levels::ERROR,
-                "certificate file path expected for --cert"
+                missingValueMessages[state]
             );
             return false;
         }
+        switch (environment.mode) {
+            case Mode::Load: {
+                if (rate >= 0.0) {
+                    environment.load.rate = rate;
+                }
+                if (rampRate >= 0.0) {
+                    environment.load.rampRate = rampRate;
+                }
+                if (duration >= 0.0) {
+                    environment.load.duration = duration;
+                }
+                if (environment.load.script.empty()) {
+                    environment.load.script = {
+                        "{\"Type\":\"GetUsers\"}",
+                        "{\"Type\":\"GetAvailableNickNames\"}",
+                    };
+                }
+            } break;
+
+            case Mode::FanOut: {
+                if (rate >= 0.0) {
+                    environment.fanOut.rate = rate;
+                }
+                if (rampRate >= 0.0) {
+                    environment.fanOut.rampRate = rampRate;
+                }
+                if (duration >= 0.0) {
+                    environment.fanOut.duration = duration;
+                }
+            } break;
+
+            case Mode::Ping: {
+                if (duration >= 0.0) {
+                    environment.ping.duration = duration;
+                }
+            } break;
+
+            case Mode::Throughput: {
+                if (duration >= 0.0) {
+                    environment.throughput.duration = duration;
+                }
+            } break;
+
+            case Mode::Requests: {
+                // Connections are counted through the traffic metrics,
+                // so they're always collected in this mode.
+                environment.metrics = true;
+            } break;
+
+            default: break;
+        }
+        if (environment.mode != Mode::Interactive) {
+            environment.hexDump = false;
+            environment.minDiagnosticsLevel = SystemAbstractions::DiagnosticsSender::Levels::WARNING;
+        }
+        if (
+            (environment.mode == Mode::HexDumpBenchmark)
+            || (environment.mode == Mode::ClockBenchmark)
+        ) {
+            if (!urlString.empty()) {
+                diagnosticMessageDelegate(
+                    "WsTalk",
+                    SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                    StringExtensions::sprintf(
+                        "no URL is used with %s",
+                        (
+                            (environment.mode == Mode::HexDumpBenchmark)
+                            ? "--hexdump-benchmark"
+                            : "--clock-benchmark"
+                        )
+                    )
+                );
+                return false;
+            }
+            return true;
+        }
         if (urlString.empty()) {
             diagnosticMessageDelegate(
                 "WsTalk",
@@ -198,16 +1310,35 @@ namespace {
             return false;
         }
         const auto scheme = environment.url.GetScheme();
-        if (scheme != "wss") {
+        if (environment.mode == Mode::Requests) {
+            if (
+                (scheme != "https")
+                && (scheme != "http")
+            ) {
+                diagnosticMessageDelegate(
+                    "WsTalk",
+                    SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                    "please use \"https\" or \"http\" scheme with --requests"
+                );
+                return false;
+            }
+        } else if (
+            (scheme != "wss")
+            && (scheme != "ws")
+        ) {
             diagnosticMessageDelegate(
                 "WsTalk",
                 SystemAbstractions::DiagnosticsSender::Levels::ERROR,
-                "please use \"wss\" (secure WebSocket) scheme"
+                "please use \"wss\" (secure WebSocket) or \"ws\" (WebSocket over plain TCP) scheme"
             );
             return false;
         }
         if (!environment.url.HasPort()) {
-            environment.url.SetPort(DEFAULT_HTTPS_PORT);
+            environment.url.SetPort(
+                ((scheme == "wss") || (scheme == "https"))
+                ? DEFAULT_HTTPS_PORT
+                : DEFAULT_HTTP_PORT
+            );
         }
         return true;
     }
@@ -261,6 +1392,154 @@ namespace {
         return true;
     }
 
+    /**
+     * This function adds decorators to the given layer of a client
+     * connection to publish hex dumps of the data passing through it,
+     * capture it to a file, or count it, as asked.
+     *
+     * @param[in] layer
+     *     This is the layer of the connection to decorate.
+     *
+     * @param[in] layerName
+     *     This is the name of the layer, used to tag its hex dumps.
+     *
+     * @param[in] captureInterface
+     *     This is the index of the capture interface with which to tag
+     *     the packets captured at this layer.
+     *
+     * @param[in] hexDump
+     *     This indicates whether or not to publish hex dumps of the
+     *     data passing through the layer.
+     *
+     * @param[in] capture
+     *     If not null, this is used to capture the data passing
+     *     through the layer.
+     *
+     * @param[in] metrics
+     *     If not null, this is where to count the traffic passing
+     *     through the layer.
+     *
+     * @param[in] diagnosticMessageDelegate
+     *     This is the function to call to publish hex dumps.
+     *
+     * @return
+     *     The decorated layer is returned.
+     */
+    std::shared_ptr< SystemAbstractions::INetworkConnection > DecorateLayer(
+        std::shared_ptr< SystemAbstractions::INetworkConnection > layer,
+        const std::string& layerName,
+        size_t captureInterface,
+        bool hexDump,
+        std::shared_ptr< PcapngWriter > capture,
+        std::shared_ptr< TrafficMetrics > metrics,
+        SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
+    ) {
+        if (metrics != nullptr) {
+            const auto metricsDecorator = std::make_shared< TrafficMetricsDecorator >();
+            metricsDecorator->Decorate(layer, metrics);
+            layer = metricsDecorator;
+        }
+        if (capture != nullptr) {
+            const auto captureDecorator = std::make_shared< PcapngCaptureDecorator >();
+            captureDecorator->Decorate(
+                layer,
+                capture,
+                captureInterface,
+                (
+                    (captureInterface == TLS_CAPTURE_INTERFACE)
+                    ? TLS_CAPTURE_PEER_PORT
+                    : 0
+                )
+            );
+            layer = captureDecorator;
+        }
+        if (hexDump) {
+            const auto hexDumpDecorator = std::make_shared< HexDumpNetworkConnectionDecorator >();
+            const auto hexDumpDelegate = [diagnosticMessageDelegate, layerName](const std::string& lines){
+                diagnosticMessageDelegate(layerName, 3, lines);
+            };
+            hexDumpDecorator->Decorate(layer, hexDumpDelegate);
+            hexDumpDecorator->DeliverAsynchronously(
+                HEX_DUMP_QUEUE_CAPACITY,
+                HexDumpNetworkConnectionDecorator::DropPolicy::DropNewest
+            );
+            layer = hexDumpDecorator;
+        }
+        return layer;
+    }
+
+    /**
+     * This function decorates the given network connection layer, if the
+     * program was asked to, so that data sent through it in short
+     * succession is gathered and sent to the layer all at once.
+     *
+     * @param[in] layer
+     *     This is the network connection layer to decorate.
+     *
+     * @param[in] window
+     *     This is the longest, in microseconds, to hold data before
+     *     sending it to the layer, or zero to send it right away.
+     *
+     * @param[in] byteThreshold
+     *     This is the number of bytes which, once gathered, are sent to
+     *     the layer at once.
+     *
+     * @return
+     *     The decorated layer is returned.
+     */
+    std::shared_ptr< SystemAbstractions::INetworkConnection > CoalesceLayer(
+        std::shared_ptr< SystemAbstractions::INetworkConnection > layer,
+        size_t window,
+        size_t byteThreshold
+    ) {
+        if (window == 0) {
+            return layer;
+        }
+        const auto coalescingDecorator = std::make_shared< CoalescingNetworkConnectionDecorator >();
+        coalescingDecorator->Decorate(
+            layer,
+            std::chrono::microseconds(window),
+            byteThreshold
+        );
+        return coalescingDecorator;
+    }
+
+    /**
+     * This function decorates the given network connection layer, if the
+     * program was asked to, so that it imitates a slower network link.
+     *
+     * @param[in] layer
+     *     This is the network connection layer to decorate.
+     *
+     * @param[in] shape
+     *     These are the properties of the network link to imitate.
+     *
+     * @param[in] connectionIndex
+     *     This is the number of connections decorated before this one,
+     *     which is added to the seed for the jitter, so that each
+     *     connection's jitter is different, but the same every run.
+     *
+     * @return
+     *     The decorated layer is returned.
+     */
+    std::shared_ptr< SystemAbstractions::INetworkConnection > ShapeLayer(
+        std::shared_ptr< SystemAbstractions::INetworkConnection > layer,
+        LinkShape shape,
+        uint32_t connectionIndex
+    ) {
+        if (
+            (shape.latency <= 0.0)
+            && (shape.jitter <= 0.0)
+            && (shape.bandwidth <= 0.0)
+        ) {
+            return layer;
+        }
+        shape.seed += connectionIndex;
+        const auto linkShapingDecorator = std::make_shared< LinkShapingNetworkConnectionDecorator >();
+        linkShapingDecorator->Decorate(layer, shape);
+        return linkShapingDecorator;
+    }
+
     /**
      * This function starts the client with the given transport layer.
      *
@@ -271,9 +1550,14 @@ namespace {
      *     This contains variables set through the operating system
      *     environment or the command-line arguments.
      *
-     * @param[in] caCerts
-     *     This is the trusted certificate authority (CA) certificate bundle to
-     *     use to verify certificates at the TLS layer.
+     * @param[in] trustStore
+     *     This holds the trusted certificate authority (CA) certificates to
+     *     use to verify certificates at the TLS layer.  It's shared by
+     *     every connection.
+     *
+     * @param[in] metrics
+     *     These are where to count the traffic passing through the client's
+     *     connections, if the program was asked to.
      *
      * @param[in] diagnosticMessageDelegate
      *     This is the function to call to publish any diagnostic messages.
@@ -284,38 +1568,95 @@ namespace {
     bool StartClient(
         Http::Client& client,
         const Environment& environment,
-        const std::string& caCerts,
+        std::shared_ptr< const TrustStore > trustStore,
+        const ConnectionMetrics& metrics,
         SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
     ) {
         auto transport = std::make_shared< HttpNetworkTransport::HttpClientNetworkTransport >();
-        transport->SubscribeToDiagnostics(diagnosticMessageDelegate);
+        transport->SubscribeToDiagnostics(
+            diagnosticMessageDelegate,
+            environment.minDiagnosticsLevel
+        );
+        std::shared_ptr< PcapngWriter > capture;
+        if (!environment.captureFile.empty()) {
+            capture = std::make_shared< PcapngWriter >();
+            if (
+                !capture->Open(
+                    environment.captureFile,
+                    {"Wire", "TLS"},
+                    environment.captureFileSize,
+                    environment.captureFiles
+                )
+            ) {
+                diagnosticMessageDelegate(
+                    "WsTalk",
+                    SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                    StringExtensions::sprintf(
+                        "unable to create capture file '%s'",
+                        environment.captureFile.c_str()
+                    )
+                );
+                return false;
+            }
+        }
         Http::Client::MobilizationDependencies deps;
+        const auto hexDump = environment.hexDump;
+        const auto coalesceWindow = environment.coalesceWindow;
+        const auto coalesceBytes = environment.coalesceBytes;
+        const auto linkShape = environment.linkShape;
+        const auto connectionsShaped = std::make_shared< std::atomic< uint32_t > >(0);
         transport->SetConnectionFactory(
             [
                 diagnosticMessageDelegate,
-                caCerts
+                trustStore,
+                hexDump,
+                capture,
+                metrics,
+                coalesceWindow,
+                coalesceBytes,
+                linkShape,
+                connectionsShaped
             ](
                 const std::string& scheme,
                 const std::string& serverName
             ) -> std::shared_ptr< SystemAbstractions::INetworkConnection > {
-                const auto hexDumpNetworkConnectionUpperDecorator = std::make_shared< HexDumpNetworkConnectionDecorator >();
+                const auto secure = (
+                    (scheme == "https")
+                    || (scheme == "wss")
+                );
+                const auto connection = DecorateLayer(
+                    ShapeLayer(
+                        std::make_shared< SystemAbstractions::NetworkConnection >(),
+                        linkShape,
+                        (*connectionsShaped)++
+                    ),
+                    "Wire",
+                    WIRE_CAPTURE_INTERFACE,
+                    hexDump,
+                    capture,
+                    metrics.wire,
+                    diagnosticMessageDelegate
+                );
+                if (!secure) {
+                    return CoalesceLayer(connection, coalesceWindow, coalesceBytes);
+                }
                 const auto tlsDecorator = std::make_shared< TlsDecorator::TlsDecorator >();
-                const auto hexDumpNetworkConnectionLowerDecorator = std::make_shared< HexDumpNetworkConnectionDecorator >();
-                const auto connection = std::make_shared< SystemAbstractions::NetworkConnection >();
-                const auto hexDumpLowerDelegate = [diagnosticMessageDelegate](const std::string& line){
-                    diagnosticMessageDelegate("Wire", 3, line);
-                };
-                hexDumpNetworkConnectionLowerDecorator->Decorate(connection, hexDumpLowerDelegate);
-                tlsDecorator->ConfigureAsClient(hexDumpNetworkConnectionLowerDecorator, caCerts, serverName);
-                const auto hexDumpUpperDelegate = [diagnosticMessageDelegate](const std::string& line){
-                    diagnosticMessageDelegate("TLS", 3, line);
-                };
-                hexDumpNetworkConnectionUpperDecorator->Decorate(tlsDecorator, hexDumpUpperDelegate);
-                return hexDumpNetworkConnectionUpperDecorator;
+                tlsDecorator->ConfigureAsClient(connection, trustStore->GetBundle(), serverName);
+                return DecorateLayer(
+                    CoalesceLayer(tlsDecorator, coalesceWindow, coalesceBytes),
+                    "TLS",
+                    TLS_CAPTURE_INTERFACE,
+                    hexDump,
+                    capture,
+                    metrics.tls,
+                    diagnosticMessageDelegate
+                );
             }
         );
         deps.transport = transport;
-        deps.timeKeeper = std::make_shared< TimeKeeper >();
+        deps.timeKeeper = std::make_shared< MonotonicClock::TimeKeeper >(
+            std::make_shared< MonotonicClock::Clock >()
+        );
         client.Mobilize(deps);
         return true;
     }
@@ -351,17 +1692,11 @@ namespace {
         const Uri::Uri& url,
         SystemAbstractions::DiagnosticsSender::DiagnosticMessageDelegate diagnosticMessageDelegate
     ) {
-        Http::Request request;
-        request.method = "GET";
-        request.target = url;
         diagnosticMessageDelegate(
             "WsTalk",
             3,
-            "Connecting to '" + request.target.GenerateString() + "'..."
+            "Connecting to '" + url.GenerateString() + "'..."
         );
-        const auto ws = std::make_shared< WebSockets::WebSocket >();
-        ws->SubscribeToDiagnostics(diagnosticMessageDelegate);
-        ws->StartOpenAsClient(request);
         WebSockets::WebSocket::Delegates wsDelegates;
         wsDelegates.text = [diagnosticMessageDelegate](const std::string& data){
             diagnosticMessageDelegate(
@@ -378,84 +1713,29 @@ namespace {
             );
         };
         wsDelegates.close = closeDelegate;
-        ws->SetDelegates(std::move(wsDelegates));
-        bool wsEngaged = false;
-        const auto transaction = client.Request(
-            request,
-            false,
-            [
-                ws,
-                &wsEngaged
-            ](
-                const Http::Response& response,
-                std::shared_ptr< Http::Connection > connection,
-                const std::string& trailer
-            ){
-                if (ws->FinishOpenAsClient(connection, response)) {
-                    wsEngaged = true;
-                }
-            }
-        );
+        WebSocketOpener opener;
+        opener.Start(client, url, std::move(wsDelegates), diagnosticMessageDelegate);
         while (!shutDown) {
-            if (transaction->AwaitCompletion(std::chrono::milliseconds(5000))) {
-                switch (transaction->state) {
-                    case Http::Client::Transaction::State::Completed: {
-                        if (wsEngaged) {
-                            diagnosticMessageDelegate(
-                                "WsTalk",
-                                3,
-                                "Connection established."
-                            );
-                            return ws;
-                        } else {
-                            if (transaction->response.statusCode == 101) {
-                                diagnosticMessageDelegate(
-                                    "WsTalk",
-                                    SystemAbstractions::DiagnosticsSender::Levels::ERROR,
-                                    "Connection upgraded, but failed to engage WebSocket"
-                                );
-                            } else {
-                                diagnosticMessageDelegate(
-                                    "WsTalk",
-                                    SystemAbstractions::DiagnosticsSender::Levels::ERROR,
-                                    StringExtensions::sprintf(
-                                        "Got back response: %u %s",
-                                        transaction->response.statusCode,
-                                        transaction->response.reasonPhrase.c_str()
-                                    )
-                                );
-                            }
-                            return nullptr;
-                        }
-                    } break;
-
-                    case Http::Client::Transaction::State::UnableToConnect: {
-                        diagnosticMessageDelegate(
-                            "WsTalk",
-                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
-                            "unable to connect"
-                        );
-                    } break;
-
-                    case Http::Client::Transaction::State::Broken: {
-                        diagnosticMessageDelegate(
-                            "WsTalk",
-                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
-                            "connection broken by server"
-                        );
-                    } break;
+            switch (opener.Await(std::chrono::milliseconds(5000))) {
+                case WebSocketOpener::State::Open: {
+                    diagnosticMessageDelegate(
+                        "WsTalk",
+                        3,
+                        "Connection established."
+                    );
+                    return opener.GetWebSocket();
+                } break;
 
-                    case Http::Client::Transaction::State::Timeout: {
-                        diagnosticMessageDelegate(
-                            "WsTalk",
-                            SystemAbstractions::DiagnosticsSender::Levels::ERROR,
-                            "timeout waiting for response"
-                        );
-                    } break;
+                case WebSocketOpener::State::Failed: {
+                    diagnosticMessageDelegate(
+                        "WsTalk",
+                        SystemAbstractions::DiagnosticsSender::Levels::ERROR,
+                        opener.GetError()
+                    );
+                    return nullptr;
+                } break;
 
-                    default: break;
-                }
-                return nullptr;
+                default: break;
             }
         }
         diagnosticMessageDelegate(
@@ -476,6 +1756,89 @@ namespace {
         client.Demobilize();
     }
 
+    /**
+     * This function prints a line of the traffic metrics report, for
+     * one direction of traffic at one layer of the client's connections.
+     *
+     * @param[in] layerName
+     *     This is the name of the layer.
+     *
+     * @param[in] directionName
+     *     This is the name of the direction of traffic.
+     *
+     * @param[in] metrics
+     *     These are the metrics of the traffic.
+     */
+    void ReportTrafficDirection(
+        const char* layerName,
+        const char* directionName,
+        const TrafficMetrics::DirectionSnapshot& metrics
+    ) {
+        printf(
+            "%-5s %-4s %9" PRIu64 " %13" PRIu64 " %10.1f %9" PRIu64 " %9" PRIu64 " %11.3f %11.3f\n",
+            layerName,
+            directionName,
+            metrics.messages,
+            metrics.bytes,
+            (
+                (metrics.messages == 0)
+                ? 0.0
+                : (double)metrics.bytes / (double)metrics.messages
+            ),
+            TrafficMetrics::GetValueAtPercentile(metrics.sizes, 50.0),
+            TrafficMetrics::GetValueAtPercentile(metrics.sizes, 99.0),
+            (double)TrafficMetrics::GetValueAtPercentile(metrics.interArrivalTimes, 50.0) / 1000.0,
+            (double)TrafficMetrics::GetValueAtPercentile(metrics.interArrivalTimes, 99.0) / 1000.0
+        );
+    }
+
+    /**
+     * This function prints a report of the traffic which passed through
+     * the client's connections, if the program was asked to count it.
+     *
+     * @param[in] metrics
+     *     These are where the traffic was counted.
+     */
+    void ReportTrafficMetrics(const ConnectionMetrics& metrics) {
+        if (metrics.wire == nullptr) {
+            return;
+        }
+        const auto wire = metrics.wire->GetSnapshot();
+        const auto tls = metrics.tls->GetSnapshot();
+        printf("\nConnections: %" PRIu64 "\n", wire.connections);
+        printf("\nlayer dir   messages         bytes  mean size  p50 size  p99 size  p50 gap ms  p99 gap ms\n");
+        ReportTrafficDirection("Wire", "sent", wire.sent);
+        ReportTrafficDirection("Wire", "recv", wire.received);
+        if (
+            (tls.sent.messages == 0)
+            && (tls.received.messages == 0)
+        ) {
+            return;
+        }
+        ReportTrafficDirection("TLS", "sent", tls.sent);
+        ReportTrafficDirection("TLS", "recv", tls.received);
+        const auto reportOverhead = [](
+            const char* directionName,
+            const TrafficMetrics::DirectionSnapshot& wire,
+            const TrafficMetrics::DirectionSnapshot& tls
+        ){
+            if (
+                (tls.bytes == 0)
+                || (tls.messages == 0)
+            ) {
+                return;
+            }
+            printf(
+                "TLS overhead (%s): %.1f%% more bytes on the wire, %.2f wire messages per TLS message\n",
+                directionName,
+                100.0 * ((double)wire.bytes - (double)tls.bytes) / (double)tls.bytes,
+                (double)wire.messages / (double)tls.messages
+            );
+        };
+        reportOverhead("sent", wire.sent, tls.sent);
+        reportOverhead("received", wire.received, tls.received);
+    }
+
 }
 
 /**
@@ -511,27 +1874,148 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
-    // Load trusted certificate authority (CA) certificate bundle to use
-    // at the TLS layer of web connections.
+    // If asked to measure hex dump formatting, do only that, since
+    // it doesn't involve connecting to anything.
+    if (environment.mode == Mode::HexDumpBenchmark) {
+        return (
+            RunHexDumpBenchmark(diagnosticsPublisher)
+            ? EXIT_SUCCESS
+            : EXIT_FAILURE
+        );
+    }
+
+    // Likewise, if asked to measure how long it takes to tell the time,
+    // do only that.
+    if (environment.mode == Mode::ClockBenchmark) {
+        return (
+            RunClockBenchmark(diagnosticsPublisher)
+            ? EXIT_SUCCESS
+            : EXIT_FAILURE
+        );
+    }
+
+    // Load trusted certificate authority (CA) certificate bundle, and
+    // gather it, along with any extra certificates, into a trust store
+    // to be shared by the TLS layer of every web connection.
+    const auto trustStoreStart = std::chrono::steady_clock::now();
     std::string caCerts;
     if (!LoadCaCerts(caCerts, diagnosticsPublisher)) {
         return EXIT_FAILURE;
     }
+    const auto trustStore = std::make_shared< TrustStore >();
+    (void)trustStore->AddCertificates(caCerts);
+    (void)trustStore->AddCertificates(environment.extraCerts);
+    diagnosticsPublisher(
+        "WsTalk",
+        3,
+        StringExtensions::sprintf(
+            "Loaded %zu trusted certificates (%zu of %zu bytes kept) in %.3f ms",
+            trustStore->GetCertificateCount(),
+            trustStore->GetBundle().length(),
+            caCerts.length() + environment.extraCerts.length(),
+            std::chrono::duration< double, std::milli >(
+                std::chrono::steady_clock::now() - trustStoreStart
+            ).count()
+        )
+    );
 
     // Set up an HTTP client to be used to connect to the web server.
     Http::Client client;
-    const auto diagnosticsSubscription = client.SubscribeToDiagnostics(diagnosticsPublisher);
+    ConnectionMetrics metrics;
+    if (environment.metrics) {
+        metrics.wire = std::make_shared< TrafficMetrics >();
+        metrics.tls = std::make_shared< TrafficMetrics >();
+    }
+    const auto diagnosticsSubscription = client.SubscribeToDiagnostics(
+        diagnosticsPublisher,
+        environment.minDiagnosticsLevel
+    );
     if (
         !StartClient(
             client,
             environment,
-            caCerts + environment.extraCerts,
+            trustStore,
+            metrics,
             diagnosticsPublisher
         )
     ) {
         return EXIT_FAILURE;
     }
 
+    // If asked to measure something, do that instead of talking to
+    // the server interactively.
+    if (environment.mode != Mode::Interactive) {
+        bool measurementSucceeded = false;
+        switch (environment.mode) {
+            case Mode::Load: {
+                measurementSucceeded = RunLoad(
+                    client,
+                    environment.url,
+                    environment.load,
+                    shutDown,
+                    diagnosticsPublisher
+                );
+            } break;
+
+            case Mode::FanOut: {
+                measurementSucceeded = RunFanOut(
+                    client,
+                    environment.url,
+                    environment.fanOut,
+                    shutDown,
+                    diagnosticsPublisher
+                );
+            } break;
+
+            case Mode::Ping: {
+                measurementSucceeded = RunPingProber(
+                    client,
+                    environment.url,
+                    environment.ping,
+                    shutDown,
+                    diagnosticsPublisher
+                );
+            } break;
+
+            case Mode::Throughput: {
+                measurementSucceeded = RunThroughputBenchmark(
+                    client,
+                    environment.url,
+                    environment.throughput,
+                    shutDown,
+                    diagnosticsPublisher
+                );
+            } break;
+
+            case Mode::Handshake: {
+                measurementSucceeded = RunHandshakeBenchmark(
+                    client,
+                    environment.url,
+                    environment.handshake,
+                    shutDown,
+                    diagnosticsPublisher
+                );
+            } break;
+
+            case Mode::Requests: {
+                measurementSucceeded = RunRequestBenchmark(
+                    client,
+                    environment.url,
+                    environment.requests,
+                    metrics.wire,
+                    shutDown,
+                    diagnosticsPublisher
+                );
+            } break;
+
+            default: break;
+        }
+        StopClient(client);
+        ReportTrafficMetrics(metrics);
+        (void)signal(SIGINT, previousInterruptHandler);
+        return (measurementSucceeded ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
     // Connect to the web server and request an upgrade to a WebSocket.
     bool wsClosed = false;
     std::mutex mutex;
@@ -617,6 +2101,7 @@ int main(int argc, char* argv[]) {
         }
     }
     ws = nullptr;
+    ReportTrafficMetrics(metrics);
 
     // We're all done!
     (void)signal(SIGINT, previousInterruptHandler);
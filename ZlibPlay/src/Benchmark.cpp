@@ -0,0 +1,832 @@
+/**
+ * @file Benchmark.cpp
+ *
+ * This module contains the implementation of the functions used to
+ * measure the throughput of zlib compression and decompression.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Benchmark.hpp"
+#include "Checksums.hpp"
+#include "Deflater.hpp"
+#include "Inflater.hpp"
+#include "ZlibArena.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <inttypes.h>
+#include <memory>
+#include <random>
+#include <stdint.h>
+#include <zlib.h>
+
+namespace {
+
+    /**
+     * These are the buffer sizes at which to measure checksum kernels.
+     */
+    constexpr size_t CHECKSUM_BUFFER_SIZES[] = {64, 1024, 16384, 262144, 4194304};
+
+    /**
+     * This is the number of starting alignments at which checksum kernels
+     * are checked against zlib.
+     */
+    constexpr size_t CHECKSUM_ALIGNMENTS = 16;
+
+    /**
+     * This is the least time to spend measuring each checksum kernel
+     * at each buffer size.
+     */
+    constexpr std::chrono::milliseconds CHECKSUM_MEASURE_TIME(200);
+
+    /**
+     * This is the least number of bytes to checksum between
+     * looking at the clock.
+     */
+    constexpr size_t CHECKSUM_BYTES_PER_CLOCK_CHECK = 1 << 20;
+
+    /**
+     * This is the clock used to time compression and decompression.
+     */
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * This holds one combination of settings to measure.
+     */
+    struct Parameters {
+        /**
+         * This is the compression level to use.
+         */
+        int level = Z_DEFAULT_COMPRESSION;
+
+        /**
+         * This is the compression strategy to use.
+         */
+        int strategy = Z_DEFAULT_STRATEGY;
+
+        /**
+         * This is the windowBits value to give to deflateInit2.
+         */
+        int windowBits = MAX_WBITS;
+
+        /**
+         * This is the size of the chunks, in bytes, in which data is fed
+         * to and collected from zlib.
+         */
+        size_t bufferSize = 16384;
+
+        /**
+         * This is the way in which zlib state is carried from one file
+         * to the next.
+         */
+        BenchmarkConfiguration::Reuse reuse = BenchmarkConfiguration::Reuse::Fresh;
+
+        /**
+         * If not empty, this is the preset dictionary to use.
+         */
+        std::vector< uint8_t > dictionary;
+    };
+
+    /**
+     * This holds what was measured for one combination of settings.
+     */
+    struct Measurements {
+        /**
+         * This is the number of files compressed.
+         */
+        size_t files = 0;
+
+        /**
+         * This is the total number of bytes compressed.
+         */
+        uint64_t inputBytes = 0;
+
+        /**
+         * This is the total number of bytes produced by compression.
+         */
+        uint64_t compressedBytes = 0;
+
+        /**
+         * This is the total time, in seconds, spent compressing,
+         * including stream setup, reset, and teardown.
+         */
+        double deflateSeconds = 0.0;
+
+        /**
+         * This is the total time, in seconds, spent decompressing,
+         * including stream setup, reset, and teardown.
+         */
+        double inflateSeconds = 0.0;
+
+        /**
+         * These are the times, in microseconds, spent compressing
+         * each chunk of input.
+         */
+        std::vector< double > deflateLatencies;
+
+        /**
+         * These are the times, in microseconds, spent decompressing
+         * each chunk of input.
+         */
+        std::vector< double > inflateLatencies;
+    };
+
+    /**
+     * This function returns the number of seconds between the given
+     * points in time.
+     *
+     * @param[in] start
+     *     This is the earlier point in time.
+     *
+     * @param[in] end
+     *     This is the later point in time.
+     *
+     * @return
+     *     The number of seconds between the given points in time
+     *     is returned.
+     */
+    double SecondsBetween(
+        Clock::time_point start,
+        Clock::time_point end
+    ) {
+        return std::chrono::duration< double >(end - start).count();
+    }
+
+    /**
+     * This function returns the given percentile of the given samples.
+     * The samples are partially reordered in the process.
+     *
+     * @param[in,out] samples
+     *     These are the samples from which to select the percentile.
+     *
+     * @param[in] fraction
+     *     This is the percentile to select, as a fraction from 0 to 1.
+     *
+     * @return
+     *     The given percentile of the given samples is returned,
+     *     or zero if there are no samples.
+     */
+    double Percentile(
+        std::vector< double >& samples,
+        double fraction
+    ) {
+        if (samples.empty()) {
+            return 0.0;
+        }
+        const auto index = std::min(
+            samples.size() - 1,
+            (size_t)(fraction * samples.size())
+        );
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+
+    /**
+     * This function returns the windowBits value to give to inflateInit2 in
+     * order to decompress data compressed with the given windowBits value.
+     *
+     * @param[in] windowBits
+     *     This is the windowBits value given to deflateInit2.
+     *
+     * @return
+     *     The windowBits value to give to inflateInit2 is returned.
+     */
+    int InflateWindowBits(int windowBits) {
+        if (windowBits < 0) {
+            return -MAX_WBITS;
+        } else if (windowBits > MAX_WBITS) {
+            return 16 + MAX_WBITS;
+        } else {
+            return MAX_WBITS;
+        }
+    }
+
+    /**
+     * This function compresses the given input, feeding it to zlib in
+     * chunks of the configured buffer size.
+     *
+     * @param[in] input
+     *     This is the data to compress.
+     *
+     * @param[in] parameters
+     *     These are the settings to use for compression.
+     *
+     * @param[in] arena
+     *     If not null, this is the arena from which zlib should
+     *     allocate its memory.
+     *
+     * @param[in,out] deflater
+     *     This is the object used to compress the data.  It's either set
+     *     up for this input and torn down afterwards, or reset and kept,
+     *     depending on how zlib state is to be reused.
+     *
+     * @param[out] output
+     *     This is where to store the compressed data.
+     *
+     * @param[in,out] measurements
+     *     This is where to record the time spent.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool Deflate(
+        const std::vector< uint8_t >& input,
+        const Parameters& parameters,
+        const std::shared_ptr< ZlibArena >& arena,
+        Deflater& deflater,
+        std::vector< uint8_t >& output,
+        Measurements& measurements
+    ) {
+        output.clear();
+        const auto start = Clock::now();
+        if (
+            (parameters.reuse != BenchmarkConfiguration::Reuse::Reset)
+            || !deflater.Reset()
+        ) {
+            DeflaterConfiguration configuration;
+            configuration.level = parameters.level;
+            configuration.windowBits = parameters.windowBits;
+            configuration.strategy = parameters.strategy;
+            configuration.chunkSize = parameters.bufferSize;
+            configuration.dictionary = parameters.dictionary;
+            if (!deflater.Initialize(configuration, arena)) {
+                fprintf(stderr, "error: unable to set up deflate\n");
+                return false;
+            }
+        }
+        const auto collectOutput = [&output](const uint8_t* data, size_t size){
+            output.insert(output.end(), data, data + size);
+            return true;
+        };
+        size_t offset = 0;
+        do {
+            const auto chunkSize = std::min(parameters.bufferSize, input.size() - offset);
+            const auto chunk = input.data() + offset;
+            offset += chunkSize;
+            const auto chunkStart = Clock::now();
+            if (
+                !deflater.Deflate(
+                    chunk,
+                    chunkSize,
+                    (offset == input.size()),
+                    collectOutput
+                )
+            ) {
+                fprintf(stderr, "error: deflate failed\n");
+                return false;
+            }
+            measurements.deflateLatencies.push_back(
+                SecondsBetween(chunkStart, Clock::now()) * 1e6
+            );
+        } while (offset < input.size());
+        if (parameters.reuse != BenchmarkConfiguration::Reuse::Reset) {
+            deflater = Deflater();
+        }
+        measurements.deflateSeconds += SecondsBetween(start, Clock::now());
+        return true;
+    }
+
+    /**
+     * This function decompresses the given input, feeding it to zlib in
+     * chunks of the configured buffer size.
+     *
+     * @param[in] input
+     *     This is the data to decompress.
+     *
+     * @param[in] parameters
+     *     These are the settings which were used for compression.
+     *
+     * @param[in] arena
+     *     If not null, this is the arena from which zlib should
+     *     allocate its memory.
+     *
+     * @param[in,out] inflater
+     *     This is the object used to decompress the data.  It's either set
+     *     up for this input and torn down afterwards, or reset and kept,
+     *     depending on how zlib state is to be reused.
+     *
+     * @param[out] output
+     *     This is where to store the decompressed data.
+     *
+     * @param[in,out] measurements
+     *     This is where to record the time spent.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool Inflate(
+        const std::vector< uint8_t >& input,
+        const Parameters& parameters,
+        const std::shared_ptr< ZlibArena >& arena,
+        Inflater& inflater,
+        std::vector< uint8_t >& output,
+        Measurements& measurements
+    ) {
+        output.clear();
+        const auto start = Clock::now();
+        if (
+            (parameters.reuse != BenchmarkConfiguration::Reuse::Reset)
+            || !inflater.Reset()
+        ) {
+            InflaterConfiguration configuration;
+            configuration.windowBits = InflateWindowBits(parameters.windowBits);
+            configuration.chunkSize = parameters.bufferSize;
+            configuration.dictionary = parameters.dictionary;
+            if (!inflater.Initialize(configuration, arena)) {
+                fprintf(stderr, "error: unable to set up inflate\n");
+                return false;
+            }
+        }
+        const auto collectOutput = [&output](const uint8_t* data, size_t size){
+            output.insert(output.end(), data, data + size);
+            return true;
+        };
+        size_t offset = 0;
+        while (
+            !inflater.IsFinished()
+            && (offset < input.size())
+        ) {
+            const auto chunkSize = std::min(parameters.bufferSize, input.size() - offset);
+            const auto chunk = input.data() + offset;
+            offset += chunkSize;
+            const auto chunkStart = Clock::now();
+            if (!inflater.Inflate(chunk, chunkSize, collectOutput)) {
+                fprintf(stderr, "error: inflate failed\n");
+                return false;
+            }
+            measurements.inflateLatencies.push_back(
+                SecondsBetween(chunkStart, Clock::now()) * 1e6
+            );
+        }
+        const auto finished = inflater.IsFinished();
+        if (parameters.reuse != BenchmarkConfiguration::Reuse::Reset) {
+            inflater = Inflater();
+        }
+        measurements.inflateSeconds += SecondsBetween(start, Clock::now());
+        if (!finished) {
+            fprintf(stderr, "error: inflate did not finish\n");
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * This function compresses and decompresses every file in the given
+     * corpus using the given settings, and verifies the round trip.
+     *
+     * @param[in] corpus
+     *     This is the collection of files to compress.
+     *
+     * @param[in] parameters
+     *     These are the settings to use.
+     *
+     * @param[in] repetitions
+     *     This is the number of times to process the corpus.
+     *
+     * @param[out] measurements
+     *     This is where to store what was measured.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool Measure(
+        const Corpus& corpus,
+        const Parameters& parameters,
+        size_t repetitions,
+        Measurements& measurements
+    ) {
+        std::shared_ptr< ZlibArena > arena;
+        if (parameters.reuse == BenchmarkConfiguration::Reuse::Arena) {
+            arena = std::make_shared< ZlibArena >();
+        }
+        Deflater deflater;
+        Inflater inflater;
+        std::vector< uint8_t > deflated;
+        std::vector< uint8_t > inflated;
+        for (size_t repetition = 0; repetition < repetitions; ++repetition) {
+            for (const auto& file: corpus) {
+                if (
+                    !Deflate(file.content, parameters, arena, deflater, deflated, measurements)
+                    || !Inflate(deflated, parameters, arena, inflater, inflated, measurements)
+                ) {
+                    fprintf(stderr, "error: unable to process '%s'\n", file.path.c_str());
+                    return false;
+                }
+                if (inflated != file.content) {
+                    fprintf(stderr, "error: round trip mismatch for '%s'\n", file.path.c_str());
+                    return false;
+                }
+                ++measurements.files;
+                measurements.inputBytes += file.content.size();
+                measurements.compressedBytes += deflated.size();
+            }
+        }
+        return true;
+    }
+
+    /**
+     * This function writes the results for one combination of settings
+     * to the given report.
+     *
+     * @param[in] report
+     *     This is the stream to which to write the results.
+     *
+     * @param[in] format
+     *     This is the format in which to write the results.
+     *
+     * @param[in] first
+     *     This indicates whether or not these are the first results
+     *     written to the report.
+     *
+     * @param[in] parameters
+     *     These are the settings which were measured.
+     *
+     * @param[in,out] measurements
+     *     This holds what was measured.  The latency samples are
+     *     reordered in the process of selecting percentiles.
+     */
+    void ReportMeasurements(
+        FILE* report,
+        BenchmarkConfiguration::ReportFormat format,
+        bool first,
+        const Parameters& parameters,
+        Measurements& measurements
+    ) {
+        const auto ratio = (
+            (measurements.inputBytes == 0)
+            ? 1.0
+            : (double)measurements.compressedBytes / (double)measurements.inputBytes
+        );
+        const auto deflateMBps = (
+            (measurements.deflateSeconds > 0.0)
+            ? (double)measurements.inputBytes / 1e6 / measurements.deflateSeconds
+            : 0.0
+        );
+        const auto inflateMBps = (
+            (measurements.inflateSeconds > 0.0)
+            ? (double)measurements.inputBytes / 1e6 / measurements.inflateSeconds
+            : 0.0
+        );
+        const auto deflateP50 = Percentile(measurements.deflateLatencies, 0.50);
+        const auto deflateP99 = Percentile(measurements.deflateLatencies, 0.99);
+        const auto inflateP50 = Percentile(measurements.inflateLatencies, 0.50);
+        const auto inflateP99 = Percentile(measurements.inflateLatencies, 0.99);
+        const auto strategy = GetStrategyName(parameters.strategy);
+        const auto reuse = GetReuseName(parameters.reuse);
+        switch (format) {
+            case BenchmarkConfiguration::ReportFormat::Csv: {
+                if (first) {
+                    fprintf(
+                        report,
+                        "level,strategy,windowBits,bufferSize,reuse,dictionaryBytes,"
+                        "files,inputBytes,compressedBytes,ratio,"
+                        "deflateMBps,inflateMBps,deflateP50us,deflateP99us,inflateP50us,inflateP99us\n"
+                    );
+                }
+                fprintf(
+                    report,
+                    "%d,%s,%d,%zu,%s,%zu,%zu,%" PRIu64 ",%" PRIu64 ",%.4f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+                    parameters.level,
+                    strategy.c_str(),
+                    parameters.windowBits,
+                    parameters.bufferSize,
+                    reuse.c_str(),
+                    parameters.dictionary.size(),
+                    measurements.files,
+                    measurements.inputBytes,
+                    measurements.compressedBytes,
+                    ratio,
+                    deflateMBps,
+                    inflateMBps,
+                    deflateP50,
+                    deflateP99,
+                    inflateP50,
+                    inflateP99
+                );
+            } break;
+
+            case BenchmarkConfiguration::ReportFormat::Json: {
+                fprintf(
+                    report,
+                    (
+                        "%s  {\"level\": %d, \"strategy\": \"%s\", \"windowBits\": %d, \"bufferSize\": %zu,"
+                        " \"reuse\": \"%s\", \"dictionaryBytes\": %zu, \"files\": %zu,"
+                        " \"inputBytes\": %" PRIu64 ", \"compressedBytes\": %" PRIu64 ","
+                        " \"ratio\": %.4f, \"deflateMBps\": %.2f, \"inflateMBps\": %.2f,"
+                        " \"deflateP50us\": %.2f, \"deflateP99us\": %.2f,"
+                        " \"inflateP50us\": %.2f, \"inflateP99us\": %.2f}"
+                    ),
+                    (first ? "" : ",\n"),
+                    parameters.level,
+                    strategy.c_str(),
+                    parameters.windowBits,
+                    parameters.bufferSize,
+                    reuse.c_str(),
+                    parameters.dictionary.size(),
+                    measurements.files,
+                    measurements.inputBytes,
+                    measurements.compressedBytes,
+                    ratio,
+                    deflateMBps,
+                    inflateMBps,
+                    deflateP50,
+                    deflateP99,
+                    inflateP50,
+                    inflateP99
+                );
+            } break;
+        }
+    }
+
+
+    /**
+     * This function measures one combination of settings
+     * and reports the results.
+     *
+     * @param[in] corpus
+     *     This is the collection of files to compress.
+     *
+     * @param[in] configuration
+     *     This holds the settings which control the benchmark.
+     *
+     * @param[in] parameters
+     *     These are the settings to measure.
+     *
+     * @param[in,out] first
+     *     This indicates whether or not no results have been written
+     *     to the report yet.  It's cleared once results are written.
+     *
+     * @param[in] report
+     *     This is the stream to which to write the results.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool MeasureAndReport(
+        const Corpus& corpus,
+        const BenchmarkConfiguration& configuration,
+        const Parameters& parameters,
+        bool& first,
+        FILE* report
+    ) {
+        fprintf(
+            stderr,
+            "Measuring level %d, strategy %s, windowBits %d, bufferSize %zu, reuse %s, dictionary %zu...\n",
+            parameters.level,
+            GetStrategyName(parameters.strategy).c_str(),
+            parameters.windowBits,
+            parameters.bufferSize,
+            GetReuseName(parameters.reuse).c_str(),
+            parameters.dictionary.size()
+        );
+        Measurements measurements;
+        if (
+            !Measure(
+                corpus,
+                parameters,
+                configuration.repetitions,
+                measurements
+            )
+        ) {
+            return false;
+        }
+        ReportMeasurements(
+            report,
+            configuration.reportFormat,
+            first,
+            parameters,
+            measurements
+        );
+        first = false;
+        return true;
+    }
+
+}
+
+std::string GetStrategyName(int strategy) {
+    switch (strategy) {
+        case Z_DEFAULT_STRATEGY: return "default";
+        case Z_FILTERED: return "filtered";
+        case Z_HUFFMAN_ONLY: return "huffman";
+        case Z_RLE: return "rle";
+        case Z_FIXED: return "fixed";
+        default: return std::to_string(strategy);
+    }
+}
+
+bool ParseStrategyName(
+    const std::string& name,
+    int& strategy
+) {
+    static const struct {
+        const char* name;
+        int strategy;
+    } strategies[] = {
+        {"default", Z_DEFAULT_STRATEGY},
+        {"filtered", Z_FILTERED},
+        {"huffman", Z_HUFFMAN_ONLY},
+        {"rle", Z_RLE},
+        {"fixed", Z_FIXED},
+    };
+    for (const auto& entry: strategies) {
+        if (name == entry.name) {
+            strategy = entry.strategy;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string GetReuseName(BenchmarkConfiguration::Reuse reuse) {
+    switch (reuse) {
+        case BenchmarkConfiguration::Reuse::Fresh: return "fresh";
+        case BenchmarkConfiguration::Reuse::Arena: return "arena";
+        case BenchmarkConfiguration::Reuse::Reset: return "reset";
+        default: return "";
+    }
+}
+
+bool ParseReuseName(
+    const std::string& name,
+    BenchmarkConfiguration::Reuse& reuse
+) {
+    static const struct {
+        const char* name;
+        BenchmarkConfiguration::Reuse reuse;
+    } reuses[] = {
+        {"fresh", BenchmarkConfiguration::Reuse::Fresh},
+        {"arena", BenchmarkConfiguration::Reuse::Arena},
+        {"reset", BenchmarkConfiguration::Reuse::Reset},
+    };
+    for (const auto& entry: reuses) {
+        if (name == entry.name) {
+            reuse = entry.reuse;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RunChecksumBenchmark(
+    const BenchmarkConfiguration& configuration,
+    FILE* report
+) {
+    constexpr size_t numBufferSizes = sizeof(CHECKSUM_BUFFER_SIZES) / sizeof(CHECKSUM_BUFFER_SIZES[0]);
+    const auto largestBufferSize = CHECKSUM_BUFFER_SIZES[numBufferSizes - 1];
+    std::vector< uint8_t > data(largestBufferSize + CHECKSUM_ALIGNMENTS);
+    std::mt19937 generator;
+    for (auto& byte: data) {
+        byte = (uint8_t)generator();
+    }
+    const struct {
+        const char* name;
+        uint32_t initial;
+        std::vector< ChecksumKernel > kernels;
+    } checksums[] = {
+        {"crc32", 0, GetCrc32Kernels()},
+        {"adler32", 1, GetAdler32Kernels()},
+    };
+    const auto json = (configuration.reportFormat == BenchmarkConfiguration::ReportFormat::Json);
+    if (json) {
+        fprintf(report, "[\n");
+    } else {
+        fprintf(report, "checksum,kernel,bufferSize,exact,GBps\n");
+    }
+    bool first = true;
+    bool allExact = true;
+    for (const auto& checksum: checksums) {
+        const auto& reference = checksum.kernels.front();
+        for (const auto& kernel: checksum.kernels) {
+            for (const auto bufferSize: CHECKSUM_BUFFER_SIZES) {
+                // Check the kernel against zlib at every alignment, both in
+                // one call and split across two calls.
+                bool exact = true;
+                for (size_t alignment = 0; alignment < CHECKSUM_ALIGNMENTS; ++alignment) {
+                    const auto buffer = data.data() + alignment;
+                    const auto expected = reference.function(checksum.initial, buffer, bufferSize);
+                    const auto split = bufferSize / 3;
+                    if (
+                        (kernel.function(checksum.initial, buffer, bufferSize) != expected)
+                        || (
+                            kernel.function(
+                                kernel.function(checksum.initial, buffer, split),
+                                buffer + split,
+                                bufferSize - split
+                            ) != expected
+                        )
+                    ) {
+                        exact = false;
+                        break;
+                    }
+                }
+                if (!exact) {
+                    fprintf(stderr, "error: %s kernel %s does not match zlib for %zu-byte buffers\n", checksum.name, kernel.name, bufferSize);
+                    allExact = false;
+                }
+
+                // Measure the kernel.
+                uint64_t bytes = 0;
+                uint32_t result = checksum.initial;
+                const auto start = Clock::now();
+                auto elapsed = Clock::duration::zero();
+                do {
+                    size_t bytesSinceClockCheck = 0;
+                    do {
+                        result = kernel.function(result, data.data(), bufferSize);
+                        bytesSinceClockCheck += bufferSize;
+                    } while (bytesSinceClockCheck < CHECKSUM_BYTES_PER_CLOCK_CHECK);
+                    bytes += bytesSinceClockCheck;
+                    elapsed = Clock::now() - start;
+                } while (elapsed < CHECKSUM_MEASURE_TIME);
+                const auto seconds = std::chrono::duration< double >(elapsed).count();
+                const auto gbps = (double)bytes / 1e9 / seconds;
+
+                // The result is printed so that the compiler can't
+                // leave out the work.
+                fprintf(
+                    stderr,
+                    "%s %s %zu: %.2f GB/s (%08" PRIX32 ")\n",
+                    checksum.name,
+                    kernel.name,
+                    bufferSize,
+                    gbps,
+                    result
+                );
+                if (json) {
+                    fprintf(
+                        report,
+                        "%s  {\"checksum\": \"%s\", \"kernel\": \"%s\", \"bufferSize\": %zu, \"exact\": %s, \"GBps\": %.3f}",
+                        (first ? "" : ",\n"),
+                        checksum.name,
+                        kernel.name,
+                        bufferSize,
+                        (exact ? "true" : "false"),
+                        gbps
+                    );
+                } else {
+                    fprintf(
+                        report,
+                        "%s,%s,%zu,%s,%.3f\n",
+                        checksum.name,
+                        kernel.name,
+                        bufferSize,
+                        (exact ? "yes" : "no"),
+                        gbps
+                    );
+                }
+                first = false;
+            }
+        }
+    }
+    if (json) {
+        fprintf(report, "%s]\n", (first ? "" : "\n"));
+    }
+    return allExact;
+}
+
+bool RunBenchmark(
+    const Corpus& corpus,
+    const BenchmarkConfiguration& configuration,
+    FILE* report
+) {
+    if (configuration.reportFormat == BenchmarkConfiguration::ReportFormat::Json) {
+        fprintf(report, "[\n");
+    }
+    bool first = true;
+    Parameters parameters;
+    for (const auto level: configuration.levels) {
+        parameters.level = level;
+        for (const auto strategy: configuration.strategies) {
+            parameters.strategy = strategy;
+            for (const auto windowBits: configuration.windowBits) {
+                parameters.windowBits = windowBits;
+                for (const auto bufferSize: configuration.bufferSizes) {
+                    parameters.bufferSize = bufferSize;
+                    for (const auto reuse: configuration.reuses) {
+                        parameters.reuse = reuse;
+                        parameters.dictionary.clear();
+                        if (!MeasureAndReport(corpus, configuration, parameters, first, report)) {
+                            return false;
+                        }
+                        if (configuration.dictionary.empty()) {
+                            continue;
+                        }
+                        if (windowBits > MAX_WBITS) {
+                            fprintf(stderr, "Skipping dictionary for windowBits %d; gzip can't use one.\n", windowBits);
+                            continue;
+                        }
+                        parameters.dictionary = configuration.dictionary;
+                        if (!MeasureAndReport(corpus, configuration, parameters, first, report)) {
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    if (configuration.reportFormat == BenchmarkConfiguration::ReportFormat::Json) {
+        fprintf(report, "%s]\n", (first ? "" : "\n"));
+    }
+    return true;
+}
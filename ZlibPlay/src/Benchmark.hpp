@@ -0,0 +1,213 @@
+#pragma once
+
+/**
+ * @file Benchmark.hpp
+ *
+ * This module declares the functions used to measure the throughput
+ * of zlib compression and decompression over a corpus of files.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Corpus.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/**
+ * This holds the settings which control a compression benchmark.
+ * Every combination of the listed levels, strategies, window sizes,
+ * buffer sizes, and ways of reusing zlib state is measured.
+ */
+struct BenchmarkConfiguration {
+    /**
+     * These are the formats in which benchmark results can be reported.
+     */
+    enum class ReportFormat {
+        /**
+         * Report one line of comma-separated values per combination,
+         * preceded by a header line.
+         */
+        Csv,
+
+        /**
+         * Report a JSON array holding one object per combination.
+         */
+        Json,
+    };
+
+    /**
+     * These are the ways in which zlib state can be carried from one
+     * file to the next while benchmarking.
+     */
+    enum class Reuse {
+        /**
+         * Set up and tear down zlib for every file, allocating its
+         * memory from the standard allocator each time.
+         */
+        Fresh,
+
+        /**
+         * Set up and tear down zlib for every file, but allocate its
+         * memory from an arena which recycles it between files.
+         */
+        Arena,
+
+        /**
+         * Set up zlib once, and reset it between files.
+         */
+        Reset,
+    };
+
+    /**
+     * These are the compression levels to measure.
+     */
+    std::vector< int > levels;
+
+    /**
+     * These are the compression strategies to measure.
+     */
+    std::vector< int > strategies;
+
+    /**
+     * These are the base two logarithms of the window sizes to measure.
+     * Values are given in the form expected by deflateInit2, so adding
+     * 16 selects the gzip wrapper and negating selects raw deflate.
+     */
+    std::vector< int > windowBits;
+
+    /**
+     * These are the sizes of the chunks, in bytes, in which data is
+     * fed to and collected from zlib.
+     */
+    std::vector< size_t > bufferSizes;
+
+    /**
+     * These are the ways of carrying zlib state between files to measure.
+     */
+    std::vector< Reuse > reuses;
+
+    /**
+     * If not empty, this is a preset dictionary.  Every combination is
+     * then measured both without and with it, except that it's not used
+     * with the gzip wrapper, which has no way to refer to one.
+     */
+    std::vector< uint8_t > dictionary;
+
+    /**
+     * This is the number of times to compress and decompress the corpus
+     * for each combination.
+     */
+    size_t repetitions = 1;
+
+    /**
+     * This is the format in which to report the results.
+     */
+    ReportFormat reportFormat = ReportFormat::Csv;
+};
+
+/**
+ * This function returns the name used in reports for the given
+ * zlib compression strategy.
+ *
+ * @param[in] strategy
+ *     This is the zlib compression strategy to name.
+ *
+ * @return
+ *     The name of the given strategy is returned.
+ */
+std::string GetStrategyName(int strategy);
+
+/**
+ * This function looks up the zlib compression strategy with the given name.
+ *
+ * @param[in] name
+ *     This is the name of the strategy to look up.
+ *
+ * @param[out] strategy
+ *     This is where to store the strategy found.
+ *
+ * @return
+ *     An indication of whether or not the name was recognized is returned.
+ */
+bool ParseStrategyName(
+    const std::string& name,
+    int& strategy
+);
+
+/**
+ * This function returns the name used in reports for the given
+ * way of reusing zlib state.
+ *
+ * @param[in] reuse
+ *     This is the way of reusing zlib state to name.
+ *
+ * @return
+ *     The name of the given way of reusing zlib state is returned.
+ */
+std::string GetReuseName(BenchmarkConfiguration::Reuse reuse);
+
+/**
+ * This function looks up the way of reusing zlib state with the given name.
+ *
+ * @param[in] name
+ *     This is the name of the way of reusing zlib state to look up.
+ *
+ * @param[out] reuse
+ *     This is where to store the way of reusing zlib state found.
+ *
+ * @return
+ *     An indication of whether or not the name was recognized is returned.
+ */
+bool ParseReuseName(
+    const std::string& name,
+    BenchmarkConfiguration::Reuse& reuse
+);
+
+/**
+ * This function compresses and decompresses every file in the given corpus
+ * with each combination of settings in the given configuration, verifies
+ * the round trip, and reports throughput, compression ratio, and per-chunk
+ * latency percentiles for each combination.
+ *
+ * @param[in] corpus
+ *     This is the collection of files to compress.
+ *
+ * @param[in] configuration
+ *     This holds the settings which control the benchmark.
+ *
+ * @param[in] report
+ *     This is the stream to which to write the results.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool RunBenchmark(
+    const Corpus& corpus,
+    const BenchmarkConfiguration& configuration,
+    FILE* report
+);
+
+/**
+ * This function checks that every CRC-32 and Adler-32 kernel the processor
+ * supports gives exactly the same results as zlib, across a range of buffer
+ * sizes and alignments, and reports the throughput of each kernel at each
+ * buffer size.
+ *
+ * @param[in] configuration
+ *     This holds the settings which control the benchmark.  Only the
+ *     report format is used.
+ *
+ * @param[in] report
+ *     This is the stream to which to write the results.
+ *
+ * @return
+ *     An indication of whether or not every kernel matched zlib is returned.
+ */
+bool RunChecksumBenchmark(
+    const BenchmarkConfiguration& configuration,
+    FILE* report
+);
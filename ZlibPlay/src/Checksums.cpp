@@ -0,0 +1,580 @@
+/**
+ * @file Checksums.cpp
+ *
+ * This module contains the implementation of the functions used to
+ * compute the CRC-32 and Adler-32 checksums used by the gzip and zlib
+ * formats, using the fastest instructions the processor supports.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Checksums.hpp"
+
+#include <zlib.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CHECKSUMS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET(features)
+#else /* not _MSC_VER */
+#include <cpuid.h>
+#define TARGET(features) __attribute__((target(features)))
+#endif /* _MSC_VER or not */
+#endif /* x86 */
+
+namespace {
+
+    /**
+     * This is the largest prime number smaller than 65536,
+     * the modulus of the sums in an Adler-32.
+     */
+    constexpr uint32_t ADLER_BASE = 65521;
+
+    /**
+     * This is the most bytes which can be added to an Adler-32 before its
+     * second sum must be reduced to avoid overflowing 32 bits.
+     */
+    constexpr size_t ADLER_NMAX = 5552;
+
+    /**
+     * This is the most input handed to zlib in one call, since zlib
+     * counts input with an unsigned int.
+     */
+    constexpr size_t MAX_INPUT_PER_CALL = 1 << 30;
+
+    /**
+     * This function updates a CRC-32 using zlib.
+     *
+     * @param[in] crc
+     *     This is the CRC-32 of the data before the given data.
+     *
+     * @param[in] data
+     *     This points to the data to add to the CRC-32.
+     *
+     * @param[in] size
+     *     This is the number of bytes of data to add to the CRC-32.
+     *
+     * @return
+     *     The updated CRC-32 is returned.
+     */
+    uint32_t ZlibCrc32(
+        uint32_t crc,
+        const uint8_t* data,
+        size_t size
+    ) {
+        while (size > 0) {
+            const auto chunkSize = (size < MAX_INPUT_PER_CALL) ? size : MAX_INPUT_PER_CALL;
+            crc = (uint32_t)crc32(crc, (const Bytef*)data, (uInt)chunkSize);
+            data += chunkSize;
+            size -= chunkSize;
+        }
+        return crc;
+    }
+
+    /**
+     * This function updates an Adler-32 using zlib.
+     *
+     * @param[in] adler
+     *     This is the Adler-32 of the data before the given data.
+     *
+     * @param[in] data
+     *     This points to the data to add to the Adler-32.
+     *
+     * @param[in] size
+     *     This is the number of bytes of data to add to the Adler-32.
+     *
+     * @return
+     *     The updated Adler-32 is returned.
+     */
+    uint32_t ZlibAdler32(
+        uint32_t adler,
+        const uint8_t* data,
+        size_t size
+    ) {
+        while (size > 0) {
+            const auto chunkSize = (size < MAX_INPUT_PER_CALL) ? size : MAX_INPUT_PER_CALL;
+            adler = (uint32_t)adler32(adler, (const Bytef*)data, (uInt)chunkSize);
+            data += chunkSize;
+            size -= chunkSize;
+        }
+        return adler;
+    }
+
+#ifdef CHECKSUMS_X86
+
+    /**
+     * This holds which of the instructions used by the kernels
+     * the processor supports.
+     */
+    struct CpuFeatures {
+        /**
+         * This indicates whether or not SSSE3 is supported.
+         */
+        bool ssse3 = false;
+
+        /**
+         * This indicates whether or not SSE4.1 is supported.
+         */
+        bool sse41 = false;
+
+        /**
+         * This indicates whether or not PCLMULQDQ is supported.
+         */
+        bool pclmul = false;
+
+        /**
+         * This indicates whether or not AVX2 is supported, both by the
+         * processor and by the operating system saving its registers.
+         */
+        bool avx2 = false;
+    };
+
+    /**
+     * This function asks the processor which of the instructions used
+     * by the kernels it supports.
+     *
+     * @return
+     *     The instructions the processor supports are returned.
+     */
+    CpuFeatures DetectCpuFeatures() {
+        CpuFeatures features;
+        unsigned int registers[4] = {0, 0, 0, 0};
+#ifdef _MSC_VER
+        __cpuid((int*)registers, 0);
+        const auto maxLeaf = registers[0];
+        __cpuid((int*)registers, 1);
+#else /* not _MSC_VER */
+        const auto maxLeaf = __get_cpuid_max(0, NULL);
+        if (maxLeaf < 1) {
+            return features;
+        }
+        __get_cpuid(1, &registers[0], &registers[1], &registers[2], &registers[3]);
+#endif /* _MSC_VER or not */
+        const auto ecx = registers[2];
+        features.pclmul = ((ecx & (1 << 1)) != 0);
+        features.ssse3 = ((ecx & (1 << 9)) != 0);
+        features.sse41 = ((ecx & (1 << 19)) != 0);
+        const auto osxsave = ((ecx & (1 << 27)) != 0);
+        if (
+            (maxLeaf < 7)
+            || !osxsave
+        ) {
+            return features;
+        }
+
+        // AVX2 registers can be used only if the operating system saves
+        // them (XCR0 bits 1 and 2).
+#ifdef _MSC_VER
+        const auto xcr0 = (uint64_t)_xgetbv(0);
+        __cpuidex((int*)registers, 7, 0);
+#else /* not _MSC_VER */
+        uint32_t xcr0Low, xcr0High;
+        __asm__ ("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+        const auto xcr0 = ((uint64_t)xcr0High << 32) | xcr0Low;
+        __cpuid_count(7, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif /* _MSC_VER or not */
+        features.avx2 = (
+            ((xcr0 & 6) == 6)
+            && ((registers[1] & (1 << 5)) != 0)
+        );
+        return features;
+    }
+
+    /**
+     * This function returns which of the instructions used by the kernels
+     * the processor supports, asking the processor only the first time.
+     *
+     * @return
+     *     The instructions the processor supports are returned.
+     */
+    const CpuFeatures& GetCpuFeatures() {
+        static const auto features = DetectCpuFeatures();
+        return features;
+    }
+
+    /**
+     * This is the least number of bytes the PCLMULQDQ kernel can fold.
+     */
+    constexpr size_t CRC32_FOLD_MIN_SIZE = 64;
+
+    /**
+     * This function folds the given data into a CRC-32 using carry-less
+     * multiplication, following Intel's "Fast CRC Computation for Generic
+     * Polynomials Using PCLMULQDQ Instruction".  Four 128-bit lanes are
+     * folded 64 bytes at a time, then folded into one lane, 16 bytes at a
+     * time, and finally reduced to 32 bits using Barrett reduction.
+     *
+     * @param[in] crc
+     *     This is the CRC-32 of the data before the given data, without
+     *     the final inversion (that is, zlib's CRC-32 inverted).
+     *
+     * @param[in] data
+     *     This points to the data to fold.
+     *
+     * @param[in] size
+     *     This is the number of bytes of data to fold.  It must be a
+     *     multiple of 16, and at least CRC32_FOLD_MIN_SIZE.
+     *
+     * @return
+     *     The updated CRC-32, without the final inversion, is returned.
+     */
+    TARGET("pclmul,sse4.1")
+    uint32_t FoldCrc32(
+        uint32_t crc,
+        const uint8_t* data,
+        size_t size
+    ) {
+        // These are the bit-reflected folding constants for the CRC-32
+        // polynomial: x^(4*128+64) and x^(4*128) mod P, x^(128+64) and
+        // x^128 mod P, x^64 mod P, then P itself and the Barrett constant.
+        const auto k1k2 = _mm_set_epi64x(0x01C6E41596, 0x0154442BD4);
+        const auto k3k4 = _mm_set_epi64x(0x00CCAA009E, 0x01751997D0);
+        const auto k5 = _mm_set_epi64x(0, 0x0163CD6124);
+        const auto poly = _mm_set_epi64x(0x01F7011641, 0x01DB710641);
+        const auto low32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+        // Load the first 64 bytes, mixing in the CRC so far.
+        auto x1 = _mm_loadu_si128((const __m128i*)(data + 0x00));
+        auto x2 = _mm_loadu_si128((const __m128i*)(data + 0x10));
+        auto x3 = _mm_loadu_si128((const __m128i*)(data + 0x20));
+        auto x4 = _mm_loadu_si128((const __m128i*)(data + 0x30));
+        x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+        data += 64;
+        size -= 64;
+
+        // Fold 64 bytes at a time into the four lanes.
+        while (size >= 64) {
+            const auto x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+            const auto x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+            const auto x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+            const auto x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+            x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+            x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+            x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(data + 0x00)));
+            x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(data + 0x10)));
+            x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(data + 0x20)));
+            x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(data + 0x30)));
+            data += 64;
+            size -= 64;
+        }
+
+        // Fold the four lanes into one.
+        const __m128i lanes[3] = {x2, x3, x4};
+        for (const auto& lane: lanes) {
+            const auto x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, lane), x5);
+        }
+
+        // Fold 16 bytes at a time into the one lane.
+        while (size >= 16) {
+            const auto x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+            x1 = _mm_xor_si128(
+                _mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)data)),
+                x5
+            );
+            data += 16;
+            size -= 16;
+        }
+
+        // Fold 128 bits down to 64.
+        auto high = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+        x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), high);
+        high = _mm_srli_si128(x1, 4);
+        x1 = _mm_and_si128(x1, low32);
+        x1 = _mm_clmulepi64_si128(x1, k5, 0x00);
+        x1 = _mm_xor_si128(x1, high);
+
+        // Barrett reduce to 32 bits.
+        auto quotient = _mm_and_si128(x1, low32);
+        quotient = _mm_clmulepi64_si128(quotient, poly, 0x10);
+        quotient = _mm_and_si128(quotient, low32);
+        quotient = _mm_clmulepi64_si128(quotient, poly, 0x00);
+        x1 = _mm_xor_si128(x1, quotient);
+        return (uint32_t)_mm_extract_epi32(x1, 1);
+    }
+
+    /**
+     * This function updates a CRC-32 using carry-less multiplication
+     * for as much of the data as possible, and zlib for the rest.
+     *
+     * @param[in] crc
+     *     This is the CRC-32 of the data before the given data.
+     *
+     * @param[in] data
+     *     This points to the data to add to the CRC-32.
+     *
+     * @param[in] size
+     *     This is the number of bytes of data to add to the CRC-32.
+     *
+     * @return
+     *     The updated CRC-32 is returned.
+     */
+    uint32_t PclmulCrc32(
+        uint32_t crc,
+        const uint8_t* data,
+        size_t size
+    ) {
+        if (size >= CRC32_FOLD_MIN_SIZE) {
+            const auto foldSize = size & ~(size_t)15;
+            crc = ~FoldCrc32(~crc, data, foldSize);
+            data += foldSize;
+            size -= foldSize;
+        }
+        return ZlibCrc32(crc, data, size);
+    }
+
+    /**
+     * This function adds the given bytes, one at a time, to the sums
+     * of an Adler-32, and reduces the sums.
+     *
+     * @param[in,out] s1
+     *     This is the sum of the bytes.
+     *
+     * @param[in,out] s2
+     *     This is the sum of the first sum after each byte.
+     *
+     * @param[in] data
+     *     This points to the bytes to add.
+     *
+     * @param[in] size
+     *     This is the number of bytes to add.  It must be
+     *     less than ADLER_NMAX.
+     */
+    void AddAdler32Tail(
+        uint32_t& s1,
+        uint32_t& s2,
+        const uint8_t* data,
+        size_t size
+    ) {
+        while (size-- > 0) {
+            s1 += *data++;
+            s2 += s1;
+        }
+        s1 %= ADLER_BASE;
+        s2 %= ADLER_BASE;
+    }
+
+    /**
+     * This function updates an Adler-32 using SSSE3, 32 bytes at a time.
+     * Each block of 32 bytes adds the sum of its bytes to the first sum,
+     * and the bytes weighted by their distance from the end of the block,
+     * plus 32 times the first sum so far, to the second sum.
+     *
+     * @param[in] adler
+     *     This is the Adler-32 of the data before the given data.
+     *
+     * @param[in] data
+     *     This points to the data to add to the Adler-32.
+     *
+     * @param[in] size
+     *     This is the number of bytes of data to add to the Adler-32.
+     *
+     * @return
+     *     The updated Adler-32 is returned.
+     */
+    TARGET("ssse3")
+    uint32_t Ssse3Adler32(
+        uint32_t adler,
+        const uint8_t* data,
+        size_t size
+    ) {
+        constexpr size_t blockSize = 32;
+        auto s1 = adler & 0xFFFF;
+        auto s2 = adler >> 16;
+        const auto tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+        const auto tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+        const auto zero = _mm_setzero_si128();
+        const auto ones = _mm_set1_epi16(1);
+        auto blocks = size / blockSize;
+        size -= blocks * blockSize;
+        while (blocks > 0) {
+            auto n = ADLER_NMAX / blockSize;
+            if (n > blocks) {
+                n = blocks;
+            }
+            blocks -= n;
+            auto vPreviousS1 = _mm_set_epi32(0, 0, 0, (int)(s1 * n));
+            auto vS2 = _mm_set_epi32(0, 0, 0, (int)s2);
+            auto vS1 = _mm_setzero_si128();
+            do {
+                const auto bytes1 = _mm_loadu_si128((const __m128i*)data);
+                const auto bytes2 = _mm_loadu_si128((const __m128i*)(data + 16));
+                vPreviousS1 = _mm_add_epi32(vPreviousS1, vS1);
+                vS1 = _mm_add_epi32(vS1, _mm_sad_epu8(bytes1, zero));
+                vS2 = _mm_add_epi32(vS2, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+                vS1 = _mm_add_epi32(vS1, _mm_sad_epu8(bytes2, zero));
+                vS2 = _mm_add_epi32(vS2, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+                data += blockSize;
+            } while (--n > 0);
+            vS2 = _mm_add_epi32(vS2, _mm_slli_epi32(vPreviousS1, 5));
+            vS1 = _mm_add_epi32(vS1, _mm_shuffle_epi32(vS1, _MM_SHUFFLE(1, 0, 3, 2)));
+            s1 += (uint32_t)_mm_cvtsi128_si32(vS1);
+            vS2 = _mm_add_epi32(vS2, _mm_shuffle_epi32(vS2, _MM_SHUFFLE(2, 3, 0, 1)));
+            vS2 = _mm_add_epi32(vS2, _mm_shuffle_epi32(vS2, _MM_SHUFFLE(1, 0, 3, 2)));
+            s2 = (uint32_t)_mm_cvtsi128_si32(vS2);
+            s1 %= ADLER_BASE;
+            s2 %= ADLER_BASE;
+        }
+        AddAdler32Tail(s1, s2, data, size);
+        return s1 | (s2 << 16);
+    }
+
+    /**
+     * This function updates an Adler-32 using AVX2, 64 bytes at a time,
+     * in the same way as the SSSE3 kernel.
+     *
+     * @param[in] adler
+     *     This is the Adler-32 of the data before the given data.
+     *
+     * @param[in] data
+     *     This points to the data to add to the Adler-32.
+     *
+     * @param[in] size
+     *     This is the number of bytes of data to add to the Adler-32.
+     *
+     * @return
+     *     The updated Adler-32 is returned.
+     */
+    TARGET("avx2")
+    uint32_t Avx2Adler32(
+        uint32_t adler,
+        const uint8_t* data,
+        size_t size
+    ) {
+        constexpr size_t blockSize = 64;
+        auto s1 = adler & 0xFFFF;
+        auto s2 = adler >> 16;
+        const auto tap1 = _mm256_setr_epi8(
+            64, 63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49,
+            48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33
+        );
+        const auto tap2 = _mm256_setr_epi8(
+            32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+            16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1
+        );
+        const auto zero = _mm256_setzero_si256();
+        const auto ones = _mm256_set1_epi16(1);
+        auto blocks = size / blockSize;
+        size -= blocks * blockSize;
+        while (blocks > 0) {
+            auto n = ADLER_NMAX / blockSize;
+            if (n > blocks) {
+                n = blocks;
+            }
+            blocks -= n;
+            auto vPreviousS1 = _mm256_setr_epi32((int)(s1 * n), 0, 0, 0, 0, 0, 0, 0);
+            auto vS2 = _mm256_setr_epi32((int)s2, 0, 0, 0, 0, 0, 0, 0);
+            auto vS1 = _mm256_setzero_si256();
+            do {
+                const auto bytes1 = _mm256_loadu_si256((const __m256i*)data);
+                const auto bytes2 = _mm256_loadu_si256((const __m256i*)(data + 32));
+                vPreviousS1 = _mm256_add_epi32(vPreviousS1, vS1);
+                vS1 = _mm256_add_epi32(vS1, _mm256_sad_epu8(bytes1, zero));
+                vS2 = _mm256_add_epi32(vS2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes1, tap1), ones));
+                vS1 = _mm256_add_epi32(vS1, _mm256_sad_epu8(bytes2, zero));
+                vS2 = _mm256_add_epi32(vS2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes2, tap2), ones));
+                data += blockSize;
+            } while (--n > 0);
+            vS2 = _mm256_add_epi32(vS2, _mm256_slli_epi32(vPreviousS1, 6));
+            auto vS1Half = _mm_add_epi32(
+                _mm256_castsi256_si128(vS1),
+                _mm256_extracti128_si256(vS1, 1)
+            );
+            auto vS2Half = _mm_add_epi32(
+                _mm256_castsi256_si128(vS2),
+                _mm256_extracti128_si256(vS2, 1)
+            );
+            vS1Half = _mm_add_epi32(vS1Half, _mm_shuffle_epi32(vS1Half, _MM_SHUFFLE(1, 0, 3, 2)));
+            s1 += (uint32_t)_mm_cvtsi128_si32(vS1Half);
+            vS2Half = _mm_add_epi32(vS2Half, _mm_shuffle_epi32(vS2Half, _MM_SHUFFLE(2, 3, 0, 1)));
+            vS2Half = _mm_add_epi32(vS2Half, _mm_shuffle_epi32(vS2Half, _MM_SHUFFLE(1, 0, 3, 2)));
+            s2 = (uint32_t)_mm_cvtsi128_si32(vS2Half);
+            s1 %= ADLER_BASE;
+            s2 %= ADLER_BASE;
+        }
+        AddAdler32Tail(s1, s2, data, size);
+        return s1 | (s2 << 16);
+    }
+
+#endif /* CHECKSUMS_X86 */
+
+    /**
+     * This function picks the fastest CRC-32 kernel the processor supports.
+     *
+     * @return
+     *     The fastest CRC-32 kernel is returned.
+     */
+    ChecksumFunction SelectCrc32() {
+        const auto kernels = GetCrc32Kernels();
+        return kernels.back().function;
+    }
+
+    /**
+     * This function picks the fastest Adler-32 kernel the processor
+     * supports.
+     *
+     * @return
+     *     The fastest Adler-32 kernel is returned.
+     */
+    ChecksumFunction SelectAdler32() {
+        const auto kernels = GetAdler32Kernels();
+        return kernels.back().function;
+    }
+
+}
+
+uint32_t Crc32(
+    uint32_t crc,
+    const uint8_t* data,
+    size_t size
+) {
+    static const auto kernel = SelectCrc32();
+    return kernel(crc, data, size);
+}
+
+uint32_t Adler32(
+    uint32_t adler,
+    const uint8_t* data,
+    size_t size
+) {
+    static const auto kernel = SelectAdler32();
+    return kernel(adler, data, size);
+}
+
+std::vector< ChecksumKernel > GetCrc32Kernels() {
+    std::vector< ChecksumKernel > kernels{
+        {"zlib", ZlibCrc32},
+    };
+#ifdef CHECKSUMS_X86
+    const auto& features = GetCpuFeatures();
+    if (
+        features.pclmul
+        && features.sse41
+    ) {
+        kernels.push_back({"pclmul", PclmulCrc32});
+    }
+#endif /* CHECKSUMS_X86 */
+    return kernels;
+}
+
+std::vector< ChecksumKernel > GetAdler32Kernels() {
+    std::vector< ChecksumKernel > kernels{
+        {"zlib", ZlibAdler32},
+    };
+#ifdef CHECKSUMS_X86
+    const auto& features = GetCpuFeatures();
+    if (features.ssse3) {
+        kernels.push_back({"ssse3", Ssse3Adler32});
+    }
+    if (features.avx2) {
+        kernels.push_back({"avx2", Avx2Adler32});
+    }
+#endif /* CHECKSUMS_X86 */
+    return kernels;
+}
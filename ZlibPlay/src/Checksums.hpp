@@ -0,0 +1,120 @@
+#pragma once
+
+/**
+ * @file Checksums.hpp
+ *
+ * This module declares the functions used to compute the CRC-32 and
+ * Adler-32 checksums used by the gzip and zlib formats, using the fastest
+ * instructions the processor supports.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * This is the type of function which updates a running checksum
+ * with more data.
+ *
+ * @param[in] checksum
+ *     This is the checksum of the data before the given data.
+ *
+ * @param[in] data
+ *     This points to the data to add to the checksum.
+ *
+ * @param[in] size
+ *     This is the number of bytes of data to add to the checksum.
+ *
+ * @return
+ *     The updated checksum is returned.
+ */
+typedef uint32_t (*ChecksumFunction)(
+    uint32_t checksum,
+    const uint8_t* data,
+    size_t size
+);
+
+/**
+ * This describes one way of computing a checksum.
+ */
+struct ChecksumKernel {
+    /**
+     * This is the name used for the kernel in reports.
+     */
+    const char* name;
+
+    /**
+     * This is the function which computes the checksum.
+     */
+    ChecksumFunction function;
+};
+
+/**
+ * This function updates a running CRC-32, as used by the gzip format,
+ * with more data, using the fastest kernel the processor supports.
+ * The result is the same as zlib's crc32 function.
+ *
+ * @param[in] crc
+ *     This is the CRC-32 of the data before the given data.
+ *     Use zero for the start of the data.
+ *
+ * @param[in] data
+ *     This points to the data to add to the CRC-32.
+ *
+ * @param[in] size
+ *     This is the number of bytes of data to add to the CRC-32.
+ *
+ * @return
+ *     The updated CRC-32 is returned.
+ */
+uint32_t Crc32(
+    uint32_t crc,
+    const uint8_t* data,
+    size_t size
+);
+
+/**
+ * This function updates a running Adler-32, as used by the zlib format,
+ * with more data, using the fastest kernel the processor supports.
+ * The result is the same as zlib's adler32 function.
+ *
+ * @param[in] adler
+ *     This is the Adler-32 of the data before the given data.
+ *     Use one for the start of the data.
+ *
+ * @param[in] data
+ *     This points to the data to add to the Adler-32.
+ *
+ * @param[in] size
+ *     This is the number of bytes of data to add to the Adler-32.
+ *
+ * @return
+ *     The updated Adler-32 is returned.
+ */
+uint32_t Adler32(
+    uint32_t adler,
+    const uint8_t* data,
+    size_t size
+);
+
+/**
+ * This function returns every CRC-32 kernel the processor supports,
+ * starting with zlib's own, which every other kernel must match,
+ * and ending with the one used by Crc32.
+ *
+ * @return
+ *     The CRC-32 kernels the processor supports are returned.
+ */
+std::vector< ChecksumKernel > GetCrc32Kernels();
+
+/**
+ * This function returns every Adler-32 kernel the processor supports,
+ * starting with zlib's own, which every other kernel must match,
+ * and ending with the one used by Adler32.
+ *
+ * @return
+ *     The Adler-32 kernels the processor supports are returned.
+ */
+std::vector< ChecksumKernel > GetAdler32Kernels();
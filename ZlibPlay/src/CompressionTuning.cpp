@@ -0,0 +1,336 @@
+/**
+ * @file CompressionTuning.cpp
+ *
+ * This module contains the implementation of the functions used to
+ * choose compression settings suited to the data being compressed.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "CompressionTuning.hpp"
+#include "Deflater.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <vector>
+
+namespace {
+
+    /**
+     * This is the least time to spend compressing the samples with each
+     * candidate setting, so that small samples are timed accurately.
+     */
+    constexpr std::chrono::milliseconds MIN_TRIAL_TIME(2);
+
+    /**
+     * This is the most times to compress the samples with each
+     * candidate setting.
+     */
+    constexpr size_t MAX_TRIAL_REPETITIONS = 64;
+
+    /**
+     * This is how much larger than the smallest output a candidate's output
+     * may be and still be preferred for being cheaper.
+     */
+    constexpr double SIZE_TOLERANCE = 0.01;
+
+    /**
+     * This holds one candidate setting tried on the samples.
+     */
+    struct Candidate {
+        /**
+         * This is the compression level to try.
+         */
+        int level;
+
+        /**
+         * This is the compression strategy to try.
+         */
+        int strategy;
+    };
+
+    /**
+     * These are the candidate settings, roughly in order of
+     * increasing cost.
+     */
+    constexpr Candidate CANDIDATES[] = {
+        {1, Z_HUFFMAN_ONLY},
+        {1, Z_RLE},
+        {1, Z_DEFAULT_STRATEGY},
+        {3, Z_DEFAULT_STRATEGY},
+        {6, Z_DEFAULT_STRATEGY},
+        {9, Z_DEFAULT_STRATEGY},
+    };
+
+    /**
+     * This holds what was measured while trying one candidate setting.
+     */
+    struct Trial {
+        /**
+         * This is the number of bytes of compressed output.
+         */
+        size_t compressedBytes = 0;
+
+        /**
+         * This is the throughput measured, in megabytes per second.
+         */
+        double mbps = 0.0;
+    };
+
+    /**
+     * This function copies samples, spread evenly through the given data,
+     * into one buffer.  All of the data is copied if it's no larger than
+     * the samples would be.
+     *
+     * @param[in] data
+     *     This points to the data to sample.
+     *
+     * @param[in] size
+     *     This is the number of bytes of data.
+     *
+     * @param[in] configuration
+     *     This holds the size and number of samples to take.
+     *
+     * @return
+     *     The sampled bytes are returned.
+     */
+    std::vector< uint8_t > TakeSamples(
+        const uint8_t* data,
+        size_t size,
+        const CompressionTuningConfiguration& configuration
+    ) {
+        const auto sampleSize = std::max((size_t)1, configuration.sampleSize);
+        const auto sampleCount = std::max((size_t)1, configuration.sampleCount);
+        if (size / sampleCount <= sampleSize) {
+            return std::vector< uint8_t >(data, data + size);
+        }
+        std::vector< uint8_t > samples;
+        samples.reserve(sampleSize * sampleCount);
+        const auto stride = (size - sampleSize) / std::max((size_t)1, sampleCount - 1);
+        for (size_t i = 0; i < sampleCount; ++i) {
+            const auto sample = data + i * stride;
+            samples.insert(samples.end(), sample, sample + sampleSize);
+        }
+        return samples;
+    }
+
+    /**
+     * This function measures the order-0 entropy of the given data.
+     *
+     * @param[in] data
+     *     This is the data to measure.
+     *
+     * @return
+     *     The entropy of the data, in bits per byte, is returned.
+     */
+    double MeasureEntropy(const std::vector< uint8_t >& data) {
+        size_t counts[256] = {0};
+        for (const auto byte: data) {
+            ++counts[byte];
+        }
+        double entropy = 0.0;
+        for (const auto count: counts) {
+            if (count > 0) {
+                const auto probability = (double)count / (double)data.size();
+                entropy -= probability * log2(probability);
+            }
+        }
+        return entropy;
+    }
+
+    /**
+     * This function compresses the given samples with the given setting,
+     * repeatedly if needed to time it accurately.
+     *
+     * @param[in] samples
+     *     This is the data to compress.
+     *
+     * @param[in] candidate
+     *     This is the setting with which to compress the data.
+     *
+     * @param[out] trial
+     *     This is where to store what was measured.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool TryCandidate(
+        const std::vector< uint8_t >& samples,
+        const Candidate& candidate,
+        Trial& trial
+    ) {
+        Deflater deflater;
+        DeflaterConfiguration configuration;
+        configuration.level = candidate.level;
+        configuration.strategy = candidate.strategy;
+        configuration.windowBits = -MAX_WBITS;
+        configuration.chunkSize = samples.size() + 1024;
+        if (!deflater.Initialize(configuration)) {
+            return false;
+        }
+        std::vector< uint8_t > output;
+        output.reserve(configuration.chunkSize);
+        size_t repetitions = 0;
+        const auto start = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::steady_clock::duration::zero();
+        do {
+            output.clear();
+            if (
+                !deflater.Compress(samples.data(), samples.size(), output)
+                || !deflater.Reset()
+            ) {
+                return false;
+            }
+            ++repetitions;
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (
+            (elapsed < MIN_TRIAL_TIME)
+            && (repetitions < MAX_TRIAL_REPETITIONS)
+        );
+        const auto seconds = std::chrono::duration< double >(elapsed).count();
+        trial.compressedBytes = output.size();
+        trial.mbps = (
+            (seconds > 0.0)
+            ? (double)(samples.size() * repetitions) / 1e6 / seconds
+            : 0.0
+        );
+        return true;
+    }
+
+    /**
+     * This function formats a message, like sprintf, into a string.
+     *
+     * @param[in] format
+     *     This is the format of the message.
+     *
+     * @param[in] ...
+     *     These are the values to put into the message.
+     *
+     * @return
+     *     The formatted message is returned.
+     */
+    std::string Format(const char* format, ...) {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        (void)vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        return buffer;
+    }
+
+}
+
+bool ChooseCompression(
+    const uint8_t* data,
+    size_t size,
+    const CompressionTuningConfiguration& configuration,
+    CompressionDecision& decision
+) {
+    decision = CompressionDecision();
+    const auto samples = TakeSamples(data, size, configuration);
+    decision.sampleBytes = samples.size();
+    if (samples.empty()) {
+        decision.level = 0;
+        decision.reason = "no data to compress";
+        return true;
+    }
+    decision.entropy = MeasureEntropy(samples);
+    if (decision.entropy >= configuration.incompressibleEntropy) {
+        decision.level = 0;
+        decision.reason = Format(
+            "entropy of %.2f bits per byte looks already compressed",
+            decision.entropy
+        );
+        return true;
+    }
+
+    // Work out the throughput needed, if any.
+    double targetMBps = configuration.targetMBps;
+    if (configuration.cpuBudgetNsPerByte > 0.0) {
+        targetMBps = std::max(targetMBps, 1e3 / configuration.cpuBudgetNsPerByte);
+    }
+
+    // Try every candidate on the samples.
+    constexpr size_t numCandidates = sizeof(CANDIDATES) / sizeof(CANDIDATES[0]);
+    Trial trials[numCandidates];
+    for (size_t i = 0; i < numCandidates; ++i) {
+        if (!TryCandidate(samples, CANDIDATES[i], trials[i])) {
+            fprintf(stderr, "error: unable to try compression level %d\n", CANDIDATES[i].level);
+            return false;
+        }
+    }
+
+    // Among the candidates fast enough, find the smallest output, then
+    // take the first (cheapest) candidate close to it.  If none are fast
+    // enough, take the fastest.
+    size_t smallest = numCandidates;
+    size_t fastest = 0;
+    for (size_t i = 0; i < numCandidates; ++i) {
+        if (trials[i].mbps > trials[fastest].mbps) {
+            fastest = i;
+        }
+        if (
+            (trials[i].mbps >= targetMBps)
+            && (
+                (smallest == numCandidates)
+                || (trials[i].compressedBytes < trials[smallest].compressedBytes)
+            )
+        ) {
+            smallest = i;
+        }
+    }
+    size_t chosen = fastest;
+    if (smallest == numCandidates) {
+        decision.targetMet = false;
+    } else {
+        const auto sizeLimit = (double)trials[smallest].compressedBytes * (1.0 + SIZE_TOLERANCE);
+        for (size_t i = 0; i < numCandidates; ++i) {
+            if (
+                (trials[i].mbps >= targetMBps)
+                && ((double)trials[i].compressedBytes <= sizeLimit)
+            ) {
+                chosen = i;
+                break;
+            }
+        }
+    }
+    decision.level = CANDIDATES[chosen].level;
+    decision.strategy = CANDIDATES[chosen].strategy;
+    decision.sampleRatio = (double)trials[chosen].compressedBytes / (double)samples.size();
+    decision.sampleMBps = trials[chosen].mbps;
+
+    // Store the data if even the chosen setting doesn't save enough.
+    if (1.0 - decision.sampleRatio < configuration.minSavings) {
+        if (decision.sampleRatio >= 1.0) {
+            decision.reason = "compressing would not make the data smaller";
+        } else {
+            decision.reason = Format(
+                "best setting within target saves only %.1f%%",
+                (1.0 - decision.sampleRatio) * 100.0
+            );
+        }
+        decision.level = 0;
+        decision.strategy = Z_DEFAULT_STRATEGY;
+        decision.sampleRatio = 1.0;
+        decision.sampleMBps = 0.0;
+        decision.targetMet = true;
+        return true;
+    }
+    if (!decision.targetMet) {
+        decision.reason = Format(
+            "no setting reaches %.1f MB/s; using the fastest",
+            targetMBps
+        );
+    } else if (targetMBps > 0.0) {
+        decision.reason = Format(
+            "smallest output at %.1f MB/s or more",
+            targetMBps
+        );
+    } else {
+        decision.reason = "smallest output; no throughput target set";
+    }
+    return true;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+/**
+ * @file CompressionTuning.hpp
+ *
+ * This module declares the functions used to choose compression settings
+ * suited to the data being compressed.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <zlib.h>
+
+/**
+ * This holds the settings which control how compression settings
+ * are chosen.
+ */
+struct CompressionTuningConfiguration {
+    /**
+     * This is the least compression throughput, in megabytes of input
+     * per second on one thread, which the chosen settings should reach.
+     * If zero, no throughput target is set.
+     */
+    double targetMBps = 0.0;
+
+    /**
+     * This is the most CPU time, in nanoseconds per byte of input on one
+     * thread, which the chosen settings should spend.  If zero, no budget
+     * is set.  If both this and the throughput target are set, the
+     * stricter of the two is used.
+     */
+    double cpuBudgetNsPerByte = 0.0;
+
+    /**
+     * This is the number of bytes in each sample taken of the data.
+     */
+    size_t sampleSize = 64 * 1024;
+
+    /**
+     * This is the number of samples, spread evenly through the data,
+     * taken of the data.
+     */
+    size_t sampleCount = 4;
+
+    /**
+     * This is the entropy, in bits per byte, at or above which the data
+     * is taken to be already compressed, without trying to compress it.
+     */
+    double incompressibleEntropy = 7.8;
+
+    /**
+     * This is the least fraction of the data which compression must save
+     * to be worth doing.  Data which saves less is stored.
+     */
+    double minSavings = 0.03;
+};
+
+/**
+ * This holds the compression settings chosen for some data,
+ * and why they were chosen.
+ */
+struct CompressionDecision {
+    /**
+     * This is the compression level chosen.  Zero means the data
+     * is stored without being compressed.
+     */
+    int level = Z_DEFAULT_COMPRESSION;
+
+    /**
+     * This is the compression strategy chosen.
+     */
+    int strategy = Z_DEFAULT_STRATEGY;
+
+    /**
+     * This is the number of bytes sampled from the data.
+     */
+    size_t sampleBytes = 0;
+
+    /**
+     * This is the order-0 entropy of the sampled bytes,
+     * in bits per byte.
+     */
+    double entropy = 0.0;
+
+    /**
+     * This is the size of the sampled bytes, once compressed with the
+     * chosen settings, divided by their original size.
+     */
+    double sampleRatio = 1.0;
+
+    /**
+     * This is the throughput, in megabytes per second, measured while
+     * compressing the sampled bytes with the chosen settings.  It is zero
+     * if the data is stored without being tried.
+     */
+    double sampleMBps = 0.0;
+
+    /**
+     * This indicates whether or not the chosen settings reach the
+     * throughput target or CPU budget, if one was set.
+     */
+    bool targetMet = true;
+
+    /**
+     * This explains why the settings were chosen.
+     */
+    std::string reason;
+};
+
+/**
+ * This function chooses compression settings for the given data.
+ *
+ * Samples are taken from throughout the data and their entropy measured.
+ * Data which looks already compressed, such as images and fonts, is stored
+ * so that no time is wasted trying to compress it.  Otherwise the samples
+ * are compressed with each candidate setting, from Huffman coding only,
+ * through run-length encoding, to the numbered levels, and the setting
+ * giving the smallest output within the throughput target or CPU budget is
+ * chosen.  If no setting saves enough space, the data is stored instead.
+ *
+ * @param[in] data
+ *     This points to the data for which to choose settings.
+ *
+ * @param[in] size
+ *     This is the number of bytes of data.
+ *
+ * @param[in] configuration
+ *     This holds the settings which control the choice.
+ *
+ * @param[out] decision
+ *     This is where to store the settings chosen, and why.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool ChooseCompression(
+    const uint8_t* data,
+    size_t size,
+    const CompressionTuningConfiguration& configuration,
+    CompressionDecision& decision
+);
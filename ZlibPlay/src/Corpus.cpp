@@ -0,0 +1,133 @@
+/**
+ * @file Corpus.cpp
+ *
+ * This module contains the implementation of the functions used to
+ * gather a corpus of files from the file system.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Corpus.hpp"
+
+#include <algorithm>
+#include <stdio.h>
+#include <SystemAbstractions/File.hpp>
+
+namespace {
+
+    /**
+     * This function adds the given path to the given list if it's a file,
+     * or recursively adds the files beneath it if it's a directory.
+     *
+     * @param[in] path
+     *     This is the path of the file or directory to walk.
+     *
+     * @param[in,out] filePaths
+     *     This is where to add the paths of the files found.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool WalkPath(
+        const std::string& path,
+        std::vector< std::string >& filePaths
+    ) {
+        SystemAbstractions::File file(path);
+        if (!file.IsExisting()) {
+            fprintf(stderr, "error: '%s' does not exist\n", path.c_str());
+            return false;
+        }
+        if (!file.IsDirectory()) {
+            filePaths.push_back(path);
+            return true;
+        }
+        std::vector< std::string > children;
+        SystemAbstractions::File::ListDirectory(path, children);
+        for (const auto& child: children) {
+            if (!WalkPath(child, filePaths)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+}
+
+bool ReadWholeFile(
+    const std::string& path,
+    std::vector< uint8_t >& content
+) {
+    SystemAbstractions::File file(path);
+    if (!file.OpenReadOnly()) {
+        fprintf(stderr, "error: unable to open '%s'\n", path.c_str());
+        return false;
+    }
+    content.resize((size_t)file.GetSize());
+    if (file.Read(content) != content.size()) {
+        fprintf(stderr, "error: unable to read '%s'\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool LoadCorpus(
+    const std::vector< std::string >& paths,
+    Corpus& corpus
+) {
+    std::vector< std::string > filePaths;
+    if (!ListCorpusFiles(paths, filePaths)) {
+        return false;
+    }
+    for (const auto& filePath: filePaths) {
+        CorpusFile corpusFile;
+        corpusFile.path = filePath;
+        if (!ReadWholeFile(filePath, corpusFile.content)) {
+            return false;
+        }
+        corpus.push_back(std::move(corpusFile));
+    }
+    return true;
+}
+
+bool ListCorpusFiles(
+    const std::vector< std::string >& paths,
+    std::vector< std::string >& filePaths
+) {
+    for (const auto& path: paths) {
+        if (!WalkPath(path, filePaths)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Corpus SplitCorpusLines(const Corpus& corpus) {
+    Corpus lines;
+    for (const auto& file: corpus) {
+        const auto& content = file.content;
+        size_t lineNumber = 0;
+        auto lineStart = content.begin();
+        while (lineStart != content.end()) {
+            ++lineNumber;
+            const auto lineEnd = std::find(lineStart, content.end(), '\n');
+            auto contentEnd = lineEnd;
+            if (
+                (contentEnd != lineStart)
+                && (*(contentEnd - 1) == '\r')
+            ) {
+                --contentEnd;
+            }
+            if (contentEnd != lineStart) {
+                CorpusFile line;
+                line.path = file.path + ":" + std::to_string(lineNumber);
+                line.content.assign(lineStart, contentEnd);
+                lines.push_back(std::move(line));
+            }
+            lineStart = lineEnd;
+            if (lineStart != content.end()) {
+                ++lineStart;
+            }
+        }
+    }
+    return lines;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+/**
+ * @file Corpus.hpp
+ *
+ * This module declares the Corpus type and the functions used to
+ * gather one from the file system.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * This holds the path and contents of one file loaded into a corpus.
+ */
+struct CorpusFile {
+    /**
+     * This is the path of the file in the file system.
+     */
+    std::string path;
+
+    /**
+     * This is the contents of the file.
+     */
+    std::vector< uint8_t > content;
+};
+
+/**
+ * This is the type used to hold a collection of files to compress.
+ */
+typedef std::vector< CorpusFile > Corpus;
+
+/**
+ * This function reads the entire contents of the given file.
+ *
+ * @param[in] path
+ *     This is the path of the file to read.
+ *
+ * @param[out] content
+ *     This is where to store the contents of the file.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool ReadWholeFile(
+    const std::string& path,
+    std::vector< uint8_t >& content
+);
+
+/**
+ * This function loads files into the given corpus.  Each given path may be
+ * either a file, which is loaded directly, or a directory, which is walked
+ * recursively to load every file beneath it.
+ *
+ * @param[in] paths
+ *     These are the paths of the files and directories to load.
+ *
+ * @param[in,out] corpus
+ *     This is the corpus to which to add the loaded files.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool LoadCorpus(
+    const std::vector< std::string >& paths,
+    Corpus& corpus
+);
+
+/**
+ * This function walks the given paths and lists the files found, without
+ * loading their contents.  Directories are walked recursively.
+ *
+ * @param[in] paths
+ *     These are the paths of the files and directories to walk.
+ *
+ * @param[in,out] filePaths
+ *     This is where to add the paths of the files found.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool ListCorpusFiles(
+    const std::vector< std::string >& paths,
+    std::vector< std::string >& filePaths
+);
+
+/**
+ * This function splits every file in the given corpus into lines, making
+ * each non-empty line its own entry.  This is used for recordings of
+ * messages, where each line holds one message.  Line endings are not
+ * included in the entries.
+ *
+ * @param[in] corpus
+ *     This is the corpus to split.
+ *
+ * @return
+ *     A corpus holding one entry for each non-empty line of the given
+ *     corpus is returned.  Each entry's path is the path of the file from
+ *     which it came, followed by a colon and the line number.
+ */
+Corpus SplitCorpusLines(const Corpus& corpus);
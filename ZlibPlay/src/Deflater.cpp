@@ -0,0 +1,200 @@
+/**
+ * @file Deflater.cpp
+ *
+ * This module contains the implementation of the Deflater class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Deflater.hpp"
+
+#include <algorithm>
+
+namespace {
+
+    /**
+     * This is the most input handed to zlib in one call, since zlib
+     * counts available input with an unsigned int.
+     */
+    constexpr size_t MAX_INPUT_PER_CALL = 1 << 30;
+
+}
+
+/**
+ * This contains the private properties of a Deflater instance.
+ */
+struct Deflater::Impl {
+    // Properties
+
+    /**
+     * This is the zlib stream used to compress data.
+     */
+    z_stream stream;
+
+    /**
+     * This indicates whether or not the zlib stream has been initialized.
+     */
+    bool initialized = false;
+
+    /**
+     * This is the arena from which zlib allocates its memory, if any.
+     * It's held here so that it outlives the stream.
+     */
+    std::shared_ptr< ZlibArena > arena;
+
+    /**
+     * This is the preset dictionary given to zlib at the start
+     * of every stream, if any.
+     */
+    std::vector< uint8_t > dictionary;
+
+    /**
+     * This is the buffer in which each chunk of output is collected.
+     */
+    std::vector< uint8_t > buffer;
+
+    // Lifecycle management
+
+    ~Impl() noexcept {
+        if (initialized) {
+            (void)deflateEnd(&stream);
+        }
+    }
+    Impl(const Impl&) = delete;
+    Impl(Impl&&) noexcept = delete;
+    Impl& operator=(const Impl&) = delete;
+    Impl& operator=(Impl&&) noexcept = delete;
+
+    // Methods
+
+    /**
+     * This is the default constructor.
+     */
+    Impl() = default;
+
+    /**
+     * This method gives zlib the preset dictionary, if any,
+     * for the stream about to begin.
+     *
+     * @return
+     *     An indication of whether or not the method succeeded is returned.
+     */
+    bool SetDictionary() {
+        return (
+            dictionary.empty()
+            || (
+                deflateSetDictionary(
+                    &stream,
+                    (const Bytef*)dictionary.data(),
+                    (uInt)dictionary.size()
+                ) == Z_OK
+            )
+        );
+    }
+};
+
+Deflater::~Deflater() noexcept = default;
+Deflater::Deflater(Deflater&&) noexcept = default;
+Deflater& Deflater::operator=(Deflater&&) noexcept = default;
+
+Deflater::Deflater()
+    : impl_(new Impl())
+{
+}
+
+bool Deflater::Initialize(
+    const DeflaterConfiguration& configuration,
+    std::shared_ptr< ZlibArena > arena
+) {
+    if (impl_->initialized) {
+        (void)deflateEnd(&impl_->stream);
+        impl_->initialized = false;
+    }
+    impl_->arena = arena;
+    impl_->stream.zalloc = Z_NULL;
+    impl_->stream.zfree = Z_NULL;
+    impl_->stream.opaque = Z_NULL;
+    if (arena != nullptr) {
+        arena->Attach(impl_->stream);
+    }
+    if (
+        deflateInit2(
+            &impl_->stream,
+            configuration.level,
+            Z_DEFLATED,
+            configuration.windowBits,
+            configuration.memLevel,
+            configuration.strategy
+        ) != Z_OK
+    ) {
+        return false;
+    }
+    impl_->initialized = true;
+    impl_->dictionary = configuration.dictionary;
+    impl_->buffer.resize(std::max((size_t)1, configuration.chunkSize));
+    return impl_->SetDictionary();
+}
+
+bool Deflater::Deflate(
+    const uint8_t* data,
+    size_t size,
+    bool finish,
+    OutputDelegate outputDelegate
+) {
+    if (!impl_->initialized) {
+        return false;
+    }
+    auto& stream = impl_->stream;
+    auto& buffer = impl_->buffer;
+    do {
+        const auto slice = std::min(size, MAX_INPUT_PER_CALL);
+        stream.next_in = (Bytef*)data;
+        stream.avail_in = (uInt)slice;
+        data += slice;
+        size -= slice;
+        const auto flush = (finish && (size == 0)) ? Z_FINISH : Z_NO_FLUSH;
+        do {
+            stream.next_out = (Bytef*)buffer.data();
+            stream.avail_out = (uInt)buffer.size();
+            const auto result = deflate(&stream, flush);
+            if (result == Z_STREAM_ERROR) {
+                return false;
+            }
+            const auto produced = buffer.size() - stream.avail_out;
+            if (
+                (produced > 0)
+                && !outputDelegate(buffer.data(), produced)
+            ) {
+                return false;
+            }
+        } while (stream.avail_out == 0);
+    } while (size > 0);
+    return true;
+}
+
+bool Deflater::Reset() {
+    return (
+        impl_->initialized
+        && (deflateReset(&impl_->stream) == Z_OK)
+        && impl_->SetDictionary()
+    );
+}
+
+bool Deflater::Compress(
+    const uint8_t* data,
+    size_t size,
+    std::vector< uint8_t >& output
+) {
+    return (
+        Reset()
+        && Deflate(
+            data,
+            size,
+            true,
+            [&output](const uint8_t* chunk, size_t chunkSize){
+                output.insert(output.end(), chunk, chunk + chunkSize);
+                return true;
+            }
+        )
+    );
+}
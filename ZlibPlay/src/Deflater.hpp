@@ -0,0 +1,187 @@
+#pragma once
+
+/**
+ * @file Deflater.hpp
+ *
+ * This module declares the Deflater class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "ZlibArena.hpp"
+
+#include <functional>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <zlib.h>
+
+/**
+ * This holds the settings given to zlib when a Deflater is initialized.
+ */
+struct DeflaterConfiguration {
+    /**
+     * This is the compression level to use.
+     */
+    int level = Z_DEFAULT_COMPRESSION;
+
+    /**
+     * This is the windowBits value to give to deflateInit2.  Adding 16
+     * selects the gzip wrapper and negating selects raw deflate.
+     */
+    int windowBits = MAX_WBITS;
+
+    /**
+     * This is the memLevel value to give to deflateInit2.
+     */
+    int memLevel = 8;
+
+    /**
+     * This is the compression strategy to use.
+     */
+    int strategy = Z_DEFAULT_STRATEGY;
+
+    /**
+     * This is the size, in bytes, of the chunks in which compressed
+     * output is delivered.
+     */
+    size_t chunkSize = 16384;
+
+    /**
+     * If not empty, this is the preset dictionary given to zlib at the
+     * start of every stream.  Preset dictionaries can't be used with the
+     * gzip wrapper.
+     */
+    std::vector< uint8_t > dictionary;
+};
+
+/**
+ * This compresses data using zlib.  Input is given in chunks, and output is
+ * delivered in chunks through a callback.  After a stream is finished, the
+ * Deflater can be reset and used for the next stream without setting up
+ * zlib again.
+ */
+class Deflater {
+    // Types
+public:
+    /**
+     * This is the type of function used to deliver compressed output.
+     *
+     * @param[in] data
+     *     This points to the next chunk of compressed output.
+     *
+     * @param[in] size
+     *     This is the number of bytes of compressed output.
+     *
+     * @return
+     *     An indication of whether or not the output was accepted is
+     *     returned.  Compression stops if the output is not accepted.
+     */
+    typedef std::function< bool(const uint8_t* data, size_t size) > OutputDelegate;
+
+    // Lifecycle management
+public:
+    ~Deflater() noexcept;
+    Deflater(const Deflater&) = delete;
+    Deflater(Deflater&&) noexcept;
+    Deflater& operator=(const Deflater&) = delete;
+    Deflater& operator=(Deflater&&) noexcept;
+
+    // Public Methods
+public:
+    /**
+     * This is the default constructor.
+     */
+    Deflater();
+
+    /**
+     * This method sets up zlib to compress data with the given settings.
+     *
+     * @param[in] configuration
+     *     These are the settings to give to zlib.
+     *
+     * @param[in] arena
+     *     If not null, this is the arena from which zlib should allocate
+     *     its memory.  Otherwise zlib uses the standard allocator.
+     *
+     * @return
+     *     An indication of whether or not the method succeeded is returned.
+     */
+    bool Initialize(
+        const DeflaterConfiguration& configuration = DeflaterConfiguration(),
+        std::shared_ptr< ZlibArena > arena = nullptr
+    );
+
+    /**
+     * This method compresses the next chunk of input.
+     *
+     * @param[in] data
+     *     This points to the next chunk of input.
+     *
+     * @param[in] size
+     *     This is the number of bytes of input.
+     *
+     * @param[in] finish
+     *     This indicates whether or not this is the last chunk of input
+     *     in the stream.  If so, all remaining output is delivered and the
+     *     stream is ended; call Reset before compressing another stream.
+     *
+     * @param[in] outputDelegate
+     *     This is the function to call to deliver compressed output.
+     *
+     * @return
+     *     An indication of whether or not the method succeeded is returned.
+     */
+    bool Deflate(
+        const uint8_t* data,
+        size_t size,
+        bool finish,
+        OutputDelegate outputDelegate
+    );
+
+    /**
+     * This method abandons any stream in progress and prepares to compress
+     * a new stream with the same settings, reusing zlib's memory.
+     *
+     * @return
+     *     An indication of whether or not the method succeeded is returned.
+     */
+    bool Reset();
+
+    /**
+     * This method compresses the given data as one complete stream,
+     * appending the result to the given vector.
+     *
+     * @param[in] data
+     *     This points to the data to compress.
+     *
+     * @param[in] size
+     *     This is the number of bytes of data to compress.
+     *
+     * @param[in,out] output
+     *     This is where to append the compressed data.
+     *
+     * @return
+     *     An indication of whether or not the method succeeded is returned.
+     */
+    bool Compress(
+        const uint8_t* data,
+        size_t size,
+        std::vector< uint8_t >& output
+    );
+
+    // Private Properties
+private:
+    /**
+     * This is the type of structure that contains the private
+     * properties of the instance.  It is defined in the implementation
+     * and declared here to ensure that it is scoped inside the class.
+     */
+    struct Impl;
+
+    /**
+     * This contains the private properties of the instance.
+     */
+    std::unique_ptr< Impl > impl_;
+};
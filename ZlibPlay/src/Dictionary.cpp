@@ -0,0 +1,300 @@
+/**
+ * @file Dictionary.cpp
+ *
+ * This module contains the implementation of the functions used to
+ * train, save, and load preset dictionaries.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Dictionary.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdio.h>
+#include <unordered_map>
+#include <zlib.h>
+
+namespace {
+
+    /**
+     * This is the number of bytes in each sequence scored while training.
+     * It's a little more than the shortest match deflate can make, so that
+     * the sequences chosen are worth referring to.
+     */
+    constexpr size_t SEQUENCE_SIZE = 6;
+
+    /**
+     * This is the largest dictionary zlib can use.
+     */
+    constexpr size_t MAX_DICTIONARY_SIZE = 1 << MAX_WBITS;
+
+    /**
+     * These are the bytes which begin every dictionary file.
+     */
+    constexpr uint8_t DICTIONARY_FILE_MAGIC[4] = {'Z', 'D', 'I', 'C'};
+
+    /**
+     * This is the version of the dictionary file format written.
+     */
+    constexpr uint32_t DICTIONARY_FILE_VERSION = 1;
+
+    /**
+     * This is the number of bytes in the header of a dictionary file:
+     * the magic bytes, then the version, Adler-32 checksum, and size of
+     * the dictionary, each as a 32-bit little-endian number.
+     */
+    constexpr size_t DICTIONARY_FILE_HEADER_SIZE = 16;
+
+    /**
+     * This function appends the given number to the given buffer,
+     * in little-endian order.
+     *
+     * @param[in] value
+     *     This is the number to append.
+     *
+     * @param[in,out] buffer
+     *     This is the buffer to which to append the number.
+     */
+    void AppendUint32(
+        uint32_t value,
+        std::vector< uint8_t >& buffer
+    ) {
+        for (size_t i = 0; i < 4; ++i) {
+            buffer.push_back((uint8_t)(value >> (i * 8)));
+        }
+    }
+
+    /**
+     * This function reads a little-endian 32-bit number
+     * from the given buffer.
+     *
+     * @param[in] buffer
+     *     This points to the number to read.
+     *
+     * @return
+     *     The number read is returned.
+     */
+    uint32_t ReadUint32(const uint8_t* buffer) {
+        return (
+            (uint32_t)buffer[0]
+            | ((uint32_t)buffer[1] << 8)
+            | ((uint32_t)buffer[2] << 16)
+            | ((uint32_t)buffer[3] << 24)
+        );
+    }
+
+    /**
+     * This function computes the checksum zlib uses to identify
+     * the given dictionary.
+     *
+     * @param[in] dictionary
+     *     This is the dictionary whose checksum to compute.
+     *
+     * @return
+     *     The Adler-32 checksum of the dictionary is returned.
+     */
+    uint32_t DictionaryChecksum(const std::vector< uint8_t >& dictionary) {
+        return (uint32_t)adler32(
+            adler32(0, Z_NULL, 0),
+            dictionary.data(),
+            (uInt)dictionary.size()
+        );
+    }
+
+}
+
+bool TrainDictionary(
+    const Corpus& samples,
+    const DictionaryTrainingConfiguration& configuration,
+    std::vector< uint8_t >& dictionary
+) {
+    dictionary.clear();
+    if (
+        (configuration.maxSize == 0)
+        || (configuration.maxSize > MAX_DICTIONARY_SIZE)
+    ) {
+        fprintf(stderr, "error: dictionary size must be from 1 to %zu bytes\n", MAX_DICTIONARY_SIZE);
+        return false;
+    }
+    if (configuration.segmentSize < SEQUENCE_SIZE) {
+        fprintf(stderr, "error: segment size must be at least %zu bytes\n", SEQUENCE_SIZE);
+        return false;
+    }
+
+    // Give each distinct sequence a number, and count the samples
+    // in which each one appears.
+    std::unordered_map< uint64_t, size_t > sequenceIds;
+    std::vector< size_t > scores;
+    std::vector< size_t > lastSampleSeen;
+    std::vector< std::vector< size_t > > sampleSequences(samples.size());
+    for (size_t sampleIndex = 0; sampleIndex < samples.size(); ++sampleIndex) {
+        const auto& content = samples[sampleIndex].content;
+        if (content.size() < SEQUENCE_SIZE) {
+            continue;
+        }
+        auto& sequences = sampleSequences[sampleIndex];
+        sequences.reserve(content.size() - SEQUENCE_SIZE + 1);
+        for (size_t i = 0; i + SEQUENCE_SIZE <= content.size(); ++i) {
+            uint64_t key = 0;
+            for (size_t j = 0; j < SEQUENCE_SIZE; ++j) {
+                key = (key << 8) | content[i + j];
+            }
+            const auto sequenceIdsEntry = sequenceIds.insert(
+                std::make_pair(key, scores.size())
+            );
+            const auto id = sequenceIdsEntry.first->second;
+            if (sequenceIdsEntry.second) {
+                scores.push_back(0);
+                lastSampleSeen.push_back(sampleIndex);
+                ++scores[id];
+            } else if (lastSampleSeen[id] != sampleIndex) {
+                lastSampleSeen[id] = sampleIndex;
+                ++scores[id];
+            }
+            sequences.push_back(id);
+        }
+    }
+
+    // Score each sequence only by the samples beyond the first in which
+    // it appears, so that content found in just one sample scores nothing
+    // and a segment's score counts only what it shares with other samples.
+    for (auto& score: scores) {
+        score = ((score >= 2) ? score - 1 : 0);
+    }
+
+    // Repeatedly pick the segment with the highest total score, and stop
+    // counting the sequences in it, until the dictionary is full.
+    std::vector< std::vector< uint8_t > > segments;
+    size_t remaining = configuration.maxSize;
+    const auto window = configuration.segmentSize - SEQUENCE_SIZE + 1;
+    while (remaining >= SEQUENCE_SIZE) {
+        size_t bestScore = 0;
+        size_t bestSample = 0;
+        size_t bestStart = 0;
+        size_t bestLength = 0;
+        for (size_t sampleIndex = 0; sampleIndex < samples.size(); ++sampleIndex) {
+            const auto& sequences = sampleSequences[sampleIndex];
+            const auto length = std::min(window, sequences.size());
+            size_t score = 0;
+            for (size_t i = 0; i < sequences.size(); ++i) {
+                score += scores[sequences[i]];
+                if (i >= length) {
+                    score -= scores[sequences[i - length]];
+                }
+                if (
+                    (i + 1 >= length)
+                    && (score > bestScore)
+                ) {
+                    bestScore = score;
+                    bestSample = sampleIndex;
+                    bestStart = i + 1 - length;
+                    bestLength = length;
+                }
+            }
+        }
+        if (bestScore == 0) {
+            break;
+        }
+        const auto& sequences = sampleSequences[bestSample];
+        for (size_t i = bestStart; i < bestStart + bestLength; ++i) {
+            scores[sequences[i]] = 0;
+        }
+        const auto& content = samples[bestSample].content;
+        const auto segmentSize = std::min(
+            remaining,
+            bestLength + SEQUENCE_SIZE - 1
+        );
+        segments.emplace_back(
+            content.begin() + bestStart,
+            content.begin() + bestStart + segmentSize
+        );
+        remaining -= segmentSize;
+    }
+
+    // Lay out the segments so that the best ones are last,
+    // closest to the data being compressed.
+    for (auto segment = segments.rbegin(); segment != segments.rend(); ++segment) {
+        dictionary.insert(dictionary.end(), segment->begin(), segment->end());
+    }
+    if (dictionary.empty()) {
+        fprintf(stderr, "error: no sequences common to more than one sample were found\n");
+        return false;
+    }
+    return true;
+}
+
+bool SaveDictionary(
+    const std::string& path,
+    const std::vector< uint8_t >& dictionary
+) {
+    std::vector< uint8_t > header(
+        DICTIONARY_FILE_MAGIC,
+        DICTIONARY_FILE_MAGIC + sizeof(DICTIONARY_FILE_MAGIC)
+    );
+    AppendUint32(DICTIONARY_FILE_VERSION, header);
+    AppendUint32(DictionaryChecksum(dictionary), header);
+    AppendUint32((uint32_t)dictionary.size(), header);
+    const auto file = std::unique_ptr< FILE, std::function< void(FILE*) > >(
+        fopen(path.c_str(), "wb"),
+        [](FILE* f){
+            if (f != NULL) {
+                (void)fclose(f);
+            }
+        }
+    );
+    if (file == NULL) {
+        fprintf(stderr, "error: unable to open '%s' for writing\n", path.c_str());
+        return false;
+    }
+    if (
+        (fwrite(header.data(), header.size(), 1, file.get()) != 1)
+        || (fwrite(dictionary.data(), dictionary.size(), 1, file.get()) != 1)
+    ) {
+        fprintf(stderr, "error: unable to write '%s'\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool LoadDictionary(
+    const std::string& path,
+    std::vector< uint8_t >& dictionary
+) {
+    std::vector< uint8_t > file;
+    if (!ReadWholeFile(path, file)) {
+        return false;
+    }
+    if (
+        (file.size() < DICTIONARY_FILE_HEADER_SIZE)
+        || !std::equal(
+            DICTIONARY_FILE_MAGIC,
+            DICTIONARY_FILE_MAGIC + sizeof(DICTIONARY_FILE_MAGIC),
+            file.begin()
+        )
+    ) {
+        fprintf(stderr, "error: '%s' is not a dictionary file\n", path.c_str());
+        return false;
+    }
+    const auto version = ReadUint32(file.data() + 4);
+    if (version != DICTIONARY_FILE_VERSION) {
+        fprintf(stderr, "error: '%s' has unsupported dictionary version %u\n", path.c_str(), (unsigned int)version);
+        return false;
+    }
+    const auto checksum = ReadUint32(file.data() + 8);
+    const auto size = ReadUint32(file.data() + 12);
+    if (
+        (size > MAX_DICTIONARY_SIZE)
+        || (file.size() - DICTIONARY_FILE_HEADER_SIZE != size)
+    ) {
+        fprintf(stderr, "error: '%s' has the wrong size\n", path.c_str());
+        return false;
+    }
+    dictionary.assign(file.begin() + DICTIONARY_FILE_HEADER_SIZE, file.end());
+    if (DictionaryChecksum(dictionary) != checksum) {
+        fprintf(stderr, "error: '%s' is corrupt\n", path.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+/**
+ * @file Dictionary.hpp
+ *
+ * This module declares the functions used to train, save, and load
+ * preset dictionaries for compressing small messages with zlib.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Corpus.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * This holds the settings which control dictionary training.
+ */
+struct DictionaryTrainingConfiguration {
+    /**
+     * This is the largest dictionary to build, in bytes.  zlib can't
+     * use more than 32 KiB of dictionary, and the time spent loading
+     * a dictionary grows with its size, so smaller is usually better
+     * for small messages.
+     */
+    size_t maxSize = 4096;
+
+    /**
+     * This is the number of bytes of a sample considered at a time
+     * when picking the pieces of the dictionary.
+     */
+    size_t segmentSize = 48;
+};
+
+/**
+ * This function builds a preset dictionary from the given samples.
+ *
+ * Every sequence of a few bytes in the samples is scored by the number of
+ * other samples in which it also appears, so that sequences found in only
+ * one sample score nothing.  The segment of a sample with the highest
+ * total score is added to the dictionary, its sequences are no longer
+ * counted, and this repeats until the dictionary is full or nothing
+ * common is left.  The best segments are placed at the end of the
+ * dictionary, where they're cheapest for deflate to refer to.
+ *
+ * @param[in] samples
+ *     These are the messages typical of what will be compressed.
+ *
+ * @param[in] configuration
+ *     This holds the settings which control training.
+ *
+ * @param[out] dictionary
+ *     This is where to store the dictionary built.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool TrainDictionary(
+    const Corpus& samples,
+    const DictionaryTrainingConfiguration& configuration,
+    std::vector< uint8_t >& dictionary
+);
+
+/**
+ * This function writes the given dictionary to the given file,
+ * in a versioned format which records its size and checksum.
+ *
+ * @param[in] path
+ *     This is the path of the file to write.
+ *
+ * @param[in] dictionary
+ *     This is the dictionary to save.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool SaveDictionary(
+    const std::string& path,
+    const std::vector< uint8_t >& dictionary
+);
+
+/**
+ * This function reads a dictionary saved by SaveDictionary, checking its
+ * version, size, and checksum.
+ *
+ * @param[in] path
+ *     This is the path of the file to read.
+ *
+ * @param[out] dictionary
+ *     This is where to store the dictionary loaded.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool LoadDictionary(
+    const std::string& path,
+    std::vector< uint8_t >& dictionary
+);
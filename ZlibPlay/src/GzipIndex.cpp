@@ -0,0 +1,588 @@
+/**
+ * @file GzipIndex.cpp
+ *
+ * This module contains the implementation of the functions used to
+ * build and use an index of access points into a gzip file.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Corpus.hpp"
+#include "Deflater.hpp"
+#include "GzipIndex.hpp"
+#include "Inflater.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdio.h>
+#include <zlib.h>
+
+namespace {
+
+    /**
+     * This is the amount of decompressed data deflate can refer back to,
+     * and so the amount kept with each access point.
+     */
+    constexpr size_t WINDOW_SIZE = 1 << MAX_WBITS;
+
+    /**
+     * This is the number of bytes of the gzip file mapped into memory
+     * at a time.
+     */
+    constexpr size_t INPUT_VIEW_SIZE = 1 << 20;
+
+    /**
+     * This is the most output collected from zlib in one call, since zlib
+     * counts available output with an unsigned int.
+     */
+    constexpr size_t MAX_OUTPUT_PER_CALL = 1 << 30;
+
+    /**
+     * This is the number of bytes at the end of each gzip member which
+     * hold its check value and size.
+     */
+    constexpr size_t GZIP_TRAILER_SIZE = 8;
+
+    /**
+     * These are the bytes which begin every index file.
+     */
+    constexpr uint8_t INDEX_FILE_MAGIC[4] = {'G', 'Z', 'I', 'X'};
+
+    /**
+     * This is the version of the index file format written.
+     */
+    constexpr uint32_t INDEX_FILE_VERSION = 1;
+
+    /**
+     * This function appends the given number to the given buffer,
+     * in little-endian order.
+     *
+     * @param[in] value
+     *     This is the number to append.
+     *
+     * @param[in] size
+     *     This is the number of bytes to use for the number.
+     *
+     * @param[in,out] buffer
+     *     This is the buffer to which to append the number.
+     */
+    void AppendNumber(
+        uint64_t value,
+        size_t size,
+        std::vector< uint8_t >& buffer
+    ) {
+        for (size_t i = 0; i < size; ++i) {
+            buffer.push_back((uint8_t)(value >> (i * 8)));
+        }
+    }
+
+    /**
+     * This reads the parts of an index file in order,
+     * checking that they're all there.
+     */
+    struct IndexFileReader {
+        // Properties
+
+        /**
+         * This is the contents of the index file.
+         */
+        const std::vector< uint8_t >& content;
+
+        /**
+         * This is the offset of the next part to read.
+         */
+        size_t position = 0;
+
+        // Methods
+
+        /**
+         * This is the constructor.
+         *
+         * @param[in] newContent
+         *     This is the contents of the index file.
+         */
+        explicit IndexFileReader(const std::vector< uint8_t >& newContent)
+            : content(newContent)
+        {
+        }
+
+        /**
+         * This method reads the next part of the file as a little-endian
+         * number.
+         *
+         * @param[in] size
+         *     This is the number of bytes used for the number.
+         *
+         * @param[out] value
+         *     This is where to store the number read.
+         *
+         * @return
+         *     An indication of whether or not the number was there
+         *     to read is returned.
+         */
+        bool ReadNumber(
+            size_t size,
+            uint64_t& value
+        ) {
+            if (content.size() - position < size) {
+                return false;
+            }
+            value = 0;
+            for (size_t i = 0; i < size; ++i) {
+                value |= (uint64_t)content[position++] << (i * 8);
+            }
+            return true;
+        }
+
+        /**
+         * This method reads the next part of the file as raw bytes.
+         *
+         * @param[in] size
+         *     This is the number of bytes to read.
+         *
+         * @param[out] bytes
+         *     This is where to store a pointer to the bytes read.
+         *
+         * @return
+         *     An indication of whether or not the bytes were there
+         *     to read is returned.
+         */
+        bool ReadBytes(
+            size_t size,
+            const uint8_t*& bytes
+        ) {
+            if (content.size() - position < size) {
+                return false;
+            }
+            bytes = content.data() + position;
+            position += size;
+            return true;
+        }
+    };
+
+    /**
+     * This function hands zlib the next part of the given file, if it has
+     * used up all the input it was given before.
+     *
+     * @param[in] file
+     *     This is the file being decompressed.
+     *
+     * @param[in,out] stream
+     *     This is the zlib stream decompressing the file.
+     *
+     * @param[in,out] mappedEnd
+     *     This is the offset just past the input last handed to zlib.
+     *
+     * @return
+     *     An indication of whether or not zlib has input to use
+     *     is returned.
+     */
+    bool SupplyInput(
+        MappedFile& file,
+        z_stream& stream,
+        uint64_t& mappedEnd
+    ) {
+        if (stream.avail_in > 0) {
+            return true;
+        }
+        const auto fileSize = file.GetSize();
+        if (mappedEnd == fileSize) {
+            fprintf(stderr, "error: gzip data ends unexpectedly\n");
+            return false;
+        }
+        const auto viewSize = (size_t)std::min(
+            (uint64_t)INPUT_VIEW_SIZE,
+            fileSize - mappedEnd
+        );
+        const auto view = file.Map(mappedEnd, viewSize);
+        if (view == nullptr) {
+            fprintf(stderr, "error: unable to map gzip data\n");
+            return false;
+        }
+        stream.next_in = (Bytef*)view;
+        stream.avail_in = (uInt)viewSize;
+        mappedEnd += viewSize;
+        return true;
+    }
+
+}
+
+bool BuildGzipIndex(
+    const std::string& path,
+    uint64_t span,
+    GzipIndex& index
+) {
+    index = GzipIndex();
+    index.span = span;
+    MappedFile file;
+    if (!file.Open(path)) {
+        fprintf(stderr, "error: unable to open '%s'\n", path.c_str());
+        return false;
+    }
+    index.compressedSize = file.GetSize();
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+        fprintf(stderr, "error: inflateInit2 failed\n");
+        return false;
+    }
+
+    // The decompressed data goes round and round the window, so that
+    // the last 32 KiB of it is always at hand for the next access point.
+    std::vector< uint8_t > window(WINDOW_SIZE);
+    stream.avail_out = 0;
+    uint64_t mappedEnd = 0;
+    uint64_t totalOut = 0;
+    uint64_t lastAccessPoint = 0;
+    bool succeeded = true;
+    for (;;) {
+        if (!SupplyInput(file, stream, mappedEnd)) {
+            succeeded = false;
+            break;
+        }
+        if (stream.avail_out == 0) {
+            stream.next_out = (Bytef*)window.data();
+            stream.avail_out = (uInt)window.size();
+        }
+        const auto availOut = stream.avail_out;
+        const auto result = inflate(&stream, Z_BLOCK);
+        totalOut += availOut - stream.avail_out;
+        if (result == Z_STREAM_END) {
+            if (mappedEnd - stream.avail_in == index.compressedSize) {
+                break;
+            }
+            (void)inflateReset(&stream);
+            continue;
+        }
+        if (result != Z_OK) {
+            fprintf(
+                stderr,
+                "error: '%s' is not valid gzip data (%s)\n",
+                path.c_str(),
+                (stream.msg == NULL) ? "unknown error" : stream.msg
+            );
+            succeeded = false;
+            break;
+        }
+
+        // Add an access point at the end of a deflate block, unless it's
+        // the last block of the member, if it's been long enough since
+        // the last one.
+        if (
+            ((stream.data_type & 128) != 0)
+            && ((stream.data_type & 64) == 0)
+            && (
+                index.accessPoints.empty()
+                || (totalOut - lastAccessPoint > span)
+            )
+        ) {
+            GzipAccessPoint accessPoint;
+            accessPoint.uncompressedOffset = totalOut;
+            accessPoint.compressedOffset = mappedEnd - stream.avail_in;
+            accessPoint.bits = stream.data_type & 7;
+            const auto windowEnd = window.begin() + (window.size() - stream.avail_out);
+            if (totalOut >= WINDOW_SIZE) {
+                accessPoint.window.assign(windowEnd, window.end());
+            }
+            accessPoint.window.insert(accessPoint.window.end(), window.begin(), windowEnd);
+            index.accessPoints.push_back(std::move(accessPoint));
+            lastAccessPoint = totalOut;
+        }
+    }
+    (void)inflateEnd(&stream);
+    index.uncompressedSize = totalOut;
+    return succeeded;
+}
+
+bool SaveGzipIndex(
+    const std::string& path,
+    const GzipIndex& index
+) {
+    std::vector< uint8_t > content(
+        INDEX_FILE_MAGIC,
+        INDEX_FILE_MAGIC + sizeof(INDEX_FILE_MAGIC)
+    );
+    AppendNumber(INDEX_FILE_VERSION, 4, content);
+    AppendNumber(index.span, 8, content);
+    AppendNumber(index.compressedSize, 8, content);
+    AppendNumber(index.uncompressedSize, 8, content);
+    AppendNumber(index.accessPoints.size(), 4, content);
+    Deflater deflater;
+    DeflaterConfiguration configuration;
+    configuration.level = Z_BEST_COMPRESSION;
+    configuration.windowBits = -MAX_WBITS;
+    if (!deflater.Initialize(configuration)) {
+        fprintf(stderr, "error: unable to set up deflate\n");
+        return false;
+    }
+    std::vector< uint8_t > compressedWindow;
+    for (const auto& accessPoint: index.accessPoints) {
+        compressedWindow.clear();
+        if (
+            !deflater.Compress(
+                accessPoint.window.data(),
+                accessPoint.window.size(),
+                compressedWindow
+            )
+        ) {
+            fprintf(stderr, "error: unable to compress access point window\n");
+            return false;
+        }
+        AppendNumber(accessPoint.uncompressedOffset, 8, content);
+        AppendNumber(accessPoint.compressedOffset, 8, content);
+        AppendNumber((uint64_t)accessPoint.bits, 1, content);
+        AppendNumber(accessPoint.window.size(), 4, content);
+        AppendNumber(compressedWindow.size(), 4, content);
+        content.insert(content.end(), compressedWindow.begin(), compressedWindow.end());
+    }
+    const auto file = std::unique_ptr< FILE, std::function< void(FILE*) > >(
+        fopen(path.c_str(), "wb"),
+        [](FILE* f){
+            if (f != NULL) {
+                (void)fclose(f);
+            }
+        }
+    );
+    if (file == NULL) {
+        fprintf(stderr, "error: unable to open '%s' for writing\n", path.c_str());
+        return false;
+    }
+    if (fwrite(content.data(), content.size(), 1, file.get()) != 1) {
+        fprintf(stderr, "error: unable to write '%s'\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool LoadGzipIndex(
+    const std::string& path,
+    GzipIndex& index
+) {
+    index = GzipIndex();
+    std::vector< uint8_t > content;
+    if (!ReadWholeFile(path, content)) {
+        return false;
+    }
+    IndexFileReader reader(content);
+    const uint8_t* magic;
+    uint64_t version;
+    if (
+        !reader.ReadBytes(sizeof(INDEX_FILE_MAGIC), magic)
+        || !std::equal(magic, magic + sizeof(INDEX_FILE_MAGIC), INDEX_FILE_MAGIC)
+        || !reader.ReadNumber(4, version)
+    ) {
+        fprintf(stderr, "error: '%s' is not a gzip index file\n", path.c_str());
+        return false;
+    }
+    if (version != INDEX_FILE_VERSION) {
+        fprintf(stderr, "error: '%s' has unsupported index version %u\n", path.c_str(), (unsigned int)version);
+        return false;
+    }
+    uint64_t numAccessPoints;
+    if (
+        !reader.ReadNumber(8, index.span)
+        || !reader.ReadNumber(8, index.compressedSize)
+        || !reader.ReadNumber(8, index.uncompressedSize)
+        || !reader.ReadNumber(4, numAccessPoints)
+    ) {
+        fprintf(stderr, "error: '%s' is truncated\n", path.c_str());
+        return false;
+    }
+    Inflater inflater;
+    InflaterConfiguration configuration;
+    configuration.windowBits = -MAX_WBITS;
+    if (!inflater.Initialize(configuration)) {
+        fprintf(stderr, "error: unable to set up inflate\n");
+        return false;
+    }
+    for (uint64_t i = 0; i < numAccessPoints; ++i) {
+        GzipAccessPoint accessPoint;
+        uint64_t bits;
+        uint64_t windowSize;
+        uint64_t compressedWindowSize;
+        const uint8_t* compressedWindow;
+        if (
+            !reader.ReadNumber(8, accessPoint.uncompressedOffset)
+            || !reader.ReadNumber(8, accessPoint.compressedOffset)
+            || !reader.ReadNumber(1, bits)
+            || !reader.ReadNumber(4, windowSize)
+            || !reader.ReadNumber(4, compressedWindowSize)
+            || !reader.ReadBytes((size_t)compressedWindowSize, compressedWindow)
+        ) {
+            fprintf(stderr, "error: '%s' is truncated\n", path.c_str());
+            return false;
+        }
+        accessPoint.bits = (int)bits;
+        if (
+            (bits > 7)
+            || (windowSize > WINDOW_SIZE)
+            || !inflater.Decompress(
+                compressedWindow,
+                (size_t)compressedWindowSize,
+                accessPoint.window
+            )
+            || (accessPoint.window.size() != windowSize)
+        ) {
+            fprintf(stderr, "error: '%s' is corrupt\n", path.c_str());
+            return false;
+        }
+        index.accessPoints.push_back(std::move(accessPoint));
+    }
+    return true;
+}
+
+bool ReadGzipRange(
+    const std::string& path,
+    const GzipIndex& index,
+    uint64_t offset,
+    size_t length,
+    std::vector< uint8_t >& output,
+    GzipRangeStatistics& statistics
+) {
+    output.clear();
+    statistics = GzipRangeStatistics();
+    if (offset >= index.uncompressedSize) {
+        return true;
+    }
+    length = (size_t)std::min((uint64_t)length, index.uncompressedSize - offset);
+    auto accessPoint = std::upper_bound(
+        index.accessPoints.begin(),
+        index.accessPoints.end(),
+        offset,
+        [](uint64_t value, const GzipAccessPoint& entry){
+            return value < entry.uncompressedOffset;
+        }
+    );
+    if (accessPoint == index.accessPoints.begin()) {
+        fprintf(stderr, "error: the index has no access point before offset %llu\n", (unsigned long long)offset);
+        return false;
+    }
+    --accessPoint;
+    statistics.accessPointOffset = accessPoint->uncompressedOffset;
+    MappedFile file;
+    if (!file.Open(path)) {
+        fprintf(stderr, "error: unable to open '%s'\n", path.c_str());
+        return false;
+    }
+    if (file.GetSize() != index.compressedSize) {
+        fprintf(stderr, "error: the index is out of date for '%s'\n", path.c_str());
+        return false;
+    }
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+        fprintf(stderr, "error: inflateInit2 failed\n");
+        return false;
+    }
+
+    // If the access point is part way into a byte, feed zlib the bits of
+    // that byte which belong after the access point.  Then give it the
+    // data before the access point, which the data after it may refer to.
+    bool succeeded = true;
+    const auto start = accessPoint->compressedOffset - ((accessPoint->bits == 0) ? 0 : 1);
+    if (accessPoint->bits != 0) {
+        const auto partialByte = file.Map(start, 1);
+        if (
+            (partialByte == nullptr)
+            || (inflatePrime(&stream, accessPoint->bits, *partialByte >> (8 - accessPoint->bits)) != Z_OK)
+        ) {
+            succeeded = false;
+        }
+    }
+    if (
+        succeeded
+        && !accessPoint->window.empty()
+        && (
+            inflateSetDictionary(
+                &stream,
+                (const Bytef*)accessPoint->window.data(),
+                (uInt)accessPoint->window.size()
+            ) != Z_OK
+        )
+    ) {
+        succeeded = false;
+    }
+    if (!succeeded) {
+        fprintf(stderr, "error: unable to start decompressing '%s' at the access point\n", path.c_str());
+        (void)inflateEnd(&stream);
+        return false;
+    }
+
+    // Decompress from the access point, throwing away the data before the
+    // range and keeping the data in it.  The access point may be in the
+    // middle of one gzip member, with others after it; the first member
+    // is decompressed as raw deflate data, since its header was skipped,
+    // and the rest as gzip data.
+    output.resize(length);
+    std::vector< uint8_t > discard(WINDOW_SIZE);
+    uint64_t skip = offset - accessPoint->uncompressedOffset;
+    uint64_t mappedEnd = accessPoint->compressedOffset;
+    size_t filled = 0;
+    size_t trailerRemaining = 0;
+    bool raw = true;
+    while (filled < length) {
+        if (!SupplyInput(file, stream, mappedEnd)) {
+            succeeded = false;
+            break;
+        }
+        if (trailerRemaining > 0) {
+            const auto trailerChunk = std::min(trailerRemaining, (size_t)stream.avail_in);
+            stream.next_in += trailerChunk;
+            stream.avail_in -= (uInt)trailerChunk;
+            trailerRemaining -= trailerChunk;
+            continue;
+        }
+        if (skip > 0) {
+            stream.next_out = (Bytef*)discard.data();
+            stream.avail_out = (uInt)std::min((uint64_t)discard.size(), skip);
+        } else {
+            stream.next_out = (Bytef*)output.data() + filled;
+            stream.avail_out = (uInt)std::min(length - filled, MAX_OUTPUT_PER_CALL);
+        }
+        const auto availOut = stream.avail_out;
+        const auto result = inflate(&stream, Z_NO_FLUSH);
+        const auto produced = availOut - stream.avail_out;
+        statistics.uncompressedBytes += produced;
+        if (skip > 0) {
+            skip -= produced;
+        } else {
+            filled += produced;
+        }
+        if (result == Z_STREAM_END) {
+            if (raw) {
+                raw = false;
+                trailerRemaining = GZIP_TRAILER_SIZE;
+                (void)inflateReset2(&stream, 16 + MAX_WBITS);
+            } else {
+                (void)inflateReset(&stream);
+            }
+            continue;
+        }
+        if (result != Z_OK) {
+            fprintf(
+                stderr,
+                "error: '%s' is not valid gzip data (%s)\n",
+                path.c_str(),
+                (stream.msg == NULL) ? "unknown error" : stream.msg
+            );
+            succeeded = false;
+            break;
+        }
+    }
+    statistics.compressedBytes = mappedEnd - stream.avail_in - start;
+    (void)inflateEnd(&stream);
+    if (!succeeded) {
+        output.clear();
+    }
+    return succeeded;
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+/**
+ * @file GzipIndex.hpp
+ *
+ * This module declares the functions used to build and use an index
+ * of access points into a gzip file, so that any part of the
+ * decompressed data can be read without decompressing everything
+ * before it.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * This holds the state needed to begin decompressing a gzip file
+ * part way through.
+ */
+struct GzipAccessPoint {
+    /**
+     * This is the offset of the access point in the decompressed data.
+     */
+    uint64_t uncompressedOffset = 0;
+
+    /**
+     * This is the offset of the first whole byte of compressed data
+     * following the access point.
+     */
+    uint64_t compressedOffset = 0;
+
+    /**
+     * This is the number of bits of the byte before the compressed
+     * offset which belong to the data following the access point.
+     */
+    int bits = 0;
+
+    /**
+     * This is the decompressed data just before the access point,
+     * up to 32 KiB of it, which later data may refer back to.
+     */
+    std::vector< uint8_t > window;
+};
+
+/**
+ * This holds access points spread through a gzip file.
+ */
+struct GzipIndex {
+    /**
+     * This is the least amount of decompressed data, in bytes,
+     * between access points.
+     */
+    uint64_t span = 0;
+
+    /**
+     * This is the size of the gzip file, in bytes.  It's used to detect
+     * an index which is out of date.
+     */
+    uint64_t compressedSize = 0;
+
+    /**
+     * This is the size of the data in the gzip file, in bytes,
+     * when decompressed.
+     */
+    uint64_t uncompressedSize = 0;
+
+    /**
+     * These are the access points, in order of increasing offset.
+     */
+    std::vector< GzipAccessPoint > accessPoints;
+};
+
+/**
+ * This holds what was done to read a range of data from a gzip file.
+ */
+struct GzipRangeStatistics {
+    /**
+     * This is the offset, in the decompressed data, of the access point
+     * from which decompression began.
+     */
+    uint64_t accessPointOffset = 0;
+
+    /**
+     * This is the number of bytes of compressed data used.
+     */
+    uint64_t compressedBytes = 0;
+
+    /**
+     * This is the number of bytes of data decompressed, including
+     * the data decompressed and thrown away before the range began.
+     */
+    uint64_t uncompressedBytes = 0;
+};
+
+/**
+ * This function decompresses the given gzip file, without holding it in
+ * memory, and makes an index of access points into it.  Files made of
+ * several gzip members are supported.
+ *
+ * @param[in] path
+ *     This is the path of the gzip file to index.
+ *
+ * @param[in] span
+ *     This is the least amount of decompressed data, in bytes,
+ *     to put between access points.
+ *
+ * @param[out] index
+ *     This is where to store the index.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool BuildGzipIndex(
+    const std::string& path,
+    uint64_t span,
+    GzipIndex& index
+);
+
+/**
+ * This function writes the given index to the given file.  The window
+ * of each access point is compressed to save space.
+ *
+ * @param[in] path
+ *     This is the path of the file to write.
+ *
+ * @param[in] index
+ *     This is the index to save.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool SaveGzipIndex(
+    const std::string& path,
+    const GzipIndex& index
+);
+
+/**
+ * This function reads an index saved by SaveGzipIndex.
+ *
+ * @param[in] path
+ *     This is the path of the file to read.
+ *
+ * @param[out] index
+ *     This is where to store the index.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool LoadGzipIndex(
+    const std::string& path,
+    GzipIndex& index
+);
+
+/**
+ * This function reads a range of the decompressed data in the given gzip
+ * file, starting from the nearest access point before the range, so that
+ * the work done depends on the span of the index and the length of the
+ * range, rather than on where the range is in the file.
+ *
+ * @param[in] path
+ *     This is the path of the gzip file to read.
+ *
+ * @param[in] index
+ *     This is the index of the gzip file.
+ *
+ * @param[in] offset
+ *     This is the offset of the range in the decompressed data.
+ *
+ * @param[in] length
+ *     This is the length of the range, in bytes.  The range is cut short
+ *     if it goes past the end of the data.
+ *
+ * @param[out] output
+ *     This is where to store the data read.
+ *
+ * @param[out] statistics
+ *     This is where to store what was done to read the data.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool ReadGzipRange(
+    const std::string& path,
+    const GzipIndex& index,
+    uint64_t offset,
+    size_t length,
+    std::vector< uint8_t >& output,
+    GzipRangeStatistics& statistics
+);
@@ -0,0 +1,261 @@
+/**
+ * @file Inflater.cpp
+ *
+ * This module contains the implementation of the Inflater class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Inflater.hpp"
+
+#include <algorithm>
+
+namespace {
+
+    /**
+     * This is the most input handed to zlib in one call, since zlib
+     * counts available input with an unsigned int.
+     */
+    constexpr size_t MAX_INPUT_PER_CALL = 1 << 30;
+
+}
+
+/**
+ * This contains the private properties of an Inflater instance.
+ */
+struct Inflater::Impl {
+    // Properties
+
+    /**
+     * This is the zlib stream used to decompress data.
+     */
+    z_stream stream;
+
+    /**
+     * This indicates whether or not the zlib stream has been initialized.
+     */
+    bool initialized = false;
+
+    /**
+     * This indicates whether or not the end of the stream
+     * has been reached.
+     */
+    bool finished = false;
+
+    /**
+     * This is the arena from which zlib allocates its memory, if any.
+     * It's held here so that it outlives the stream.
+     */
+    std::shared_ptr< ZlibArena > arena;
+
+    /**
+     * This is the preset dictionary with which the data was
+     * compressed, if any.
+     */
+    std::vector< uint8_t > dictionary;
+
+    /**
+     * This indicates whether or not the data is raw deflate, in which
+     * case the dictionary must be given to zlib before it's asked for.
+     */
+    bool raw = false;
+
+    /**
+     * This is the buffer in which each chunk of output is collected.
+     */
+    std::vector< uint8_t > buffer;
+
+    // Lifecycle management
+
+    ~Impl() noexcept {
+        if (initialized) {
+            (void)inflateEnd(&stream);
+        }
+    }
+    Impl(const Impl&) = delete;
+    Impl(Impl&&) noexcept = delete;
+    Impl& operator=(const Impl&) = delete;
+    Impl& operator=(Impl&&) noexcept = delete;
+
+    // Methods
+
+    /**
+     * This is the default constructor.
+     */
+    Impl() = default;
+
+    /**
+     * This method gives zlib the preset dictionary.
+     *
+     * @return
+     *     An indication of whether or not the method succeeded is returned.
+     */
+    bool SetDictionary() {
+        return (
+            inflateSetDictionary(
+                &stream,
+                (const Bytef*)dictionary.data(),
+                (uInt)dictionary.size()
+            ) == Z_OK
+        );
+    }
+
+    /**
+     * This method prepares for the stream about to begin, giving zlib
+     * the preset dictionary now if it won't ask for it later.
+     *
+     * @return
+     *     An indication of whether or not the method succeeded is returned.
+     */
+    bool BeginStream() {
+        finished = false;
+        return (
+            !raw
+            || dictionary.empty()
+            || SetDictionary()
+        );
+    }
+};
+
+Inflater::~Inflater() noexcept = default;
+Inflater::Inflater(Inflater&&) noexcept = default;
+Inflater& Inflater::operator=(Inflater&&) noexcept = default;
+
+Inflater::Inflater()
+    : impl_(new Impl())
+{
+}
+
+bool Inflater::Initialize(
+    const InflaterConfiguration& configuration,
+    std::shared_ptr< ZlibArena > arena
+) {
+    if (impl_->initialized) {
+        (void)inflateEnd(&impl_->stream);
+        impl_->initialized = false;
+    }
+    impl_->arena = arena;
+    impl_->stream.zalloc = Z_NULL;
+    impl_->stream.zfree = Z_NULL;
+    impl_->stream.opaque = Z_NULL;
+    impl_->stream.next_in = Z_NULL;
+    impl_->stream.avail_in = 0;
+    if (arena != nullptr) {
+        arena->Attach(impl_->stream);
+    }
+    if (inflateInit2(&impl_->stream, configuration.windowBits) != Z_OK) {
+        return false;
+    }
+    impl_->initialized = true;
+    impl_->dictionary = configuration.dictionary;
+    impl_->raw = (configuration.windowBits < 0);
+    impl_->buffer.resize(std::max((size_t)1, configuration.chunkSize));
+    return impl_->BeginStream();
+}
+
+bool Inflater::Inflate(
+    const uint8_t* data,
+    size_t size,
+    OutputDelegate outputDelegate,
+    size_t* consumed
+) {
+    if (consumed != nullptr) {
+        *consumed = 0;
+    }
+    if (!impl_->initialized) {
+        return false;
+    }
+    auto& stream = impl_->stream;
+    auto& buffer = impl_->buffer;
+    while (
+        (size > 0)
+        && !impl_->finished
+    ) {
+        const auto slice = std::min(size, MAX_INPUT_PER_CALL);
+        stream.next_in = (Bytef*)data;
+        stream.avail_in = (uInt)slice;
+        do {
+            stream.next_out = (Bytef*)buffer.data();
+            stream.avail_out = (uInt)buffer.size();
+            auto result = inflate(&stream, Z_NO_FLUSH);
+            if (result == Z_NEED_DICT) {
+                // zlib checks that the dictionary is the one the stream
+                // was compressed with.
+                if (
+                    impl_->dictionary.empty()
+                    || !impl_->SetDictionary()
+                ) {
+                    return false;
+                }
+                result = inflate(&stream, Z_NO_FLUSH);
+            }
+            if (
+                (result != Z_OK)
+                && (result != Z_STREAM_END)
+                && (result != Z_BUF_ERROR)
+            ) {
+                return false;
+            }
+            const auto produced = buffer.size() - stream.avail_out;
+            if (
+                (produced > 0)
+                && !outputDelegate(buffer.data(), produced)
+            ) {
+                return false;
+            }
+            if (result == Z_STREAM_END) {
+                impl_->finished = true;
+                break;
+            }
+        } while (stream.avail_out == 0);
+        const auto used = slice - stream.avail_in;
+        if (consumed != nullptr) {
+            *consumed += used;
+        }
+        data += used;
+        size -= used;
+        if (
+            (used < slice)
+            && !impl_->finished
+        ) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool Inflater::IsFinished() const {
+    return impl_->finished;
+}
+
+bool Inflater::Reset() {
+    if (
+        !impl_->initialized
+        || (inflateReset(&impl_->stream) != Z_OK)
+    ) {
+        return false;
+    }
+    return impl_->BeginStream();
+}
+
+bool Inflater::Decompress(
+    const uint8_t* data,
+    size_t size,
+    std::vector< uint8_t >& output
+) {
+    size_t consumed;
+    return (
+        Reset()
+        && Inflate(
+            data,
+            size,
+            [&output](const uint8_t* chunk, size_t chunkSize){
+                output.insert(output.end(), chunk, chunk + chunkSize);
+                return true;
+            },
+            &consumed
+        )
+        && IsFinished()
+        && (consumed == size)
+    );
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+/**
+ * @file Inflater.hpp
+ *
+ * This module declares the Inflater class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "ZlibArena.hpp"
+
+#include <functional>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <zlib.h>
+
+/**
+ * This holds the settings given to zlib when an Inflater is initialized.
+ */
+struct InflaterConfiguration {
+    /**
+     * This is the windowBits value to give to inflateInit2.  Adding 16
+     * expects the gzip wrapper, adding 32 detects the zlib or gzip wrapper
+     * automatically, and negating expects raw deflate.
+     */
+    int windowBits = MAX_WBITS;
+
+    /**
+     * This is the size, in bytes, of the chunks in which decompressed
+     * output is delivered.
+     */
+    size_t chunkSize = 16384;
+
+    /**
+     * If not empty, this is the preset dictionary with which the data
+     * was compressed.  With raw deflate it's given to zlib at the start
+     * of every stream; otherwise it's given when the stream asks for it,
+     * after checking that it's the one the stream was compressed with.
+     */
+    std::vector< uint8_t > dictionary;
+};
+
+/**
+ * This decompresses data using zlib.  Input is given in chunks, and output
+ * is delivered in chunks through a callback.  After a stream is finished,
+ * the Inflater can be reset and used for the next stream without setting
+ * up zlib again.
+ */
+class Inflater {
+    // Types
+public:
+    /**
+     * This is the type of function used to deliver decompressed output.
+     *
+     * @param[in] data
+     *     This points to the next chunk of decompressed output.
+     *
+     * @param[in] size
+     *     This is the number of bytes of decompressed output.
+     *
+     * @return
+     *     An indication of whether or not the output was accepted is
+     *     returned.  Decompression stops if the output is not accepted.
+     */
+    typedef std::function< bool(const uint8_t* data, size_t size) > OutputDelegate;
+
+    // Lifecycle management
+public:
+    ~Inflater() noexcept;
+    Inflater(const Inflater&) = delete;
+    Inflater(Inflater&&) noexcept;
+    Inflater& operator=(const Inflater&) = delete;
+    Inflater& operator=(Inflater&&) noexcept;
+
+    // Public Methods
+public:
+    /**
+     * This is the default constructor.
+     */
+    Inflater();
+
+    /**
+     * This method sets up zlib to decompress data with the given settings.
+     *
+     * @param[in] configuration
+     *     These are the settings to give to zlib.
+     *
+     * @param[in] arena
+     *     If not null, this is the arena from which zlib should allocate
+     *     its memory.  Otherwise zlib uses the standard allocator.
+     *
+     * @return
+     *     An indication of whether or not the method succeeded is returned.
+     */
+    bool Initialize(
+        const InflaterConfiguration& configuration = InflaterConfiguration(),
+        std::shared_ptr< ZlibArena > arena = nullptr
+    );
+
+    /**
+     * This method decompresses the next chunk of input.  Decompression
+     * stops at the end of the stream, leaving any input after it unused.
+     *
+     * @param[in] data
+     *     This points to the next chunk of input.
+     *
+     * @param[in] size
+     *     This is the number of bytes of input.
+     *
+     * @param[in] outputDelegate
+     *     This is the function to call to deliver decompressed output.
+     *
+     * @param[out] consumed
+     *     If not null, this is where to store the number of bytes of
+     *     input used.
+     *
+     * @return
+     *     An indication of whether or not the method succeeded is returned.
+     */
+    bool Inflate(
+        const uint8_t* data,
+        size_t size,
+        OutputDelegate outputDelegate,
+        size_t* consumed = nullptr
+    );
+
+    /**
+     * This method indicates whether or not the end of the stream
+     * has been reached.
+     *
+     * @return
+     *     An indication of whether or not the end of the stream
+     *     has been reached is returned.
+     */
+    bool IsFinished() const;
+
+    /**
+     * This method abandons any stream in progress and prepares to
+     * decompress a new stream with the same settings, reusing zlib's memory.
+     *
+     * @return
+     *     An indication of whether or not the method succeeded is returned.
+     */
+    bool Reset();
+
+    /**
+     * This method decompresses the given data as one complete stream,
+     * appending the result to the given vector.
+     *
+     * @param[in] data
+     *     This points to the data to decompress.
+     *
+     * @param[in] size
+     *     This is the number of bytes of data to decompress.
+     *
+     * @param[in,out] output
+     *     This is where to append the decompressed data.
+     *
+     * @return
+     *     An indication of whether or not the data was one complete
+     *     stream, successfully decompressed, is returned.
+     */
+    bool Decompress(
+        const uint8_t* data,
+        size_t size,
+        std::vector< uint8_t >& output
+    );
+
+    // Private Properties
+private:
+    /**
+     * This is the type of structure that contains the private
+     * properties of the instance.  It is defined in the implementation
+     * and declared here to ensure that it is scoped inside the class.
+     */
+    struct Impl;
+
+    /**
+     * This contains the private properties of the instance.
+     */
+    std::unique_ptr< Impl > impl_;
+};
@@ -0,0 +1,234 @@
+/**
+ * @file MappedFile.cpp
+ *
+ * This module contains the implementation of the MappedFile class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else /* POSIX */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif /* _WIN32 or POSIX */
+
+/**
+ * This contains the private properties of a MappedFile instance.
+ */
+struct MappedFile::Impl {
+    // Properties
+
+#ifdef _WIN32
+    /**
+     * This is the operating system handle to the open file.
+     */
+    HANDLE file = INVALID_HANDLE_VALUE;
+
+    /**
+     * This is the operating system handle to the file mapping object.
+     */
+    HANDLE mapping = NULL;
+#else /* POSIX */
+    /**
+     * This is the operating system handle to the open file.
+     */
+    int file = -1;
+#endif /* _WIN32 or POSIX */
+
+    /**
+     * This is the size of the open file, in bytes.
+     */
+    uint64_t size = 0;
+
+    /**
+     * This is the start of the currently mapped view, if any.
+     */
+    void* view = nullptr;
+
+    /**
+     * This is the number of bytes in the currently mapped view.
+     */
+    size_t viewSize = 0;
+
+    // Methods
+
+    /**
+     * This method returns the granularity to which the offsets of
+     * mapped views must be aligned.
+     *
+     * @return
+     *     The view offset alignment, in bytes, is returned.
+     */
+    static uint64_t GetViewAlignment() {
+#ifdef _WIN32
+        SYSTEM_INFO systemInfo;
+        GetSystemInfo(&systemInfo);
+        return (uint64_t)systemInfo.dwAllocationGranularity;
+#else /* POSIX */
+        return (uint64_t)sysconf(_SC_PAGESIZE);
+#endif /* _WIN32 or POSIX */
+    }
+
+    /**
+     * This method unmaps the currently mapped view, if any.
+     */
+    void Unmap() {
+        if (view == nullptr) {
+            return;
+        }
+#ifdef _WIN32
+        (void)UnmapViewOfFile(view);
+#else /* POSIX */
+        (void)munmap(view, viewSize);
+#endif /* _WIN32 or POSIX */
+        view = nullptr;
+        viewSize = 0;
+    }
+
+    /**
+     * This method unmaps any mapped view and closes the open file, if any.
+     */
+    void Close() {
+        Unmap();
+#ifdef _WIN32
+        if (mapping != NULL) {
+            (void)CloseHandle(mapping);
+            mapping = NULL;
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            (void)CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+        }
+#else /* POSIX */
+        if (file >= 0) {
+            (void)close(file);
+            file = -1;
+        }
+#endif /* _WIN32 or POSIX */
+        size = 0;
+    }
+};
+
+MappedFile::~MappedFile() noexcept {
+    impl_->Close();
+}
+
+MappedFile::MappedFile()
+    : impl_(new Impl())
+{
+}
+
+bool MappedFile::Open(const std::string& path) {
+    impl_->Close();
+#ifdef _WIN32
+    impl_->file = CreateFileA(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        NULL
+    );
+    if (impl_->file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(impl_->file, &size)) {
+        impl_->Close();
+        return false;
+    }
+    impl_->size = (uint64_t)size.QuadPart;
+
+    // Windows refuses to create a mapping of an empty file,
+    // so leave such files unmapped.
+    if (impl_->size > 0) {
+        impl_->mapping = CreateFileMappingA(
+            impl_->file,
+            NULL,
+            PAGE_READONLY,
+            0,
+            0,
+            NULL
+        );
+        if (impl_->mapping == NULL) {
+            impl_->Close();
+            return false;
+        }
+    }
+#else /* POSIX */
+    impl_->file = open(path.c_str(), O_RDONLY);
+    if (impl_->file < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(impl_->file, &status) != 0) {
+        impl_->Close();
+        return false;
+    }
+    impl_->size = (uint64_t)status.st_size;
+#endif /* _WIN32 or POSIX */
+    return true;
+}
+
+uint64_t MappedFile::GetSize() const {
+    return impl_->size;
+}
+
+const uint8_t* MappedFile::Map(
+    uint64_t offset,
+    size_t size
+) {
+    impl_->Unmap();
+    if (
+        (offset > impl_->size)
+        || (size > impl_->size - offset)
+    ) {
+        return nullptr;
+    }
+    if (size == 0) {
+        static const uint8_t empty = 0;
+        return &empty;
+    }
+    const auto alignment = Impl::GetViewAlignment();
+    const auto viewOffset = offset - (offset % alignment);
+    const auto viewSize = (size_t)(offset - viewOffset) + size;
+#ifdef _WIN32
+    impl_->view = MapViewOfFile(
+        impl_->mapping,
+        FILE_MAP_READ,
+        (DWORD)(viewOffset >> 32),
+        (DWORD)(viewOffset & 0xFFFFFFFF),
+        viewSize
+    );
+    if (impl_->view == NULL) {
+        impl_->view = nullptr;
+        return nullptr;
+    }
+#else /* POSIX */
+    impl_->view = mmap(
+        NULL,
+        viewSize,
+        PROT_READ,
+        MAP_PRIVATE,
+        impl_->file,
+        (off_t)viewOffset
+    );
+    if (impl_->view == MAP_FAILED) {
+        impl_->view = nullptr;
+        return nullptr;
+    }
+#ifdef MADV_SEQUENTIAL
+    (void)madvise(impl_->view, viewSize, MADV_SEQUENTIAL);
+#endif /* MADV_SEQUENTIAL */
+#endif /* _WIN32 or POSIX */
+    impl_->viewSize = viewSize;
+    return (const uint8_t*)impl_->view + (size_t)(offset - viewOffset);
+}
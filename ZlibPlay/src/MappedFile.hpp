@@ -0,0 +1,91 @@
+#pragma once
+
+/**
+ * @file MappedFile.hpp
+ *
+ * This module declares the MappedFile class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/**
+ * This provides read-only access to a file by mapping it into memory.
+ * Only one view of the file is mapped at a time, so a file of any size can
+ * be walked with a bounded amount of address space and resident memory.
+ */
+class MappedFile {
+    // Lifecycle management
+public:
+    ~MappedFile() noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) noexcept = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) noexcept = delete;
+
+    // Public Methods
+public:
+    /**
+     * This is the default constructor.
+     */
+    MappedFile();
+
+    /**
+     * This method opens the file with the given path for mapping.
+     *
+     * @param[in] path
+     *     This is the path of the file to open.
+     *
+     * @return
+     *     An indication of whether or not the method succeeded is returned.
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * This method returns the size of the open file.
+     *
+     * @return
+     *     The size of the open file, in bytes, is returned.
+     */
+    uint64_t GetSize() const;
+
+    /**
+     * This method maps the given range of the open file into memory,
+     * replacing any range mapped previously.  The returned pointer is valid
+     * until the next call to this method or until the object is destroyed.
+     *
+     * @param[in] offset
+     *     This is the offset of the first byte of the file to map.
+     *
+     * @param[in] size
+     *     This is the number of bytes of the file to map.
+     *
+     * @return
+     *     A pointer to the byte of the file at the given offset is returned.
+     *
+     * @retval nullptr
+     *     This is returned if the range could not be mapped.
+     */
+    const uint8_t* Map(
+        uint64_t offset,
+        size_t size
+    );
+
+    // Private Properties
+private:
+    /**
+     * This is the type of structure that contains the private
+     * properties of the instance.  It is defined in the implementation
+     * and declared here to ensure that it is scoped inside the class.
+     */
+    struct Impl;
+
+    /**
+     * This contains the private properties of the instance.
+     */
+    std::unique_ptr< Impl > impl_;
+};
@@ -0,0 +1,291 @@
+/**
+ * @file ParallelGunzip.cpp
+ *
+ * This module contains the implementation of the functions used to
+ * decompress gzip data made of several members using several threads
+ * at once.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Inflater.hpp"
+#include "ParallelGunzip.hpp"
+#include "ThreadPool.hpp"
+
+#include <deque>
+#include <future>
+#include <memory>
+#include <string.h>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+
+    /**
+     * This is the smallest possible gzip member: a 10-byte header,
+     * an empty deflate stream, and an 8-byte trailer.
+     */
+    constexpr size_t MIN_MEMBER_SIZE = 20;
+
+    /**
+     * This is the number of members per worker thread which may be
+     * decompressed or waiting to be written at any one time.  It bounds
+     * the memory used to hold decompressed members.
+     */
+    constexpr size_t MEMBERS_IN_FLIGHT_PER_THREAD = 2;
+
+    /**
+     * This is the size of the chunks in which decompressed output
+     * is collected.
+     */
+    constexpr size_t OUTPUT_CHUNK_SIZE = 256 * 1024;
+
+    /**
+     * This holds the input and output of decompressing one member.
+     */
+    struct Member {
+        /**
+         * This is the offset of the member in the gzip data.
+         */
+        size_t offset = 0;
+
+        /**
+         * This is the number of bytes of gzip data in the member.
+         */
+        size_t size = 0;
+
+        /**
+         * This is the decompressed output.
+         */
+        std::vector< uint8_t > output;
+
+        /**
+         * This is used to report the outcome of decompressing the member.
+         */
+        std::promise< bool > completion;
+    };
+
+    /**
+     * This function decompresses one gzip member, which zlib checks
+     * against the CRC-32 and size in its trailer.
+     *
+     * @param[in] input
+     *     This points to the start of the member.
+     *
+     * @param[in] inputSize
+     *     This is the number of bytes from the start of the member
+     *     to the end of the gzip data.
+     *
+     * @param[in] outputDelegate
+     *     This is the function to call to deliver the decompressed output.
+     *
+     * @param[out] memberSize
+     *     This is where to store the number of bytes of gzip data
+     *     in the member.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool InflateMember(
+        const uint8_t* input,
+        size_t inputSize,
+        Inflater::OutputDelegate outputDelegate,
+        size_t& memberSize
+    ) {
+        Inflater inflater;
+        InflaterConfiguration configuration;
+        configuration.windowBits = 16 + MAX_WBITS;
+        configuration.chunkSize = OUTPUT_CHUNK_SIZE;
+        return (
+            inflater.Initialize(configuration)
+            && inflater.Inflate(input, inputSize, outputDelegate, &memberSize)
+            && inflater.IsFinished()
+        );
+    }
+
+    /**
+     * This function finds every place in the given gzip data which looks
+     * like the start of a member: the gzip magic number, the deflate
+     * method, no reserved flags, and a known operating system.
+     *
+     * @param[in] input
+     *     This points to the gzip data to search.
+     *
+     * @param[in] inputSize
+     *     This is the number of bytes of gzip data to search.
+     *
+     * @return
+     *     The offsets of the places which look like the start of
+     *     a member are returned, in order.
+     */
+    std::vector< size_t > FindMemberCandidates(
+        const uint8_t* input,
+        size_t inputSize
+    ) {
+        std::vector< size_t > candidates;
+        if (inputSize < MIN_MEMBER_SIZE) {
+            return candidates;
+        }
+        const auto searchEnd = input + inputSize - MIN_MEMBER_SIZE + 1;
+        auto next = input;
+        while (next < searchEnd) {
+            const auto magic = (const uint8_t*)memchr(next, 0x1F, searchEnd - next);
+            if (magic == NULL) {
+                break;
+            }
+            if (
+                (magic[1] == 0x8B)
+                && (magic[2] == Z_DEFLATED)
+                && ((magic[3] & 0xE0) == 0)
+                && (
+                    (magic[9] <= 13)
+                    || (magic[9] == 0xFF)
+                )
+            ) {
+                candidates.push_back(magic - input);
+            }
+            next = magic + 1;
+        }
+        return candidates;
+    }
+
+}
+
+bool SerialGunzip(
+    const uint8_t* input,
+    size_t inputSize,
+    DecompressedOutputDelegate outputDelegate,
+    GunzipStatistics& statistics
+) {
+    statistics = GunzipStatistics();
+    size_t offset = 0;
+    do {
+        size_t memberSize;
+        if (!InflateMember(input + offset, inputSize - offset, outputDelegate, memberSize)) {
+            return false;
+        }
+        offset += memberSize;
+        ++statistics.members;
+    } while (offset < inputSize);
+    return true;
+}
+
+bool ParallelGunzip(
+    const uint8_t* input,
+    size_t inputSize,
+    const ParallelGunzipConfiguration& configuration,
+    DecompressedOutputDelegate outputDelegate,
+    GunzipStatistics& statistics
+) {
+    const auto candidates = FindMemberCandidates(input, inputSize);
+    if (candidates.size() < 2) {
+        return SerialGunzip(input, inputSize, outputDelegate, statistics);
+    }
+    ThreadPool pool(configuration.threads);
+    if (pool.GetNumThreads() < 2) {
+        return SerialGunzip(input, inputSize, outputDelegate, statistics);
+    }
+    statistics = GunzipStatistics();
+    statistics.parallel = true;
+
+    // Decompress every candidate on the thread pool.  Take the results in
+    // order, using a member only if it starts where the last one ended.
+    // Any real member which wasn't taken for a candidate is decompressed
+    // here instead, so that nothing is missed.
+    const auto maxMembersInFlight = pool.GetNumThreads() * MEMBERS_IN_FLIGHT_PER_THREAD;
+    std::deque< std::pair< std::shared_ptr< Member >, std::future< bool > > > membersInFlight;
+    size_t expectedOffset = 0;
+    bool succeeded = true;
+    const auto catchUpTo = [
+        input,
+        inputSize,
+        &expectedOffset,
+        &succeeded,
+        &outputDelegate,
+        &statistics
+    ](size_t offset){
+        while (
+            succeeded
+            && (expectedOffset < offset)
+        ) {
+            size_t memberSize;
+            if (
+                !InflateMember(
+                    input + expectedOffset,
+                    inputSize - expectedOffset,
+                    outputDelegate,
+                    memberSize
+                )
+            ) {
+                succeeded = false;
+                return;
+            }
+            expectedOffset += memberSize;
+            ++statistics.members;
+        }
+    };
+    const auto retireOldestMember = [
+        &membersInFlight,
+        &expectedOffset,
+        &succeeded,
+        &outputDelegate,
+        &statistics,
+        &catchUpTo
+    ]{
+        const auto member = membersInFlight.front().first;
+        const auto memberSucceeded = membersInFlight.front().second.get();
+        membersInFlight.pop_front();
+        catchUpTo(member->offset);
+        if (!succeeded) {
+            return;
+        }
+        if (member->offset < expectedOffset) {
+            ++statistics.falseStarts;
+            return;
+        }
+        if (
+            !memberSucceeded
+            || !outputDelegate(member->output.data(), member->output.size())
+        ) {
+            succeeded = false;
+            return;
+        }
+        expectedOffset += member->size;
+        ++statistics.members;
+    };
+    for (const auto candidate: candidates) {
+        const auto member = std::make_shared< Member >();
+        member->offset = candidate;
+        membersInFlight.emplace_back(member, member->completion.get_future());
+        pool.Post(
+            [input, inputSize, member]{
+                auto& output = member->output;
+                member->completion.set_value(
+                    InflateMember(
+                        input + member->offset,
+                        inputSize - member->offset,
+                        [&output](const uint8_t* data, size_t size){
+                            output.insert(output.end(), data, data + size);
+                            return true;
+                        },
+                        member->size
+                    )
+                );
+            }
+        );
+        while (
+            succeeded
+            && (membersInFlight.size() >= maxMembersInFlight)
+        ) {
+            retireOldestMember();
+        }
+        if (!succeeded) {
+            break;
+        }
+    }
+    while (!membersInFlight.empty()) {
+        retireOldestMember();
+    }
+    catchUpTo(inputSize);
+    return succeeded;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+/**
+ * @file ParallelGunzip.hpp
+ *
+ * This module declares the functions used to decompress gzip data made
+ * of several members using several threads at once.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * This holds the settings which control parallel gzip decompression.
+ */
+struct ParallelGunzipConfiguration {
+    /**
+     * This is the number of threads to use.  If zero, one thread is
+     * used per hardware thread of the machine.
+     */
+    size_t threads = 0;
+};
+
+/**
+ * This holds what was done to decompress gzip data.
+ */
+struct GunzipStatistics {
+    /**
+     * This is the number of gzip members decompressed.
+     */
+    size_t members = 0;
+
+    /**
+     * This is the number of places which looked like the start of a gzip
+     * member but turned out to be inside another member.
+     */
+    size_t falseStarts = 0;
+
+    /**
+     * This indicates whether or not members were decompressed in parallel.
+     */
+    bool parallel = false;
+};
+
+/**
+ * This is the type of function used to deliver decompressed output.
+ * Output is delivered in order, from the thread which called the
+ * decompression function.
+ *
+ * @param[in] data
+ *     This points to the next piece of decompressed output.
+ *
+ * @param[in] size
+ *     This is the number of bytes of decompressed output.
+ *
+ * @return
+ *     An indication of whether or not the output was accepted is returned.
+ *     Decompression stops early if the output is not accepted.
+ */
+typedef std::function< bool(const uint8_t* data, size_t size) > DecompressedOutputDelegate;
+
+/**
+ * This function decompresses the given gzip data, one member after
+ * another, on the calling thread.
+ *
+ * @param[in] input
+ *     This points to the gzip data to decompress.
+ *
+ * @param[in] inputSize
+ *     This is the number of bytes of gzip data to decompress.
+ *
+ * @param[in] outputDelegate
+ *     This is the function to call to deliver the decompressed output.
+ *
+ * @param[out] statistics
+ *     This is where to store what was done.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool SerialGunzip(
+    const uint8_t* input,
+    size_t inputSize,
+    DecompressedOutputDelegate outputDelegate,
+    GunzipStatistics& statistics
+);
+
+/**
+ * This function decompresses the given gzip data, decompressing its
+ * members on a pool of threads.
+ *
+ * Member boundaries can't be known for certain without decompressing
+ * everything before them, so every place which looks like the start of a
+ * member is decompressed speculatively.  Results are then taken in order,
+ * starting from the beginning of the data, and each member is used only
+ * if it starts exactly where the member before it ended; the rest are
+ * thrown away.  The output is therefore the same as decompressing the
+ * members one after another.  Data with only one member is decompressed
+ * on the calling thread.
+ *
+ * @param[in] input
+ *     This points to the gzip data to decompress.
+ *
+ * @param[in] inputSize
+ *     This is the number of bytes of gzip data to decompress.
+ *
+ * @param[in] configuration
+ *     This holds the settings which control the decompression.
+ *
+ * @param[in] outputDelegate
+ *     This is the function to call to deliver the decompressed output.
+ *
+ * @param[out] statistics
+ *     This is where to store what was done.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool ParallelGunzip(
+    const uint8_t* input,
+    size_t inputSize,
+    const ParallelGunzipConfiguration& configuration,
+    DecompressedOutputDelegate outputDelegate,
+    GunzipStatistics& statistics
+);
@@ -0,0 +1,270 @@
+/**
+ * @file ParallelGzip.cpp
+ *
+ * This module contains the implementation of the functions used to
+ * compress data into the gzip format using several threads at once.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Checksums.hpp"
+#include "ParallelGzip.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace {
+
+    /**
+     * This is the number of bytes at the end of each block given to the
+     * compressor of the next block as a preset dictionary.  It's the
+     * largest distance a deflate match can reach back.
+     */
+    constexpr size_t DICTIONARY_SIZE = 32768;
+
+    /**
+     * This is the number of blocks per worker thread which may be
+     * compressed or waiting to be written at any one time.  It bounds
+     * the memory used to hold compressed blocks.
+     */
+    constexpr size_t BLOCKS_IN_FLIGHT_PER_THREAD = 2;
+
+    /**
+     * This holds the input and output of compressing one block.
+     */
+    struct Block {
+        /**
+         * This points to the input to compress.  The bytes before it,
+         * up to dictionarySize of them, are used as the preset dictionary.
+         */
+        const uint8_t* input = nullptr;
+
+        /**
+         * This is the number of bytes of input to compress.
+         */
+        size_t size = 0;
+
+        /**
+         * This is the number of bytes before the input to use
+         * as the preset dictionary.
+         */
+        size_t dictionarySize = 0;
+
+        /**
+         * This indicates whether or not this is the final block
+         * of the deflate stream.
+         */
+        bool last = false;
+
+        /**
+         * This is the compression level to use.
+         */
+        int level = Z_DEFAULT_COMPRESSION;
+
+        /**
+         * This is the compression strategy to use.
+         */
+        int strategy = Z_DEFAULT_STRATEGY;
+
+        /**
+         * This is the compressed output.
+         */
+        std::vector< uint8_t > output;
+
+        /**
+         * This is the CRC-32 of the input.
+         */
+        uLong crc = 0;
+
+        /**
+         * This is used to report the outcome of compressing the block.
+         */
+        std::promise< bool > completion;
+    };
+
+    /**
+     * This function compresses one block into raw deflate data.  Blocks
+     * other than the last are ended with a sync flush, which aligns the
+     * output to a byte boundary without marking the end of the stream, so
+     * that the outputs of all blocks can be concatenated.
+     *
+     * @param[in,out] block
+     *     This holds the input and receives the output.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool CompressBlock(Block& block) {
+        block.crc = Crc32(0, block.input, block.size);
+        z_stream stream;
+        stream.zalloc = Z_NULL;
+        stream.zfree = Z_NULL;
+        stream.opaque = Z_NULL;
+        if (
+            deflateInit2(
+                &stream,
+                block.level,
+                Z_DEFLATED,
+                -MAX_WBITS,
+                8,
+                block.strategy
+            ) != Z_OK
+        ) {
+            return false;
+        }
+        if (
+            (block.dictionarySize > 0)
+            && (
+                deflateSetDictionary(
+                    &stream,
+                    (const Bytef*)block.input - block.dictionarySize,
+                    (uInt)block.dictionarySize
+                ) != Z_OK
+            )
+        ) {
+            (void)deflateEnd(&stream);
+            return false;
+        }
+        block.output.resize(deflateBound(&stream, (uLong)block.size) + 16);
+        stream.next_in = (Bytef*)block.input;
+        stream.avail_in = (uInt)block.size;
+        const auto flush = block.last ? Z_FINISH : Z_SYNC_FLUSH;
+        size_t produced = 0;
+        for (;;) {
+            stream.next_out = (Bytef*)block.output.data() + produced;
+            stream.avail_out = (uInt)(block.output.size() - produced);
+            const auto result = deflate(&stream, flush);
+            produced = block.output.size() - stream.avail_out;
+            if (result == Z_STREAM_ERROR) {
+                (void)deflateEnd(&stream);
+                return false;
+            }
+            if (
+                block.last
+                ? (result == Z_STREAM_END)
+                : ((stream.avail_in == 0) && (stream.avail_out != 0))
+            ) {
+                break;
+            }
+            block.output.resize(block.output.size() * 2);
+        }
+        block.output.resize(produced);
+        (void)deflateEnd(&stream);
+        return true;
+    }
+
+    /**
+     * This function stores the given value at the given location,
+     * least significant byte first, as gzip requires.
+     *
+     * @param[out] destination
+     *     This is where to store the value.
+     *
+     * @param[in] value
+     *     This is the value to store.
+     */
+    void StoreLittleEndian32(
+        uint8_t* destination,
+        uint32_t value
+    ) {
+        for (size_t i = 0; i < 4; ++i) {
+            destination[i] = (uint8_t)(value >> (8 * i));
+        }
+    }
+
+}
+
+bool ParallelGzip(
+    const uint8_t* input,
+    size_t inputSize,
+    const ParallelGzipConfiguration& configuration,
+    CompressedOutputDelegate outputDelegate
+) {
+    // Write the gzip header (RFC 1952), with no file name or
+    // modification time, and the operating system marked as unknown.
+    const uint8_t header[10] = {
+        0x1F, 0x8B, Z_DEFLATED, 0,
+        0, 0, 0, 0,
+        (uint8_t)(
+            (configuration.level == Z_BEST_COMPRESSION) ? 2 :
+            (configuration.level == Z_BEST_SPEED) ? 4 :
+            0
+        ),
+        0xFF
+    };
+    if (!outputDelegate(header, sizeof(header))) {
+        return false;
+    }
+
+    // Compress the blocks on the thread pool, writing their output in
+    // order as it becomes available, and combining their check values.
+    const auto blockSize = std::max((size_t)1, configuration.blockSize);
+    ThreadPool pool(configuration.threads);
+    const auto maxBlocksInFlight = pool.GetNumThreads() * BLOCKS_IN_FLIGHT_PER_THREAD;
+    std::deque< std::pair< std::shared_ptr< Block >, std::future< bool > > > blocksInFlight;
+    auto crc = crc32(0L, Z_NULL, 0);
+    bool succeeded = true;
+    const auto retireOldestBlock = [
+        &blocksInFlight,
+        &crc,
+        &succeeded,
+        &outputDelegate
+    ]{
+        const auto block = blocksInFlight.front().first;
+        const auto blockSucceeded = blocksInFlight.front().second.get();
+        blocksInFlight.pop_front();
+        if (!succeeded) {
+            return;
+        }
+        if (
+            !blockSucceeded
+            || !outputDelegate(block->output.data(), block->output.size())
+        ) {
+            succeeded = false;
+            return;
+        }
+        crc = crc32_combine(crc, block->crc, (z_off_t)block->size);
+    };
+    size_t offset = 0;
+    do {
+        const auto block = std::make_shared< Block >();
+        block->input = input + offset;
+        block->size = std::min(blockSize, inputSize - offset);
+        block->dictionarySize = std::min(DICTIONARY_SIZE, offset);
+        offset += block->size;
+        block->last = (offset == inputSize);
+        block->level = configuration.level;
+        block->strategy = configuration.strategy;
+        blocksInFlight.emplace_back(block, block->completion.get_future());
+        pool.Post(
+            [block]{
+                block->completion.set_value(CompressBlock(*block));
+            }
+        );
+        while (
+            succeeded
+            && (blocksInFlight.size() >= maxBlocksInFlight)
+        ) {
+            retireOldestBlock();
+        }
+    } while (
+        succeeded
+        && (offset < inputSize)
+    );
+    while (!blocksInFlight.empty()) {
+        retireOldestBlock();
+    }
+    if (!succeeded) {
+        return false;
+    }
+
+    // Write the gzip trailer.
+    uint8_t trailer[8];
+    StoreLittleEndian32(trailer, (uint32_t)crc);
+    StoreLittleEndian32(trailer + 4, (uint32_t)inputSize);
+    return outputDelegate(trailer, sizeof(trailer));
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+/**
+ * @file ParallelGzip.hpp
+ *
+ * This module declares the functions used to compress data into the gzip
+ * format using several threads at once.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <zlib.h>
+
+/**
+ * This holds the settings which control parallel gzip compression.
+ */
+struct ParallelGzipConfiguration {
+    /**
+     * This is the compression level to use.
+     */
+    int level = Z_DEFAULT_COMPRESSION;
+
+    /**
+     * This is the compression strategy to use.
+     */
+    int strategy = Z_DEFAULT_STRATEGY;
+
+    /**
+     * This is the number of bytes of input compressed by each task.
+     */
+    size_t blockSize = 128 * 1024;
+
+    /**
+     * This is the number of threads to use.  If zero, one thread is
+     * used per hardware thread of the machine.
+     */
+    size_t threads = 0;
+};
+
+/**
+ * This is the type of function used to deliver compressed output.
+ * Output is delivered in order, from the thread which called the
+ * compression function.
+ *
+ * @param[in] data
+ *     This points to the next piece of compressed output.
+ *
+ * @param[in] size
+ *     This is the number of bytes of compressed output.
+ *
+ * @return
+ *     An indication of whether or not the output was accepted is returned.
+ *     Compression stops early if the output is not accepted.
+ */
+typedef std::function< bool(const uint8_t* data, size_t size) > CompressedOutputDelegate;
+
+/**
+ * This function compresses the given data into a single gzip member.
+ * The input is split into blocks which are compressed independently on
+ * a pool of threads, each primed with the tail of the block before it as
+ * a preset dictionary so that little compression is lost at the seams.
+ * The blocks' check values are combined into the one CRC-32 written in
+ * the gzip trailer, so the result is a standard gzip stream which any
+ * gzip decoder can decompress.
+ *
+ * @param[in] input
+ *     This points to the data to compress.
+ *
+ * @param[in] inputSize
+ *     This is the number of bytes of data to compress.
+ *
+ * @param[in] configuration
+ *     This holds the settings which control the compression.
+ *
+ * @param[in] outputDelegate
+ *     This is the function to call to deliver the compressed output.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool ParallelGzip(
+    const uint8_t* input,
+    size_t inputSize,
+    const ParallelGzipConfiguration& configuration,
+    CompressedOutputDelegate outputDelegate
+);
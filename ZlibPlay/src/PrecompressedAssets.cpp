@@ -0,0 +1,678 @@
+/**
+ * @file PrecompressedAssets.cpp
+ *
+ * This module contains the implementation of the functions used to keep
+ * a gzip-compressed copy beside every file served as static content.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Checksums.hpp"
+#include "Corpus.hpp"
+#include "Deflater.hpp"
+#include "PrecompressedAssets.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <future>
+#include <inttypes.h>
+#include <Json/Value.hpp>
+#include <map>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include <SystemAbstractions/File.hpp>
+
+namespace {
+
+    /**
+     * This is the name of the manifest kept in each directory precompressed.
+     */
+    const std::string MANIFEST_NAME = ".precompressed";
+
+    /**
+     * This is the first line of every manifest.
+     */
+    const std::string MANIFEST_HEADER = "ZlibPlay precompressed assets";
+
+    /**
+     * This is the version of the manifest format written.
+     */
+    constexpr unsigned int MANIFEST_VERSION = 1;
+
+    /**
+     * This is added to the name of a file to get the name
+     * of its compressed copy.
+     */
+    const std::string COMPRESSED_SUFFIX = ".gz";
+
+    /**
+     * This is added to the name of a file being written, until it's
+     * complete and renamed into place.
+     */
+    const std::string TEMPORARY_SUFFIX = ".tmp";
+
+    /**
+     * This holds what the manifest records about one file.
+     */
+    struct ManifestEntry {
+        /**
+         * This is the size of the file, in bytes.
+         */
+        uint64_t size = 0;
+
+        /**
+         * This is the time the file was last modified.
+         */
+        int64_t modified = 0;
+
+        /**
+         * This is the CRC-32 of the contents of the file.
+         */
+        uint32_t crc = 0;
+
+        /**
+         * This is the size of the file's compressed copy, in bytes,
+         * or zero if it has none.
+         */
+        uint64_t compressedSize = 0;
+    };
+
+    /**
+     * This holds what the manifest records about each file,
+     * keyed by the path of the file relative to the directory.
+     */
+    typedef std::map< std::string, ManifestEntry > Manifest;
+
+    /**
+     * This holds one file to be checked, and compressed if needed,
+     * on the thread pool.
+     */
+    struct Job {
+        /**
+         * This is the path of the file.
+         */
+        std::string path;
+
+        /**
+         * This is what the manifest recorded about the file, if anything.
+         */
+        std::shared_ptr< ManifestEntry > previous;
+
+        /**
+         * This is what the manifest should now record about the file.
+         */
+        ManifestEntry entry;
+
+        /**
+         * These are the possible outcomes of a job.
+         */
+        enum class Outcome {
+            Compressed,
+            Touched,
+            Incompressible,
+            Failed,
+        };
+
+        /**
+         * This is used to report the outcome of the job.
+         */
+        std::promise< Outcome > completion;
+    };
+
+    /**
+     * This function checks whether or not the given string ends
+     * with the given suffix.
+     *
+     * @param[in] s
+     *     This is the string to check.
+     *
+     * @param[in] suffix
+     *     This is the suffix to look for.
+     *
+     * @return
+     *     An indication of whether or not the string ends with the suffix
+     *     is returned.
+     */
+    bool EndsWith(
+        const std::string& s,
+        const std::string& suffix
+    ) {
+        return (
+            (s.length() >= suffix.length())
+            && (s.compare(s.length() - suffix.length(), suffix.length(), suffix) == 0)
+        );
+    }
+
+    /**
+     * This function checks whether or not the given character
+     * separates the parts of a path.
+     *
+     * @param[in] c
+     *     This is the character to check.
+     *
+     * @return
+     *     An indication of whether or not the character separates
+     *     the parts of a path is returned.
+     */
+    bool IsPathSeparator(char c) {
+        return (
+            (c == '/')
+            || (c == '\\')
+        );
+    }
+
+    /**
+     * This function replaces the file at the given path with the file
+     * at the given temporary path.
+     *
+     * @param[in] temporaryPath
+     *     This is the path of the complete new file.
+     *
+     * @param[in] path
+     *     This is the path of the file to replace.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool ReplaceFile(
+        const std::string& temporaryPath,
+        const std::string& path
+    ) {
+#ifdef _WIN32
+        // On Windows, rename won't replace an existing file.
+        (void)remove(path.c_str());
+#endif /* _WIN32 */
+        if (rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            fprintf(stderr, "error: unable to rename '%s' to '%s'\n", temporaryPath.c_str(), path.c_str());
+            (void)remove(temporaryPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * This function writes the given data to a temporary file and then
+     * renames it into place, so that the server never sees a partly
+     * written file.
+     *
+     * @param[in] path
+     *     This is the path of the file to write.
+     *
+     * @param[in] data
+     *     This is the data to write.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool WriteFileInPlace(
+        const std::string& path,
+        const std::vector< uint8_t >& data
+    ) {
+        const auto temporaryPath = path + TEMPORARY_SUFFIX;
+        auto file = fopen(temporaryPath.c_str(), "wb");
+        if (file == NULL) {
+            fprintf(stderr, "error: unable to open '%s' for writing\n", temporaryPath.c_str());
+            return false;
+        }
+        const auto written = (
+            data.empty()
+            || (fwrite(data.data(), data.size(), 1, file) == 1)
+        );
+        if (
+            (fclose(file) != 0)
+            || !written
+        ) {
+            fprintf(stderr, "error: unable to write '%s'\n", temporaryPath.c_str());
+            (void)remove(temporaryPath.c_str());
+            return false;
+        }
+        return ReplaceFile(temporaryPath, path);
+    }
+
+    /**
+     * This function checks whether or not the compressed copy of the file
+     * at the given path is as the given manifest entry records it.
+     *
+     * @param[in] path
+     *     This is the path of the file whose compressed copy to check.
+     *
+     * @param[in] entry
+     *     This is what the manifest records about the file.
+     *
+     * @return
+     *     An indication of whether or not the compressed copy is as
+     *     the manifest records it is returned.
+     */
+    bool IsCompressedCopyIntact(
+        const std::string& path,
+        const ManifestEntry& entry
+    ) {
+        SystemAbstractions::File compressedFile(path + COMPRESSED_SUFFIX);
+        if (entry.compressedSize == 0) {
+            return !compressedFile.IsExisting();
+        }
+        return (
+            compressedFile.IsExisting()
+            && (compressedFile.GetSize() == entry.compressedSize)
+        );
+    }
+
+    /**
+     * This function reads the manifest in the given directory.
+     * A missing manifest is treated as an empty one.
+     *
+     * @param[in] root
+     *     This is the directory whose manifest to read.
+     *
+     * @param[out] level
+     *     This is where to store the compression level recorded in the
+     *     manifest, or -1 if there's no manifest.
+     *
+     * @param[out] manifest
+     *     This is where to store what the manifest records about each file.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool LoadManifest(
+        const std::string& root,
+        int& level,
+        Manifest& manifest
+    ) {
+        level = -1;
+        manifest.clear();
+        const auto path = root + "/" + MANIFEST_NAME;
+        if (!SystemAbstractions::File(path).IsExisting()) {
+            return true;
+        }
+        std::vector< uint8_t > content;
+        if (!ReadWholeFile(path, content)) {
+            return false;
+        }
+        const std::string text(content.begin(), content.end());
+        size_t lineStart = 0;
+        size_t lineNumber = 0;
+        while (lineStart < text.length()) {
+            auto lineEnd = text.find('\n', lineStart);
+            if (lineEnd == std::string::npos) {
+                lineEnd = text.length();
+            }
+            const auto line = text.substr(lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 1;
+            if (++lineNumber == 1) {
+                unsigned int version;
+                if (
+                    (line.compare(0, MANIFEST_HEADER.length(), MANIFEST_HEADER) != 0)
+                    || (sscanf(line.c_str() + MANIFEST_HEADER.length(), " %u %d", &version, &level) != 2)
+                    || (version != MANIFEST_VERSION)
+                ) {
+                    fprintf(stderr, "warning: ignoring unrecognized manifest '%s'\n", path.c_str());
+                    level = -1;
+                    return true;
+                }
+                continue;
+            }
+            ManifestEntry entry;
+            int pathOffset = 0;
+            if (
+                (
+                    sscanf(
+                        line.c_str(),
+                        "%" SCNu64 " %" SCNd64 " %" SCNx32 " %" SCNu64 "%n",
+                        &entry.size,
+                        &entry.modified,
+                        &entry.crc,
+                        &entry.compressedSize,
+                        &pathOffset
+                    ) != 4
+                )
+                || (pathOffset == 0)
+                || ((size_t)pathOffset + 1 >= line.length())
+                || (line[(size_t)pathOffset] != ' ')
+            ) {
+                fprintf(stderr, "warning: ignoring bad line %zu of manifest '%s'\n", lineNumber, path.c_str());
+                continue;
+            }
+            // Skip exactly the one space separating the path, since
+            // the path itself may begin with spaces.
+            manifest[line.substr((size_t)pathOffset + 1)] = entry;
+        }
+        return true;
+    }
+
+    /**
+     * This function writes the manifest in the given directory.
+     *
+     * @param[in] root
+     *     This is the directory whose manifest to write.
+     *
+     * @param[in] level
+     *     This is the compression level used for the compressed copies.
+     *
+     * @param[in] manifest
+     *     This holds what to record about each file.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool SaveManifest(
+        const std::string& root,
+        int level,
+        const Manifest& manifest
+    ) {
+        std::string text = MANIFEST_HEADER + " " + std::to_string(MANIFEST_VERSION) + " " + std::to_string(level) + "\n";
+        for (const auto& manifestEntry: manifest) {
+            const auto& entry = manifestEntry.second;
+            char numbers[80];
+            (void)snprintf(
+                numbers,
+                sizeof(numbers),
+                "%" PRIu64 " %" PRId64 " %08" PRIx32 " %" PRIu64 " ",
+                entry.size,
+                entry.modified,
+                entry.crc,
+                entry.compressedSize
+            );
+            text += numbers;
+            text += manifestEntry.first;
+            text += "\n";
+        }
+        return WriteFileInPlace(
+            root + "/" + MANIFEST_NAME,
+            std::vector< uint8_t >(text.begin(), text.end())
+        );
+    }
+
+    /**
+     * This function recursively finds the files beneath the given
+     * directory, leaving out compressed copies, files being written,
+     * and the manifest.
+     *
+     * @param[in] directory
+     *     This is the directory to walk.
+     *
+     * @param[in,out] filePaths
+     *     This is where to add the paths of the files found.
+     */
+    void ListSourceFiles(
+        const std::string& directory,
+        std::vector< std::string >& filePaths
+    ) {
+        std::vector< std::string > children;
+        SystemAbstractions::File::ListDirectory(directory, children);
+        for (const auto& child: children) {
+            if (SystemAbstractions::File(child).IsDirectory()) {
+                ListSourceFiles(child, filePaths);
+            } else if (
+                !EndsWith(child, COMPRESSED_SUFFIX)
+                && !EndsWith(child, TEMPORARY_SUFFIX)
+                && !EndsWith(child, "/" + MANIFEST_NAME)
+            ) {
+                filePaths.push_back(child);
+            }
+        }
+    }
+
+    /**
+     * This function returns the path of the given file under the given
+     * directory, relative to the directory.
+     *
+     * @param[in] directory
+     *     This is the directory containing the file.
+     *
+     * @param[in] filePath
+     *     This is the path of the file, which begins with the path of
+     *     the directory.
+     *
+     * @return
+     *     The path of the file relative to the directory is returned.
+     */
+    std::string GetRelativePath(
+        const std::string& directory,
+        const std::string& filePath
+    ) {
+        auto offset = directory.length();
+        while (
+            (offset < filePath.length())
+            && IsPathSeparator(filePath[offset])
+        ) {
+            ++offset;
+        }
+        return filePath.substr(offset);
+    }
+
+    /**
+     * This function reads one file and writes its compressed copy,
+     * unless the file's contents are the same as when the existing
+     * copy was made.
+     *
+     * @param[in,out] job
+     *     This holds the file to compress, and receives what the manifest
+     *     should record about it.
+     *
+     * @param[in] level
+     *     This is the compression level to use.
+     *
+     * @return
+     *     The outcome of the job is returned.
+     */
+    Job::Outcome CompressAsset(
+        Job& job,
+        int level
+    ) {
+        std::vector< uint8_t > content;
+        if (!ReadWholeFile(job.path, content)) {
+            return Job::Outcome::Failed;
+        }
+        job.entry.size = content.size();
+        job.entry.crc = Crc32(0, content.data(), content.size());
+        if (
+            (job.previous != nullptr)
+            && (job.previous->size == job.entry.size)
+            && (job.previous->crc == job.entry.crc)
+            && IsCompressedCopyIntact(job.path, *job.previous)
+        ) {
+            job.entry.compressedSize = job.previous->compressedSize;
+            return Job::Outcome::Touched;
+        }
+        Deflater deflater;
+        DeflaterConfiguration configuration;
+        configuration.level = level;
+        configuration.windowBits = 16 + MAX_WBITS;
+        configuration.memLevel = MAX_MEM_LEVEL;
+        configuration.chunkSize = std::max((size_t)16384, content.size() / 2);
+        std::vector< uint8_t > compressed;
+        if (
+            !deflater.Initialize(configuration)
+            || !deflater.Compress(content.data(), content.size(), compressed)
+        ) {
+            fprintf(stderr, "error: unable to compress '%s'\n", job.path.c_str());
+            return Job::Outcome::Failed;
+        }
+        const auto compressedPath = job.path + COMPRESSED_SUFFIX;
+        if (compressed.size() >= content.size()) {
+            job.entry.compressedSize = 0;
+            (void)remove(compressedPath.c_str());
+            return Job::Outcome::Incompressible;
+        }
+        if (!WriteFileInPlace(compressedPath, compressed)) {
+            return Job::Outcome::Failed;
+        }
+        job.entry.compressedSize = compressed.size();
+        return Job::Outcome::Compressed;
+    }
+
+}
+
+bool ListStaticContentRoots(
+    const std::string& configurationPath,
+    const std::string& base,
+    std::vector< std::string >& roots
+) {
+    std::vector< uint8_t > encoding;
+    if (!ReadWholeFile(configurationPath, encoding)) {
+        return false;
+    }
+    const auto configuration = Json::Value::FromEncoding(
+        std::string(encoding.begin(), encoding.end())
+    );
+    if (
+        !configuration.Has("plugins")
+        || !configuration["plugins"].Has("StaticContentPlugin")
+        || !configuration["plugins"]["StaticContentPlugin"].Has("configuration")
+    ) {
+        fprintf(stderr, "error: '%s' does not configure the static content plug-in\n", configurationPath.c_str());
+        return false;
+    }
+    const auto pluginConfiguration = configuration["plugins"]["StaticContentPlugin"]["configuration"];
+
+    // The plug-in takes either a list of spaces, or a single space
+    // given directly in its configuration.
+    std::vector< Json::Value > spaces;
+    if (pluginConfiguration.Has("spaces")) {
+        const auto spacesConfiguration = pluginConfiguration["spaces"];
+        for (size_t i = 0; i < spacesConfiguration.GetSize(); ++i) {
+            spaces.push_back(spacesConfiguration[i]);
+        }
+    } else {
+        spaces.push_back(pluginConfiguration);
+    }
+    for (const auto& space: spaces) {
+        if (!space.Has("root")) {
+            continue;
+        }
+        const std::string root = space["root"];
+        if (
+            base.empty()
+            || root.empty()
+            || (root[0] == '/')
+            || (root[0] == '\\')
+            || (
+                (root.length() >= 2)
+                && (root[1] == ':')
+            )
+        ) {
+            roots.push_back(root);
+        } else {
+            roots.push_back(base + "/" + root);
+        }
+    }
+    if (roots.empty()) {
+        fprintf(stderr, "error: '%s' configures no static content roots\n", configurationPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool PrecompressDirectory(
+    const std::string& rootPath,
+    const PrecompressConfiguration& configuration,
+    PrecompressStatistics& statistics
+) {
+    // Drop any trailing separators from the root, so that paths built
+    // from it, and the manifest keys taken from them, are the same
+    // however the root was given.
+    auto root = rootPath;
+    while (
+        (root.length() > 1)
+        && IsPathSeparator(root.back())
+    ) {
+        root.pop_back();
+    }
+    SystemAbstractions::File rootDirectory(root);
+    if (!rootDirectory.IsDirectory()) {
+        fprintf(stderr, "error: '%s' is not a directory\n", root.c_str());
+        return false;
+    }
+    int manifestLevel;
+    Manifest previousManifest;
+    if (!LoadManifest(root, manifestLevel, previousManifest)) {
+        return false;
+    }
+    const auto rebuildAll = (
+        configuration.force
+        || (manifestLevel != configuration.level)
+    );
+
+    // Decide which files need to be read, and hand those to the pool.
+    std::vector< std::string > filePaths;
+    ListSourceFiles(root, filePaths);
+    statistics.files += filePaths.size();
+    Manifest manifest;
+    std::vector< std::pair< std::string, std::shared_ptr< Job > > > jobs;
+    ThreadPool pool(configuration.threads);
+    for (const auto& filePath: filePaths) {
+        const auto relativePath = GetRelativePath(root, filePath);
+        SystemAbstractions::File file(filePath);
+        const auto job = std::make_shared< Job >();
+        job->path = filePath;
+        job->entry.size = file.GetSize();
+        job->entry.modified = (int64_t)file.GetLastModifiedTime();
+        const auto previousEntry = previousManifest.find(relativePath);
+        if (previousEntry != previousManifest.end()) {
+            const auto& previous = previousEntry->second;
+            if (
+                !rebuildAll
+                && (previous.size == job->entry.size)
+                && (previous.modified == job->entry.modified)
+                && IsCompressedCopyIntact(filePath, previous)
+            ) {
+                manifest[relativePath] = previous;
+                ++statistics.unchanged;
+                continue;
+            }
+            if (!rebuildAll) {
+                job->previous = std::make_shared< ManifestEntry >(previous);
+            }
+        }
+        jobs.emplace_back(relativePath, job);
+        const auto level = configuration.level;
+        pool.Post(
+            [job, level]{
+                job->completion.set_value(CompressAsset(*job, level));
+            }
+        );
+    }
+
+    // Collect the results.
+    bool succeeded = true;
+    for (const auto& relativePathAndJob: jobs) {
+        const auto& job = relativePathAndJob.second;
+        const auto outcome = job->completion.get_future().get();
+        if (outcome == Job::Outcome::Failed) {
+            // Leave the file out of the manifest,
+            // so that it's tried again next time.
+            succeeded = false;
+            continue;
+        }
+        if (outcome == Job::Outcome::Compressed) {
+            ++statistics.compressed;
+            statistics.inputBytes += job->entry.size;
+            statistics.outputBytes += job->entry.compressedSize;
+        } else if (outcome == Job::Outcome::Touched) {
+            ++statistics.touched;
+        } else {
+            ++statistics.incompressible;
+        }
+        manifest[relativePathAndJob.first] = job->entry;
+    }
+
+    // Remove compressed copies of files which are gone.
+    for (const auto& previousEntry: previousManifest) {
+        if (
+            (manifest.find(previousEntry.first) == manifest.end())
+            && (previousEntry.second.compressedSize > 0)
+            && !SystemAbstractions::File(root + "/" + previousEntry.first).IsExisting()
+        ) {
+            const auto compressedPath = root + "/" + previousEntry.first + COMPRESSED_SUFFIX;
+            if (remove(compressedPath.c_str()) == 0) {
+                ++statistics.removed;
+            }
+        }
+    }
+    return (
+        SaveManifest(root, configuration.level, manifest)
+        && succeeded
+    );
+}
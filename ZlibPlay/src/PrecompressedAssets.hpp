@@ -0,0 +1,143 @@
+#pragma once
+
+/**
+ * @file PrecompressedAssets.hpp
+ *
+ * This module declares the functions used to keep a gzip-compressed copy
+ * beside every file served as static content, so that the server can send
+ * compressed responses without compressing anything per request.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+/**
+ * This holds the settings which control precompressing static content.
+ */
+struct PrecompressConfiguration {
+    /**
+     * This is the compression level to use.
+     */
+    int level = Z_BEST_COMPRESSION;
+
+    /**
+     * This is the number of threads to use.  If zero, one thread is
+     * used per hardware thread of the machine.
+     */
+    size_t threads = 0;
+
+    /**
+     * This indicates whether or not to compress every file again,
+     * even those whose compressed copies are up to date.
+     */
+    bool force = false;
+};
+
+/**
+ * This holds what was done to precompress static content.
+ */
+struct PrecompressStatistics {
+    /**
+     * This is the number of files found.
+     */
+    size_t files = 0;
+
+    /**
+     * This is the number of files compressed.
+     */
+    size_t compressed = 0;
+
+    /**
+     * This is the number of files whose size and modification time
+     * haven't changed, and so weren't read.
+     */
+    size_t unchanged = 0;
+
+    /**
+     * This is the number of files whose modification time changed,
+     * but whose contents didn't, and so weren't compressed.
+     */
+    size_t touched = 0;
+
+    /**
+     * This is the number of files given no compressed copy,
+     * because compressing them didn't make them smaller.
+     */
+    size_t incompressible = 0;
+
+    /**
+     * This is the number of compressed copies removed because
+     * the files they were made from are gone.
+     */
+    size_t removed = 0;
+
+    /**
+     * This is the number of bytes of files compressed.
+     */
+    uint64_t inputBytes = 0;
+
+    /**
+     * This is the number of bytes of compressed copies written.
+     */
+    uint64_t outputBytes = 0;
+};
+
+/**
+ * This function reads the web server configuration file at the given path
+ * and returns the root directory of every space configured for the static
+ * content plug-in.
+ *
+ * @param[in] configurationPath
+ *     This is the path of the web server configuration file.
+ *
+ * @param[in] base
+ *     This is the directory against which to resolve roots given
+ *     as relative paths.  If empty, they are left relative to the
+ *     current working directory, as the server does.
+ *
+ * @param[out] roots
+ *     This is where to store the root directories found.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool ListStaticContentRoots(
+    const std::string& configurationPath,
+    const std::string& base,
+    std::vector< std::string >& roots
+);
+
+/**
+ * This function walks the given directory and makes sure that every file
+ * beneath it has an up-to-date compressed copy beside it, with ".gz" added
+ * to its name.  Files are compressed in parallel.
+ *
+ * A manifest kept in the directory records the size, modification time,
+ * and CRC-32 of each file as of when it was last compressed.  A file whose
+ * size and modification time match the manifest isn't read at all; one
+ * whose modification time changed but whose size and CRC-32 match isn't
+ * compressed again.  Compressed copies of files no longer present are
+ * removed.  Files which don't get smaller when compressed get no copy.
+ *
+ * @param[in] root
+ *     This is the directory whose files to compress.
+ *
+ * @param[in] configuration
+ *     This holds the settings which control the compression.
+ *
+ * @param[in,out] statistics
+ *     This is where to add up what was done.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool PrecompressDirectory(
+    const std::string& root,
+    const PrecompressConfiguration& configuration,
+    PrecompressStatistics& statistics
+);
@@ -0,0 +1,301 @@
+/**
+ * @file StreamingCompression.cpp
+ *
+ * This module contains the implementation of the functions used to
+ * compress one file into another without holding either of them in memory.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "MappedFile.hpp"
+#include "StreamingCompression.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    /**
+     * This writes buffers to a file on a separate thread, so that the
+     * thread producing the data can go on filling another buffer while
+     * a previous one is written.  Only one buffer is handed over at a time.
+     */
+    class BackgroundWriter {
+        // Lifecycle management
+    public:
+        /**
+         * This is the destructor.  It waits for any buffer being written
+         * and then stops the writer thread.
+         */
+        ~BackgroundWriter() noexcept {
+            {
+                std::lock_guard< std::mutex > lock(mutex_);
+                stop_ = true;
+                wakeCondition_.notify_all();
+            }
+            thread_.join();
+        }
+        BackgroundWriter(const BackgroundWriter&) = delete;
+        BackgroundWriter(BackgroundWriter&&) noexcept = delete;
+        BackgroundWriter& operator=(const BackgroundWriter&) = delete;
+        BackgroundWriter& operator=(BackgroundWriter&&) noexcept = delete;
+
+        // Public Methods
+    public:
+        /**
+         * This is the constructor.
+         *
+         * @param[in] file
+         *     This is the file to which to write.
+         */
+        explicit BackgroundWriter(FILE* file)
+            : file_(file)
+            , thread_(&BackgroundWriter::Worker, this)
+        {
+        }
+
+        /**
+         * This method hands the given data to the writer thread, after
+         * waiting for it to finish writing whatever it was given before.
+         * The data must remain unchanged until the next call to this method
+         * or to the Finish method.
+         *
+         * @param[in] data
+         *     This points to the data to write.
+         *
+         * @param[in] size
+         *     This is the number of bytes to write.
+         *
+         * @return
+         *     An indication of whether or not all data handed to the
+         *     writer so far has been written successfully is returned.
+         */
+        bool Write(
+            const uint8_t* data,
+            size_t size
+        ) {
+            std::unique_lock< std::mutex > lock(mutex_);
+            idleCondition_.wait(lock, [this]{ return pendingData_ == nullptr; });
+            pendingData_ = data;
+            pendingSize_ = size;
+            wakeCondition_.notify_one();
+            return !failed_;
+        }
+
+        /**
+         * This method waits for the writer thread to finish writing
+         * whatever it was given.
+         *
+         * @return
+         *     An indication of whether or not all data handed to the
+         *     writer has been written successfully is returned.
+         */
+        bool Finish() {
+            std::unique_lock< std::mutex > lock(mutex_);
+            idleCondition_.wait(lock, [this]{ return pendingData_ == nullptr; });
+            return !failed_;
+        }
+
+        // Private Methods
+    private:
+        /**
+         * This method is the body of the writer thread.
+         */
+        void Worker() {
+            std::unique_lock< std::mutex > lock(mutex_);
+            for (;;) {
+                wakeCondition_.wait(lock, [this]{ return stop_ || (pendingData_ != nullptr); });
+                if (pendingData_ == nullptr) {
+                    return;
+                }
+                const auto data = pendingData_;
+                const auto size = pendingSize_;
+                lock.unlock();
+                const auto written = fwrite(data, 1, size, file_);
+                lock.lock();
+                if (written != size) {
+                    failed_ = true;
+                }
+                pendingData_ = nullptr;
+                idleCondition_.notify_all();
+            }
+        }
+
+        // Private Properties
+    private:
+        /**
+         * This is the file to which to write.
+         */
+        FILE* file_;
+
+        /**
+         * This is used to synchronize access to the object.
+         */
+        std::mutex mutex_;
+
+        /**
+         * This is used to wake the writer thread when there is data
+         * to write or when it should stop.
+         */
+        std::condition_variable wakeCondition_;
+
+        /**
+         * This is used to wake the producer when the writer thread
+         * has finished writing.
+         */
+        std::condition_variable idleCondition_;
+
+        /**
+         * This points to the data waiting to be written, if any.
+         */
+        const uint8_t* pendingData_ = nullptr;
+
+        /**
+         * This is the number of bytes waiting to be written.
+         */
+        size_t pendingSize_ = 0;
+
+        /**
+         * This indicates whether or not any write has failed.
+         */
+        bool failed_ = false;
+
+        /**
+         * This indicates whether or not the writer thread should stop.
+         */
+        bool stop_ = false;
+
+        /**
+         * This is the writer thread.
+         */
+        std::thread thread_;
+    };
+
+}
+
+bool CompressFile(
+    const std::string& inputPath,
+    const std::string& outputPath,
+    const StreamingCompressionConfiguration& configuration,
+    StreamingCompressionStatistics& statistics
+) {
+    MappedFile input;
+    if (!input.Open(inputPath)) {
+        fprintf(stderr, "error: unable to open '%s'\n", inputPath.c_str());
+        return false;
+    }
+    const auto fileHandle = std::unique_ptr< FILE, std::function< void(FILE*) > >(
+        fopen(outputPath.c_str(), "wb"),
+        [](FILE*f){
+            if (f != NULL) {
+                (void)fclose(f);
+            }
+        }
+    );
+    if (fileHandle == NULL) {
+        fprintf(stderr, "error: unable to open '%s'\n", outputPath.c_str());
+        return false;
+    }
+
+    // The output buffers are already large, so have the standard library
+    // write them straight through rather than copying them again.
+    (void)setvbuf(fileHandle.get(), NULL, _IONBF, 0);
+
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    if (
+        deflateInit2(
+            &stream,
+            configuration.level,
+            Z_DEFLATED,
+            configuration.windowBits,
+            8,
+            configuration.strategy
+        ) != Z_OK
+    ) {
+        fprintf(stderr, "error: deflateInit2 failed\n");
+        return false;
+    }
+    std::vector< uint8_t > buffers[2] = {
+        std::vector< uint8_t >(configuration.bufferSize),
+        std::vector< uint8_t >(configuration.bufferSize),
+    };
+    size_t currentBuffer = 0;
+    stream.next_out = (Bytef*)buffers[currentBuffer].data();
+    stream.avail_out = (uInt)configuration.bufferSize;
+    const auto inputSize = input.GetSize();
+    uint64_t offset = 0;
+    int result = Z_OK;
+    bool succeeded = true;
+    {
+        BackgroundWriter writer(fileHandle.get());
+        do {
+            const auto windowSize = (size_t)std::min(
+                (uint64_t)configuration.mapWindowSize,
+                inputSize - offset
+            );
+            const auto window = input.Map(offset, windowSize);
+            if (window == nullptr) {
+                fprintf(stderr, "error: unable to map '%s'\n", inputPath.c_str());
+                succeeded = false;
+                break;
+            }
+            stream.next_in = (Bytef*)window;
+            stream.avail_in = (uInt)windowSize;
+            offset += windowSize;
+            const auto flush = (offset == inputSize) ? Z_FINISH : Z_NO_FLUSH;
+            do {
+                result = deflate(&stream, flush);
+                if (result == Z_STREAM_ERROR) {
+                    fprintf(stderr, "error: deflate failed (%d: %s)\n", result, stream.msg);
+                    succeeded = false;
+                    break;
+                }
+                if (stream.avail_out == 0) {
+                    if (!writer.Write(buffers[currentBuffer].data(), configuration.bufferSize)) {
+                        succeeded = false;
+                        break;
+                    }
+                    statistics.outputBytes += configuration.bufferSize;
+                    currentBuffer = 1 - currentBuffer;
+                    stream.next_out = (Bytef*)buffers[currentBuffer].data();
+                    stream.avail_out = (uInt)configuration.bufferSize;
+                }
+            } while (
+                (stream.avail_in > 0)
+                || (
+                    (flush == Z_FINISH)
+                    && (result != Z_STREAM_END)
+                )
+            );
+            statistics.inputBytes += windowSize;
+        } while (
+            succeeded
+            && (offset < inputSize)
+        );
+        const auto remainder = configuration.bufferSize - stream.avail_out;
+        if (
+            succeeded
+            && (remainder > 0)
+        ) {
+            succeeded = writer.Write(buffers[currentBuffer].data(), remainder);
+            statistics.outputBytes += remainder;
+        }
+        if (!writer.Finish()) {
+            succeeded = false;
+        }
+    }
+    (void)deflateEnd(&stream);
+    if (!succeeded) {
+        fprintf(stderr, "error: unable to compress '%s' into '%s'\n", inputPath.c_str(), outputPath.c_str());
+    }
+    return succeeded;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+/**
+ * @file StreamingCompression.hpp
+ *
+ * This module declares the functions used to compress one file into
+ * another without holding either of them in memory.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <zlib.h>
+
+/**
+ * This holds the settings which control streaming file compression.
+ */
+struct StreamingCompressionConfiguration {
+    /**
+     * This is the compression level to use.
+     */
+    int level = Z_DEFAULT_COMPRESSION;
+
+    /**
+     * This is the compression strategy to use.
+     */
+    int strategy = Z_DEFAULT_STRATEGY;
+
+    /**
+     * This is the windowBits value to give to deflateInit2.
+     * The default selects the gzip wrapper with the largest window.
+     */
+    int windowBits = 16 + MAX_WBITS;
+
+    /**
+     * This is the size, in bytes, of each of the two buffers used to
+     * hand compressed output to the thread which writes it to the file.
+     */
+    size_t bufferSize = 1024 * 1024;
+
+    /**
+     * This is the number of bytes of input mapped into memory at a time.
+     */
+    size_t mapWindowSize = 16 * 1024 * 1024;
+};
+
+/**
+ * This holds what was observed while compressing a file.
+ */
+struct StreamingCompressionStatistics {
+    /**
+     * This is the number of bytes read from the input file.
+     */
+    uint64_t inputBytes = 0;
+
+    /**
+     * This is the number of bytes written to the output file.
+     */
+    uint64_t outputBytes = 0;
+};
+
+/**
+ * This function compresses the file at the given input path, writing the
+ * result to the file at the given output path.  The input is mapped into
+ * memory one window at a time and fed straight to zlib, whose output is
+ * collected in a fixed pair of buffers: while one is being filled, the
+ * other is being written to the output file by a separate thread.  Memory
+ * use therefore does not depend on the size of the file.
+ *
+ * @param[in] inputPath
+ *     This is the path of the file to compress.
+ *
+ * @param[in] outputPath
+ *     This is the path of the file to which to write the compressed data.
+ *
+ * @param[in] configuration
+ *     This holds the settings which control the compression.
+ *
+ * @param[out] statistics
+ *     This is where to store what was observed during compression.
+ *
+ * @return
+ *     An indication of whether or not the function succeeded is returned.
+ */
+bool CompressFile(
+    const std::string& inputPath,
+    const std::string& outputPath,
+    const StreamingCompressionConfiguration& configuration,
+    StreamingCompressionStatistics& statistics
+);
@@ -0,0 +1,106 @@
+/**
+ * @file ThreadPool.cpp
+ *
+ * This module contains the implementation of the ThreadPool class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * This contains the private properties of a ThreadPool instance.
+ */
+struct ThreadPool::Impl {
+    // Properties
+
+    /**
+     * This is used to synchronize access to the object.
+     */
+    std::mutex mutex;
+
+    /**
+     * This is used to wake up worker threads when a task is posted
+     * or the pool is shutting down.
+     */
+    std::condition_variable wakeCondition;
+
+    /**
+     * These are the tasks waiting to be run.
+     */
+    std::deque< Task > tasks;
+
+    /**
+     * This indicates whether or not the worker threads should stop
+     * once the queue is empty.
+     */
+    bool stop = false;
+
+    /**
+     * These are the worker threads.
+     */
+    std::vector< std::thread > workers;
+
+    // Methods
+
+    /**
+     * This method is the body of each worker thread.  It runs tasks
+     * from the queue until told to stop.
+     */
+    void Worker() {
+        std::unique_lock< std::mutex > lock(mutex);
+        for (;;) {
+            wakeCondition.wait(
+                lock,
+                [this]{ return stop || !tasks.empty(); }
+            );
+            if (tasks.empty()) {
+                return;
+            }
+            auto task = std::move(tasks.front());
+            tasks.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+};
+
+ThreadPool::~ThreadPool() noexcept {
+    {
+        std::lock_guard< std::mutex > lock(impl_->mutex);
+        impl_->stop = true;
+        impl_->wakeCondition.notify_all();
+    }
+    for (auto& worker: impl_->workers) {
+        worker.join();
+    }
+}
+
+ThreadPool::ThreadPool(size_t numThreads)
+    : impl_(new Impl())
+{
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < numThreads; ++i) {
+        impl_->workers.emplace_back(&Impl::Worker, impl_.get());
+    }
+}
+
+size_t ThreadPool::GetNumThreads() const {
+    return impl_->workers.size();
+}
+
+void ThreadPool::Post(Task task) {
+    std::lock_guard< std::mutex > lock(impl_->mutex);
+    impl_->tasks.push_back(std::move(task));
+    impl_->wakeCondition.notify_one();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+/**
+ * @file ThreadPool.hpp
+ *
+ * This module declares the ThreadPool class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <functional>
+#include <memory>
+#include <stddef.h>
+
+/**
+ * This is a fixed set of worker threads which run tasks posted to
+ * a shared queue, in the order in which they were posted.
+ */
+class ThreadPool {
+    // Types
+public:
+    /**
+     * This is the type of function which can be posted to the pool.
+     */
+    typedef std::function< void() > Task;
+
+    // Lifecycle management
+public:
+    /**
+     * This is the destructor.  It waits for all posted tasks to complete
+     * before joining the worker threads.
+     */
+    ~ThreadPool() noexcept;
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) noexcept = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+    // Public Methods
+public:
+    /**
+     * This is the constructor.
+     *
+     * @param[in] numThreads
+     *     This is the number of worker threads to start.  If zero, one
+     *     thread is started per hardware thread of the machine.
+     */
+    explicit ThreadPool(size_t numThreads = 0);
+
+    /**
+     * This method returns the number of worker threads in the pool.
+     *
+     * @return
+     *     The number of worker threads in the pool is returned.
+     */
+    size_t GetNumThreads() const;
+
+    /**
+     * This method queues the given task to be run by the next
+     * available worker thread.
+     *
+     * @param[in] task
+     *     This is the task to run.
+     */
+    void Post(Task task);
+
+    // Private Properties
+private:
+    /**
+     * This is the type of structure that contains the private
+     * properties of the instance.  It is defined in the implementation
+     * and declared here to ensure that it is scoped inside the class.
+     */
+    struct Impl;
+
+    /**
+     * This contains the private properties of the instance.
+     */
+    std::unique_ptr< Impl > impl_;
+};
@@ -0,0 +1,154 @@
+/**
+ * @file ZlibArena.cpp
+ *
+ * This module contains the implementation of the ZlibArena class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "ZlibArena.hpp"
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace {
+
+    /**
+     * This is the number of bytes placed in front of each block to record
+     * its size.  It's rounded up so that the block itself keeps the
+     * alignment given by malloc.
+     */
+    constexpr size_t HEADER_SIZE = (
+        (sizeof(size_t) + alignof(std::max_align_t) - 1)
+        / alignof(std::max_align_t)
+        * alignof(std::max_align_t)
+    );
+
+}
+
+/**
+ * This contains the private properties of a ZlibArena instance.
+ */
+struct ZlibArena::Impl {
+    // Properties
+
+    /**
+     * This is used to synchronize access to the object.
+     */
+    mutable std::mutex mutex;
+
+    /**
+     * These are the blocks held for reuse, keyed by their size.
+     * Each pointer is to the start of the header of the block.
+     */
+    std::map< size_t, std::vector< void* > > freeBlocks;
+
+    /**
+     * This is the most memory, in bytes, to hold for reuse.
+     */
+    size_t maxRetainedBytes = 0;
+
+    /**
+     * These are counters describing the arena's activity.
+     */
+    Statistics statistics;
+
+    // Methods
+
+    /**
+     * This function is given to zlib to allocate memory.
+     *
+     * @param[in] opaque
+     *     This points to the arena's private properties.
+     *
+     * @param[in] items
+     *     This is the number of items to allocate.
+     *
+     * @param[in] size
+     *     This is the size of each item to allocate.
+     *
+     * @return
+     *     A pointer to the allocated memory is returned.
+     *
+     * @retval Z_NULL
+     *     This is returned if the memory could not be allocated.
+     */
+    static voidpf Allocate(voidpf opaque, uInt items, uInt size) {
+        const auto self = (Impl*)opaque;
+        const auto blockSize = (size_t)items * (size_t)size;
+        {
+            std::lock_guard< std::mutex > lock(self->mutex);
+            ++self->statistics.allocations;
+            const auto freeBlocksEntry = self->freeBlocks.find(blockSize);
+            if (
+                (freeBlocksEntry != self->freeBlocks.end())
+                && !freeBlocksEntry->second.empty()
+            ) {
+                const auto header = freeBlocksEntry->second.back();
+                freeBlocksEntry->second.pop_back();
+                self->statistics.retainedBytes -= blockSize;
+                ++self->statistics.reuses;
+                return (uint8_t*)header + HEADER_SIZE;
+            }
+        }
+        const auto header = malloc(HEADER_SIZE + blockSize);
+        if (header == NULL) {
+            return Z_NULL;
+        }
+        *(size_t*)header = blockSize;
+        return (uint8_t*)header + HEADER_SIZE;
+    }
+
+    /**
+     * This function is given to zlib to free memory.
+     *
+     * @param[in] opaque
+     *     This points to the arena's private properties.
+     *
+     * @param[in] address
+     *     This points to the memory to free.
+     */
+    static void Free(voidpf opaque, voidpf address) {
+        const auto self = (Impl*)opaque;
+        const auto header = (void*)((uint8_t*)address - HEADER_SIZE);
+        const auto blockSize = *(const size_t*)header;
+        {
+            std::lock_guard< std::mutex > lock(self->mutex);
+            if (self->statistics.retainedBytes + blockSize <= self->maxRetainedBytes) {
+                self->freeBlocks[blockSize].push_back(header);
+                self->statistics.retainedBytes += blockSize;
+                return;
+            }
+        }
+        free(header);
+    }
+};
+
+ZlibArena::~ZlibArena() noexcept {
+    for (const auto& freeBlocksEntry: impl_->freeBlocks) {
+        for (const auto header: freeBlocksEntry.second) {
+            free(header);
+        }
+    }
+}
+
+ZlibArena::ZlibArena(size_t maxRetainedBytes)
+    : impl_(new Impl())
+{
+    impl_->maxRetainedBytes = maxRetainedBytes;
+}
+
+void ZlibArena::Attach(z_stream& stream) {
+    stream.zalloc = &Impl::Allocate;
+    stream.zfree = &Impl::Free;
+    stream.opaque = impl_.get();
+}
+
+auto ZlibArena::GetStatistics() const -> Statistics {
+    std::lock_guard< std::mutex > lock(impl_->mutex);
+    return impl_->statistics;
+}
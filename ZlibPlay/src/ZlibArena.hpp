@@ -0,0 +1,101 @@
+#pragma once
+
+/**
+ * @file ZlibArena.hpp
+ *
+ * This module declares the ZlibArena class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <memory>
+#include <stddef.h>
+#include <zlib.h>
+
+/**
+ * This is a memory allocator for zlib streams which keeps the memory freed
+ * by one stream and hands it to the next one which asks for a block of the
+ * same size.  zlib allocates the same few blocks (its state, window, and
+ * hash tables, a few hundred kilobytes in all) every time a stream with the
+ * same settings is initialized, so recycling them avoids most of the cost
+ * of initializing and ending streams in quick succession.
+ *
+ * An arena may be shared by streams on different threads.  It must
+ * outlive every stream attached to it.
+ */
+class ZlibArena {
+    // Types
+public:
+    /**
+     * This holds counters describing the arena's activity.
+     */
+    struct Statistics {
+        /**
+         * This is the number of blocks requested by zlib.
+         */
+        size_t allocations = 0;
+
+        /**
+         * This is the number of requests satisfied by recycling a block.
+         */
+        size_t reuses = 0;
+
+        /**
+         * This is the number of bytes currently held for reuse.
+         */
+        size_t retainedBytes = 0;
+    };
+
+    // Lifecycle management
+public:
+    /**
+     * This is the destructor.  It releases all memory held for reuse.
+     */
+    ~ZlibArena() noexcept;
+    ZlibArena(const ZlibArena&) = delete;
+    ZlibArena(ZlibArena&&) noexcept = delete;
+    ZlibArena& operator=(const ZlibArena&) = delete;
+    ZlibArena& operator=(ZlibArena&&) noexcept = delete;
+
+    // Public Methods
+public:
+    /**
+     * This is the constructor.
+     *
+     * @param[in] maxRetainedBytes
+     *     This is the most memory, in bytes, to hold for reuse.
+     *     Blocks freed beyond this limit are returned to the system.
+     */
+    explicit ZlibArena(size_t maxRetainedBytes = 16 * 1024 * 1024);
+
+    /**
+     * This method sets up the given stream to allocate its memory from
+     * the arena.  It must be called before the stream is initialized.
+     *
+     * @param[in,out] stream
+     *     This is the stream to set up.
+     */
+    void Attach(z_stream& stream);
+
+    /**
+     * This method returns counters describing the arena's activity.
+     *
+     * @return
+     *     Counters describing the arena's activity are returned.
+     */
+    Statistics GetStatistics() const;
+
+    // Private Properties
+private:
+    /**
+     * This is the type of structure that contains the private
+     * properties of the instance.  It is defined in the implementation
+     * and declared here to ensure that it is scoped inside the class.
+     */
+    struct Impl;
+
+    /**
+     * This contains the private properties of the instance.
+     */
+    std::unique_ptr< Impl > impl_;
+};
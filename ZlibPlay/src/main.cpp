@@ -7,29 +7,74 @@
  * © 2018 by Richard Walters
  */
 
+#include "Benchmark.hpp"
+#include "Checksums.hpp"
+#include "CompressionTuning.hpp"
+#include "Corpus.hpp"
+#include "Deflater.hpp"
+#include "Dictionary.hpp"
+#include "GzipIndex.hpp"
+#include "Inflater.hpp"
+#include "MappedFile.hpp"
+#include "ParallelGunzip.hpp"
+#include "ParallelGzip.hpp"
+#include "PrecompressedAssets.hpp"
+#include "StreamingCompression.hpp"
+
+#include <chrono>
+#include <errno.h>
 #include <functional>
 #include <inttypes.h>
 #include <memory>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <string>
+#include <SystemAbstractions/File.hpp>
 #include <vector>
 #include <zlib.h>
 
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif /* not _WIN32 */
+
 namespace {
 
     /**
-     * This is the number of bytes that we will allocate at a time while
-     * deflating data.
+     * This is the number of bytes of deflated data that we will receive
+     * at a time while playing with deflate.
      */
     constexpr size_t DEFLATE_BUFFER_INCREMENT = 256;
 
     /**
-     * This is the number of bytes that we will allocate for the buffer used to
-     * receive inflated data.
+     * This is the number of bytes of inflated data that we will receive
+     * at a time while playing with inflate.
      */
     constexpr size_t INFLATE_BUFFER_SIZE = 256;
 
+    /**
+     * This is the largest buffer size, in bytes, accepted for benchmarking.
+     */
+    constexpr size_t MAX_BENCHMARK_BUFFER_SIZE = 1 << 30;
+
+    /**
+     * This is the largest block size, in bytes, accepted for parallel
+     * compression.
+     */
+    constexpr size_t MAX_BLOCK_SIZE = 1 << 30;
+
+    /**
+     * This is the path of the file to which a trained dictionary is
+     * written, if no other path is given.
+     */
+    const std::string DEFAULT_DICTIONARY_PATH = "dictionary.zdict";
+
+    /**
+     * This is the suffix added to the path of a gzip file to make the path
+     * of its index, if no other path is given.
+     */
+    const std::string GZIP_INDEX_SUFFIX = ".gzi";
+
     /**
      * This function prints to the standard error stream information
      * about how to use this program.
@@ -38,9 +83,103 @@ namespace {
         fprintf(
             stderr,
             (
-                "Usage: ZlibPlay\n"
+                "Usage: ZlibPlay [--bench PATH] [--level LIST] [--strategy LIST]\n"
+                "                [--window-bits LIST] [--buffer-size LIST] [--repeat N]\n"
+                "                [--reuse LIST] [--dictionary FILE] [--lines]\n"
+                "                [--format csv|json] [--output FILE]\n"
+                "       ZlibPlay --checksums [--format csv|json] [--output FILE]\n"
+                "       ZlibPlay --gzip PATH [--level N] [--threads N] [--block-size N]\n"
+                "                [--auto] [--verify] [--output FILE]\n"
+                "       ZlibPlay --gunzip PATH [--threads N] [--compare] [--output FILE]\n"
+                "       ZlibPlay --stream PATH [--level N] [--window-bits N]\n"
+                "                [--buffer-size N] [--auto] [--output FILE]\n"
+                "       ZlibPlay --train PATH [--dictionary-size N] [--output FILE]\n"
+                "       ZlibPlay --index PATH [--span N] [--output FILE]\n"
+                "       ZlibPlay --extract PATH --offset N --length N [--output FILE]\n"
+                "       ZlibPlay --precompress PATH [--base DIR] [--level N] [--threads N]\n"
+                "                [--force]\n"
                 "\n"
                 "Do stuff with zlib.\n"
+                "\n"
+                "With no arguments, compress and decompress a short message, showing\n"
+                "each step.  Given one or more --bench paths, instead measure the\n"
+                "throughput of compressing and decompressing every file found at those\n"
+                "paths, for every combination of the listed settings.  With --checksums,\n"
+                "instead measure the throughput of each CRC-32 and Adler-32 kernel\n"
+                "this processor supports, checking each against zlib.  Given a --gzip\n"
+                "path, compress that file into the gzip format using several threads,\n"
+                "and given a --gunzip path, decompress the members of that gzip file\n"
+                "using several threads.  Given a --stream path, compress that file\n"
+                "using a constant amount of memory, no matter how large the file is.\n"
+                "Given one or more --train paths, build a preset dictionary from the\n"
+                "messages recorded in the files found at those paths, one message per\n"
+                "line.  Given an --index path, make an index of access points into that\n"
+                "gzip file, and given an --extract path, use that index to read part of\n"
+                "the decompressed data without decompressing everything before it.\n"
+                "Given one or more --precompress paths, write a gzip-compressed copy\n"
+                "beside every file in the static content roots configured in those web\n"
+                "server configuration files, or in those directories, compressing only\n"
+                "files which changed since the last time.\n"
+                "\n"
+                "  --bench PATH        File or directory (walked recursively) to add to\n"
+                "                      the benchmark corpus; may be given more than once\n"
+                "  --level LIST        Compression levels (default: 1,3,6,9)\n"
+                "  --strategy LIST     Strategies: default, filtered, huffman, rle, fixed\n"
+                "                      (default: default,filtered,huffman,rle)\n"
+                "  --window-bits LIST  deflateInit2 windowBits values (default: 9,12,15)\n"
+                "  --buffer-size LIST  Chunk sizes in bytes (default: 4096,16384,65536)\n"
+                "  --reuse LIST        How zlib state is carried between files: fresh,\n"
+                "                      arena, reset (default: fresh)\n"
+                "  --dictionary FILE   Also measure every combination using this trained\n"
+                "                      preset dictionary\n"
+                "  --lines             Treat each line of each corpus file as its own\n"
+                "                      message\n"
+                "  --checksums         Check and measure the checksum kernels\n"
+                "  --repeat N          Times to process the corpus per combination\n"
+                "                      (default: 1)\n"
+                "  --format FORMAT     Report format, csv or json (default: csv)\n"
+                "  --output FILE       Write the report to FILE instead of standard output,\n"
+                "                      the compressed file to FILE instead of PATH.gz,\n"
+                "                      the decompressed file to FILE instead of PATH\n"
+                "                      without .gz, the dictionary to FILE instead of\n"
+                "                      dictionary.zdict, the index to FILE instead of\n"
+                "                      PATH.gzi, or the extracted data to FILE instead\n"
+                "                      of standard output\n"
+                "  --stream PATH       File to compress through fixed-size buffers\n"
+                "  --gzip PATH         File to compress in parallel blocks\n"
+                "  --threads N         Threads to use (default: one per hardware thread)\n"
+                "  --block-size N      Bytes of input per block (default: 131072)\n"
+                "  --verify            Decompress the result and check it against the input\n"
+                "  --auto              Choose the compression level and strategy by sampling\n"
+                "                      the input, storing data which looks already\n"
+                "                      compressed\n"
+                "  --target-mbps N     Least compression throughput per thread, in MB/s,\n"
+                "                      for --auto to aim for\n"
+                "  --cpu-budget N      Most CPU time per byte, in nanoseconds, for --auto\n"
+                "                      to spend\n"
+                "  --gunzip PATH       Gzip file whose members to decompress in parallel\n"
+                "  --compare           Instead of writing the output, time decompressing\n"
+                "                      in parallel against one member at a time, and check\n"
+                "                      that both give the same output\n"
+                "  --train PATH        File or directory (walked recursively) of recorded\n"
+                "                      messages to train a dictionary on; may be given\n"
+                "                      more than once\n"
+                "  --dictionary-size N Largest dictionary to build, in bytes (default: 4096)\n"
+                "  --index PATH        Gzip file to index\n"
+                "  --span N            Least decompressed bytes between access points\n"
+                "                      (default: 1048576)\n"
+                "  --extract PATH      Gzip file from which to read a range, using the\n"
+                "                      index at PATH.gzi\n"
+                "  --offset N          Offset of the range in the decompressed data\n"
+                "  --length N          Length of the range in bytes\n"
+                "  --precompress PATH  Web server configuration file whose static content\n"
+                "                      roots to precompress, or a directory to precompress;\n"
+                "                      may be given more than once\n"
+                "  --base DIR          Directory against which to resolve relative roots\n"
+                "                      (default: the current directory, as the server does)\n"
+                "  --force             Compress every file again, even if unchanged\n"
+                "\n"
+                "LIST is a comma-separated list of values.\n"
             )
         );
     }
@@ -50,8 +189,253 @@ namespace {
      * or the command-line arguments.
      */
     struct Environment {
+        /**
+         * These are the paths of the files and directories to compress
+         * when benchmarking.  If empty, the program plays with a short
+         * message instead.
+         */
+        std::vector< std::string > benchmarkPaths;
+
+        /**
+         * This holds the settings which control the benchmark.
+         */
+        BenchmarkConfiguration benchmark;
+
+        /**
+         * This is the path of the file to which to write the benchmark
+         * report.  If empty, the report is written to standard output.
+         */
+        std::string reportPath;
+
+        /**
+         * This is the path of the file to compress in parallel blocks.
+         */
+        std::string gzipPath;
+
+        /**
+         * This holds the settings which control parallel compression.
+         */
+        ParallelGzipConfiguration gzip;
+
+        /**
+         * This indicates whether or not to check compressed output by
+         * decompressing it and comparing it with the input.
+         */
+        bool verify = false;
+
+        /**
+         * This indicates whether or not to check and measure
+         * the checksum kernels.
+         */
+        bool checksums = false;
+
+        /**
+         * This indicates whether or not to choose the compression level
+         * and strategy by sampling the data to compress.
+         */
+        bool autoTune = false;
+
+        /**
+         * This holds the settings which control how the compression level
+         * and strategy are chosen.
+         */
+        CompressionTuningConfiguration tuning;
+
+        /**
+         * This is the path of the gzip file whose members to decompress
+         * in parallel.
+         */
+        std::string gunzipPath;
+
+        /**
+         * This indicates whether or not to compare parallel decompression
+         * with serial decompression, rather than writing the output.
+         */
+        bool compare = false;
+
+        /**
+         * This is the path of the file to compress through
+         * fixed-size buffers.
+         */
+        std::string streamPath;
+
+        /**
+         * This holds the settings which control streaming compression.
+         */
+        StreamingCompressionConfiguration stream;
+
+        /**
+         * This is the path of the preset dictionary to measure
+         * when benchmarking, if any.
+         */
+        std::string dictionaryPath;
+
+        /**
+         * This indicates whether or not each line of each file in the
+         * benchmark corpus is treated as its own message.
+         */
+        bool lines = false;
+
+        /**
+         * These are the paths of the files and directories holding the
+         * recorded messages from which to train a dictionary.
+         */
+        std::vector< std::string > trainingPaths;
+
+        /**
+         * This holds the settings which control dictionary training.
+         */
+        DictionaryTrainingConfiguration training;
+
+        /**
+         * This is the path of the gzip file to index.
+         */
+        std::string indexPath;
+
+        /**
+         * This is the least amount of decompressed data, in bytes,
+         * to put between access points when indexing a gzip file.
+         */
+        uint64_t span = 1 << 20;
+
+        /**
+         * This is the path of the gzip file from which to read a range
+         * of decompressed data.
+         */
+        std::string extractPath;
+
+        /**
+         * This is the offset of the range to read, in the
+         * decompressed data.
+         */
+        uint64_t extractOffset = 0;
+
+        /**
+         * This is the length of the range to read, in bytes.
+         */
+        uint64_t extractLength = 0;
+
+        /**
+         * These are the paths of the web server configuration files whose
+         * static content roots to precompress, or of directories
+         * to precompress.
+         */
+        std::vector< std::string > precompressPaths;
+
+        /**
+         * This is the directory against which to resolve relative static
+         * content roots.  If empty, they're left relative to the current
+         * working directory.
+         */
+        std::string precompressBase;
+
+        /**
+         * This holds the settings which control precompressing
+         * static content.
+         */
+        PrecompressConfiguration precompress;
     };
 
+    /**
+     * This function splits the given comma-separated list and parses
+     * each element as an integer.
+     *
+     * @param[in] list
+     *     This is the list to parse.
+     *
+     * @param[out] values
+     *     This is where to store the values parsed.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool ParseIntegerList(
+        const std::string& list,
+        std::vector< long >& values
+    ) {
+        values.clear();
+        size_t start = 0;
+        for (;;) {
+            const auto end = list.find(',', start);
+            const auto element = list.substr(start, end - start);
+            char* elementEnd;
+            const auto value = strtol(element.c_str(), &elementEnd, 10);
+            if (
+                element.empty()
+                || (*elementEnd != '\0')
+            ) {
+                return false;
+            }
+            values.push_back(value);
+            if (end == std::string::npos) {
+                break;
+            }
+            start = end + 1;
+        }
+        return true;
+    }
+
+    /**
+     * This function parses the given string as an unsigned 64-bit integer.
+     *
+     * @param[in] text
+     *     This is the string to parse.
+     *
+     * @param[out] value
+     *     This is where to store the value parsed.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool ParseUint64(
+        const std::string& text,
+        uint64_t& value
+    ) {
+        if (
+            text.empty()
+            || (text[0] < '0')
+            || (text[0] > '9')
+        ) {
+            return false;
+        }
+        char* textEnd;
+        errno = 0;
+        value = (uint64_t)strtoull(text.c_str(), &textEnd, 10);
+        return (
+            (errno == 0)
+            && (*textEnd == '\0')
+        );
+    }
+
+    /**
+     * This function parses the given string as a positive number.
+     *
+     * @param[in] text
+     *     This is the string to parse.
+     *
+     * @param[out] value
+     *     This is where to store the value parsed.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool ParsePositiveNumber(
+        const std::string& text,
+        double& value
+    ) {
+        if (text.empty()) {
+            return false;
+        }
+        char* textEnd;
+        errno = 0;
+        value = strtod(text.c_str(), &textEnd);
+        return (
+            (errno == 0)
+            && (*textEnd == '\0')
+            && (value > 0.0)
+        );
+    }
+
     /**
      * This function updates the program environment to incorporate
      * any applicable command-line arguments.
@@ -65,9 +449,6 @@ namespace {
      * @param[in,out] environment
      *     This is the environment to update.
      *
-     * @param[in] diagnosticMessageDelegate
-     *     This is the function to call to publish any diagnostic messages.
-     *
      * @return
      *     An indication of whether or not the function succeeded is returned.
      */
@@ -79,15 +460,590 @@ namespace {
         enum class State {
             // First command-line argument
             Initial,
+
+            // Path to add to the benchmark corpus
+            BenchmarkPath,
+
+            // List of compression levels to benchmark
+            Levels,
+
+            // List of compression strategies to benchmark
+            Strategies,
+
+            // List of windowBits values to benchmark
+            WindowBits,
+
+            // List of buffer sizes to benchmark
+            BufferSizes,
+
+            // List of ways to carry zlib state between files
+            Reuses,
+
+            // Number of times to process the corpus
+            Repetitions,
+
+            // Format of the benchmark report
+            Format,
+
+            // Path of the file to which to write the output
+            Output,
+
+            // Path of the file to compress in parallel blocks
+            GzipPath,
+
+            // Number of threads to use
+            Threads,
+
+            // Number of bytes of input per block
+            BlockSize,
+
+            // Path of the file to compress through fixed-size buffers
+            StreamPath,
+
+            // Path of the gzip file to decompress in parallel
+            GunzipPath,
+
+            // Least compression throughput for automatic tuning
+            TargetMBps,
+
+            // Most CPU time per byte for automatic tuning
+            CpuBudget,
+
+            // Path of the preset dictionary to measure
+            DictionaryPath,
+
+            // Path of recorded messages from which to train a dictionary
+            TrainingPath,
+
+            // Largest dictionary to build
+            DictionarySize,
+
+            // Path of the gzip file to index
+            IndexPath,
+
+            // Least decompressed bytes between access points
+            Span,
+
+            // Path of the gzip file from which to read a range
+            ExtractPath,
+
+            // Offset of the range to read
+            Offset,
+
+            // Length of the range to read
+            Length,
+
+            // Configuration file or directory to precompress
+            PrecompressPath,
+
+            // Directory against which to resolve relative roots
+            Base,
         } state = State::Initial;
+        auto& benchmark = environment.benchmark;
+        std::vector< long > values;
         for (int i = 1; i < argc; ++i) {
             const std::string arg(argv[i]);
             switch (state) {
                 case State::Initial: { // next argument
+                    if (arg == "--bench") {
+                        state = State::BenchmarkPath;
+                    } else if (arg == "--level") {
+                        state = State::Levels;
+                    } else if (arg == "--strategy") {
+                        state = State::Strategies;
+                    } else if (arg == "--window-bits") {
+                        state = State::WindowBits;
+                    } else if (arg == "--buffer-size") {
+                        state = State::BufferSizes;
+                    } else if (arg == "--reuse") {
+                        state = State::Reuses;
+                    } else if (arg == "--repeat") {
+                        state = State::Repetitions;
+                    } else if (arg == "--format") {
+                        state = State::Format;
+                    } else if (arg == "--output") {
+                        state = State::Output;
+                    } else if (arg == "--gzip") {
+                        state = State::GzipPath;
+                    } else if (arg == "--threads") {
+                        state = State::Threads;
+                    } else if (arg == "--block-size") {
+                        state = State::BlockSize;
+                    } else if (arg == "--stream") {
+                        state = State::StreamPath;
+                    } else if (arg == "--dictionary") {
+                        state = State::DictionaryPath;
+                    } else if (arg == "--train") {
+                        state = State::TrainingPath;
+                    } else if (arg == "--dictionary-size") {
+                        state = State::DictionarySize;
+                    } else if (arg == "--index") {
+                        state = State::IndexPath;
+                    } else if (arg == "--span") {
+                        state = State::Span;
+                    } else if (arg == "--extract") {
+                        state = State::ExtractPath;
+                    } else if (arg == "--offset") {
+                        state = State::Offset;
+                    } else if (arg == "--length") {
+                        state = State::Length;
+                    } else if (arg == "--gunzip") {
+                        state = State::GunzipPath;
+                    } else if (arg == "--compare") {
+                        environment.compare = true;
+                    } else if (arg == "--precompress") {
+                        state = State::PrecompressPath;
+                    } else if (arg == "--base") {
+                        state = State::Base;
+                    } else if (arg == "--force") {
+                        environment.precompress.force = true;
+                    } else if (arg == "--checksums") {
+                        environment.checksums = true;
+                    } else if (arg == "--auto") {
+                        environment.autoTune = true;
+                    } else if (arg == "--target-mbps") {
+                        state = State::TargetMBps;
+                    } else if (arg == "--cpu-budget") {
+                        state = State::CpuBudget;
+                    } else if (arg == "--verify") {
+                        environment.verify = true;
+                    } else if (arg == "--lines") {
+                        environment.lines = true;
+                    } else {
+                        fprintf(stderr, "error: unrecognized argument '%s'\n", arg.c_str());
+                        return false;
+                    }
+                } break;
+
+                case State::BenchmarkPath: {
+                    environment.benchmarkPaths.push_back(arg);
+                    state = State::Initial;
+                } break;
+
+                case State::Levels: {
+                    if (!ParseIntegerList(arg, values)) {
+                        fprintf(stderr, "error: bad compression level list '%s'\n", arg.c_str());
+                        return false;
+                    }
+                    benchmark.levels.clear();
+                    for (const auto value: values) {
+                        if (
+                            (value < Z_DEFAULT_COMPRESSION)
+                            || (value > Z_BEST_COMPRESSION)
+                        ) {
+                            fprintf(stderr, "error: compression level %ld out of range\n", value);
+                            return false;
+                        }
+                        benchmark.levels.push_back((int)value);
+                    }
+                    state = State::Initial;
+                } break;
+
+                case State::Strategies: {
+                    benchmark.strategies.clear();
+                    size_t start = 0;
+                    for (;;) {
+                        const auto end = arg.find(',', start);
+                        const auto name = arg.substr(start, end - start);
+                        int strategy;
+                        if (!ParseStrategyName(name, strategy)) {
+                            fprintf(stderr, "error: unrecognized strategy '%s'\n", name.c_str());
+                            return false;
+                        }
+                        benchmark.strategies.push_back(strategy);
+                        if (end == std::string::npos) {
+                            break;
+                        }
+                        start = end + 1;
+                    }
+                    state = State::Initial;
+                } break;
+
+                case State::WindowBits: {
+                    if (!ParseIntegerList(arg, values)) {
+                        fprintf(stderr, "error: bad windowBits list '%s'\n", arg.c_str());
+                        return false;
+                    }
+                    benchmark.windowBits.clear();
+                    for (const auto value: values) {
+                        const auto magnitude = (value < 0) ? -value : value;
+                        const auto bits = (magnitude > MAX_WBITS) ? magnitude - 16 : magnitude;
+                        if (
+                            (bits < 8)
+                            || (bits > MAX_WBITS)
+                            || ((value < 0) && (magnitude > MAX_WBITS))
+                            || ((bits == 8) && (value != 8))
+                        ) {
+                            fprintf(stderr, "error: windowBits %ld out of range\n", value);
+                            return false;
+                        }
+                        benchmark.windowBits.push_back((int)value);
+                    }
+                    state = State::Initial;
+                } break;
+
+                case State::BufferSizes: {
+                    if (!ParseIntegerList(arg, values)) {
+                        fprintf(stderr, "error: bad buffer size list '%s'\n", arg.c_str());
+                        return false;
+                    }
+                    benchmark.bufferSizes.clear();
+                    for (const auto value: values) {
+                        if (
+                            (value <= 0)
+                            || ((size_t)value > MAX_BENCHMARK_BUFFER_SIZE)
+                        ) {
+                            fprintf(stderr, "error: buffer size %ld out of range\n", value);
+                            return false;
+                        }
+                        benchmark.bufferSizes.push_back((size_t)value);
+                    }
+                    state = State::Initial;
+                } break;
+
+                case State::Reuses: {
+                    benchmark.reuses.clear();
+                    size_t start = 0;
+                    for (;;) {
+                        const auto end = arg.find(',', start);
+                        const auto name = arg.substr(start, end - start);
+                        BenchmarkConfiguration::Reuse reuse;
+                        if (!ParseReuseName(name, reuse)) {
+                            fprintf(stderr, "error: unrecognized reuse '%s'\n", name.c_str());
+                            return false;
+                        }
+                        benchmark.reuses.push_back(reuse);
+                        if (end == std::string::npos) {
+                            break;
+                        }
+                        start = end + 1;
+                    }
+                    state = State::Initial;
+                } break;
+
+                case State::Repetitions: {
+                    if (
+                        !ParseIntegerList(arg, values)
+                        || (values.size() != 1)
+                        || (values[0] <= 0)
+                    ) {
+                        fprintf(stderr, "error: bad repetition count '%s'\n", arg.c_str());
+                        return false;
+                    }
+                    benchmark.repetitions = (size_t)values[0];
+                    state = State::Initial;
+                } break;
+
+                case State::Format: {
+                    if (arg == "csv") {
+                        benchmark.reportFormat = BenchmarkConfiguration::ReportFormat::Csv;
+                    } else if (arg == "json") {
+                        benchmark.reportFormat = BenchmarkConfiguration::ReportFormat::Json;
+                    } else {
+                        fprintf(stderr, "error: unrecognized report format '%s'\n", arg.c_str());
+                        return false;
+                    }
+                    state = State::Initial;
+                } break;
+
+                case State::Output: {
+                    environment.reportPath = arg;
+                    state = State::Initial;
+                } break;
+
+                case State::GzipPath: {
+                    environment.gzipPath = arg;
+                    state = State::Initial;
+                } break;
+
+                case State::Threads: {
+                    if (
+                        !ParseIntegerList(arg, values)
+                        || (values.size() != 1)
+                        || (values[0] <= 0)
+                    ) {
+                        fprintf(stderr, "error: bad thread count '%s'\n", arg.c_str());
+                        return false;
+                    }
+                    environment.gzip.threads = (size_t)values[0];
+                    state = State::Initial;
+                } break;
+
+                case State::BlockSize: {
+                    if (
+                        !ParseIntegerList(arg, values)
+                        || (values.size() != 1)
+                        || (values[0] <= 0)
+                        || ((size_t)values[0] > MAX_BLOCK_SIZE)
+                    ) {
+                        fprintf(stderr, "error: bad block size '%s'\n", arg.c_str());
+                        return false;
+                    }
+                    environment.gzip.blockSize = (size_t)values[0];
+                    state = State::Initial;
+                } break;
+
+                case State::StreamPath: {
+                    environment.streamPath = arg;
+                    state = State::Initial;
+                } break;
+
+                case State::GunzipPath: {
+                    environment.gunzipPath = arg;
+                    state = State::Initial;
+                } break;
+
+                case State::TargetMBps: {
+                    if (!ParsePositiveNumber(arg, environment.tuning.targetMBps)) {
+                        fprintf(stderr, "error: bad target throughput '%s'\n", arg.c_str());
+                        return false;
+                    }
+                    state = State::Initial;
+                } break;
+
+                case State::CpuBudget: {
+                    if (!ParsePositiveNumber(arg, environment.tuning.cpuBudgetNsPerByte)) {
+                        fprintf(stderr, "error: bad CPU budget '%s'\n", arg.c_str());
+                        return false;
+                    }
+                    state = State::Initial;
+                } break;
+
+                case State::DictionaryPath: {
+                    environment.dictionaryPath = arg;
+                    state = State::Initial;
+                } break;
+
+                case State::TrainingPath: {
+                    environment.trainingPaths.push_back(arg);
+                    state = State::Initial;
+                } break;
+
+                case State::DictionarySize: {
+                    if (
+                        !ParseIntegerList(arg, values)
+                        || (values.size() != 1)
+                        || (values[0] <= 0)
+                        || (values[0] > (1 << MAX_WBITS))
+                    ) {
+                        fprintf(stderr, "error: bad dictionary size '%s'\n", arg.c_str());
+                        return false;
+                    }
+                    environment.training.maxSize = (size_t)values[0];
+                    state = State::Initial;
+                } break;
+
+                case State::IndexPath: {
+                    environment.indexPath = arg;
+                    state = State::Initial;
+                } break;
+
+                case State::Span: {
+                    if (
+                        !ParseUint64(arg, environment.span)
+                        || (environment.span == 0)
+                    ) {
+                        fprintf(stderr, "error: bad span '%s'\n", arg.c_str());
+                        return false;
+                    }
+                    state = State::Initial;
+                } break;
+
+                case State::ExtractPath: {
+                    environment.extractPath = arg;
+                    state = State::Initial;
+                } break;
+
+                case State::Offset: {
+                    if (!ParseUint64(arg, environment.extractOffset)) {
+                        fprintf(stderr, "error: bad offset '%s'\n", arg.c_str());
+                        return false;
+                    }
+                    state = State::Initial;
+                } break;
+
+                case State::Length: {
+                    if (
+                        !ParseUint64(arg, environment.extractLength)
+                        || (environment.extractLength > SIZE_MAX)
+                    ) {
+                        fprintf(stderr, "error: bad length '%s'\n", arg.c_str());
+                        return false;
+                    }
+                    state = State::Initial;
+                } break;
+
+                case State::PrecompressPath: {
+                    environment.precompressPaths.push_back(arg);
+                    state = State::Initial;
+                } break;
+
+                case State::Base: {
+                    environment.precompressBase = arg;
                     state = State::Initial;
                 } break;
             }
         }
+        if (state != State::Initial) {
+            fprintf(stderr, "error: value expected after last argument\n");
+            return false;
+        }
+        if (
+            (size_t)(!environment.benchmarkPaths.empty())
+            + (size_t)(!environment.gzipPath.empty())
+            + (size_t)(!environment.streamPath.empty())
+            + (size_t)(!environment.trainingPaths.empty())
+            + (size_t)(!environment.indexPath.empty())
+            + (size_t)(!environment.extractPath.empty())
+            + (size_t)(!environment.gunzipPath.empty())
+            + (size_t)environment.checksums
+            + (size_t)(!environment.precompressPaths.empty())
+            > 1
+        ) {
+            fprintf(stderr, "error: only one of --bench, --checksums, --gzip, --gunzip, --stream, --train, --index, --extract, and --precompress may be used\n");
+            return false;
+        }
+        if (!benchmark.levels.empty()) {
+            environment.gzip.level = benchmark.levels.front();
+            environment.stream.level = benchmark.levels.front();
+            environment.precompress.level = benchmark.levels.front();
+        }
+        environment.precompress.threads = environment.gzip.threads;
+        if (!benchmark.strategies.empty()) {
+            environment.gzip.strategy = benchmark.strategies.front();
+            environment.stream.strategy = benchmark.strategies.front();
+        }
+        if (!benchmark.windowBits.empty()) {
+            environment.stream.windowBits = benchmark.windowBits.front();
+        }
+        if (!benchmark.bufferSizes.empty()) {
+            environment.stream.bufferSize = benchmark.bufferSizes.front();
+        }
+        if (benchmark.levels.empty()) {
+            benchmark.levels = {1, 3, 6, 9};
+        }
+        if (benchmark.strategies.empty()) {
+            benchmark.strategies = {Z_DEFAULT_STRATEGY, Z_FILTERED, Z_HUFFMAN_ONLY, Z_RLE};
+        }
+        if (benchmark.windowBits.empty()) {
+            benchmark.windowBits = {9, 12, MAX_WBITS};
+        }
+        if (benchmark.bufferSizes.empty()) {
+            benchmark.bufferSizes = {4096, 16384, 65536};
+        }
+        if (benchmark.reuses.empty()) {
+            benchmark.reuses = {BenchmarkConfiguration::Reuse::Fresh};
+        }
+        return true;
+    }
+
+    /**
+     * This function decompresses the given gzip data and checks that
+     * the result matches the given original data.
+     *
+     * @param[in] compressed
+     *     This is the gzip data to decompress.
+     *
+     * @param[in] original
+     *     This points to the data expected from decompression.
+     *
+     * @param[in] originalSize
+     *     This is the number of bytes expected from decompression.
+     *
+     * @return
+     *     An indication of whether or not the decompressed data matches
+     *     the original data is returned.
+     */
+    bool GunzipMatches(
+        const std::vector< uint8_t >& compressed,
+        const uint8_t* original,
+        size_t originalSize
+    ) {
+        Inflater inflater;
+        InflaterConfiguration configuration;
+        configuration.windowBits = 16 + MAX_WBITS;
+        if (!inflater.Initialize(configuration)) {
+            return false;
+        }
+        size_t offset = 0;
+        size_t consumed;
+        return (
+            inflater.Inflate(
+                compressed.data(),
+                compressed.size(),
+                [original, originalSize, &offset](const uint8_t* data, size_t size){
+                    if (
+                        (size > originalSize - offset)
+                        || (memcmp(data, original + offset, size) != 0)
+                    ) {
+                        return false;
+                    }
+                    offset += size;
+                    return true;
+                },
+                &consumed
+            )
+            && inflater.IsFinished()
+            && (consumed == compressed.size())
+            && (offset == originalSize)
+        );
+    }
+
+    /**
+     * This function chooses the compression level and strategy for the
+     * given data, and reports the choice.
+     *
+     * @param[in] environment
+     *     This contains variables set through the operating system environment
+     *     or the command-line arguments.
+     *
+     * @param[in] data
+     *     This points to the data to be compressed.
+     *
+     * @param[in] size
+     *     This is the number of bytes of data to be compressed.
+     *
+     * @param[in,out] level
+     *     This is the compression level to update.
+     *
+     * @param[in,out] strategy
+     *     This is the compression strategy to update.
+     *
+     * @return
+     *     An indication of whether or not the function succeeded is returned.
+     */
+    bool TuneCompression(
+        const Environment& environment,
+        const uint8_t* data,
+        size_t size,
+        int& level,
+        int& strategy
+    ) {
+        CompressionDecision decision;
+        if (!ChooseCompression(data, size, environment.tuning, decision)) {
+            return false;
+        }
+        level = decision.level;
+        strategy = decision.strategy;
+        if (level == 0) {
+            printf(
+                "Auto: storing (%s; sampled %zu bytes at %.2f bits per byte).\n",
+                decision.reason.c_str(),
+                decision.sampleBytes,
+                decision.entropy
+            );
+        } else {
+            printf(
+                "Auto: level %d, strategy %s (%s; sampled %zu bytes at %.2f bits per byte, ratio %.3f at %.1f MB/s).\n",
+                level,
+                GetStrategyName(strategy).c_str(),
+                decision.reason.c_str(),
+                decision.sampleBytes,
+                decision.entropy,
+                decision.sampleRatio,
+                decision.sampleMBps
+            );
+        }
         return true;
     }
 
@@ -134,45 +1090,48 @@ void PlayWithInflateDeflate(const Environment& environment) {
     // Here's the buffer in which we'll put the deflated data.
     std::vector< uint8_t > deflatedContent;
 
-    // Here's the buffer in which we'll put the inflated data.
-    std::vector< uint8_t > inflatedContent(INFLATE_BUFFER_SIZE);
-
     // This is where we'll build up the inflated data output.
     std::string output;
 
-    // Initialize the deflate stream.
-    z_stream deflateStream;
-    deflateStream.zalloc = Z_NULL;
-    deflateStream.zfree = Z_NULL;
-    deflateStream.opaque = Z_NULL;
-    if (deflateInit(&deflateStream, Z_DEFAULT_COMPRESSION) == Z_OK) {
-        printf("deflateInit succeeded.\n");
+    // Set up the deflater.
+    Deflater deflater;
+    DeflaterConfiguration deflaterConfiguration;
+    deflaterConfiguration.windowBits = MAX_WBITS;
+    deflaterConfiguration.chunkSize = DEFLATE_BUFFER_INCREMENT;
+    if (
+        environment.autoTune
+        && !TuneCompression(
+            environment,
+            (const uint8_t*)input.data(),
+            input.length(),
+            deflaterConfiguration.level,
+            deflaterConfiguration.strategy
+        )
+    ) {
+        return;
+    }
+    if (deflater.Initialize(deflaterConfiguration)) {
+        printf("Deflater initialized.\n");
     } else {
-        printf("deflateInit failed.\n");
+        printf("Deflater failed to initialize.\n");
         return;
     }
 
     // Deflate the data.
-    deflateStream.next_in = (Bytef*)input.c_str();
-    deflateStream.avail_in = (uInt)input.length();
-    deflateStream.total_in = 0;
-    int result = Z_OK;
-    while (result != Z_STREAM_END) {
-        size_t totalDeflatedPreviously = deflatedContent.size();
-        deflatedContent.resize(totalDeflatedPreviously + DEFLATE_BUFFER_INCREMENT);
-        deflateStream.next_out = (Bytef*)deflatedContent.data() + totalDeflatedPreviously;
-        deflateStream.avail_out = DEFLATE_BUFFER_INCREMENT;
-        deflateStream.total_out = 0;
-        result = deflate(&deflateStream, Z_FINISH);
-        deflatedContent.resize(totalDeflatedPreviously + (size_t)deflateStream.total_out);
-        if (result == Z_OK) {
-            printf("deflate produced %zu more bytes.\n", (size_t)deflateStream.total_out);
-        } else if (result == Z_STREAM_END) {
-            printf("deflate produced last %zu bytes.\n", (size_t)deflateStream.total_out);
-        } else if (result != Z_BUF_ERROR) {
-            printf("deflate failed (%d: %s).\n", (int)result, deflateStream.msg);
-            return;
-        }
+    if (
+        !deflater.Deflate(
+            (const uint8_t*)input.data(),
+            input.length(),
+            true,
+            [&deflatedContent](const uint8_t* data, size_t size){
+                printf("deflate produced %zu bytes.\n", size);
+                deflatedContent.insert(deflatedContent.end(), data, data + size);
+                return true;
+            }
+        )
+    ) {
+        printf("deflate failed.\n");
+        return;
     }
 
     // Display deflated data.
@@ -187,64 +1146,38 @@ void PlayWithInflateDeflate(const Environment& environment) {
     }
     printf("\n");
 
-    // End the deflate stream.
-    result = deflateEnd(&deflateStream);
-    if (result == Z_OK) {
-        printf("deflateEnd succeeded.\n");
+    // Set up the inflater.
+    Inflater inflater;
+    InflaterConfiguration inflaterConfiguration;
+    inflaterConfiguration.windowBits = MAX_WBITS;
+    inflaterConfiguration.chunkSize = INFLATE_BUFFER_SIZE;
+    if (inflater.Initialize(inflaterConfiguration)) {
+        printf("Inflater initialized.\n");
     } else {
-        printf("deflateEnd failed (%d: %s).\n", (int)result, deflateStream.msg);
-        return;
-    }
-
-    // Initialize the inflate stream.
-    z_stream inflateStream;
-    inflateStream.zalloc = Z_NULL;
-    inflateStream.zfree = Z_NULL;
-    inflateStream.opaque = Z_NULL;
-    if (inflateInit(&inflateStream) == Z_OK) {
-        printf("inflateInit succeeded.\n");
-    } else {
-        printf("inflateInit failed.\n");
+        printf("Inflater failed to initialize.\n");
         return;
     }
 
     // inflate the data.
-    inflateStream.next_in = (Bytef*)deflatedContent.data();
-    inflateStream.avail_in = (uInt)deflatedContent.size();
-    inflateStream.total_in = 0;
-    result = Z_OK;
-    while (result != Z_STREAM_END) {
-        size_t totalInflatedPreviously = inflatedContent.size();
-        inflateStream.next_out = (Bytef*)inflatedContent.data();
-        inflateStream.avail_out = (uInt)inflatedContent.size();
-        inflateStream.total_out = 0;
-        result = inflate(&inflateStream, Z_FINISH);
-        output += std::string(
-            inflatedContent.begin(),
-            inflatedContent.begin() + (size_t)inflateStream.total_out
-        );
-        if (result == Z_OK) {
-            printf("inflate produced %zu more bytes.\n", (size_t)inflateStream.total_out);
-        } else if (result == Z_STREAM_END) {
-            printf("inflate produced last %zu bytes.\n", (size_t)inflateStream.total_out);
-        } else if (result != Z_BUF_ERROR) {
-            printf("inflate failed (%d: %s).\n", (int)result, inflateStream.msg);
-            return;
-        }
+    if (
+        !inflater.Inflate(
+            deflatedContent.data(),
+            deflatedContent.size(),
+            [&output](const uint8_t* data, size_t size){
+                printf("inflate produced %zu bytes.\n", size);
+                output.append((const char*)data, size);
+                return true;
+            }
+        )
+        || !inflater.IsFinished()
+    ) {
+        printf("inflate failed.\n");
+        return;
     }
 
     // Display inflated data.
     printf("inflated data: %s\n", output.c_str());
 
-    // End the inflate stream.
-    result = inflateEnd(&inflateStream);
-    if (result == Z_OK) {
-        printf("inflateEnd succeeded.\n");
-    } else {
-        printf("inflateEnd failed (%d: %s).\n", (int)result, inflateStream.msg);
-        return;
-    }
-
     // Display some stats.
     printf("Original:   %zu bytes\n", input.length());
     printf("Compressed: %zu bytes\n", deflatedContent.size());
@@ -269,54 +1202,36 @@ void PlayWithGzip(const Environment& environment) {
     // Here's the buffer in which we'll put the deflated data.
     std::vector< uint8_t > deflatedContent;
 
-    // Here's the buffer in which we'll put the inflated data.
-    std::vector< uint8_t > inflatedContent(INFLATE_BUFFER_SIZE);
-
     // This is where we'll build up the inflated data output.
     std::string output;
 
-    // Initialize the deflate stream.
-    z_stream deflateStream;
-    deflateStream.zalloc = Z_NULL;
-    deflateStream.zfree = Z_NULL;
-    deflateStream.opaque = Z_NULL;
-    if (
-        deflateInit2(
-            &deflateStream,
-            Z_DEFAULT_COMPRESSION,
-            Z_DEFLATED,
-            16 + MAX_WBITS,
-            8,
-            Z_DEFAULT_STRATEGY
-        ) == Z_OK
-    ) {
-        printf("deflateInit2 succeeded.\n");
+    // Set up the deflater.
+    Deflater deflater;
+    DeflaterConfiguration deflaterConfiguration;
+    deflaterConfiguration.windowBits = 16 + MAX_WBITS;
+    deflaterConfiguration.chunkSize = DEFLATE_BUFFER_INCREMENT;
+    if (deflater.Initialize(deflaterConfiguration)) {
+        printf("Deflater initialized.\n");
     } else {
-        printf("deflateInit2 failed.\n");
+        printf("Deflater failed to initialize.\n");
         return;
     }
 
     // Deflate the data.
-    deflateStream.next_in = (Bytef*)input.c_str();
-    deflateStream.avail_in = (uInt)input.length();
-    deflateStream.total_in = 0;
-    int result = Z_OK;
-    while (result != Z_STREAM_END) {
-        size_t totalDeflatedPreviously = deflatedContent.size();
-        deflatedContent.resize(totalDeflatedPreviously + DEFLATE_BUFFER_INCREMENT);
-        deflateStream.next_out = (Bytef*)deflatedContent.data() + totalDeflatedPreviously;
-        deflateStream.avail_out = DEFLATE_BUFFER_INCREMENT;
-        deflateStream.total_out = 0;
-        result = deflate(&deflateStream, Z_FINISH);
-        deflatedContent.resize(totalDeflatedPreviously + (size_t)deflateStream.total_out);
-        if (result == Z_OK) {
-            printf("deflate produced %zu more bytes.\n", (size_t)deflateStream.total_out);
-        } else if (result == Z_STREAM_END) {
-            printf("deflate produced last %zu bytes.\n", (size_t)deflateStream.total_out);
-        } else if (result != Z_BUF_ERROR) {
-            printf("deflate failed (%d: %s).\n", (int)result, deflateStream.msg);
-            return;
-        }
+    if (
+        !deflater.Deflate(
+            (const uint8_t*)input.data(),
+            input.length(),
+            true,
+            [&deflatedContent](const uint8_t* data, size_t size){
+                printf("deflate produced %zu bytes.\n", size);
+                deflatedContent.insert(deflatedContent.end(), data, data + size);
+                return true;
+            }
+        )
+    ) {
+        printf("deflate failed.\n");
+        return;
     }
 
     // Display deflated data.
@@ -334,74 +1249,613 @@ void PlayWithGzip(const Environment& environment) {
     // Write deflated data to a file, for offline testing.
     DumpFile("test.gz", deflatedContent);
 
-    // End the deflate stream.
-    result = deflateEnd(&deflateStream);
-    if (result == Z_OK) {
-        printf("deflateEnd succeeded.\n");
+    // Set up the inflater.
+    Inflater inflater;
+    InflaterConfiguration inflaterConfiguration;
+    inflaterConfiguration.windowBits = 16 + MAX_WBITS;
+    inflaterConfiguration.chunkSize = INFLATE_BUFFER_SIZE;
+    if (inflater.Initialize(inflaterConfiguration)) {
+        printf("Inflater initialized.\n");
     } else {
-        printf("deflateEnd failed (%d: %s).\n", (int)result, deflateStream.msg);
+        printf("Inflater failed to initialize.\n");
         return;
     }
 
-    // Initialize the inflate stream.
-    z_stream inflateStream;
-    inflateStream.zalloc = Z_NULL;
-    inflateStream.zfree = Z_NULL;
-    inflateStream.opaque = Z_NULL;
+    // inflate the data.
     if (
-        inflateInit2(
-            &inflateStream,
-            16 + MAX_WBITS
-        ) == Z_OK
+        !inflater.Inflate(
+            deflatedContent.data(),
+            deflatedContent.size(),
+            [&output](const uint8_t* data, size_t size){
+                printf("inflate produced %zu bytes.\n", size);
+                output.append((const char*)data, size);
+                return true;
+            }
+        )
+        || !inflater.IsFinished()
     ) {
-        printf("inflateInit2 succeeded.\n");
-    } else {
-        printf("inflateInit2 failed.\n");
+        printf("inflate failed.\n");
         return;
     }
 
-    // inflate the data.
-    inflateStream.next_in = (Bytef*)deflatedContent.data();
-    inflateStream.avail_in = (uInt)deflatedContent.size();
-    inflateStream.total_in = 0;
-    result = Z_OK;
-    while (result != Z_STREAM_END) {
-        size_t totalInflatedPreviously = inflatedContent.size();
-        inflateStream.next_out = (Bytef*)inflatedContent.data();
-        inflateStream.avail_out = (uInt)inflatedContent.size();
-        inflateStream.total_out = 0;
-        result = inflate(&inflateStream, Z_FINISH);
-        output += std::string(
-            inflatedContent.begin(),
-            inflatedContent.begin() + (size_t)inflateStream.total_out
-        );
-        if (result == Z_OK) {
-            printf("inflate produced %zu more bytes.\n", (size_t)inflateStream.total_out);
-        } else if (result == Z_STREAM_END) {
-            printf("inflate produced last %zu bytes.\n", (size_t)inflateStream.total_out);
-        } else if (result != Z_BUF_ERROR) {
-            printf("inflate failed (%d: %s).\n", (int)result, inflateStream.msg);
-            return;
-        }
-    }
-
     // Display inflated data.
     printf("inflated data: %s\n", output.c_str());
 
-    // End the inflate stream.
-    result = inflateEnd(&inflateStream);
-    if (result == Z_OK) {
-        printf("inflateEnd succeeded.\n");
-    } else {
-        printf("inflateEnd failed (%d: %s).\n", (int)result, inflateStream.msg);
-        return;
-    }
-
     // Display some stats.
     printf("Original:   %zu bytes\n", input.length());
     printf("Compressed: %zu bytes\n", deflatedContent.size());
 }
 
+/**
+ * This function loads the benchmark corpus and measures compression
+ * throughput over it, writing the report to standard output or to the
+ * configured report file.
+ *
+ * @param[in] environment
+ *     This contains variables set through the operating system environment
+ *     or the command-line arguments.
+ *
+ * @return
+ *     The exit code to return from the program is returned.
+ */
+int MeasureThroughput(const Environment& environment) {
+    Corpus corpus;
+    if (!LoadCorpus(environment.benchmarkPaths, corpus)) {
+        return EXIT_FAILURE;
+    }
+    fprintf(stderr, "Loaded %zu files into the corpus.\n", corpus.size());
+    if (environment.lines) {
+        corpus = SplitCorpusLines(corpus);
+        fprintf(stderr, "Split the corpus into %zu messages.\n", corpus.size());
+    }
+    auto benchmark = environment.benchmark;
+    if (
+        !environment.dictionaryPath.empty()
+        && !LoadDictionary(environment.dictionaryPath, benchmark.dictionary)
+    ) {
+        return EXIT_FAILURE;
+    }
+    FILE* report = stdout;
+    if (!environment.reportPath.empty()) {
+        report = fopen(environment.reportPath.c_str(), "w");
+        if (report == NULL) {
+            fprintf(stderr, "error: unable to open '%s'\n", environment.reportPath.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+    const auto succeeded = RunBenchmark(corpus, benchmark, report);
+    if (report != stdout) {
+        (void)fclose(report);
+    }
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * This function checks the checksum kernels against zlib and reports
+ * how fast each one is.
+ *
+ * @param[in] environment
+ *     This contains variables set through the operating system environment
+ *     or the command-line arguments.
+ *
+ * @return
+ *     The exit code to return from the program is returned.
+ */
+int MeasureChecksums(const Environment& environment) {
+    FILE* report = stdout;
+    if (!environment.reportPath.empty()) {
+        report = fopen(environment.reportPath.c_str(), "w");
+        if (report == NULL) {
+            fprintf(stderr, "error: unable to open '%s'\n", environment.reportPath.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+    const auto succeeded = RunChecksumBenchmark(environment.benchmark, report);
+    if (report != stdout) {
+        (void)fclose(report);
+    }
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * This function loads the recorded messages, trains a preset dictionary
+ * from them, and saves it to the configured file.
+ *
+ * @param[in] environment
+ *     This contains variables set through the operating system environment
+ *     or the command-line arguments.
+ *
+ * @return
+ *     The exit code to return from the program is returned.
+ */
+int TrainDictionaryFromMessages(const Environment& environment) {
+    Corpus recordings;
+    if (!LoadCorpus(environment.trainingPaths, recordings)) {
+        return EXIT_FAILURE;
+    }
+    const auto messages = SplitCorpusLines(recordings);
+    fprintf(stderr, "Loaded %zu messages from %zu files.\n", messages.size(), recordings.size());
+    std::vector< uint8_t > dictionary;
+    if (!TrainDictionary(messages, environment.training, dictionary)) {
+        return EXIT_FAILURE;
+    }
+    const auto dictionaryPath = (
+        environment.reportPath.empty()
+        ? DEFAULT_DICTIONARY_PATH
+        : environment.reportPath
+    );
+    if (!SaveDictionary(dictionaryPath, dictionary)) {
+        return EXIT_FAILURE;
+    }
+    fprintf(stderr, "Wrote a %zu-byte dictionary to '%s'.\n", dictionary.size(), dictionaryPath.c_str());
+    return EXIT_SUCCESS;
+}
+
+/**
+ * This function builds an index of access points into the configured
+ * gzip file and saves it.
+ *
+ * @param[in] environment
+ *     This contains variables set through the operating system environment
+ *     or the command-line arguments.
+ *
+ * @return
+ *     The exit code to return from the program is returned.
+ */
+int IndexGzipFile(const Environment& environment) {
+    const auto indexPath = (
+        environment.reportPath.empty()
+        ? environment.indexPath + GZIP_INDEX_SUFFIX
+        : environment.reportPath
+    );
+    const auto start = std::chrono::steady_clock::now();
+    GzipIndex index;
+    if (
+        !BuildGzipIndex(environment.indexPath, environment.span, index)
+        || !SaveGzipIndex(indexPath, index)
+    ) {
+        return EXIT_FAILURE;
+    }
+    const auto seconds = std::chrono::duration< double >(
+        std::chrono::steady_clock::now() - start
+    ).count();
+    fprintf(
+        stderr,
+        "Indexed %" PRIu64 " bytes (%" PRIu64 " decompressed) with %zu access points in %.3f seconds into '%s'.\n",
+        index.compressedSize,
+        index.uncompressedSize,
+        index.accessPoints.size(),
+        seconds,
+        indexPath.c_str()
+    );
+    return EXIT_SUCCESS;
+}
+
+/**
+ * This function reads the configured range of decompressed data from the
+ * configured gzip file, using the file's index, and writes it to standard
+ * output or to the configured output file.
+ *
+ * @param[in] environment
+ *     This contains variables set through the operating system environment
+ *     or the command-line arguments.
+ *
+ * @return
+ *     The exit code to return from the program is returned.
+ */
+int ExtractRange(const Environment& environment) {
+    GzipIndex index;
+    if (!LoadGzipIndex(environment.extractPath + GZIP_INDEX_SUFFIX, index)) {
+        return EXIT_FAILURE;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    std::vector< uint8_t > range;
+    GzipRangeStatistics statistics;
+    if (
+        !ReadGzipRange(
+            environment.extractPath,
+            index,
+            environment.extractOffset,
+            (size_t)environment.extractLength,
+            range,
+            statistics
+        )
+    ) {
+        return EXIT_FAILURE;
+    }
+    const auto seconds = std::chrono::duration< double >(
+        std::chrono::steady_clock::now() - start
+    ).count();
+    FILE* output = stdout;
+    if (!environment.reportPath.empty()) {
+        output = fopen(environment.reportPath.c_str(), "wb");
+        if (output == NULL) {
+            fprintf(stderr, "error: unable to open '%s'\n", environment.reportPath.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+    const auto written = (
+        range.empty()
+        || (fwrite(range.data(), range.size(), 1, output) == 1)
+    );
+    if (output != stdout) {
+        (void)fclose(output);
+    }
+    if (!written) {
+        fprintf(stderr, "error: unable to write the range\n");
+        return EXIT_FAILURE;
+    }
+    fprintf(
+        stderr,
+        "Read %zu bytes from the access point at %" PRIu64 ", using %" PRIu64 " compressed bytes and decompressing %" PRIu64 " bytes, in %.3f seconds.\n",
+        range.size(),
+        statistics.accessPointOffset,
+        statistics.compressedBytes,
+        statistics.uncompressedBytes,
+        seconds
+    );
+    return EXIT_SUCCESS;
+}
+
+/**
+ * This function compresses the configured file into the gzip format,
+ * splitting it into blocks which are compressed on several threads.
+ *
+ * @param[in] environment
+ *     This contains variables set through the operating system environment
+ *     or the command-line arguments.
+ *
+ * @return
+ *     The exit code to return from the program is returned.
+ */
+int CompressInParallel(const Environment& environment) {
+    MappedFile inputFile;
+    if (!inputFile.Open(environment.gzipPath)) {
+        fprintf(stderr, "error: unable to open '%s'\n", environment.gzipPath.c_str());
+        return EXIT_FAILURE;
+    }
+    const auto inputSize = (size_t)inputFile.GetSize();
+    const auto input = inputFile.Map(0, inputSize);
+    if (input == nullptr) {
+        fprintf(stderr, "error: unable to map '%s'\n", environment.gzipPath.c_str());
+        return EXIT_FAILURE;
+    }
+    auto configuration = environment.gzip;
+    if (
+        environment.autoTune
+        && !TuneCompression(
+            environment,
+            input,
+            inputSize,
+            configuration.level,
+            configuration.strategy
+        )
+    ) {
+        return EXIT_FAILURE;
+    }
+    const auto outputPath = (
+        environment.reportPath.empty()
+        ? environment.gzipPath + ".gz"
+        : environment.reportPath
+    );
+    const auto fileHandle = std::unique_ptr< FILE, std::function< void(FILE*) > >(
+        fopen(outputPath.c_str(), "wb"),
+        [](FILE*f){
+            if (f != NULL) {
+                (void)fclose(f);
+            }
+        }
+    );
+    if (fileHandle == NULL) {
+        fprintf(stderr, "error: unable to open '%s'\n", outputPath.c_str());
+        return EXIT_FAILURE;
+    }
+    std::vector< uint8_t > compressed;
+    size_t compressedSize = 0;
+    const auto start = std::chrono::steady_clock::now();
+    const auto succeeded = ParallelGzip(
+        input,
+        inputSize,
+        configuration,
+        [&](const uint8_t* data, size_t size){
+            compressedSize += size;
+            if (environment.verify) {
+                compressed.insert(compressed.end(), data, data + size);
+            }
+            return (fwrite(data, 1, size, fileHandle.get()) == size);
+        }
+    );
+    const auto seconds = std::chrono::duration< double >(
+        std::chrono::steady_clock::now() - start
+    ).count();
+    if (!succeeded) {
+        fprintf(stderr, "error: unable to compress '%s'\n", environment.gzipPath.c_str());
+        return EXIT_FAILURE;
+    }
+    printf(
+        "Compressed %zu bytes into %zu bytes in %.3f seconds (%.2f MB/s).\n",
+        inputSize,
+        compressedSize,
+        seconds,
+        (seconds > 0.0) ? (double)inputSize / 1e6 / seconds : 0.0
+    );
+    if (environment.verify) {
+        if (!GunzipMatches(compressed, input, inputSize)) {
+            fprintf(stderr, "error: compressed output does not match input\n");
+            return EXIT_FAILURE;
+        }
+        printf("Verified compressed output.\n");
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * This function decompresses the configured gzip file, decompressing its
+ * members in parallel, and either writes the output to a file or compares
+ * the time taken with decompressing the members one at a time.
+ *
+ * @param[in] environment
+ *     This contains variables set through the operating system environment
+ *     or the command-line arguments.
+ *
+ * @return
+ *     The exit code to return from the program is returned.
+ */
+int DecompressInParallel(const Environment& environment) {
+    MappedFile inputFile;
+    if (!inputFile.Open(environment.gunzipPath)) {
+        fprintf(stderr, "error: unable to open '%s'\n", environment.gunzipPath.c_str());
+        return EXIT_FAILURE;
+    }
+    const auto inputSize = (size_t)inputFile.GetSize();
+    const auto input = inputFile.Map(0, inputSize);
+    if (input == nullptr) {
+        fprintf(stderr, "error: unable to map '%s'\n", environment.gunzipPath.c_str());
+        return EXIT_FAILURE;
+    }
+    ParallelGunzipConfiguration configuration;
+    configuration.threads = environment.gzip.threads;
+    GunzipStatistics statistics;
+    if (environment.compare) {
+        struct Digest {
+            uint32_t crc = 0;
+            uint64_t size = 0;
+        } serialDigest, parallelDigest;
+        const auto digestOutput = [](Digest& digest){
+            return [&digest](const uint8_t* data, size_t size){
+                digest.crc = Crc32(digest.crc, data, size);
+                digest.size += size;
+                return true;
+            };
+        };
+        const auto serialStart = std::chrono::steady_clock::now();
+        if (!SerialGunzip(input, inputSize, digestOutput(serialDigest), statistics)) {
+            fprintf(stderr, "error: unable to decompress '%s'\n", environment.gunzipPath.c_str());
+            return EXIT_FAILURE;
+        }
+        const auto serialSeconds = std::chrono::duration< double >(
+            std::chrono::steady_clock::now() - serialStart
+        ).count();
+        const auto parallelStart = std::chrono::steady_clock::now();
+        if (!ParallelGunzip(input, inputSize, configuration, digestOutput(parallelDigest), statistics)) {
+            fprintf(stderr, "error: unable to decompress '%s'\n", environment.gunzipPath.c_str());
+            return EXIT_FAILURE;
+        }
+        const auto parallelSeconds = std::chrono::duration< double >(
+            std::chrono::steady_clock::now() - parallelStart
+        ).count();
+        printf(
+            "Serial:   %" PRIu64 " bytes in %.3f seconds (%.2f MB/s).\n",
+            serialDigest.size,
+            serialSeconds,
+            (serialSeconds > 0.0) ? (double)serialDigest.size / 1e6 / serialSeconds : 0.0
+        );
+        printf(
+            "Parallel: %" PRIu64 " bytes in %.3f seconds (%.2f MB/s), %zu members, %zu false starts%s.\n",
+            parallelDigest.size,
+            parallelSeconds,
+            (parallelSeconds > 0.0) ? (double)parallelDigest.size / 1e6 / parallelSeconds : 0.0,
+            statistics.members,
+            statistics.falseStarts,
+            statistics.parallel ? "" : " (fell back to serial)"
+        );
+        if (
+            (serialDigest.size != parallelDigest.size)
+            || (serialDigest.crc != parallelDigest.crc)
+        ) {
+            fprintf(stderr, "error: parallel output does not match serial output\n");
+            return EXIT_FAILURE;
+        }
+        printf("Outputs match; speedup %.2fx.\n", (parallelSeconds > 0.0) ? serialSeconds / parallelSeconds : 0.0);
+        return EXIT_SUCCESS;
+    }
+    auto outputPath = environment.reportPath;
+    if (outputPath.empty()) {
+        const std::string suffix = ".gz";
+        const auto& inputPath = environment.gunzipPath;
+        if (
+            (inputPath.length() > suffix.length())
+            && (inputPath.compare(inputPath.length() - suffix.length(), suffix.length(), suffix) == 0)
+        ) {
+            outputPath = inputPath.substr(0, inputPath.length() - suffix.length());
+        } else {
+            outputPath = inputPath + ".out";
+        }
+    }
+    const auto fileHandle = std::unique_ptr< FILE, std::function< void(FILE*) > >(
+        fopen(outputPath.c_str(), "wb"),
+        [](FILE*f){
+            if (f != NULL) {
+                (void)fclose(f);
+            }
+        }
+    );
+    if (fileHandle == NULL) {
+        fprintf(stderr, "error: unable to open '%s'\n", outputPath.c_str());
+        return EXIT_FAILURE;
+    }
+    uint64_t outputSize = 0;
+    const auto start = std::chrono::steady_clock::now();
+    const auto succeeded = ParallelGunzip(
+        input,
+        inputSize,
+        configuration,
+        [&](const uint8_t* data, size_t size){
+            outputSize += size;
+            return (fwrite(data, 1, size, fileHandle.get()) == size);
+        },
+        statistics
+    );
+    const auto seconds = std::chrono::duration< double >(
+        std::chrono::steady_clock::now() - start
+    ).count();
+    if (!succeeded) {
+        fprintf(stderr, "error: unable to decompress '%s'\n", environment.gunzipPath.c_str());
+        return EXIT_FAILURE;
+    }
+    printf(
+        "Decompressed %zu bytes into %" PRIu64 " bytes (%zu members) in %.3f seconds (%.2f MB/s)%s.\n",
+        inputSize,
+        outputSize,
+        statistics.members,
+        seconds,
+        (seconds > 0.0) ? (double)outputSize / 1e6 / seconds : 0.0,
+        statistics.parallel ? "" : " on one thread"
+    );
+    return EXIT_SUCCESS;
+}
+
+/**
+ * This function compresses the configured file into another file,
+ * streaming it through fixed-size buffers.
+ *
+ * @param[in] environment
+ *     This contains variables set through the operating system environment
+ *     or the command-line arguments.
+ *
+ * @return
+ *     The exit code to return from the program is returned.
+ */
+int CompressStreaming(const Environment& environment) {
+    auto configuration = environment.stream;
+    if (environment.autoTune) {
+        // Only the pages sampled are read, so mapping the whole file
+        // here doesn't bring it all into memory.
+        MappedFile inputFile;
+        if (!inputFile.Open(environment.streamPath)) {
+            fprintf(stderr, "error: unable to open '%s'\n", environment.streamPath.c_str());
+            return EXIT_FAILURE;
+        }
+        const auto inputSize = (size_t)inputFile.GetSize();
+        const auto input = inputFile.Map(0, inputSize);
+        if (input == nullptr) {
+            fprintf(stderr, "error: unable to map '%s'\n", environment.streamPath.c_str());
+            return EXIT_FAILURE;
+        }
+        if (
+            !TuneCompression(
+                environment,
+                input,
+                inputSize,
+                configuration.level,
+                configuration.strategy
+            )
+        ) {
+            return EXIT_FAILURE;
+        }
+    }
+    const auto outputPath = (
+        environment.reportPath.empty()
+        ? environment.streamPath + ".gz"
+        : environment.reportPath
+    );
+    StreamingCompressionStatistics statistics;
+    const auto start = std::chrono::steady_clock::now();
+    if (
+        !CompressFile(
+            environment.streamPath,
+            outputPath,
+            configuration,
+            statistics
+        )
+    ) {
+        return EXIT_FAILURE;
+    }
+    const auto seconds = std::chrono::duration< double >(
+        std::chrono::steady_clock::now() - start
+    ).count();
+    printf(
+        "Compressed %" PRIu64 " bytes into %" PRIu64 " bytes in %.3f seconds (%.2f MB/s).\n",
+        statistics.inputBytes,
+        statistics.outputBytes,
+        seconds,
+        (seconds > 0.0) ? (double)statistics.inputBytes / 1e6 / seconds : 0.0
+    );
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        printf("Peak resident set size: %ld KiB\n", (long)usage.ru_maxrss);
+    }
+#endif /* not _WIN32 */
+    return EXIT_SUCCESS;
+}
+
+/**
+ * This function writes a compressed copy beside every file in the
+ * configured static content roots which doesn't already have an
+ * up-to-date one.
+ *
+ * @param[in] environment
+ *     This contains variables set through the operating system environment
+ *     or the command-line arguments.
+ *
+ * @return
+ *     The exit code to return from the program is returned.
+ */
+int PrecompressStaticContent(const Environment& environment) {
+    std::vector< std::string > roots;
+    for (const auto& path: environment.precompressPaths) {
+        if (SystemAbstractions::File(path).IsDirectory()) {
+            roots.push_back(path);
+        } else if (!ListStaticContentRoots(path, environment.precompressBase, roots)) {
+            return EXIT_FAILURE;
+        }
+    }
+    PrecompressStatistics totals;
+    bool succeeded = true;
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& root: roots) {
+        PrecompressStatistics statistics;
+        if (!PrecompressDirectory(root, environment.precompress, statistics)) {
+            succeeded = false;
+        }
+        printf(
+            "%s: %zu files, %zu compressed, %zu unchanged, %zu touched, %zu incompressible, %zu removed.\n",
+            root.c_str(),
+            statistics.files,
+            statistics.compressed,
+            statistics.unchanged,
+            statistics.touched,
+            statistics.incompressible,
+            statistics.removed
+        );
+        totals.compressed += statistics.compressed;
+        totals.inputBytes += statistics.inputBytes;
+        totals.outputBytes += statistics.outputBytes;
+    }
+    const auto seconds = std::chrono::duration< double >(
+        std::chrono::steady_clock::now() - start
+    ).count();
+    printf(
+        "Compressed %zu files, %" PRIu64 " bytes into %" PRIu64 " bytes, in %.3f seconds.\n",
+        totals.compressed,
+        totals.inputBytes,
+        totals.outputBytes,
+        seconds
+    );
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 /**
  * This function is the entrypoint of the program.
  * It just sets up the bot and has it log into Twitch.  At that point, the
@@ -427,6 +1881,33 @@ int main(int argc, char* argv[]) {
         PrintUsageInformation();
         return EXIT_FAILURE;
     }
+    if (!environment.benchmarkPaths.empty()) {
+        return MeasureThroughput(environment);
+    }
+    if (environment.checksums) {
+        return MeasureChecksums(environment);
+    }
+    if (!environment.gzipPath.empty()) {
+        return CompressInParallel(environment);
+    }
+    if (!environment.gunzipPath.empty()) {
+        return DecompressInParallel(environment);
+    }
+    if (!environment.streamPath.empty()) {
+        return CompressStreaming(environment);
+    }
+    if (!environment.trainingPaths.empty()) {
+        return TrainDictionaryFromMessages(environment);
+    }
+    if (!environment.indexPath.empty()) {
+        return IndexGzipFile(environment);
+    }
+    if (!environment.extractPath.empty()) {
+        return ExtractRange(environment);
+    }
+    if (!environment.precompressPaths.empty()) {
+        return PrecompressStaticContent(environment);
+    }
     PlayWithInflateDeflate(environment);
     PlayWithGzip(environment);
     return EXIT_SUCCESS;